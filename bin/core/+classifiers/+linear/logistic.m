@@ -3,7 +3,9 @@ classdef logistic < classifier
         classifiers_count;
         saved_class_pair;
         method_code;
+        feature_ids;
         model_weights;
+        model_weights_by_feature;
         problem_form;
         reg_type;
         reg_param;
@@ -79,12 +81,28 @@ classdef logistic < classifier
                 classify_num_workers_t = num_workers;
             end
             
+            % Only features which fire for at least one training observation get a weight. The others would be left
+            % with a zero one by every solver, so dropping them changes no decision, but shrinks every classifier.
+            
+            feature_ids_t = find(any(train_sample,2));
+            train_sample_compact = train_sample(feature_ids_t,:);
+            
             if class_info.labels_count == 2
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
             elseif check.same(multiclass_form,'1va')
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_all(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_all(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
             else
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
+            end
+            
+            % L1 regularization leaves most weights at zero. They are also kept as a sparse "classifiers_count" x
+            % "geometry + 1" matrix, whose columns hold the non-zero weights of each feature, so classification only
+            % visits the weights of the features an observation has.
+            
+            if check.same(reg_type,'L1')
+                model_weights_by_feature_t = sparse(model_weights_t');
+            else
+                model_weights_by_feature_t = [];
             end
             
             input_geometry = dataset.geometry(train_sample);
@@ -93,7 +111,9 @@ classdef logistic < classifier
             obj.classifiers_count = classifiers_count_t;
             obj.saved_class_pair = saved_class_pair_t;
             obj.method_code = method_code_t;
+            obj.feature_ids = feature_ids_t;
             obj.model_weights = model_weights_t;
+            obj.model_weights_by_feature = model_weights_by_feature_t;
             obj.problem_form = problem_form;
             obj.reg_type = reg_type;
             obj.reg_param = reg_param;
@@ -105,9 +125,29 @@ classdef logistic < classifier
     
     methods (Access=protected)
         function [labels_idx_hat,labels_confidence] = do_classify(obj,sample)
-            N = dataset.count(sample);
+            % Models saved before training samples were compacted have no "feature_ids", and use all the features.
             
-            classifiers_decisions = xtern.x_classifiers_liblinear_classify(sample,obj.model_weights,obj.method_code,obj.reg_param,obj.classify_num_workers);
+            if check.empty(obj.feature_ids)
+                sample_compact = sample;
+            else
+                sample_compact = sample(obj.feature_ids,:);
+            end
+            
+            if ~check.empty(obj.model_weights_by_feature)
+                classifiers_decisions = xtern.x_classifiers_linear_classify_sparse(sample_compact,obj.model_weights_by_feature,obj.classify_num_workers);
+            else
+                classifiers_decisions = xtern.x_classifiers_liblinear_classify(sample_compact,obj.model_weights,obj.method_code,obj.reg_param,obj.classify_num_workers);
+            end
+            [labels_idx_hat,labels_confidence] = obj.decide(classifiers_decisions);
+        end
+        
+        function [labels_idx_hat,labels_confidence] = do_classify_recoded(obj,t_recoder,sample_plain)
+            classifiers_decisions = t_recoder.code_classify(sample_plain,obj.model_weights,obj.feature_ids);
+            [labels_idx_hat,labels_confidence] = obj.decide(classifiers_decisions);
+        end
+        
+        function [labels_idx_hat,labels_confidence] = decide(obj,classifiers_decisions)
+            N = size(classifiers_decisions,2);
             
             if obj.saved_labels_count == 2
                 classifiers_probs_t1 = 1 ./ (1 + 2.71828183 .^ (-classifiers_decisions));
@@ -166,6 +206,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -199,6 +242,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -229,6 +275,8 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -262,6 +310,8 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -292,6 +342,8 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -325,6 +377,8 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -355,6 +409,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -388,6 +445,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -418,6 +478,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -451,6 +514,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -481,6 +547,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 1]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.same(cl.problem_form,'Primal'));
@@ -507,6 +576,9 @@ classdef logistic < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 1]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.same(cl.problem_form,'Primal'));
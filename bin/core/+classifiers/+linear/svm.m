@@ -3,7 +3,9 @@ classdef svm < classifier
         classifiers_count;
         saved_class_pair;
         method_code;
+        feature_ids;
         model_weights;
+        model_weights_by_feature;
         problem_form;
         loss_type;
         reg_type;
@@ -35,16 +37,17 @@ classdef svm < classifier
             assert(reg_param > 0);
             assert(check.scalar(multiclass_form));
             assert(check.string(multiclass_form));
-            assert(check.one_of(multiclass_form,'1va','1v1'));
+            assert(check.one_of(multiclass_form,'1va','1v1','cs'));
+            assert(~check.same(multiclass_form,'cs') || (check.same(problem_form,'Dual') && check.same(loss_type,'L1')));
             assert(check.scalar(num_workers) || (check.vector(num_workers) && (length(num_workers) == 2)));
             assert(check.natural(num_workers));
             assert(check.checkv(num_workers >= 1));
             assert(class_info.compatible(train_sample));
             
-            if class_info.labels_count == 2
+            if (class_info.labels_count == 2) && ~check.same(multiclass_form,'cs')
                 classifiers_count_t = 1;
                 saved_class_pair_t = [1 2];
-            elseif check.same(multiclass_form,'1va')
+            elseif check.one_of(multiclass_form,'1va','cs')
                 classifiers_count_t = class_info.labels_count;
                 saved_class_pair_t = zeros(classifiers_count_t,2);
                 
@@ -66,7 +69,9 @@ classdef svm < classifier
                 end
             end
             
-            if check.same(problem_form,'Primal')
+            if check.same(multiclass_form,'cs')
+                method_code_t = 4;
+            elseif check.same(problem_form,'Primal')
                 if check.same(reg_type,'L1')
                     method_code_t = 5;
                 else
@@ -88,12 +93,33 @@ classdef svm < classifier
                 classify_num_workers_t = num_workers;
             end
             
-            if class_info.labels_count == 2
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+            % Only features which fire for at least one training observation get a weight. The others would be left
+            % with a zero one by every solver, so dropping them changes no decision, but shrinks every classifier.
+            
+            feature_ids_t = find(any(train_sample,2));
+            train_sample_compact = train_sample(feature_ids_t,:);
+            
+            % The Crammer-Singer form trains one scorer per class in a single joint problem, rather than building one
+            % binary problem per classifier. The scorers are stored and applied like the "1va" classifiers.
+            
+            if check.same(multiclass_form,'cs')
+                model_weights_t = xtern.x_classifiers_liblinear_train_crammer_singer(train_sample_compact,class_info,reg_param);
+            elseif class_info.labels_count == 2
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
             elseif check.same(multiclass_form,'1va')
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_all(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_all(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
+            else
+                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample_compact,class_info,method_code_t,reg_param,train_num_workers_t);
+            end
+            
+            % L1 regularization leaves most weights at zero. They are also kept as a sparse "classifiers_count" x
+            % "geometry + 1" matrix, whose columns hold the non-zero weights of each feature, so classification only
+            % visits the weights of the features an observation has.
+            
+            if check.same(reg_type,'L1')
+                model_weights_by_feature_t = sparse(model_weights_t');
             else
-                model_weights_t = xtern.x_classifiers_liblinear_train_one_vs_one(train_sample,class_info,method_code_t,reg_param,train_num_workers_t);
+                model_weights_by_feature_t = [];
             end
             
             input_geometry = dataset.geometry(train_sample);
@@ -102,7 +128,9 @@ classdef svm < classifier
             obj.classifiers_count = classifiers_count_t;
             obj.saved_class_pair = saved_class_pair_t;
             obj.method_code = method_code_t;
+            obj.feature_ids = feature_ids_t;
             obj.model_weights = model_weights_t;
+            obj.model_weights_by_feature = model_weights_by_feature_t;
             obj.problem_form = problem_form;
             obj.loss_type = loss_type;
             obj.reg_type = reg_type;
@@ -117,11 +145,38 @@ classdef svm < classifier
         function [labels_idx_hat,labels_confidence] = do_classify(obj,sample)
             assert(issparse(sample));
             
-            N = dataset.count(sample);
+            % Models saved before training samples were compacted have no "feature_ids", and use all the features.
+            
+            if check.empty(obj.feature_ids)
+                sample_compact = sample;
+            else
+                sample_compact = sample(obj.feature_ids,:);
+            end
             
-            classifiers_decisions = xtern.x_classifiers_liblinear_classify(sample,obj.model_weights,obj.method_code,obj.reg_param,obj.classify_num_workers);
+            if ~check.empty(obj.model_weights_by_feature)
+                classifiers_decisions = xtern.x_classifiers_linear_classify_sparse(sample_compact,obj.model_weights_by_feature,obj.classify_num_workers);
+            else
+                classifiers_decisions = xtern.x_classifiers_liblinear_classify(sample_compact,obj.model_weights,obj.method_code,obj.reg_param,obj.classify_num_workers);
+            end
+            [labels_idx_hat,labels_confidence] = obj.decide(classifiers_decisions);
+        end
+        
+        function [labels_idx_hat,labels_confidence] = do_classify_recoded(obj,t_recoder,sample_plain)
+            classifiers_decisions = t_recoder.code_classify(sample_plain,obj.model_weights,obj.feature_ids);
+            [labels_idx_hat,labels_confidence] = obj.decide(classifiers_decisions);
+        end
+        
+        function [labels_idx_hat,labels_confidence] = decide(obj,classifiers_decisions)
+            N = size(classifiers_decisions,2);
             
-            if obj.saved_labels_count == 2
+            if check.same(obj.multiclass_form,'cs')
+                classifiers_probs = exp(bsxfun(@minus,classifiers_decisions,max(classifiers_decisions,[],1)));
+                
+                [~,max_probs_idx] = max(classifiers_probs,[],1);
+                
+                labels_idx_hat = max_probs_idx;
+                labels_confidence = bsxfun(@rdivide,classifiers_probs,sum(classifiers_probs,1));
+            elseif obj.saved_labels_count == 2
                 classifiers_probs_t1 = 1 ./ (1 + 2.71828183 .^ (-classifiers_decisions));
                 classifiers_probs = [classifiers_probs_t1; 1 - classifiers_probs_t1];
                 
@@ -171,6 +226,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -205,6 +263,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -236,6 +297,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -270,6 +333,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -301,6 +366,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -335,6 +402,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -366,6 +435,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -400,6 +471,8 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -419,6 +492,36 @@ classdef svm < classifier
             
             clearvars -except test_figure;
             
+            fprintf('    In dual form, L1 loss, L2 regularization and Crammer-Singer multiclass handling.\n');
+            
+            [s,ci] = dataset.load('../../test/classifier_data_3.mat');
+            
+            cl = classifiers.linear.svm(s,ci,'Dual','L1','L2',1,'cs',1);
+
+            assert(cl.classifiers_count == 3);
+            assert(check.same(cl.saved_class_pair,[1 0; 2 0; 3 0]));
+            assert(cl.method_code == 4);
+            assert(check.matrix(cl.model_weights));
+            assert(check.same(size(cl.model_weights),[3 3]));
+            assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(check.empty(cl.model_weights_by_feature));
+            assert(check.checkf(@(ii)all([s(:,ii);1]' * cl.model_weights(:,1) >= [s(:,ii);1]' * cl.model_weights(:,2:3)),1:100));
+            assert(check.checkf(@(ii)all([s(:,ii);1]' * cl.model_weights(:,2) >= [s(:,ii);1]' * cl.model_weights(:,[1 3])),101:200));
+            assert(check.checkf(@(ii)all([s(:,ii);1]' * cl.model_weights(:,3) >= [s(:,ii);1]' * cl.model_weights(:,1:2)),201:300));
+            assert(check.same(cl.problem_form,'Dual'));
+            assert(check.same(cl.loss_type,'L1'));
+            assert(check.same(cl.reg_type,'L2'));
+            assert(cl.reg_param == 1);
+            assert(check.same(cl.multiclass_form,'cs'));
+            assert(cl.train_num_workers == 1);
+            assert(cl.classify_num_workers == 1);
+            assert(check.same(cl.input_geometry,2));
+            assert(check.same(cl.saved_labels,{'1' '2' '3'}));
+            assert(cl.saved_labels_count == 3);
+            
+            clearvars -except test_figure;
+            
             fprintf('    With multiple threads and One-vs-Experiment multiclass handling.\n');
             
             [s,ci] = dataset.load('../../test/classifier_data_3.mat');
@@ -431,6 +534,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -465,6 +571,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -496,6 +605,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,201:300));
@@ -530,6 +642,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 3]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,2) >= 0,1:100));
@@ -561,6 +676,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 1]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.same(cl.problem_form,'Primal'));
@@ -588,6 +706,9 @@ classdef svm < classifier
             assert(check.matrix(cl.model_weights));
             assert(check.same(size(cl.model_weights),[3 1]));
             assert(check.number(cl.model_weights));
+            assert(check.same(cl.feature_ids,[1;2]));
+            assert(issparse(cl.model_weights_by_feature));
+            assert(check.same(full(cl.model_weights_by_feature),cl.model_weights'));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) >= 0,1:100));
             assert(check.checkf(@(ii)[s(:,ii);1]' * cl.model_weights(:,1) < 0,101:200));
             assert(check.same(cl.problem_form,'Primal'));
@@ -603,6 +724,22 @@ classdef svm < classifier
             
             clearvars -except test_figure;
             
+            fprintf('    With features which never fire.\n');
+            
+            [s,ci] = dataset.load('../../test/classifier_data_3.mat');
+            s_p = [sparse(1,300); s(1,:); sparse(2,300); s(2,:)];
+            
+            cl = classifiers.linear.svm(s_p,ci,'Primal','L2','L2',1,'1va',1);
+            cl_r = classifiers.linear.svm(s,ci,'Primal','L2','L2',1,'1va',1);
+            
+            assert(check.same(cl.feature_ids,[2;5]));
+            assert(check.same(size(cl.model_weights),[3 3]));
+            assert(check.same(cl.model_weights,cl_r.model_weights,1e-10));
+            assert(check.same(cl.input_geometry,5));
+            assert(check.same(cl.classify(s_p,-1),cl_r.classify(s,-1)));
+            
+            clearvars -except test_figure;
+            
             fprintf('  Function "classify".\n');
             
             fprintf('    On clearly separated data.\n');
@@ -853,6 +990,37 @@ classdef svm < classifier
                 pause(5);
             end
             
+            clearvars -except test_figure;
+            
+            fprintf('      In dual form, L1 loss, L2 regularization and Crammer-Singer multiclass handling.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_clear_data_3.train.mat');
+            [s_ts,ci_ts] = dataset.load('../../test/classifier_clear_data_3.test.mat');
+            
+            cl = classifiers.linear.svm(s_tr,ci_tr,'Dual','L1','L2',1,'cs',1);
+            [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = cl.classify(s_ts,ci_ts);
+            
+            assert(check.same(labels_idx_hat,ci_ts.labels_idx));
+            assert(check.matrix(labels_confidence));
+            assert(check.same(size(labels_confidence),[3 60]));
+            assert(check.unitreal(labels_confidence));
+            assert(check.same(sum(labels_confidence,1),ones(1,60)));
+            assert(check.checkv(labels_confidence(1,1:20) >= labels_confidence(2,1:20)));
+            assert(check.checkv(labels_confidence(1,1:20) >= labels_confidence(3,1:20)));
+            assert(check.checkv(labels_confidence(2,21:40) >= labels_confidence(1,21:40)));
+            assert(check.checkv(labels_confidence(2,21:40) >= labels_confidence(3,21:40)));
+            assert(check.checkv(labels_confidence(3,41:60) >= labels_confidence(1,41:60)));
+            assert(check.checkv(labels_confidence(3,41:60) >= labels_confidence(2,41:60)));
+            assert(score == 100);
+            assert(check.checkv(conf_matrix == [20 0 0; 0 20 0; 0 0 20]));
+            assert(check.empty(misclassified));
+            
+            if test_figure ~= -1
+                figure(test_figure);
+                utils.display.classification_border(cl,s_tr,s_ts,ci_tr,ci_ts,[-1 5 -1 5]);
+                pause(5);
+            end
+            
             clearvars -except test_figure;
 
 	        fprintf('    On clearly separated data with only two classes.\n');
@@ -1604,6 +1772,49 @@ classdef svm < classifier
             end
             
             clearvars -except test_figure;
+            
+            fprintf('  Function "classify_coded".\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_mostly_clear_data_3.train.mat');
+            [s_ts,ci_ts] = dataset.load('../../test/classifier_mostly_clear_data_3.test.mat');
+            coded_path = tempname();
+            
+            dataset.save_coded(coded_path,s_ts,true);
+            
+            cl = classifiers.linear.svm(s_tr,ci_tr,'Primal','L2','L2',1,'1va',1);
+            [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = cl.classify(s_ts,ci_ts);
+            [labels_idx_hat_c,labels_confidence_c,score_c,conf_matrix_c,misclassified_c] = cl.classify_coded(coded_path,ci_ts,7);
+            
+            assert(check.same(labels_idx_hat_c,labels_idx_hat));
+            assert(check.same(labels_confidence_c,labels_confidence,1e-10));
+            assert(score_c == score);
+            assert(check.same(conf_matrix_c,conf_matrix));
+            assert(check.same(misclassified_c,misclassified));
+            
+            delete(coded_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('  Function "classify_recoded".\n');
+            
+            [s,ci] = dataset.load('../../data/mnist.train.mat');
+            s_tr = dataset.subsample(s,1:200);
+            ci_tr = ci.subsample(1:200);
+            s_ts = dataset.subsample(s,201:300);
+            ci_ts = ci.subsample(201:300);
+            
+            t = transforms.image.recoder(s_tr,100,5,5,0.01,false,'Random:Filters',{32 'Corr' [] 4 1},'Linear',[],'KeepSign','MaxNoSign',4,1);
+            cl = classifiers.linear.svm(t.code(s_tr),ci_tr,'Primal','L2','L2',1,'1va',1);
+            [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = cl.classify(t.code(s_ts),ci_ts);
+            [labels_idx_hat_r,labels_confidence_r,score_r,conf_matrix_r,misclassified_r] = cl.classify_recoded(t,s_ts,ci_ts);
+            
+            assert(check.same(labels_idx_hat_r,labels_idx_hat));
+            assert(check.same(labels_confidence_r,labels_confidence,1e-10));
+            assert(score_r == score);
+            assert(check.same(conf_matrix_r,conf_matrix));
+            assert(check.same(misclassified_r,misclassified));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -3,10 +3,17 @@ classdef knn < classifier
         sample;
         labels_idx;
         k;
+        index_type;
+        index_params;
+        num_workers;
+        index_sample_norms;
+        index_centroids;
+        index_list_offsets;
+        index_list_members;
     end
     
     methods (Access=public)
-        function [obj] = knn(train_sample,class_info,k)
+        function [obj] = knn(train_sample,class_info,k,index_type,index_params,num_workers)
             assert(check.dataset_record(train_sample));
             assert(check.scalar(class_info));
             assert(check.classifier_info(class_info));
@@ -14,14 +21,105 @@ classdef knn < classifier
             assert(check.natural(k));
             assert(k >= 1);
             assert(k <= dataset.count(train_sample));
+            assert(~exist('index_type','var') || check.scalar(index_type));
+            assert(~exist('index_type','var') || check.string(index_type));
+            assert(~exist('index_type','var') || check.one_of(index_type,'Exact','Exact:Native','IVF'));
+            assert(~exist('index_params','var') || check.empty(index_params) || check.vector(index_params));
+            assert(~exist('index_params','var') || check.empty(index_params) || check.cell(index_params));
+            assert(~exist('index_type','var') || ~check.same(index_type,'IVF') || (exist('index_params','var') && classifiers.knn.ivf_params_ok(index_params,dataset.count(train_sample))));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
             assert(class_info.compatible(train_sample));
             
+            if ~exist('index_type','var')
+                index_type = 'Exact';
+            end
+            
+            if ~exist('index_params','var')
+                index_params = {};
+            end
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
+            
+            assert(check.same(index_type,'Exact') || ~issparse(train_sample));
+            
+            index_sample_norms_t = [];
+            index_centroids_t = zeros(dataset.geometry(train_sample),0);
+            index_list_offsets_t = zeros(1,0);
+            index_list_members_t = zeros(1,0);
+            
+            if check.same(index_type,'Exact:Native')
+                index_sample_norms_t = sum(train_sample .^ 2,1);
+            elseif check.same(index_type,'IVF')
+                list_count = index_params{1};
+                
+                if length(index_params) == 3
+                    max_iter_count = index_params{3};
+                else
+                    max_iter_count = 10;
+                end
+                
+                initial_centroids = train_sample(:,randperm(dataset.count(train_sample),list_count));
+                
+                [index_centroids_t,index_list_offsets_t,index_list_members_t,index_sample_norms_t] = ...
+                    xtern.x_classifiers_knn_build_index(train_sample,initial_centroids,max_iter_count,num_workers);
+            end
+            
             input_geometry = dataset.geometry(train_sample);
 
             obj = obj@classifier(input_geometry,class_info.labels);
             obj.sample = train_sample;
             obj.labels_idx = class_info.labels_idx;
             obj.k = k;
+            obj.index_type = index_type;
+            obj.index_params = index_params;
+            obj.num_workers = num_workers;
+            obj.index_sample_norms = index_sample_norms_t;
+            obj.index_centroids = index_centroids_t;
+            obj.index_list_offsets = index_list_offsets_t;
+            obj.index_list_members = index_list_members_t;
+        end
+        
+        function [neighbours_idx,neighbours_dist] = nearest(obj,sample,use_exact)
+            assert(check.dataset_record(sample) || (check.scalar(sample) && check.string(sample)));
+            assert(check.string(sample) || (dataset.geometry(sample) == obj.input_geometry));
+            assert(~check.string(sample) || check.same(dataset.mapped_info(sample),obj.input_geometry));
+            assert(~issparse(sample));
+            assert(~check.same(obj.index_type,'Exact'));
+            assert(~exist('use_exact','var') || check.scalar(use_exact));
+            assert(~exist('use_exact','var') || check.logical(use_exact));
+            
+            if exist('use_exact','var') && use_exact
+                [neighbours_idx,neighbours_dist] = xtern.x_classifiers_knn_search(obj.sample,obj.index_sample_norms,zeros(obj.input_geometry,0),zeros(1,0),zeros(1,0),0,obj.k,sample,obj.num_workers);
+            else
+                [neighbours_idx,neighbours_dist] = xtern.x_classifiers_knn_search(obj.sample,obj.index_sample_norms,obj.index_centroids,obj.index_list_offsets,obj.index_list_members,obj.probe_count(),obj.k,sample,obj.num_workers);
+            end
+        end
+        
+        function [recall,index_time,exact_time] = index_report(obj,sample)
+            assert(check.dataset_record(sample));
+            assert(dataset.geometry(sample) == obj.input_geometry);
+            assert(~issparse(sample));
+            assert(~check.same(obj.index_type,'Exact'));
+            
+            index_time_obj = tic();
+            neighbours_idx = obj.nearest(sample,false);
+            index_time = toc(index_time_obj);
+            
+            exact_time_obj = tic();
+            exact_neighbours_idx = obj.nearest(sample,true);
+            exact_time = toc(exact_time_obj);
+            
+            found_count = 0;
+            
+            for ii = 1:dataset.count(sample)
+                found_count = found_count + length(intersect(neighbours_idx(:,ii),exact_neighbours_idx(:,ii)));
+            end
+            
+            recall = found_count / numel(exact_neighbours_idx);
         end
     end
     
@@ -29,9 +127,54 @@ classdef knn < classifier
         function [labels_idx_hat,labels_confidence] = do_classify(obj,sample)
             N = dataset.count(sample);
             
-            labels_idx_hat = knnclassify(sample',obj.sample',obj.labels_idx)';
-            labels_confidence = zeros(obj.saved_labels_count,N);
-            labels_confidence(sub2ind(size(labels_confidence),labels_idx_hat,1:N)) = 1;
+            if check.same(obj.index_type,'Exact')
+                labels_idx_hat = knnclassify(sample',obj.sample',obj.labels_idx)';
+                labels_confidence = zeros(obj.saved_labels_count,N);
+                labels_confidence(sub2ind(size(labels_confidence),labels_idx_hat,1:N)) = 1;
+            else
+                neighbours_idx = obj.nearest(sample,false);
+                neighbours_labels_idx = reshape(obj.labels_idx(neighbours_idx),size(neighbours_idx));
+                
+                % Ties in the vote are broken in favor of the label of the closest neighbour.
+                
+                votes = zeros(obj.saved_labels_count,N);
+                nearest_rank = (obj.k + 1) * ones(obj.saved_labels_count,N);
+                
+                for rank = obj.k:-1:1
+                    votes_idx = sub2ind(size(votes),neighbours_labels_idx(rank,:),1:N);
+                    votes(votes_idx) = votes(votes_idx) + 1;
+                    nearest_rank(votes_idx) = rank;
+                end
+                
+                [~,labels_idx_hat] = max(votes - nearest_rank / (obj.k + 1),[],1);
+                labels_confidence = votes / obj.k;
+            end
+        end
+        
+        function [probe_count] = probe_count(obj)
+            if check.same(obj.index_type,'IVF')
+                probe_count = obj.index_params{2};
+            else
+                probe_count = 0;
+            end
+        end
+    end
+    
+    methods (Static,Access=protected)
+        function [o] = ivf_params_ok(index_params,sample_count)
+            o = check.vector(index_params) && ...
+                check.cell(index_params) && ...
+                ((length(index_params) == 2) || (length(index_params) == 3)) && ...
+                check.scalar(index_params{1}) && ...
+                check.natural(index_params{1}) && ...
+                (index_params{1} >= 1) && ...
+                (index_params{1} <= sample_count) && ...
+                check.scalar(index_params{2}) && ...
+                check.natural(index_params{2}) && ...
+                (index_params{2} >= 1) && ...
+                (index_params{2} <= index_params{1}) && ...
+                ((length(index_params) == 2) || ...
+                 (check.scalar(index_params{3}) && check.natural(index_params{3}) && (index_params{3} >= 1)));
         end
     end
     
@@ -51,6 +194,33 @@ classdef knn < classifier
             assert(check.same(cl.input_geometry,2));
             assert(check.same(cl.saved_labels,{'1' '2' '3'}));
             assert(cl.saved_labels_count == 3);
+            assert(check.same(cl.index_type,'Exact'));
+            assert(check.empty(cl.index_params));
+            assert(cl.num_workers == 1);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With IVF index.\n');
+            
+            [s,ci] = dataset.load('../../test/classifier_data_3.mat');
+            
+            cl = classifiers.knn(s,ci,1,'IVF',{4 2},2);
+            
+            assert(check.same(cl.sample,s));
+            assert(check.same(cl.labels_idx,ci.labels_idx));
+            assert(cl.k == 1);
+            assert(check.same(cl.index_type,'IVF'));
+            assert(check.same(cl.index_params,{4 2}));
+            assert(cl.num_workers == 2);
+            assert(check.same(cl.index_sample_norms,sum(s .^ 2,1)));
+            assert(check.same(size(cl.index_centroids),[2 4]));
+            assert(check.same(cl.index_list_offsets(1),0));
+            assert(check.same(cl.index_list_offsets(end),dataset.count(s)));
+            assert(all(diff(cl.index_list_offsets) >= 0));
+            assert(check.same(sort(cl.index_list_members)',0:(dataset.count(s) - 1)));
+            assert(check.same(cl.input_geometry,2));
+            assert(check.same(cl.saved_labels,{'1' '2' '3'}));
+            assert(cl.saved_labels_count == 3);
             
             clearvars -except test_figure;
             
@@ -137,6 +307,106 @@ classdef knn < classifier
             end
             
             clearvars -except test_figure;
+            
+            fprintf('    With native exact search.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_mostly_clear_data_3.train.mat');
+            [s_ts,ci_ts] = dataset.load('../../test/classifier_mostly_clear_data_3.test.mat');
+            
+            cl = classifiers.knn(s_tr,ci_tr,3);
+            cl_native = classifiers.knn(s_tr,ci_tr,3,'Exact:Native',{},2);
+            labels_idx_hat = cl.classify(s_ts,ci_ts);
+            [labels_idx_hat_native,labels_confidence_native,score_native] = cl_native.classify(s_ts,ci_ts);
+            
+            assert(check.same(labels_idx_hat_native,labels_idx_hat));
+            assert(check.same(sum(labels_confidence_native,1),ones(1,60)));
+            assert(score_native == 90);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With IVF index probing all lists.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_clear_data_3.train.mat');
+            [s_ts,ci_ts] = dataset.load('../../test/classifier_clear_data_3.test.mat');
+            
+            cl = classifiers.knn(s_tr,ci_tr,3,'IVF',{6 6},2);
+            [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = cl.classify(s_ts,ci_ts);
+            
+            assert(check.same(labels_idx_hat,ci_ts.labels_idx));
+            assert(check.same(labels_confidence,[ones(20,1) zeros(20,1) zeros(20,1);zeros(20,1) ones(20,1) zeros(20,1);zeros(20,1) zeros(20,1) ones(20,1)]'));
+            assert(score == 100);
+            assert(check.same(conf_matrix,[20 0 0; 0 20 0; 0 0 20]));
+            assert(check.empty(misclassified));
+            
+            if test_figure ~= -1
+                figure(test_figure);
+                utils.display.classification_border(cl,s_tr,s_ts,ci_tr,ci_ts,[-1 5 -1 5]);
+                pause(5);
+            end
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With IVF index probing one list.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_clear_data_3.train.mat');
+            [s_ts,ci_ts] = dataset.load('../../test/classifier_clear_data_3.test.mat');
+            
+            cl = classifiers.knn(s_tr,ci_tr,3,'IVF',{3 1 20},1);
+            [~,~,score] = cl.classify(s_ts,ci_ts);
+            
+            assert(score >= 90);
+            
+            clearvars -except test_figure;
+            
+            fprintf('  Function "index_report".\n');
+            
+            fprintf('    With all lists probed.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_unclear_data_3.train.mat');
+            s_ts = dataset.load('../../test/classifier_unclear_data_3.test.mat');
+            
+            cl = classifiers.knn(s_tr,ci_tr,5,'IVF',{8 8},2);
+            [recall,index_time,exact_time] = cl.index_report(s_ts);
+            
+            assert(recall == 1);
+            assert(index_time >= 0);
+            assert(exact_time >= 0);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With one list probed.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_unclear_data_3.train.mat');
+            s_ts = dataset.load('../../test/classifier_unclear_data_3.test.mat');
+            
+            cl = classifiers.knn(s_tr,ci_tr,5,'IVF',{8 1},2);
+            recall = cl.index_report(s_ts);
+            
+            assert(recall > 0);
+            assert(recall <= 1);
+            
+            clearvars -except test_figure;
+            
+            fprintf('  Function "nearest".\n');
+            
+            fprintf('    With a mapped dataset.\n');
+            
+            [s_tr,ci_tr] = dataset.load('../../test/classifier_unclear_data_3.train.mat');
+            s_ts = dataset.load('../../test/classifier_unclear_data_3.test.mat');
+            dataset_path = tempname();
+            
+            dataset.save_mapped(dataset_path,s_ts,-1,'Float64');
+            
+            cl = classifiers.knn(s_tr,ci_tr,5,'IVF',{8 2},2);
+            [neighbours_idx,neighbours_dist] = cl.nearest(s_ts);
+            [neighbours_idx_mapped,neighbours_dist_mapped] = cl.nearest(dataset_path);
+            
+            assert(check.same(neighbours_idx_mapped,neighbours_idx));
+            assert(check.same(neighbours_dist_mapped,neighbours_dist));
+            
+            delete(dataset_path);
+            
+            clearvars -except test_figure;
         end
     end
 end
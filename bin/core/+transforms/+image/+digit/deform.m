@@ -5,10 +5,11 @@ classdef deform < transform
         field_smoothness_factor;
         field_intensity;
         do_deforming;
+        num_workers;
     end
     
     methods (Access=public)
-        function [obj] = deform(train_sample_plain,scaling_max,rotation_max,field_smoothness_factor,field_intensity)
+        function [obj] = deform(train_sample_plain,scaling_max,rotation_max,field_smoothness_factor,field_intensity,num_workers)
             assert(check.dataset_image(train_sample_plain));
             assert(size(train_sample_plain,3) == 1); % A BIT OF A HACK
             assert(size(train_sample_plain,1) == size(train_sample_plain,2)); % A BIT OF A HACK
@@ -28,6 +29,13 @@ classdef deform < transform
             assert(check.empty(field_intensity) || field_intensity > 0);
             assert((check.empty(field_smoothness_factor) && check.empty(field_intensity)) || ...
                    (~check.empty(field_smoothness_factor) && ~check.empty(field_intensity)));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
                
             if ~check.empty(field_smoothness_factor)
                 do_deforming_t = true;
@@ -44,73 +52,27 @@ classdef deform < transform
             obj.field_smoothness_factor = field_smoothness_factor;
             obj.field_intensity = field_intensity;
             obj.do_deforming = do_deforming_t;
+            obj.num_workers = num_workers;
         end
     end
     
     methods (Access=protected)
-        function [sample_coded] = do_code(obj,sample_plain)
-            N = dataset.count(sample_plain);
-            [~,dr,dc,~] = dataset.geometry(sample_plain);
-            [col_i,row_i] = meshgrid(1:dr,1:dc);
-            log_batch_size = ceil(N / 10);
-
-            if obj.do_deforming
-                smooth_kernel = fspecial('gaussian',dr,obj.field_smoothness_factor);
-            end
-
-            sample_coded = zeros(dr,dc,1,N);
-            
-            for ii = 1:N
-                scaling_factor_row = utils.common.rand_range(1 - obj.scaling_max/100,1 + obj.scaling_max/100);
-                scaling_factor_col = utils.common.rand_range(1 - obj.scaling_max/100,1 + obj.scaling_max/100);
-                rotation_angle = utils.common.rand_range(-obj.rotation_max,obj.rotation_max);
-                
-                original_instance = sample_plain(:,:,:,ii);
-                
-                [min_row,max_row,min_col,max_col] = transforms.image.digit.deform.get_bounds(original_instance);
-                
-                resized_row_count = min(dr,transforms.image.digit.deform.ceil_to_same_parity(dr,(max_row - min_row + 1) * scaling_factor_row));
-                resized_col_count = min(dc,transforms.image.digit.deform.ceil_to_same_parity(dc,(max_col - min_col + 1) * scaling_factor_col));
-                offset_row = (dr - resized_row_count) / 2 + 1;
-                offset_col = (dc - resized_col_count) / 2 + 1;
-                
-                resized_core = imresize(original_instance(min_row:max_row,min_col:max_col),[resized_row_count resized_col_count]);
-                resized_instance = zeros(dr,dc);
-                resized_instance(offset_row:dr - offset_row + 1,offset_col:dc - offset_col + 1) = resized_core;
-                
-                rotated_instance = imrotate(resized_instance,rotation_angle,'bilinear','crop');
-                
-                if obj.do_deforming
-                    field_row_1 = utils.common.rand_range(-0.05,0.05,dr,dc);
-                    field_row_2 = conv2(field_row_1,smooth_kernel,'same');
-                    field_row_3 = field_row_2 ./ max(max(field_row_2));
-                    field_col_1 = utils.common.rand_range(-0.05,0.05,dr,dc);
-                    field_col_2 = conv2(field_col_1,smooth_kernel,'same');
-                    field_col_3 = field_col_2 ./ max(max(field_col_2));
-                    
-                    deformed_instance = interp2(col_i,row_i,rotated_instance,col_i + obj.field_intensity * field_col_3,row_i + obj.field_intensity * field_row_3,'bilinear',0);
-                else
-                    deformed_instance = rotated_instance;
-                end
-                
-                sample_coded(:,:,:,ii) = deformed_instance;
-            end
-        end
-    end
-    
-    methods (Static,Access=private)
-        function [min_row,max_row,min_col,max_col] = get_bounds(instance)
-            [~,min_row] = find(instance',1,'first');
-            [~,max_row] = find(instance',1,'last');
-            [~,min_col] = find(instance,1,'first');
-            [~,max_col] = find(instance,1,'last');
+        function [o] = is_cacheable(~)
+            % Each call draws new deformations.
+            
+            o = false;
         end
         
-        function [o] = ceil_to_same_parity(reference,num)
-            if mod(reference,2) == 0
-                o = 2 * ceil(num / 2);
+        function [sample_coded] = do_code(obj,sample_plain)
+            % Every image gets its own random stream derived from "seed", so the result does not depend on
+            % "num_workers". Scaling, rotation and the displacement field are composed into a single resampling.
+            
+            seed = randi(2^31 - 1);
+            
+            if obj.do_deforming
+                sample_coded = xtern.x_image_digit_deform(sample_plain,obj.scaling_max,obj.rotation_max,obj.field_smoothness_factor,obj.field_intensity,seed,obj.num_workers);
             else
-                o = 2 * ceil((num - 1) / 2) + 1;
+                sample_coded = xtern.x_image_digit_deform(sample_plain,obj.scaling_max,obj.rotation_max,0,0,seed,obj.num_workers);
             end
         end
     end
@@ -132,6 +94,7 @@ classdef deform < transform
             assert(t.field_smoothness_factor == 5);
             assert(t.field_intensity == 2.4);
             assert(t.do_deforming == true);
+            assert(t.num_workers == 1);
             assert(check.same(t.input_geometry,[16*16*1 16 16 1]));
             assert(check.same(t.output_geometry,[16*16*1 16 16 1]));
 
@@ -148,6 +111,7 @@ classdef deform < transform
             assert(check.same(t.field_smoothness_factor,[]));
             assert(check.same(t.field_intensity,[]));
             assert(t.do_deforming == false);
+            assert(t.num_workers == 1);
             assert(check.same(t.input_geometry,[16*16*1 16 16 1]));
             assert(check.same(t.output_geometry,[16*16*1 16 16 1]));
             
@@ -177,6 +141,43 @@ classdef deform < transform
             end
             
             clearvars -except test_figure;
+            
+            fprintf('    With field deformations.\n');
+            
+            s_1 = rand(16,16,1,16);
+            s = zeros(24,24,1,16);
+            s(5:20,5:20,:,:) = s_1;
+            
+            t = transforms.image.digit.deform(s,10,15,5,2.4);
+            
+            s_p = t.code(s);
+            
+            assert(check.tensor(s_p,4));
+            assert(check.same(size(s_p),[24 24 1 16]));
+            assert(check.number(s_p));
+            assert(all(s_p(:) >= 0));
+            assert(all(s_p(:) <= 1));
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With multiple workers.\n');
+            
+            s_1 = rand(16,16,1,16);
+            s = zeros(24,24,1,16);
+            s(5:20,5:20,:,:) = s_1;
+            
+            t_1 = transforms.image.digit.deform(s,10,15,5,2.4);
+            t_4 = transforms.image.digit.deform(s,10,15,5,2.4,4);
+            
+            rng(7);
+            s_p_1 = t_1.code(s);
+            rng(7);
+            s_p_4 = t_4.code(s);
+            
+            assert(t_4.num_workers == 4);
+            assert(check.same(s_p_1,s_p_4));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -4,10 +4,11 @@ classdef patch_extract < transform
         patch_row_count;
         patch_col_count;
         required_variance;
+        num_workers;
     end
     
     methods (Access=public)
-        function [obj] = patch_extract(train_sample_plain,patches_count,patch_row_count,patch_col_count,required_variance)
+        function [obj] = patch_extract(train_sample_plain,patches_count,patch_row_count,patch_col_count,required_variance,num_workers)
             assert(check.dataset_image(train_sample_plain));
             assert(check.scalar(patches_count));
             assert(check.natural(patches_count));
@@ -21,6 +22,13 @@ classdef patch_extract < transform
             assert(check.scalar(required_variance));
             assert(check.number(required_variance));
             assert(required_variance >= 0);
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
             
             [d dr dc dl] = dataset.geometry(train_sample_plain);
             
@@ -32,33 +40,25 @@ classdef patch_extract < transform
             obj.patch_row_count = patch_row_count;
             obj.patch_col_count = patch_col_count;
             obj.required_variance = required_variance;
+            obj.num_workers = num_workers;
         end
     end
     
     methods (Access=protected)
+        function [o] = is_cacheable(~)
+            % Each call draws new patches.
+            
+            o = false;
+        end
+        
         function [sample_coded] = do_code(obj,sample_plain)
-            N = dataset.count(sample_plain);
-            [~,dr,dc,dl] = dataset.geometry(sample_plain);
-            
-            log_batch_size = ceil(obj.patches_count / 10);
-            sample_coded = zeros(obj.patch_row_count,obj.patch_col_count,dl,obj.patches_count);
-            
-            curr_patches_count = 1;
-            
-            while curr_patches_count <= obj.patches_count
-                image_idx = randi(N);
-                row_skip = randi(dr - obj.patch_row_count + 1);
-                col_skip = randi(dc - obj.patch_col_count + 1);
-                
-                patch = sample_plain(row_skip:(row_skip + obj.patch_row_count - 1),...
-                                     col_skip:(col_skip + obj.patch_col_count - 1),...
-                                     :,image_idx);
-                
-                if var(patch(:)) >= obj.required_variance
-                    sample_coded(:,:,:,curr_patches_count) = patch;
-                    curr_patches_count = curr_patches_count + 1;
-                end
-            end
+            % Candidates are drawn natively from streams derived from one seed, which itself comes from the
+            % global MATLAB generator, so results are reproducible with "rng" and independent of "num_workers".
+            
+            seed = randi(2^31 - 1);
+            
+            sample_coded = xtern.x_image_patch_extract(sample_plain,obj.patches_count,obj.patch_row_count,obj.patch_col_count,...
+                                                       obj.required_variance,seed,obj.num_workers);
         end
     end
     
@@ -76,6 +76,7 @@ classdef patch_extract < transform
             assert(t.patch_row_count == 5);
             assert(t.patch_col_count == 5);
             assert(t.required_variance == 0.01);
+            assert(t.num_workers == 1);
             assert(check.same(t.input_geometry,[192*256*3 192 256 3]));
             assert(check.same(t.output_geometry,[5*5*3 5 5 3]));
             
@@ -101,6 +102,36 @@ classdef patch_extract < transform
             end
             
             clearvars -except test_figure;
+            
+            fprintf('    With multiple workers.\n');
+            
+            s = dataset.load('../../test/scenes_small.mat');
+            
+            t_1 = transforms.image.patch_extract(s,50,40,40,0.01);
+            t_4 = transforms.image.patch_extract(s,50,40,40,0.01,4);
+            rng(7);
+            s_p_1 = t_1.code(s);
+            rng(7);
+            s_p_4 = t_4.code(s);
+            
+            assert(t_4.num_workers == 4);
+            assert(check.same(size(s_p_4),[40 40 3 50]));
+            assert(check.same(s_p_4,s_p_1));
+            assert(check.checkf(@(ii)var(reshape(s_p_4(:,:,:,ii),[1 40*40*3])) >= 0.01,1:50));
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With high required variance.\n');
+            
+            s = dataset.load('../../test/scenes_small.mat');
+            
+            t = transforms.image.patch_extract(s,200,5,5,0.02,2);
+            s_p = t.code(s);
+            
+            assert(check.same(size(s_p),[5 5 3 200]));
+            assert(check.checkf(@(ii)var(reshape(s_p(:,:,:,ii),[1 5*5*3])) >= 0.02,1:200));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -26,14 +26,20 @@ classdef recoder < transform
         polarity_split_type;
         reduce_type;
         reduce_spread;
+        hashed_geometry;
+        channel_mode;
+        channel_code;
         num_workers;
     end
     
+    properties (Dependent,Hidden,GetAccess=public)
+        dict;
+    end
+    
     methods (Access=public)
         function [obj] = recoder(train_sample_plain,patches_count,patch_row_count,patch_col_count,patch_required_variance,do_patch_zca,...
-                                 dictionary_type,dictionary_params,nonlinear_type,nonlinear_params,polarity_split_type,reduce_type,reduce_spread,num_workers)
+                                 dictionary_type,dictionary_params,nonlinear_type,nonlinear_params,polarity_split_type,reduce_type,reduce_spread,num_workers,hashed_geometry,channel_mode)
             assert(check.dataset_image(train_sample_plain));
-            assert(size(train_sample_plain,3) == 1); % A BIT OF A HACK
             assert(check.scalar(patches_count));
             assert(check.scalar(patches_count));
             assert(check.natural(patches_count));
@@ -53,10 +59,10 @@ classdef recoder < transform
             assert(check.logical(do_patch_zca));
             assert(check.scalar(dictionary_type));
             assert(check.string(dictionary_type));
-            assert(check.one_of(dictionary_type,'Dict','Random:Filters','Random:Instances','Learn:Grad','Learn:GradSt'));
+            assert(check.one_of(dictionary_type,'Dict','Random:Filters','Random:Instances','Learn:Grad','Learn:GradSt','Learn:Online','Learn:KSVD'));
             assert((check.same(dictionary_type,'Dict') && check.matrix(dictionary_params{1}) && ...
-                   (size(dictionary_params{1},2) == patch_row_count * patch_col_count) && check.number(dictionary_params{1})) || ...
-                   (check.one_of(dictionary_type,'Random:Filters','Random:Instances','Learn:Grad','Learn:GradSt') && ...
+                   (mod(size(dictionary_params{1},2),patch_row_count * patch_col_count) == 0) && check.number(dictionary_params{1})) || ...
+                   (check.one_of(dictionary_type,'Random:Filters','Random:Instances','Learn:Grad','Learn:GradSt','Learn:Online','Learn:KSVD') && ...
                     check.scalar(dictionary_params{1}) && check.natural(dictionary_params{1}) && dictionary_params{1} >= 1));
             assert(check.vector(dictionary_params));
             assert(length(dictionary_params) >= 4);
@@ -89,12 +95,44 @@ classdef recoder < transform
             assert(check.scalar(num_workers));
             assert(check.natural(num_workers));
             assert(num_workers >= 1);
+            assert(~exist('hashed_geometry','var') || check.scalar(hashed_geometry));
+            assert(~exist('hashed_geometry','var') || check.natural(hashed_geometry));
+            assert(~exist('hashed_geometry','var') || (hashed_geometry <= 2^32)); % Native coders keep 32 bit feature indices.
+            assert(~exist('channel_mode','var') || check.scalar(channel_mode));
+            assert(~exist('channel_mode','var') || check.string(channel_mode));
+            assert(~exist('channel_mode','var') || check.one_of(channel_mode,'Joint','PerChannel'));
+            
+            if ~exist('hashed_geometry','var')
+                hashed_geometry = 0;
+            end
+            
+            if ~exist('channel_mode','var')
+                channel_mode = 'Joint';
+            end
+            
+            [d,dr,dc,dl] = dataset.geometry(train_sample_plain);
+            
+            % With "Joint" channels, patches span all the layers of an image and are coded with one dictionary. With
+            % "PerChannel" channels, each layer is coded with its own dictionary, and a "Dict" holds the words of the
+            % first layer's dictionary, followed by those of the second one, and so on.
+            
+            if check.same(channel_mode,'Joint')
+                channel_code_t = 0;
+                channel_count_t = 1;
+            elseif check.same(channel_mode,'PerChannel')
+                channel_code_t = 1;
+                channel_count_t = dl;
+            else
+                assert(false);
+            end
             
-            [d,dr,dc,~] = dataset.geometry(train_sample_plain);
+            assert(~check.same(dictionary_type,'Dict') || ...
+                   ((size(dictionary_params{1},2) == patch_row_count * patch_col_count * dl / channel_count_t) && ...
+                    (mod(size(dictionary_params{1},1),channel_count_t) == 0)));
             
             if check.same(dictionary_type,'Dict')
                 dictionary_ctor_fn_t = @transforms.record.dictionary;
-                word_count_t = size(dictionary_params{1},1);
+                word_count_t = size(dictionary_params{1},1) / channel_count_t;
             elseif check.same(dictionary_type,'Random:Filters')
                 dictionary_ctor_fn_t = @transforms.record.dictionary.random.filters;
                 word_count_t = dictionary_params{1};
@@ -107,6 +145,12 @@ classdef recoder < transform
             elseif check.same(dictionary_type,'Learn:GradSt')
                 dictionary_ctor_fn_t = @transforms.record.dictionary.learn.grad_st;
                 word_count_t = dictionary_params{1};
+            elseif check.same(dictionary_type,'Learn:Online')
+                dictionary_ctor_fn_t = @transforms.record.dictionary.learn.online;
+                word_count_t = dictionary_params{1};
+            elseif check.same(dictionary_type,'Learn:KSVD')
+                dictionary_ctor_fn_t = @transforms.record.dictionary.learn.ksvd;
+                word_count_t = dictionary_params{1};
             else
                 assert(false);
             end
@@ -171,23 +215,49 @@ classdef recoder < transform
             aftreduce_row_count_t = aftcoding_row_count_t / reduce_spread;
             aftreduce_col_count_t = aftcoding_col_count_t / reduce_spread;
             
-            t_patches = transforms.image.patch_extract(train_sample_plain,patches_count,patch_row_count,patch_col_count,patch_required_variance);
+            t_patches = transforms.image.patch_extract(train_sample_plain,patches_count,patch_row_count,patch_col_count,patch_required_variance,num_workers);
             patches_1 = t_patches.code(train_sample_plain);
             patches_2 = dataset.flatten_image(patches_1);
-            patches_3 = bsxfun(@minus,patches_2,mean(patches_2,1));
+            layer_geometry = size(patches_2,1) / channel_count_t;
+            t_zca_t = cell(1,channel_count_t);
+            t_dictionary_t = cell(1,channel_count_t);
             
-            if do_patch_zca
-                t_zca_t = transforms.record.zca(patches_3);
-                patches_4 = t_zca_t.code(patches_3);
-            else
-                t_zca_t = {};
-                patches_4 = patches_3;
+            for ll = 1:channel_count_t
+                patches_3 = patches_2((ll - 1) * layer_geometry + 1:ll * layer_geometry,:);
+                patches_3 = bsxfun(@minus,patches_3,mean(patches_3,1));
+                
+                if do_patch_zca
+                    t_zca_t{ll} = transforms.record.zca(patches_3);
+                    patches_4 = t_zca_t{ll}.code(patches_3);
+                else
+                    t_zca_t{ll} = {};
+                    patches_4 = patches_3;
+                end
+                
+                dictionary_params_t = dictionary_params;
+                
+                if check.same(dictionary_type,'Dict')
+                    dictionary_params_t{1} = dictionary_params{1}((ll - 1) * word_count_t + 1:ll * word_count_t,:);
+                end
+                
+                t_dictionary_t{ll} = dictionary_ctor_fn_t(patches_4,dictionary_params_t{:});
+            end
+            
+            if channel_count_t == 1
+                t_zca_t = t_zca_t{1};
+                t_dictionary_t = t_dictionary_t{1};
             end
-
-            t_dictionary_t = dictionary_ctor_fn_t(patches_4,dictionary_params{:});
             
-            input_geometry = [d,dr,dc,1];
-            output_geometry = polarity_split_multiplier_t * aftreduce_row_count_t * aftreduce_col_count_t * word_count_t;
+            input_geometry = [d,dr,dc,dl];
+            
+            % With a nonzero "hashed_geometry", every (cell,word,polarity) feature is hashed into one of that many
+            % signed buckets, and the output geometry no longer depends on the image size or dictionary.
+            
+            if hashed_geometry ~= 0
+                output_geometry = hashed_geometry;
+            else
+                output_geometry = polarity_split_multiplier_t * aftreduce_row_count_t * aftreduce_col_count_t * word_count_t * channel_count_t;
+            end
             
             obj = obj@transform(input_geometry,output_geometry);
             obj.dictionary_ctor_fn = dictionary_ctor_fn_t;
@@ -216,22 +286,170 @@ classdef recoder < transform
             obj.polarity_split_type = polarity_split_type;
             obj.reduce_type = reduce_type;
             obj.reduce_spread = reduce_spread;
+            obj.hashed_geometry = hashed_geometry;
+            obj.channel_mode = channel_mode;
+            obj.channel_code = channel_code_t;
             obj.num_workers = num_workers;
         end
+        
+        function [dict] = get.dict(obj)
+            % With "PerChannel" channels, the dictionaries of the layers are stacked, as a "Dict" dictionary is.
+            
+            if iscell(obj.t_dictionary)
+                dict = cell2mat(cellfun(@(t)t.dict,obj.t_dictionary','UniformOutput',false));
+            else
+                dict = obj.t_dictionary.dict;
+            end
+        end
+        
+        function [sample_coded] = code_file(obj,dataset_path)
+            assert(check.scalar(obj));
+            assert(check.scalar(dataset_path));
+            assert(check.string(dataset_path));
+            
+            % The mapped dataset is read by the workers directly, so it never needs to fit in memory.
+            
+            geometry = dataset.mapped_info(dataset_path);
+            
+            assert(dataset.geom_compatible(obj.input_geometry,geometry));
+            
+            sample_coded = obj.code_native(geometry(2),geometry(3),dataset_path);
+        end
+        
+        function [] = code_stream(obj,sample_plain,coded_path,chunk_count,compress_idx,value_encoding)
+            assert(check.scalar(obj));
+            assert(check.dataset_image(sample_plain) || (check.scalar(sample_plain) && check.string(sample_plain)));
+            assert(check.scalar(coded_path));
+            assert(check.string(coded_path));
+            assert(check.scalar(chunk_count));
+            assert(check.natural(chunk_count));
+            assert(chunk_count >= 1);
+            assert(~exist('compress_idx','var') || check.scalar(compress_idx));
+            assert(~exist('compress_idx','var') || check.logical(compress_idx));
+            assert(~exist('value_encoding','var') || check.scalar(value_encoding));
+            assert(~exist('value_encoding','var') || check.string(value_encoding));
+            assert(~exist('value_encoding','var') || check.one_of(value_encoding,'Float64','Float16','Int8','Codebook'));
+            
+            if ~exist('compress_idx','var')
+                compress_idx = false;
+            end
+            
+            if ~exist('value_encoding','var')
+                value_encoding = 'Float64';
+            end
+            
+            % Observations are coded "chunk_count" at a time and each chunk is appended to "coded_path" as soon as it is
+            % done, so neither the plain sample, when it is a mapped dataset, nor the coded one is ever fully in memory.
+            
+            if check.string(sample_plain)
+                geometry = dataset.mapped_info(sample_plain);
+                sample_plain_flattened = sample_plain;
+            else
+                geometry = dataset.geometry(sample_plain);
+                sample_plain_flattened = reshape(sample_plain,geometry(1),[]);
+            end
+            
+            assert(dataset.geom_compatible(obj.input_geometry,geometry));
+            
+            [dict_ids,coeff_count,coding_params_cell] = obj.native_dictionaries();
+            
+            xtern.x_image_recoder_code_stream(geometry(2),geometry(3),obj.patch_row_count,obj.patch_col_count,obj.channel_code,...
+                                              obj.coding_code,dict_ids,[],[],coeff_count,coding_params_cell{:},...
+                                              obj.nonlinear_code,obj.nonlinear_modulator,obj.polarity_split_code,obj.reduce_code,obj.reduce_spread,obj.hashed_geometry,...
+                                              sample_plain_flattened,coded_path,chunk_count,double(compress_idx),...
+                                              dataset.coded_value_encoding_code(value_encoding),obj.num_workers);
+        end
+        
+        function [classifiers_decisions] = code_classify(obj,sample_plain,model_weights,feature_ids)
+            assert(check.scalar(obj));
+            assert(check.dataset_image(sample_plain) || (check.scalar(sample_plain) && check.string(sample_plain)));
+            assert(check.matrix(model_weights));
+            assert(check.number(model_weights));
+            assert(~exist('feature_ids','var') || check.empty(feature_ids) || check.vector(feature_ids));
+            assert(~exist('feature_ids','var') || check.empty(feature_ids) || check.natural(feature_ids));
+            assert(~exist('feature_ids','var') || check.empty(feature_ids) || check.checkv(feature_ids >= 1 & feature_ids <= obj.output_geometry));
+            assert(~exist('feature_ids','var') || check.empty(feature_ids) || check.checkv(diff(feature_ids) > 0));
+            
+            if ~exist('feature_ids','var')
+                feature_ids = [];
+            end
+            
+            assert((check.empty(feature_ids) && (size(model_weights,1) == obj.output_geometry + 1)) || ...
+                   (~check.empty(feature_ids) && (size(model_weights,1) == length(feature_ids) + 1)));
+            
+            % Every observation is coded and reduced to the decisions of the linear classifiers in "model_weights",
+            % one per column, right away. The coded sample is never built, permuted or handed back to MATLAB. With
+            % "feature_ids", the classifiers were trained on a compacted sample, and coded observations are compacted
+            % to the same features first.
+            
+            if check.string(sample_plain)
+                geometry = dataset.mapped_info(sample_plain);
+                sample_plain_flattened = sample_plain;
+            else
+                geometry = dataset.geometry(sample_plain);
+                sample_plain_flattened = reshape(sample_plain,geometry(1),[]);
+            end
+            
+            assert(dataset.geom_compatible(obj.input_geometry,geometry));
+            
+            [dict_ids,coeff_count,coding_params_cell] = obj.native_dictionaries();
+            
+            classifiers_decisions = ...
+                xtern.x_image_recoder_classify(geometry(2),geometry(3),obj.patch_row_count,obj.patch_col_count,obj.channel_code,...
+                                               obj.coding_code,dict_ids,[],[],coeff_count,coding_params_cell{:},...
+                                               obj.nonlinear_code,obj.nonlinear_modulator,obj.polarity_split_code,obj.reduce_code,obj.reduce_spread,obj.hashed_geometry,...
+                                               sample_plain_flattened,model_weights,feature_ids,obj.num_workers);
+        end
     end
     
     methods (Access=protected)
         function [sample_coded] = do_code(obj,sample_plain)
             [d,dr,dc,~] = dataset.geometry(sample_plain);
             sample_plain_flattened = reshape(sample_plain,d,[]);
+            sample_coded = obj.code_native(dr,dc,sample_plain_flattened);
+        end
+        
+        function [sample_coded] = code_native(obj,dr,dc,sample_plain)
+            % With fewer images than workers, the idle workers would be wasted, so every image is split into row bands,
+            % which are coded in parallel instead.
+            
+            if check.string(sample_plain)
+                [~,N] = dataset.mapped_info(sample_plain);
+            else
+                N = size(sample_plain,2);
+            end
+            
+            if N < obj.num_workers
+                max_band_count = obj.num_workers;
+            else
+                max_band_count = 1;
+            end
+            
+            [dict_ids,coeff_count,coding_params_cell] = obj.native_dictionaries();
+            
             [sample_coded_t,observations_perm] = ...
-                xtern.x_image_recoder_code(dr,dc,obj.patch_row_count,obj.patch_col_count,...
-                                           obj.coding_code,obj.t_dictionary.dict,obj.t_dictionary.dict_transp,obj.t_dictionary.dict_x_dict_transp,...
-                                           obj.t_dictionary.coeff_count,obj.t_dictionary.coding_params_cell{:},...
-                                           obj.nonlinear_code,obj.nonlinear_modulator,obj.polarity_split_code,obj.reduce_code,obj.reduce_spread,...
-                                           sample_plain_flattened,obj.num_workers);
+                xtern.x_image_recoder_code(dr,dc,obj.patch_row_count,obj.patch_col_count,obj.channel_code,...
+                                           obj.coding_code,dict_ids,[],[],coeff_count,coding_params_cell{:},...
+                                           obj.nonlinear_code,obj.nonlinear_modulator,obj.polarity_split_code,obj.reduce_code,obj.reduce_spread,obj.hashed_geometry,...
+                                           sample_plain,max_band_count,obj.num_workers);
             sample_coded(:,observations_perm+1) = sample_coded_t;
         end
+        
+        function [dict_ids,coeff_count,coding_params_cell] = native_dictionaries(obj)
+            % The native coders get the handles of all the dictionaries, in layer order, and stack them themselves. All
+            % of them share the coding method and its parameters.
+            
+            if iscell(obj.t_dictionary)
+                dict_ids = cellfun(@(t)t.dict_handle.id,obj.t_dictionary);
+                t_first = obj.t_dictionary{1};
+            else
+                dict_ids = obj.t_dictionary.dict_handle.id;
+                t_first = obj.t_dictionary;
+            end
+            
+            coeff_count = t_first.coeff_count;
+            coding_params_cell = t_first.coding_params_cell;
+        end
     end
     
     methods (Static,Access=public)
@@ -244,7 +462,24 @@ classdef recoder < transform
             
             fprintf('  Function "code".\n');
             
-            fprintf('    NOT YET TESTED.\n');
+            fprintf('    With hashed features.\n');
+            
+            s = dataset.load('../../data/mnist.train.mat');
+            s = dataset.subsample(s,1:20);
+            rng(7);
+            dict = randn(32,5*5);
+            
+            t_1 = transforms.image.recoder(s,100,5,5,0.01,false,'Dict',{dict 'Corr' [] 4 1},'Linear',[],'KeepSign','MaxNoSign',4,1,1024);
+            t_4 = transforms.image.recoder(s,100,5,5,0.01,false,'Dict',{dict 'Corr' [] 4 1},'Linear',[],'KeepSign','MaxNoSign',4,4,1024);
+            s_c_1 = t_1.code(s);
+            s_c_4 = t_4.code(s);
+            
+            assert(t_1.hashed_geometry == 1024);
+            assert(t_1.output_geometry == 1024);
+            assert(check.same(size(s_c_1),[1024 20]));
+            assert(check.same(s_c_4,s_c_1));
+            
+            clearvars -except test_figure;
         end
     end
 end
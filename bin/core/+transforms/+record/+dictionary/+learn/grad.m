@@ -48,10 +48,12 @@ classdef grad < transforms.record.dictionary
                 diff = train_sample_plain - dict_transp * coeffs;
                 delta_dict = coeffs * diff';
                 
-                dict = dict + (learning_rate_schedule(iter) / N) * delta_dict;
-                dict = transforms.record.dictionary.normalize_dict(dict);
+                changed_idx = find(any(coeffs,2))';
+                
+                dict(changed_idx,:) = dict(changed_idx,:) + (learning_rate_schedule(iter) / N) * delta_dict(changed_idx,:);
+                dict(changed_idx,:) = transforms.record.dictionary.normalize_dict(dict(changed_idx,:));
                 dict_transp = dict';
-                dict_x_dict_transp = dict * dict_transp;
+                dict_x_dict_transp = transforms.record.dictionary.refresh_gram(dict_x_dict_transp,dict,changed_idx);
                 
                 mean_error = mean(sum((diff .^ 2)));
                 saved_mse_t(iter) = mean_error;
@@ -55,9 +55,12 @@ classdef grad_st < transforms.record.dictionary
                 diff = iter_sample - dict_transp * coeffs;
                 delta_dict = coeffs * diff';
 
-                dict = dict + (learning_rate_schedule(iter) / selection_size) * delta_dict;
-                dict = transforms.record.dictionary.normalize_dict(dict);
+                changed_idx = find(any(coeffs,2))';
+                
+                dict(changed_idx,:) = dict(changed_idx,:) + (learning_rate_schedule(iter) / selection_size) * delta_dict(changed_idx,:);
+                dict(changed_idx,:) = transforms.record.dictionary.normalize_dict(dict(changed_idx,:));
                 dict_transp = dict';
+                dict_x_dict_transp = transforms.record.dictionary.refresh_gram(dict_x_dict_transp,dict,changed_idx);
                 
                 mean_error = sum(mean((diff .^ 2)));
                 saved_mse_t(iter) = mean_error;
@@ -7,10 +7,11 @@ classdef neural_gas < transforms.record.dictionary
         initial_neight_size;
         final_neight_size;
         max_iter_count;
+        do_display;
     end
     
     methods (Access=public)
-        function [obj] = neural_gas(train_sample_plain,word_count,coding_method,coding_params,coeff_count,num_workers,version,initial_learn_rate,final_learn_rate,initial_neight_size,final_neight_size,max_iter_count)
+        function [obj] = neural_gas(train_sample_plain,word_count,coding_method,coding_params,coeff_count,num_workers,version,initial_learn_rate,final_learn_rate,initial_neight_size,final_neight_size,max_iter_count,do_display)
             assert(check.dataset_record(train_sample_plain));
             assert(check.scalar(word_count));
             assert(check.natural(word_count));
@@ -25,7 +26,7 @@ classdef neural_gas < transforms.record.dictionary
             assert(num_workers >= 1);
             assert(check.scalar(version));
             assert(check.string(version));
-            assert(check.one_of(version,'V1','V2'));
+            assert(check.one_of(version,'V1'));
             assert(check.scalar(initial_learn_rate));
             assert(check.number(initial_learn_rate));
             assert(initial_learn_rate > 0);
@@ -40,49 +41,38 @@ classdef neural_gas < transforms.record.dictionary
             assert(final_neight_size > 0);
             assert(final_learn_rate <= initial_learn_rate);
             assert(final_neight_size <= initial_neight_size);
+            assert(check.scalar(max_iter_count));
+            assert(check.natural(max_iter_count));
+            assert(max_iter_count >= 1);
+            assert(~exist('do_display','var') || check.scalar(do_display));
+            assert(~exist('do_display','var') || check.logical(do_display));
+            
+            if ~exist('do_display','var')
+                do_display = false;
+            end
 
-            coding_fn_t = transforms.record.dictionary.coding_setup(coding_method);
-
-            N = dataset.count(train_sample_plain);
+            % The whole schedule runs natively. Each iteration moves only the atoms used to code the chosen observation,
+            % ranked by the magnitude of their coefficients, and keeps the Gram matrix current for them.
+            
             d = dataset.geometry(train_sample_plain);
-            dict = transforms.record.dictionary.normalize_dict(utils.common.rand_range(-1,1,word_count,d));
-            dict_transp = dict';
-            dict_x_dict_transp = dict * dict_transp;
-            saved_mse_t = zeros(1,max_iter_count);
+            initial_dict = utils.common.rand_range(-1,1,word_count,d);
+            initial_dict = transforms.record.dictionary.normalize_dict(initial_dict);
+            coding_code = transforms.record.dictionary.coding_setup_code(coding_method);
             learn_rate_sch = utils.common.schedule(initial_learn_rate,final_learn_rate,max_iter_count);
             neight_size_sch = utils.common.schedule(initial_neight_size,final_neight_size,max_iter_count);
-            ranks = zeros(1,word_count);
-
-            if check.same(version,'V1')
-                for iter = 1:max_iter_count
-                    target_observation = train_sample_plain(:,randi(N));
-                    
-                    similarities = coding_fn_t(dict,dict_transp,dict_x_dict_transp,coding_params,coeff_count,target_observation,num_workers);
-                    [~,sorted_similarities_idx] = sort(-abs(similarities),'ascend');
-                    ranks(sorted_similarities_idx) = 1:word_count;
-                    similarities_big = repmat(similarities,1,d);
-                    diff = repmat(target_observation',word_count,1) - similarities_big .* dict;
-                    scaling = repmat((2.71828183 .^ (-ranks / neight_size_sch(iter)))',1,d);
-                    dict = dict + learn_rate_sch(iter) * scaling .* similarities_big .* diff;
-                    dict = transforms.record.dictionary.normalize_dict(dict);
-                    dict_transp = dict';
-                    
-                    saved_mse_t(iter) = norm(target_observation - dict_transp * similarities);
-                    
-                    if mod(iter-1,100) == 0
-                        sz = sqrt(size(dict,2));
-                        subplot(2,1,1);
-                        utils.display.dictionary(dict,sz,sz);
-                        subplot(2,1,2);
-                        plot(saved_mse_t);
-                        axis([1 max_iter_count 0 max(saved_mse_t)]);
-                        pause(0.1);
-                    end
-                end
-            elseif check.same(version,'V2');
-                assert(false);
-            else
-                assert(false);
+            seed = randi(2^31 - 1);
+            
+            [dict,saved_mse_t] = xtern.x_dictionary_learn_neural_gas(full(train_sample_plain),initial_dict,coding_code,coding_params,coeff_count,...
+                                                                     learn_rate_sch,neight_size_sch,seed);
+            
+            if do_display
+                sz = sqrt(d);
+                subplot(2,1,1);
+                utils.display.dictionary(dict,sz,sz);
+                subplot(2,1,2);
+                plot(saved_mse_t);
+                axis([1 max_iter_count 0 max(saved_mse_t)]);
+                pause(0.1);
             end
             
             obj = obj@transforms.record.dictionary(train_sample_plain,dict,coding_method,coding_params,coeff_count,num_workers);
@@ -93,6 +83,7 @@ classdef neural_gas < transforms.record.dictionary
             obj.initial_neight_size = initial_neight_size;
             obj.final_neight_size = final_neight_size;
             obj.max_iter_count = max_iter_count;
+            obj.do_display = do_display;
         end
     end
     
@@ -102,7 +93,56 @@ classdef neural_gas < transforms.record.dictionary
             
             fprintf('  Proper construction.\n');
             
-            fprintf('    NOT YET TESTED!\n');
+            s = dataset.load('../../test/three_component_cloud.mat');
+
+            t = transforms.record.dictionary.learn.neural_gas(s,3,'MP',[],1,1,'V1',0.5,0.01,1,0.1,1000);
+            
+            assert(check.vector(t.saved_mse));
+            assert(length(t.saved_mse) == 1000);
+            assert(check.number(t.saved_mse));
+            assert(check.checkv(t.saved_mse >= 0));
+            assert(check.same(t.version,'V1'));
+            assert(t.initial_learn_rate == 0.5);
+            assert(t.final_learn_rate == 0.01);
+            assert(t.initial_neight_size == 1);
+            assert(t.final_neight_size == 0.1);
+            assert(t.max_iter_count == 1000);
+            assert(t.do_display == false);
+            assert(check.matrix(t.dict));
+            assert(check.same(size(t.dict),[3 2]));
+            assert(check.number(t.dict));
+            assert(check.checkf(@(ii)check.same(norm(t.dict(ii,:)),1),1:3));
+            assert(check.matrix(t.dict_transp));
+            assert(check.same(size(t.dict_transp),[2 3]));
+            assert(check.number(t.dict_transp));
+            assert(check.checkf(@(ii)check.same(norm(t.dict_transp(:,ii)),1),1:3));
+            assert(check.same(t.dict_transp,t.dict'));
+            assert(t.word_count == 3);
+            assert(check.same(t.coding_fn,@xtern.x_dictionary_matching_pursuit));
+            assert(check.same(t.coding_params_cell,{[]}));
+            assert(check.same(t.coding_method,'MP'));
+            assert(check.same(t.coding_params,[]));
+            assert(t.coeff_count == 1);
+            assert(t.num_workers == 1);
+            assert(check.same(t.input_geometry,2));
+            assert(check.same(t.output_geometry,3));
+            
+            clearvars -except test_figure;
+            
+            fprintf('  With "OMP" and two coefficients.\n');
+            
+            s = dataset.load('../../test/three_component_cloud.mat');
+            
+            rng(7);
+            t_1 = transforms.record.dictionary.learn.neural_gas(s,3,'OMP',[],2,1,'V1',0.5,0.01,1,0.1,200);
+            rng(7);
+            t_2 = transforms.record.dictionary.learn.neural_gas(s,3,'OMP',[],2,1,'V1',0.5,0.01,1,0.1,200);
+            
+            assert(check.checkf(@(ii)check.same(norm(t_1.dict(ii,:)),1),1:3));
+            assert(check.same(t_1.dict,t_2.dict));
+            assert(check.same(t_1.saved_mse,t_2.saved_mse));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -0,0 +1,131 @@
+classdef online < transforms.record.dictionary
+    properties (GetAccess=public,SetAccess=immutable)
+        saved_mse;
+        batch_size;
+        max_iter_count;
+    end
+
+    methods (Access=public)
+        function [obj] = online(train_sample_plain,word_count,coding_method,coding_params,coeff_count,num_workers,batch_size,max_iter_count)
+            assert(check.dataset_record(train_sample_plain));
+            assert(check.scalar(word_count));
+            assert(check.natural(word_count));
+            assert(word_count >= 1);
+            assert(transforms.record.dictionary.coding_setup_ok(coding_method,coding_params));
+            assert(check.scalar(coeff_count));
+            assert(check.natural(coeff_count));
+            assert(coeff_count >= 1);
+            assert(coeff_count <= word_count);
+            assert(check.scalar(num_workers));
+            assert(check.natural(num_workers));
+            assert(num_workers >= 1);
+            assert(check.scalar(batch_size));
+            assert(check.natural(batch_size));
+            assert(batch_size >= 1);
+            assert(check.scalar(max_iter_count));
+            assert(check.natural(max_iter_count));
+            assert(max_iter_count >= 1);
+            
+            % Each iteration codes one mini-batch and updates the atoms from the running statistics of all codes seen
+            % so far, so the cost of an iteration depends on "batch_size" and not on the size of the sample.
+            
+            d = dataset.geometry(train_sample_plain);
+            initial_dict = utils.common.rand_range(-1,1,word_count,d);
+            initial_dict = transforms.record.dictionary.normalize_dict(initial_dict);
+            coding_code = transforms.record.dictionary.coding_setup_code(coding_method);
+            seed = randi(2^31 - 1);
+            
+            [dict,saved_mse_t] = xtern.x_dictionary_learn_online(full(train_sample_plain),initial_dict,coding_code,coding_params,coeff_count,...
+                                                                 batch_size,max_iter_count,seed,num_workers);
+            
+            obj = obj@transforms.record.dictionary(train_sample_plain,dict,coding_method,coding_params,coeff_count,num_workers);
+            obj.saved_mse = saved_mse_t;
+            obj.batch_size = batch_size;
+            obj.max_iter_count = max_iter_count;
+        end
+    end
+    
+    methods (Static,Access=public)
+        function test(test_figure)
+            fprintf('Testing "transforms.record.dictionary.learn.online".\n');
+            
+            fprintf('  Proper construction.\n');
+            
+            s = dataset.load('../../test/three_component_cloud.mat');
+
+            t = transforms.record.dictionary.learn.online(s,3,'MP',[],1,2,64,100);
+            
+            assert(check.vector(t.saved_mse));
+            assert(length(t.saved_mse) == 100);
+            assert(check.number(t.saved_mse));
+            assert(check.checkv(t.saved_mse > 0));
+            assert(mean(t.saved_mse(91:100)) <= mean(t.saved_mse(1:10)));
+            assert(t.batch_size == 64);
+            assert(t.max_iter_count == 100);
+            assert(check.matrix(t.dict));
+            assert(check.same(size(t.dict),[3 2]));
+            assert(check.number(t.dict));
+            assert(check.checkf(@(ii)check.same(norm(t.dict(ii,:)),1),1:3));
+            assert(check.matrix(t.dict_transp));
+            assert(check.same(size(t.dict_transp),[2 3]));
+            assert(check.number(t.dict_transp));
+            assert(check.checkf(@(ii)check.same(norm(t.dict_transp(:,ii)),1),1:3));
+            assert(check.same(t.dict_transp,t.dict'));
+            assert(t.word_count == 3);
+            assert(check.same(t.coding_fn,@xtern.x_dictionary_matching_pursuit));
+            assert(check.same(t.coding_params_cell,{[]}));
+            assert(check.same(t.coding_method,'MP'));
+            assert(check.same(t.coding_params,[]));
+            assert(t.coeff_count == 1);
+            assert(t.num_workers == 2);
+            assert(check.same(t.input_geometry,2));
+            assert(check.same(t.output_geometry,3));
+
+            s_p = t.code(s);
+            s_r = t.dict_transp * s_p;
+
+            if test_figure ~= -1
+                figure(test_figure);
+                clf(gcf());
+                subplot(1,3,1);
+                hold on;
+                scatter(s(1,:),s(2,:),'o','b');
+                line([0;t.dict(1,1)],[0;t.dict(1,2)],'Color','r','LineWidth',3);
+                line([0;t.dict(2,1)],[0;t.dict(2,2)],'Color','r','LineWidth',3);
+                line([0;t.dict(3,1)],[0;t.dict(3,2)],'Color','r','LineWidth',3);
+                hold off;
+                axis([-7 7 -7 7]);
+                axis('square');
+                title('Original samples.');
+                hold off;
+                subplot(1,3,2);
+                scatter3(s_p(1,:),s_p(2,:),s_p(3,:),'o','b');
+                axis([-7 7 -7 7 -7 7]);
+                axis('square');
+                title('Coded samples.');
+                subplot(1,3,3);
+                scatter(s_r(1,:),s_r(2,:),'o','b');
+                axis([-7 7 -7 7]);
+                axis('square');
+                title('Restored samples.');
+                pause(5);
+            end
+            
+            clearvars -except test_figure;
+            
+            fprintf('  With multiple workers.\n');
+            
+            s = dataset.load('../../test/three_component_cloud.mat');
+            
+            rng(7);
+            t_1 = transforms.record.dictionary.learn.online(s,3,'OMP',[],2,1,64,20);
+            rng(7);
+            t_4 = transforms.record.dictionary.learn.online(s,3,'OMP',[],2,4,64,20);
+            
+            assert(check.same(t_1.dict,t_4.dict));
+            assert(check.same(t_1.saved_mse,t_4.saved_mse));
+            
+            clearvars -except test_figure;
+        end
+    end
+end
@@ -1,8 +1,6 @@
 classdef dictionary < transform
     properties (GetAccess=public,SetAccess=immutable)
         dict;
-        dict_transp;
-        dict_x_dict_transp;
         word_count;
         coding_fn;
         coding_params_cell;
@@ -11,6 +9,15 @@ classdef dictionary < transform
         coeff_count;
         num_workers;
     end
+    
+    properties (Hidden,GetAccess=public,SetAccess=immutable)
+        dict_handle;
+    end
+    
+    properties (Dependent,Hidden,GetAccess=public)
+        dict_transp;
+        dict_x_dict_transp;
+    end
 
     methods (Access=public)
         function [obj] = dictionary(train_sample_plain,dict,coding_method,coding_params,coeff_count,num_workers)
@@ -26,9 +33,12 @@ classdef dictionary < transform
             assert(check.natural(num_workers));
             assert(num_workers >= 1);
             
+            % The transpose and the Gram matrix are kept only on the native side, where they are built once, when the
+            % dictionary is registered, and then shared by every coding call. "dict_transp" and "dict_x_dict_transp"
+            % are recomputed on access. The handle is hidden, so cache keys still depend on the public properties only.
+            
             dict_t = transforms.record.dictionary.normalize_dict(dict);
-            dict_transp_t = dict_t';
-            dict_x_dict_transp_t = dict_t * dict_transp_t;
+            dict_handle_t = utils.dictionary_handle(dict_t);
             word_count_t = size(dict,1);
             [coding_fn_t,coding_params_cell_t] = transforms.record.dictionary.coding_setup(coding_method,coding_params);
             
@@ -37,8 +47,7 @@ classdef dictionary < transform
 
             obj = obj@transform(input_geometry,output_geometry);
             obj.dict = dict_t;
-            obj.dict_transp = dict_transp_t;
-            obj.dict_x_dict_transp = dict_x_dict_transp_t;
+            obj.dict_handle = dict_handle_t;
             obj.word_count = word_count_t;
             obj.coding_fn = coding_fn_t;
             obj.coding_params_cell = coding_params_cell_t;
@@ -49,9 +58,19 @@ classdef dictionary < transform
         end
     end
     
+    methods
+        function [dict_transp] = get.dict_transp(obj)
+            dict_transp = obj.dict';
+        end
+        
+        function [dict_x_dict_transp] = get.dict_x_dict_transp(obj)
+            dict_x_dict_transp = obj.dict * obj.dict';
+        end
+    end
+    
     methods (Access=protected)
         function [sample_coded] = do_code(obj,sample_plain,~)
-            sample_coded = obj.coding_fn(obj.dict,obj.dict_transp,obj.dict_x_dict_transp,obj.coding_params_cell{:},obj.coeff_count,sample_plain,obj.num_workers);
+            sample_coded = obj.coding_fn(obj.dict_handle.id,[],[],obj.coding_params_cell{:},obj.coeff_count,sample_plain,obj.num_workers);
         end
     end
     
@@ -90,9 +109,38 @@ classdef dictionary < transform
             end
         end
 
+        function [coding_code] = coding_setup_code(coding_method)
+            if check.same(coding_method,'Corr')
+                coding_code = 0;
+            elseif check.same(coding_method,'MP')
+                coding_code = 1;
+            elseif check.same(coding_method,'OMP')
+                coding_code = 2;
+            elseif check.same(coding_method,'OOMP')
+                coding_code = 3;
+            elseif check.same(coding_method,'SparseNet')
+                coding_code = 4;
+            else
+                assert(false);
+            end
+        end
+
         function [norm_dict] = normalize_dict(dict)
             norm_dict = dict ./ repmat(sqrt(sum(dict .^ 2,2)),1,size(dict,2));
         end
+
+        function [dict_x_dict_transp] = refresh_gram(dict_x_dict_transp,dict,changed_idx)
+            % Only the rows and columns of the changed atoms move. Once about half the atoms changed, a single full
+            % product is cheaper than refreshing them one at a time.
+            
+            if 2 * length(changed_idx) >= size(dict,1)
+                dict_x_dict_transp = dict * dict';
+            else
+                changed_gram = dict * dict(changed_idx,:)';
+                dict_x_dict_transp(:,changed_idx) = changed_gram;
+                dict_x_dict_transp(changed_idx,:) = changed_gram';
+            end
+        end
     end
     
     methods (Static,Access=public)
@@ -1209,6 +1257,30 @@ classdef dictionary < transform
             
             clearvars -except test_figure;
             
+            fprintf('  Function "refresh_gram".\n');
+            
+            fprintf('    With few changed atoms.\n');
+            
+            dict = transforms.record.dictionary.normalize_dict(rand(8,5) - 0.5);
+            dict_x_dict_transp = dict * dict';
+            dict([2 7],:) = transforms.record.dictionary.normalize_dict(rand(2,5) - 0.5);
+            dict_x_dict_transp = transforms.record.dictionary.refresh_gram(dict_x_dict_transp,dict,[2 7]);
+            
+            assert(check.same(dict_x_dict_transp,dict * dict',1e-12));
+            assert(check.same(dict_x_dict_transp,dict_x_dict_transp'));
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With many changed atoms.\n');
+            
+            dict = transforms.record.dictionary.normalize_dict(rand(8,5) - 0.5);
+            dict_x_dict_transp = dict * dict';
+            dict(1:6,:) = transforms.record.dictionary.normalize_dict(rand(6,5) - 0.5);
+            dict_x_dict_transp = transforms.record.dictionary.refresh_gram(dict_x_dict_transp,dict,1:6);
+            
+            assert(check.same(dict_x_dict_transp,dict * dict',1e-12));
+            
+            clearvars -except test_figure;
         end
     end
 end
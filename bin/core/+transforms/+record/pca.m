@@ -4,20 +4,50 @@ classdef pca < transform
         sample_mean;
         kept_energy;
         coded_features_count;
+        fit_type;
+        num_workers;
     end
     
     methods (Access=public)
-        function [obj] = pca(train_sample_plain,kept_energy)
+        function [obj] = pca(train_sample_plain,kept_energy,fit_type,num_workers)
             assert(check.dataset_record(train_sample_plain));
             assert(check.scalar(kept_energy));
             assert(check.unitreal(kept_energy));
-
-            sample_mean_t = mean(train_sample_plain,2);
+            assert(~exist('fit_type','var') || check.scalar(fit_type));
+            assert(~exist('fit_type','var') || check.string(fit_type));
+            assert(~exist('fit_type','var') || check.one_of(fit_type,'Batch','Stream','Stream:Truncated'));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('fit_type','var')
+                fit_type = 'Batch';
+            end
             
-            [coeffs_t,~,latent] = princomp(train_sample_plain');
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
+
+            if check.same(fit_type,'Batch')
+                sample_mean_t = mean(train_sample_plain,2);
+            
+                [coeffs_t,~,latent] = princomp(train_sample_plain');
+                
+                total_energy = sum(latent);
+            else
+                [sample_mean_t,covariance] = xtern.x_transforms_record_covariance(full(train_sample_plain),num_workers);
+                
+                if check.same(fit_type,'Stream:Truncated') && (kept_energy < 1)
+                    [coeffs_t,latent] = transforms.record.pca.truncated_eig(covariance,kept_energy);
+                    total_energy = trace(covariance);
+                else
+                    [coeffs_t,latent] = transforms.record.pca.sorted_eig(covariance);
+                    total_energy = sum(latent);
+                end
+            end
             
             energy_per_comp_rel = cumsum(latent);
-            kept_energy_rel = kept_energy * energy_per_comp_rel(end);
+            kept_energy_rel = kept_energy * total_energy;
             coded_features_count_t = find(energy_per_comp_rel >= kept_energy_rel,1);
             
             input_geometry = dataset.geometry(train_sample_plain);
@@ -28,6 +58,8 @@ classdef pca < transform
             obj.sample_mean = sample_mean_t;
             obj.kept_energy = kept_energy;
             obj.coded_features_count = coded_features_count_t;
+            obj.fit_type = fit_type;
+            obj.num_workers = num_workers;
         end
     end
     
@@ -39,6 +71,46 @@ classdef pca < transform
     end
     
     methods (Static,Access=public)
+        function [coeffs,latent] = sorted_eig(covariance)
+            assert(check.matrix(covariance));
+            assert(size(covariance,1) == size(covariance,2));
+            
+            [coeffs_t,latent_t] = eig(covariance);
+            [latent,latent_idx] = sort(diag(latent_t),'descend');
+            coeffs = coeffs_t(:,latent_idx);
+        end
+        
+        function [coeffs,latent] = truncated_eig(covariance,kept_energy)
+            assert(check.matrix(covariance));
+            assert(size(covariance,1) == size(covariance,2));
+            assert(check.scalar(kept_energy));
+            assert(check.unitreal(kept_energy));
+            
+            % Only the leading eigenpairs are computed, doubling their number until they hold the required fraction
+            % of the total energy, which is the trace of the covariance. Close to full rank a dense solve is cheaper.
+            
+            d = size(covariance,1);
+            total_energy = trace(covariance);
+            k = min(8,d);
+            
+            while true
+                if 2 * k >= d
+                    [coeffs,latent] = transforms.record.pca.sorted_eig(covariance);
+                    return;
+                end
+                
+                [coeffs_t,latent_t] = eigs(covariance,k,'lm',struct('issym',true,'disp',0));
+                [latent,latent_idx] = sort(diag(latent_t),'descend');
+                coeffs = coeffs_t(:,latent_idx);
+                
+                if sum(latent) >= kept_energy * total_energy
+                    return;
+                end
+                
+                k = 2 * k;
+            end
+        end
+        
         function test(test_figure)
             fprintf('Testing "transforms.record.pca".\n');
             
@@ -56,6 +128,8 @@ classdef pca < transform
             assert(check.same(t.sample_mean,[3;3],0.1));
             assert(t.kept_energy == 0.9);
             assert(t.coded_features_count == 1);
+            assert(check.same(t.fit_type,'Batch'));
+            assert(t.num_workers == 1);
             assert(check.same(t.input_geometry,2));
             assert(check.same(t.output_geometry,1));
             
@@ -78,6 +152,24 @@ classdef pca < transform
             
             clearvars -except test_figure;
             
+            fprintf('    With streaming fit.\n');
+            
+            s = dataset.load('../../test/correlated_cloud.mat');
+            s_s = princomp(s');
+            
+            t = transforms.record.pca(s,0.9,'Stream',3);
+            
+            assert(check.same(abs(t.coeffs * s_s),eye(2),1e-6));
+            assert(check.same(t.sample_mean,mean(s,2),1e-9));
+            assert(t.kept_energy == 0.9);
+            assert(t.coded_features_count == 1);
+            assert(check.same(t.fit_type,'Stream'));
+            assert(t.num_workers == 3);
+            assert(check.same(t.input_geometry,2));
+            assert(check.same(t.output_geometry,1));
+            
+            clearvars -except test_figure;
+            
             fprintf('  Function "code".\n');
             
             fprintf('    With 90%% kept energy.\n');
@@ -138,6 +230,19 @@ classdef pca < transform
             
             clearvars -except test_figure;
             
+            fprintf('    With streaming fit.\n');
+            
+            s = dataset.load('../../test/correlated_cloud.mat');
+            [~,s_s,p_latent] = princomp(s');
+            
+            t = transforms.record.pca(s,1,'Stream',2);
+            s_p = t.code(s);
+            
+            assert(check.same(abs(s_p),abs(s_s'),1e-6));
+            assert(check.same(var(s_p,0,2),p_latent,1e-6));
+            
+            clearvars -except test_figure;
+            
             fprintf('  Apply PCA on image patches.\n');
             
             fprintf('    With 95%% kept energy.\n');
@@ -201,6 +306,28 @@ classdef pca < transform
             end
             
             clearvars -except test_figure;
+            
+            fprintf('    With 95%% kept energy and truncated streaming fit.\n');
+            
+            s1 = dataset.load('../../test/scenes_small.mat');
+            t1 = transforms.image.patch_extract(s1,400,10,10,0.0001);
+            s2 = t1.code(s1);
+            s3 = dataset.flatten_image(s2);
+            
+            t2_batch = transforms.record.pca(s3,0.95);
+            t2 = transforms.record.pca(s3,0.95,'Stream:Truncated',2);
+            
+            assert(t2.coded_features_count == t2_batch.coded_features_count);
+            assert(size(t2.coeffs,1) >= t2.coded_features_count);
+            assert(check.same(t2.coeffs * t2.coeffs',eye(size(t2.coeffs,1)),1e-6));
+            assert(check.same(t2.sample_mean,t2_batch.sample_mean,1e-9));
+            
+            s3_p = t2.code(s3);
+            s3_p_batch = t2_batch.code(s3);
+            
+            assert(check.same(sum(s3_p .^ 2,1),sum(s3_p_batch .^ 2,1),1e-3));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -0,0 +1,241 @@
+classdef pipeline < transform
+    properties (GetAccess=public,SetAccess=immutable)
+        chain;
+        ops_type;
+        ops_params;
+        num_workers;
+    end
+
+    properties (Constant,GetAccess=public)
+        OP_DC_OFFSET = 0;
+        OP_AFFINE = 1;
+        OP_L2_NORMALIZE = 2;
+        OP_LINEAR = 3;
+    end
+
+    methods (Access=public)
+        function [obj] = pipeline(chain,num_workers)
+            assert(check.cell(chain));
+            assert(check.vector(chain));
+            assert(check.checkf(@transforms.record.pipeline.transform_ok,chain));
+            assert(check.checkv(cellfun(@(t)t.output_geometry,chain(1:end-1)) == ...
+                                cellfun(@(t)t.input_geometry,chain(2:end)),true));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
+
+            [ops_type_t,ops_params_t] = transforms.record.pipeline.compile(chain);
+
+            input_geometry = chain{1}.input_geometry;
+            output_geometry = chain{end}.output_geometry;
+
+            obj = obj@transform(input_geometry,output_geometry);
+            obj.chain = chain;
+            obj.ops_type = ops_type_t;
+            obj.ops_params = ops_params_t;
+            obj.num_workers = num_workers;
+        end
+    end
+
+    methods (Access=protected)
+        function [sample_coded] = do_code(obj,sample_plain)
+            sample_coded = xtern.x_transforms_record_pipeline_code(obj.ops_type,obj.ops_params,full(sample_plain),obj.num_workers);
+        end
+    end
+
+    methods (Static,Access=public)
+        function [ops_type,ops_params] = compile(chain)
+            assert(check.cell(chain));
+            assert(check.vector(chain));
+            assert(check.checkf(@transforms.record.pipeline.transform_ok,chain));
+
+            % Every transform is lowered to a short list of ops, and each op is fused into the previous one whenever
+            % the result is a single op no more expensive than the two. Per-feature affine steps and observation
+            % centering disappear into neighbouring linear steps, so a chain ending in "zca" or "pca" is usually
+            % one matrix product.
+
+            ops_type = zeros(1,0);
+            ops_params = cell(1,0);
+
+            for ii = 1:length(chain)
+                [t_ops_type,t_ops_params] = transforms.record.pipeline.lower(chain{ii});
+
+                for jj = 1:length(t_ops_type)
+                    op_type = t_ops_type(jj);
+                    op_params = t_ops_params{jj};
+                    fused = true;
+
+                    while fused && ~isempty(ops_type)
+                        [fused,op_type,op_params] = transforms.record.pipeline.fuse(ops_type(end),ops_params{end},op_type,op_params);
+
+                        if fused
+                            ops_type = ops_type(1:end-1);
+                            ops_params = ops_params(1:end-1);
+                        end
+                    end
+
+                    ops_type = [ops_type op_type];
+                    ops_params = [ops_params {op_params}];
+                end
+            end
+        end
+
+        function test(test_figure)
+            fprintf('Testing "transforms.record.pipeline".\n');
+
+            fprintf('  Proper construction.\n');
+
+            s = mvnrnd(zeros(1,10),diag(1:10),1000)';
+
+            t1 = transforms.record.standardize(s);
+            t2 = transforms.record.zca(t1.code(s));
+            t = transforms.record.pipeline({t1 t2});
+
+            assert(length(t.chain) == 2);
+            assert(check.same(t.ops_type,transforms.record.pipeline.OP_LINEAR));
+            assert(check.same(size(t.ops_params{1}),[10 11]));
+            assert(t.num_workers == 1);
+            assert(check.same(t.input_geometry,10));
+            assert(check.same(t.output_geometry,10));
+
+            clearvars -except test_figure;
+
+            fprintf('  Function "code".\n');
+
+            fprintf('    With "mean_substract", "standardize" and "zca".\n');
+
+            s = mvnrnd(ones(1,10),diag(1:10),1000)';
+
+            t1 = transforms.record.mean_substract(s);
+            t2 = transforms.record.standardize(t1.code(s));
+            t3 = transforms.record.zca(t2.code(t1.code(s)),0.1);
+            t = transforms.record.pipeline({t1 t2 t3});
+            s_p = t.code(s);
+
+            assert(check.same(t.ops_type,transforms.record.pipeline.OP_LINEAR));
+            assert(check.same(s_p,t3.code(t2.code(t1.code(s))),1e-6));
+
+            clearvars -except test_figure;
+
+            fprintf('    With "dc_offset", "normalize" and "pca".\n');
+
+            s = mvnrnd(ones(1,10),diag(1:10),1000)';
+
+            t1 = transforms.record.dc_offset(s);
+            t2 = transforms.record.normalize(t1.code(s));
+            t3 = transforms.record.pca(t2.code(t1.code(s)),0.9);
+            t = transforms.record.pipeline({t1 t2 t3});
+            s_p = t.code(s);
+
+            assert(check.same(t.ops_type,[transforms.record.pipeline.OP_DC_OFFSET ...
+                                          transforms.record.pipeline.OP_AFFINE ...
+                                          transforms.record.pipeline.OP_L2_NORMALIZE ...
+                                          transforms.record.pipeline.OP_LINEAR]));
+            assert(check.same(t.output_geometry,t3.output_geometry));
+            assert(check.same(s_p,t3.code(t2.code(t1.code(s))),1e-6));
+
+            clearvars -except test_figure;
+
+            fprintf('    With "pca" followed by "dc_offset" and "zca".\n');
+
+            s = mvnrnd(ones(1,10),diag(1:10),1000)';
+
+            t1 = transforms.record.pca(s,0.9);
+            t2 = transforms.record.dc_offset(t1.code(s));
+            t3 = transforms.record.zca(t2.code(t1.code(s)),0.1);
+            t = transforms.record.pipeline({t1 t2 t3});
+            s_p = t.code(s);
+
+            assert(check.same(t.ops_type,transforms.record.pipeline.OP_LINEAR));
+            assert(check.same(s_p,t3.code(t2.code(t1.code(s))),1e-6));
+
+            clearvars -except test_figure;
+
+            fprintf('    With multiple workers.\n');
+
+            s = mvnrnd(ones(1,10),diag(1:10),20000)';
+
+            t1 = transforms.record.standardize(s);
+            t2 = transforms.record.normalize(t1.code(s));
+            t = transforms.record.pipeline({t1 t2},4);
+            s_p = t.code(s);
+
+            assert(t.num_workers == 4);
+            assert(check.same(s_p,t2.code(t1.code(s)),1e-6));
+
+            clearvars -except test_figure;
+        end
+    end
+
+    methods (Static,Access=protected)
+        function [o] = transform_ok(t)
+            o = isa(t,'transforms.record.dc_offset') || ...
+                isa(t,'transforms.record.mean_substract') || ...
+                isa(t,'transforms.record.standardize') || ...
+                isa(t,'transforms.record.normalize') || ...
+                isa(t,'transforms.record.pca') || ...
+                isa(t,'transforms.record.zca');
+        end
+
+        function [ops_type,ops_params] = lower(t)
+            % Affine ops hold [scale shift] and linear ops hold [matrix bias], as the native kernel expects them.
+
+            if isa(t,'transforms.record.dc_offset')
+                ops_type = transforms.record.pipeline.OP_DC_OFFSET;
+                ops_params = {[]};
+            elseif isa(t,'transforms.record.mean_substract')
+                ops_type = transforms.record.pipeline.OP_AFFINE;
+                ops_params = {[ones(t.input_geometry,1) -t.kept_mean]};
+            elseif isa(t,'transforms.record.standardize')
+                ops_type = transforms.record.pipeline.OP_AFFINE;
+                ops_params = {[1 ./ t.kept_deviation -t.kept_mean ./ t.kept_deviation]};
+            elseif isa(t,'transforms.record.normalize')
+                ops_type = [transforms.record.pipeline.OP_AFFINE transforms.record.pipeline.OP_L2_NORMALIZE];
+                ops_params = {[ones(t.input_geometry,1) -t.kept_mean] []};
+            elseif isa(t,'transforms.record.pca')
+                coeffs_t = t.coeffs(1:t.coded_features_count,:);
+                ops_type = transforms.record.pipeline.OP_LINEAR;
+                ops_params = {[coeffs_t -coeffs_t * t.sample_mean]};
+            else
+                ops_type = transforms.record.pipeline.OP_LINEAR;
+                ops_params = {[t.saved_transform_code -t.saved_transform_code * t.sample_mean]};
+            end
+        end
+
+        function [fused,op_type,op_params] = fuse(prev_type,prev_params,next_type,next_params)
+            fused = true;
+
+            if (prev_type == transforms.record.pipeline.OP_AFFINE) && (next_type == transforms.record.pipeline.OP_AFFINE)
+                op_type = transforms.record.pipeline.OP_AFFINE;
+                op_params = [next_params(:,1) .* prev_params(:,1) next_params(:,1) .* prev_params(:,2) + next_params(:,2)];
+            elseif (prev_type == transforms.record.pipeline.OP_AFFINE) && (next_type == transforms.record.pipeline.OP_LINEAR)
+                op_type = transforms.record.pipeline.OP_LINEAR;
+                op_params = [bsxfun(@times,next_params(:,1:end-1),prev_params(:,1)') ...
+                             next_params(:,1:end-1) * prev_params(:,2) + next_params(:,end)];
+            elseif (prev_type == transforms.record.pipeline.OP_LINEAR) && (next_type == transforms.record.pipeline.OP_AFFINE)
+                op_type = transforms.record.pipeline.OP_LINEAR;
+                op_params = [bsxfun(@times,prev_params,next_params(:,1)) + [zeros(size(prev_params,1),size(prev_params,2) - 1) next_params(:,2)]];
+            elseif (prev_type == transforms.record.pipeline.OP_DC_OFFSET) && (next_type == transforms.record.pipeline.OP_LINEAR)
+                % Centering an observation is multiplying it by "eye(d) - ones(d) / d".
+                op_type = transforms.record.pipeline.OP_LINEAR;
+                op_params = [bsxfun(@minus,next_params(:,1:end-1),mean(next_params(:,1:end-1),2)) next_params(:,end)];
+            elseif (prev_type == transforms.record.pipeline.OP_LINEAR) && (next_type == transforms.record.pipeline.OP_DC_OFFSET)
+                op_type = transforms.record.pipeline.OP_LINEAR;
+                op_params = bsxfun(@minus,prev_params,mean(prev_params,1));
+            elseif (prev_type == transforms.record.pipeline.OP_LINEAR) && (next_type == transforms.record.pipeline.OP_LINEAR) && ...
+                   (size(next_params,1) * (size(prev_params,2) - 1) <= size(prev_params,1) * (size(prev_params,2) - 1) + size(next_params,1) * size(prev_params,1))
+                op_type = transforms.record.pipeline.OP_LINEAR;
+                op_params = [next_params(:,1:end-1) * prev_params(:,1:end-1) ...
+                             next_params(:,1:end-1) * prev_params(:,end) + next_params(:,end)];
+            else
+                fused = false;
+                op_type = next_type;
+                op_params = next_params;
+            end
+        end
+    end
+end
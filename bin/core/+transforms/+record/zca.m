@@ -6,22 +6,44 @@ classdef zca < transform
         coeffs_eigenvalues;
         sample_mean;
         div_epsilon;
+        fit_type;
+        num_workers;
     end
     
     methods (Access=public)
-        function [obj] = zca(train_sample_plain,div_epsilon)
+        function [obj] = zca(train_sample_plain,div_epsilon,fit_type,num_workers)
             assert(check.dataset_record(train_sample_plain));
             assert(~exist('div_epsilon','var') || check.scalar(div_epsilon));
             assert(~exist('div_epsilon','var') || check.number(div_epsilon));
             assert(~exist('div_epsilon','var') || (div_epsilon >= 0));
+            assert(~exist('fit_type','var') || check.scalar(fit_type));
+            assert(~exist('fit_type','var') || check.string(fit_type));
+            assert(~exist('fit_type','var') || check.one_of(fit_type,'Batch','Stream'));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
             
             if ~exist('div_epsilon','var')
                 div_epsilon = 0;
             end
             
-            sample_mean_t = mean(train_sample_plain,2);
+            if ~exist('fit_type','var')
+                fit_type = 'Batch';
+            end
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
+            
+            if check.same(fit_type,'Batch')
+                sample_mean_t = mean(train_sample_plain,2);
 
-            [coeffs_t,~,coeffs_eigenvalues_t] = princomp(train_sample_plain');
+                [coeffs_t,~,coeffs_eigenvalues_t] = princomp(train_sample_plain');
+            else
+                [sample_mean_t,covariance] = xtern.x_transforms_record_covariance(full(train_sample_plain),num_workers);
+                [coeffs_t,coeffs_eigenvalues_t] = transforms.record.pca.sorted_eig(covariance);
+                coeffs_eigenvalues_t = max(coeffs_eigenvalues_t,0);
+            end
             
             input_geometry = dataset.geometry(train_sample_plain);
             output_geometry = input_geometry;
@@ -33,6 +55,8 @@ classdef zca < transform
             obj.coeffs_eigenvalues = coeffs_eigenvalues_t;
             obj.sample_mean = sample_mean_t;
             obj.div_epsilon = div_epsilon;
+            obj.fit_type = fit_type;
+            obj.num_workers = num_workers;
         end
     end
     
@@ -62,6 +86,8 @@ classdef zca < transform
             assert(check.same(t.coeffs_eigenvalues,p_latent,0.1));
             assert(check.same(t.sample_mean,[3;3],0.1));
             assert(t.div_epsilon == 0);
+            assert(check.same(t.fit_type,'Batch'));
+            assert(t.num_workers == 1);
             assert(check.same(t.input_geometry,2));
             assert(check.same(t.output_geometry,2));
             
@@ -86,6 +112,26 @@ classdef zca < transform
             
             clearvars -except test_figure;
             
+            fprintf('    With streaming fit.\n');
+            
+            s = dataset.load('../../test/correlated_cloud.mat');
+            [s_s,~,p_latent] = princomp(s');
+
+            t = transforms.record.zca(s,1e-5,'Stream',3);
+            
+            assert(check.same(t.saved_transform_code,s_s * diag(1 ./ sqrt(p_latent + 1e-5)) * s_s',1e-6));
+            assert(check.same(t.saved_transform_decode,s_s * diag(sqrt(p_latent + 1e-5)) * s_s',1e-6));
+            assert(check.same(abs(t.coeffs * s_s),eye(2),1e-6));
+            assert(check.same(t.coeffs_eigenvalues,p_latent,1e-6));
+            assert(check.same(t.sample_mean,mean(s,2),1e-9));
+            assert(t.div_epsilon == 1e-5);
+            assert(check.same(t.fit_type,'Stream'));
+            assert(t.num_workers == 3);
+            assert(check.same(t.input_geometry,2));
+            assert(check.same(t.output_geometry,2));
+            
+            clearvars -except test_figure;
+            
             fprintf('  Function "code".\n');
             
             s = dataset.load('../../test/correlated_cloud.mat');
@@ -144,6 +190,21 @@ classdef zca < transform
             end
             
             clearvars -except test_figure;
+            
+            fprintf('  Apply ZCA on image patches with streaming fit.\n');
+            
+            s1 = dataset.load('../../test/scenes_small.mat');
+            t1 = transforms.image.patch_extract(s1,1500,16,16,0.01);
+            s2 = t1.code(s1);
+            s3 = dataset.flatten_image(s2);
+            
+            t2_batch = transforms.record.zca(s3,0.1);
+            t2 = transforms.record.zca(s3,0.1,'Stream',4);
+            
+            assert(check.same(t2.saved_transform_code,t2_batch.saved_transform_code,1e-4));
+            assert(check.same(t2.code(s3),t2_batch.code(s3),1e-4));
+            
+            clearvars -except test_figure;
         end
     end
 end
@@ -0,0 +1,226 @@
+classdef cache
+    methods (Static,Access=public)
+        function [cache_dir] = directory(new_cache_dir)
+            assert(~exist('new_cache_dir','var') || check.string(new_cache_dir));
+            assert(~exist('new_cache_dir','var') || check.empty(new_cache_dir) || (exist(new_cache_dir,'dir') == 7));
+            
+            % An empty directory, which is the default, disables caching.
+            
+            persistent saved_cache_dir;
+            
+            if exist('new_cache_dir','var')
+                saved_cache_dir = new_cache_dir;
+            end
+            
+            if check.empty(saved_cache_dir)
+                cache_dir = '';
+            else
+                cache_dir = saved_cache_dir;
+            end
+        end
+        
+        function [o] = enabled()
+            o = ~check.empty(utils.cache.directory());
+        end
+        
+        function [key] = key(varargin)
+            % Objects are hashed through their public properties, so two transforms built with the same parameters
+            % and with equal dictionaries share a key, whichever run built them. The "execution_properties" of
+            % transforms, such as "num_workers", are not hashed.
+            
+            key = xtern.x_utils_hash(utils.cache.flatten(varargin));
+        end
+        
+        function [hit,sample_coded] = fetch(key)
+            assert(check.scalar(key));
+            assert(check.string(key));
+            assert(utils.cache.enabled());
+            
+            sparse_path = fullfile(utils.cache.directory(),[key '.csc']);
+            dense_path = fullfile(utils.cache.directory(),[key '.dat']);
+            
+            if exist(sparse_path,'file') == 2
+                hit = true;
+                sample_coded = dataset.load_coded(sparse_path);
+            elseif exist(dense_path,'file') == 2
+                hit = true;
+                sample_coded = dataset.load_mapped(dense_path);
+            else
+                hit = false;
+                sample_coded = [];
+            end
+        end
+        
+        function [] = store(key,sample_coded)
+            assert(check.scalar(key));
+            assert(check.string(key));
+            assert(check.dataset(sample_coded));
+            assert(utils.cache.enabled());
+            
+            % Entries are written under a temporary name and then renamed, so a reader never sees a partial one.
+            
+            temp_path = fullfile(utils.cache.directory(),[key '.tmp']);
+            
+            if issparse(sample_coded)
+                dataset.save_coded(temp_path,sample_coded,true);
+                movefile(temp_path,fullfile(utils.cache.directory(),[key '.csc']));
+            else
+                dataset.save_mapped(temp_path,sample_coded,-1);
+                movefile(temp_path,fullfile(utils.cache.directory(),[key '.dat']));
+            end
+        end
+        
+        function [] = clear()
+            assert(utils.cache.enabled());
+            
+            delete(fullfile(utils.cache.directory(),'*.csc'));
+            delete(fullfile(utils.cache.directory(),'*.dat'));
+        end
+    end
+    
+    methods (Static,Access=public)
+        function test(~)
+            fprintf('Testing "utils.cache".\n');
+            
+            cache_dir = tempname();
+            mkdir(cache_dir);
+            
+            fprintf('  Function "directory".\n');
+            
+            assert(check.empty(utils.cache.directory()));
+            assert(~utils.cache.enabled());
+            
+            utils.cache.directory(cache_dir);
+            
+            assert(check.same(utils.cache.directory(),cache_dir));
+            assert(utils.cache.enabled());
+            
+            utils.cache.directory('');
+            
+            assert(~utils.cache.enabled());
+            
+            fprintf('  Function "key".\n');
+            
+            s = rand(10,20);
+            t_1 = transforms.record.mean_substract(s);
+            t_2 = transforms.record.mean_substract(s);
+            t_3 = transforms.record.mean_substract(s + 1);
+            t_4 = transforms.record.pca(s,0.9,'Batch',1);
+            t_5 = transforms.record.pca(s,0.9,'Batch',2);
+            
+            assert(length(utils.cache.key(s)) == 16);
+            assert(check.same(utils.cache.key(s),utils.cache.key(s)));
+            assert(~check.same(utils.cache.key(s),utils.cache.key(single(s))));
+            assert(~check.same(utils.cache.key(s),utils.cache.key(s')));
+            assert(~check.same(utils.cache.key(s),utils.cache.key(sparse(s))));
+            assert(~check.same(utils.cache.key({1 2}),utils.cache.key([1 2])));
+            assert(~check.same(utils.cache.key('ab'),utils.cache.key({'a' 'b'})));
+            assert(~check.same(utils.cache.key(struct('a',1)),utils.cache.key(struct('b',1))));
+            assert(check.same(utils.cache.key(t_1,s),utils.cache.key(t_2,s)));
+            assert(~check.same(utils.cache.key(t_1,s),utils.cache.key(t_3,s)));
+            assert(~check.same(utils.cache.key(t_1,s),utils.cache.key(t_1,s + 1)));
+            assert(check.same(utils.cache.key(t_4,s),utils.cache.key(t_5,s)));
+            
+            clearvars -except cache_dir;
+            
+            fprintf('  Functions "fetch" and "store".\n');
+            
+            utils.cache.directory(cache_dir);
+            
+            s_1 = sprand(100,30,0.1);
+            s_2 = rand(8,8,1,5);
+            
+            [hit,s_r] = utils.cache.fetch('0123456789abcdef');
+            
+            assert(~hit);
+            assert(check.empty(s_r));
+            
+            utils.cache.store('0123456789abcdef',s_1);
+            utils.cache.store('fedcba9876543210',s_2);
+            [hit_1,s_r_1] = utils.cache.fetch('0123456789abcdef');
+            [hit_2,s_r_2] = utils.cache.fetch('fedcba9876543210');
+            
+            assert(hit_1);
+            assert(check.same(s_r_1,s_1));
+            assert(hit_2);
+            assert(check.same(s_r_2,s_2));
+            
+            utils.cache.clear();
+            
+            assert(~utils.cache.fetch('0123456789abcdef'));
+            
+            utils.cache.directory('');
+            
+            clearvars -except cache_dir;
+            
+            fprintf('  Cached "transform.code".\n');
+            
+            utils.cache.directory(cache_dir);
+            
+            s = rand(10,20);
+            t = transforms.record.standardize(s);
+            
+            s_p_1 = t.code(s);
+            entries_count_1 = length(dir(fullfile(cache_dir,'*.dat')));
+            s_p_2 = t.code(s);
+            entries_count_2 = length(dir(fullfile(cache_dir,'*.dat')));
+            
+            utils.cache.directory('');
+            
+            s_p_3 = t.code(s);
+            
+            assert(entries_count_1 == 1);
+            assert(entries_count_2 == 1);
+            assert(check.same(s_p_1,s_p_3));
+            assert(check.same(s_p_2,s_p_3));
+            
+            clearvars -except cache_dir;
+            
+            rmdir(cache_dir,'s');
+        end
+    end
+    
+    methods (Static,Access=protected)
+        function [parts] = flatten(value)
+            % Containers contribute a tag and their size ahead of their contents, so differently nested values with
+            % the same leaves still produce different parts.
+            
+            if isnumeric(value) || islogical(value) || ischar(value)
+                parts = {value};
+            elseif isa(value,'function_handle')
+                parts = {'function_handle' func2str(value)};
+            elseif iscell(value)
+                parts = {'cell' size(value)};
+                
+                for ii = 1:numel(value)
+                    parts = [parts utils.cache.flatten(value{ii})];
+                end
+            elseif isstruct(value)
+                names = fieldnames(value);
+                parts = {'struct' size(value)};
+                
+                for ii = 1:numel(value)
+                    for jj = 1:length(names)
+                        parts = [parts {names{jj}} utils.cache.flatten(value(ii).(names{jj}))];
+                    end
+                end
+            elseif isobject(value)
+                names = properties(value);
+                
+                if isa(value,'transform')
+                    names = setdiff(names,transform.execution_properties,'stable');
+                end
+                
+                parts = {class(value) size(value)};
+                
+                for ii = 1:numel(value)
+                    for jj = 1:length(names)
+                        parts = [parts {names{jj}} utils.cache.flatten(value(ii).(names{jj}))];
+                    end
+                end
+            else
+                assert(false);
+            end
+        end
+    end
+end
@@ -137,7 +137,7 @@ classdef common
             end
         end
         
-        function [patches,t_patch,t_dc_offset,t_zca] = mnist_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca)
+        function [patches,t_patch,t_dc_offset,t_zca] = mnist_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca,num_workers)
             assert(check.scalar(patches_count));
             assert(check.natural(patches_count));
             assert(patches_count >= 1);
@@ -151,10 +151,17 @@ classdef common
             assert(patch_col_count <= 28);
             assert(check.scalar(do_patch_zca));
             assert(check.logical(do_patch_zca));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
 
             images = dataset.load('../../data/mnist.train.mat');
             
-            t_patch = transforms.image.patch_extract(images,patches_count,patch_row_count,patch_col_count,0.01);
+            t_patch = transforms.image.patch_extract(images,patches_count,patch_row_count,patch_col_count,0.01,num_workers);
             
             patches_1 = t_patch.code(images);
             patches_1f = dataset.flatten_image(patches_1);
@@ -172,7 +179,7 @@ classdef common
             end
         end
         
-        function [patches_r,patches_g,patches_b,t_patch,t_dc_offset,t_zca] = cifar10_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca)
+        function [patches_r,patches_g,patches_b,t_patch,t_dc_offset,t_zca] = cifar10_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca,num_workers)
             assert(check.scalar(patches_count));
             assert(check.natural(patches_count));
             assert(patches_count >= 1);
@@ -186,20 +193,26 @@ classdef common
             assert(patch_col_count <= 28);
             assert(check.scalar(do_patch_zca));
             assert(check.logical(do_patch_zca));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
 
             images = dataset.load('../../data/cifar10.train.mat');
             
-            t_patch_r = transforms.image.patch_extract(images(:,:,1,:),patches_count,patch_row_count,patch_col_count,0.01);
-            t_patch_g = transforms.image.patch_extract(images(:,:,2,:),patches_count,patch_row_count,patch_col_count,0.01);
-            t_patch_b = transforms.image.patch_extract(images(:,:,3,:),patches_count,patch_row_count,patch_col_count,0.01);
-            t_patch = {t_patch_r t_patch_g t_patch_b};
+            % Patches are extracted from all three layers in one pass, at the same locations, and then split into
+            % one block of rows per layer, as "transforms.image.recoder" does for "PerChannel" channels.
             
-            patches_1_r = t_patch_r.code(images(:,:,1,:));
-            patches_1_g = t_patch_g.code(images(:,:,2,:));
-            patches_1_b = t_patch_b.code(images(:,:,3,:));
-            patches_1f_r = dataset.flatten_image(patches_1_r);
-            patches_1f_g = dataset.flatten_image(patches_1_g);
-            patches_1f_b = dataset.flatten_image(patches_1_b);
+            t_patch = transforms.image.patch_extract(images,patches_count,patch_row_count,patch_col_count,0.01,num_workers);
+            
+            patches_1 = dataset.flatten_image(t_patch.code(images));
+            layer_geometry = patch_row_count * patch_col_count;
+            patches_1f_r = patches_1(1:layer_geometry,:);
+            patches_1f_g = patches_1(layer_geometry + 1:2 * layer_geometry,:);
+            patches_1f_b = patches_1(2 * layer_geometry + 1:3 * layer_geometry,:);
             
             t_dc_offset_r = transforms.record.dc_offset(patches_1f_r);
             t_dc_offset_g = transforms.record.dc_offset(patches_1f_g);
@@ -226,7 +239,7 @@ classdef common
             end
         end
         
-        function [patches,t_patch,t_dc_offset,t_zca] = norbsmall_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca)
+        function [patches,t_patch,t_dc_offset,t_zca] = norbsmall_patches_for_dict_learning(patches_count,patch_row_count,patch_col_count,do_patch_zca,num_workers)
             assert(check.scalar(patches_count));
             assert(check.natural(patches_count));
             assert(patches_count >= 1);
@@ -240,11 +253,18 @@ classdef common
             assert(patch_col_count <= 28);
             assert(check.scalar(do_patch_zca));
             assert(check.logical(do_patch_zca));
+            assert(~exist('num_workers','var') || check.scalar(num_workers));
+            assert(~exist('num_workers','var') || check.natural(num_workers));
+            assert(~exist('num_workers','var') || (num_workers >= 1));
+            
+            if ~exist('num_workers','var')
+                num_workers = 1;
+            end
 
             images = dataset.load('../../data/norbsmall.train.mat');
             images = images(:,:,1,:);
             
-            t_patch = transforms.image.patch_extract(images,patches_count,patch_row_count,patch_col_count,0.01);
+            t_patch = transforms.image.patch_extract(images,patches_count,patch_row_count,patch_col_count,0.01,num_workers);
             
             patches_1 = t_patch.code(images);
             patches_1f = dataset.flatten_image(patches_1);
@@ -0,0 +1,100 @@
+classdef dictionary_handle < handle
+    properties (GetAccess=public,SetAccess=private)
+        dict;
+    end
+    
+    properties (Transient,GetAccess=public,SetAccess=private)
+        id;
+    end
+    
+    methods (Access=public)
+        function [obj] = dictionary_handle(dict)
+            assert(check.matrix(dict));
+            assert(check.number(dict));
+            
+            % The native side keeps its own copy of "dict", along with the transpose and the Gram matrix, until the
+            % last reference to this object is cleared. The copy held here is shared with the caller's one, and is
+            % only used to rebuild the native side when the object is loaded from disk.
+            
+            obj.dict = dict;
+            obj.id = xtern.x_dictionary_handle_create(dict);
+        end
+        
+        function [] = delete(obj)
+            if ~check.empty(obj.id)
+                xtern.x_dictionary_handle_destroy(obj.id);
+            end
+        end
+    end
+    
+    methods (Static,Access=public)
+        function [obj] = loadobj(obj)
+            obj.id = xtern.x_dictionary_handle_create(obj.dict);
+        end
+        
+        function test(~)
+            fprintf('Testing "utils.dictionary_handle".\n');
+            
+            fprintf('  Proper construction.\n');
+            
+            dict = rand(20,10);
+            dict = bsxfun(@rdivide,dict,sqrt(sum(dict .^ 2,2)));
+            
+            h = utils.dictionary_handle(dict);
+            
+            assert(check.same(h.dict,dict));
+            assert(isa(h.id,'uint64'));
+            assert(check.scalar(h.id));
+            
+            clearvars;
+            
+            fprintf('  Coding with a handle.\n');
+            
+            dict = rand(20,10);
+            dict = bsxfun(@rdivide,dict,sqrt(sum(dict .^ 2,2)));
+            s = rand(10,50);
+            
+            h = utils.dictionary_handle(dict);
+            
+            assert(check.same(xtern.x_dictionary_correlation(h.id,[],[],[],4,s,1),...
+                              xtern.x_dictionary_correlation(dict,dict',dict * dict',[],4,s,1)));
+            assert(check.same(xtern.x_dictionary_matching_pursuit(h.id,[],[],[],4,s,1),...
+                              xtern.x_dictionary_matching_pursuit(dict,dict',dict * dict',[],4,s,1)));
+            assert(check.same(xtern.x_dictionary_orthogonal_matching_pursuit(h.id,[],[],[],4,s,2),...
+                              xtern.x_dictionary_orthogonal_matching_pursuit(dict,dict',dict * dict',[],4,s,2),1e-10));
+            
+            clearvars;
+            
+            fprintf('  Saving and loading.\n');
+            
+            dict = rand(20,10);
+            dict = bsxfun(@rdivide,dict,sqrt(sum(dict .^ 2,2)));
+            s = rand(10,50);
+            handle_path = [tempname() '.mat'];
+            
+            h = utils.dictionary_handle(dict);
+            save(handle_path,'h');
+            clear h;
+            loaded = load(handle_path);
+            delete(handle_path);
+            
+            assert(check.same(loaded.h.dict,dict));
+            assert(~check.empty(loaded.h.id));
+            assert(check.same(xtern.x_dictionary_correlation(loaded.h.id,[],[],[],4,s,1),...
+                              xtern.x_dictionary_correlation(dict,dict',dict * dict',[],4,s,1)));
+            
+            clearvars;
+            
+            fprintf('  Invalid handles.\n');
+            
+            try
+                xtern.x_dictionary_correlation(uint64(0),[],[],[],4,rand(10,5),1);
+                assert(false);
+            catch e
+                assert(check.same(e.identifier,'master:InvalidHandle'));
+            end
+            
+            clearvars;
+        end
+    end
+end
@@ -2,9 +2,43 @@
 #define _BASE_DEFINES_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #if __STDC_VERSION__ < 199901L
 #define restrict __restrict__
 #endif
 
+/* The modules are compiled as C into "libxtern", which the MEX files, compiled as C++, link against, so the headers
+   of the modules keep their declarations between "BEGIN_C_DECLS" and "END_C_DECLS". */
+
+#if defined(__cplusplus)
+#define BEGIN_C_DECLS extern "C" {
+#define END_C_DECLS }
+#else
+#define BEGIN_C_DECLS
+#define END_C_DECLS
+#endif
+
+/* With "XTERN_CPU_DISPATCH" defined, functions marked "CPU_DISPATCH" are compiled once for each of the instruction
+   sets below, and the dynamic loader binds every call to the best version the CPU supports, as reported by cpuid. */
+
+#if defined(XTERN_CPU_DISPATCH) && defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define CPU_DISPATCH __attribute__((target_clones("avx512f","avx2","sse4.2","default")))
+#else
+#define CPU_DISPATCH
+#endif
+
+/* With "XTERN_COMPACT_IDX" defined, the coding and reduce layers keep coefficient indices as 32 bit integers, which
+   halves the memory traffic of their sorts and the index buffers in "coding_tmps". Coded geometries, hashed or not,
+   must then have no index above "COEFF_IDX_MAX", which callers check with "code_image_idx_fits". Indices are
+   widened to "size_t" with "widen_idx" only where they leave these layers. */
+
+#if defined(XTERN_COMPACT_IDX)
+typedef uint32_t coeff_idx_t;
+#define COEFF_IDX_MAX ((size_t)UINT32_MAX)
+#else
+typedef size_t coeff_idx_t;
+#define COEFF_IDX_MAX ((size_t)SIZE_MAX)
+#endif
+
 #endif
@@ -10,14 +10,14 @@
 
 #include "coding_methods.h"
 #include "latools.h"
+#include "small_kernels.h"
 
 size_t
 correlation_coding_tmps_length(
     size_t  geometry,
     size_t  word_count,
     size_t  coeff_count) {
-    return word_count * sizeof(double) + // for "similarities".
-           word_count * sizeof(size_t);  // for "similarities_idx".
+    return word_count * sizeof(double); // for "similarities".
 }
 
 size_t
@@ -53,20 +53,70 @@ optimized_orthogonal_matching_pursuit_coding_tmps_length(
            geometry * sizeof(double);                   // for "local_residual".
 }
 
+size_t
+batch_orthogonal_matching_pursuit_coding_tmps_length(
+    size_t  geometry,
+    size_t  word_count,
+    size_t  coeff_count) {
+    return word_count * sizeof(double) +                // for "initial_similarities".
+           word_count * sizeof(double) +                // for "similarities".
+           coeff_count * coeff_count * sizeof(double) + // for "gram_cholesky".
+           coeff_count * sizeof(double) +               // for "gram_cholesky_row".
+           word_count * sizeof(bool);                   // for "used_column_mask".
+}
+
 size_t
 sparse_net_coding_tmps_length(
     size_t  geometry,
     size_t  word_count,
     size_t  coeff_count) {
     return word_count * sizeof(double) +  // for "initial_coeffs".
-           word_count * sizeof(size_t) +  // for "initial_coeffs_idx".
            geometry * sizeof(double);     // for "local_coeffs".
 }
 
+size_t
+coding_type_tmps_length(
+    enum coding_type  coding_type,
+    size_t            geometry,
+    size_t            word_count,
+    size_t            coeff_count) {
+    if (coding_type == CORRELATION) {
+	return correlation_coding_tmps_length(geometry,word_count,coeff_count);
+    } else if (coding_type == MATCHING_PURSUIT) {
+	return matching_pursuit_coding_tmps_length(geometry,word_count,coeff_count);
+    } else if (coding_type == ORTHOGONAL_MATCHING_PURSUIT) {
+	return orthogonal_matching_pursuit_coding_tmps_length(geometry,word_count,coeff_count);
+    } else if (coding_type == OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT) {
+	return optimized_orthogonal_matching_pursuit_coding_tmps_length(geometry,word_count,coeff_count);
+    } else if (coding_type == SPARSE_NET) {
+	return sparse_net_coding_tmps_length(geometry,word_count,coeff_count);
+    } else {
+	exit(EXIT_FAILURE);
+    }
+}
+
+coding_method_t
+coding_type_method(
+    enum coding_type  coding_type) {
+    if (coding_type == CORRELATION) {
+	return correlation;
+    } else if (coding_type == MATCHING_PURSUIT) {
+	return matching_pursuit;
+    } else if (coding_type == ORTHOGONAL_MATCHING_PURSUIT) {
+	return orthogonal_matching_pursuit;
+    } else if (coding_type == OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT) {
+	return optimized_orthogonal_matching_pursuit;
+    } else if (coding_type == SPARSE_NET) {
+	return sparse_net;
+    } else {
+	exit(EXIT_FAILURE);
+    }
+}
+
 void
 correlation(
     double* restrict        o_coeffs,
-    size_t* restrict        o_coeffs_idx,
+    coeff_idx_t* restrict   o_coeffs_idx,
     size_t                  geometry,
     size_t                  word_count,
     const double* restrict  dict,
@@ -78,28 +128,20 @@ correlation(
     void* restrict          coding_tmps) {
     char* restrict    curr_coding_tmps;
     double* restrict  similarities;
-    size_t* restrict  similarities_idx;
 
     curr_coding_tmps = (char* restrict)coding_tmps;
 
     similarities = (double* restrict)curr_coding_tmps;
     curr_coding_tmps += word_count * sizeof(double);
-    similarities_idx = (size_t* restrict)curr_coding_tmps;
-    curr_coding_tmps += word_count * sizeof(size_t);
 
     dgemv('N',(int)word_count,(int)geometry,1,(double*)dict,(int)word_count,(double*)observation,1,0,similarities,1);
-    fill_idx_1n(similarities_idx,word_count);
-
-    sort_by_abs_coeffs(similarities,similarities_idx,word_count);
-
-    memcpy(o_coeffs,similarities,coeff_count * sizeof(double));
-    memcpy(o_coeffs_idx,similarities_idx,coeff_count * sizeof(size_t));
+    top_k_by_abs(o_coeffs,o_coeffs_idx,word_count,coeff_count,similarities);
 }
 
 void
 matching_pursuit(
     double* restrict        o_coeffs,
-    size_t* restrict        o_coeffs_idx,
+    coeff_idx_t* restrict   o_coeffs_idx,
     size_t                  geometry,
     size_t                  word_count,
     const double* restrict  dict,
@@ -123,20 +165,20 @@ matching_pursuit(
     dgemv('N',(int)word_count,(int)geometry,1,(double*)dict,(int)word_count,(double*)observation,1,0,similarities,1);
 
     for (ii = 0; ii < coeff_count; ii++) {
-        max_idx = (size_t)idamax((int)word_count,similarities,1) - 1;
+        max_idx = abs_argmax(word_count,similarities);
         max_sim = similarities[max_idx];
 
         o_coeffs[ii] = max_sim;
-        o_coeffs_idx[ii] = max_idx; /* There is a very very small chance of inserting a duplicate here. */
+        o_coeffs_idx[ii] = (coeff_idx_t)max_idx; /* There is a very very small chance of inserting a duplicate here. */
 
-        daxpy((int)word_count,-max_sim,(double*)dict_x_dict_transp + max_idx * word_count,1,similarities,1);
+        small_daxpy(word_count,-max_sim,dict_x_dict_transp + max_idx * word_count,similarities);
     }
 }
 
 void
 orthogonal_matching_pursuit(
     double* restrict        o_coeffs,
-    size_t* restrict        o_coeffs_idx,
+    coeff_idx_t* restrict   o_coeffs_idx,
     size_t                  geometry,
     size_t                  word_count,
     const double* restrict  dict,
@@ -173,32 +215,32 @@ orthogonal_matching_pursuit(
 
     for (ii = 0; ii < coeff_count; ii++) {
         dgemv('N',(int)word_count,(int)geometry,1,(double*)dict,(int)word_count,(double*)residual,1,0,similarities,1);
-        max_idx = (size_t)idamax((int)word_count,similarities,1) - 1;
+        max_idx = abs_argmax(word_count,similarities);
 
         winner_column_dict_transp = dict_transp + max_idx * geometry;
         curr_column_dict_transp_normalized = dict_transp_normalized + ii * geometry;
         curr_column_coeff_inversion_matrix = coeff_inversion_matrix + ii * coeff_count;
 
-        dgemv('T',(int)geometry,(int)ii,1,(double*)dict_transp_normalized,(int)geometry,(double*)winner_column_dict_transp,1,0,(double*)curr_column_coeff_inversion_matrix,1);
+        small_dgemv_t(geometry,ii,1,dict_transp_normalized,winner_column_dict_transp,0,curr_column_coeff_inversion_matrix);
         memcpy(curr_column_dict_transp_normalized,winner_column_dict_transp,geometry * sizeof(double));
-        dgemv('N',(int)geometry,(int)ii,-1,(double*)dict_transp_normalized,(int)geometry,(double*)curr_column_coeff_inversion_matrix,1,1,(double*)curr_column_dict_transp_normalized,1);
-        new_norm = dnrm2((int)geometry,(double*)curr_column_dict_transp_normalized,1);
-        dscal((int)geometry,1 / new_norm,(double*)curr_column_dict_transp_normalized,1);
-        curr_column_coeff_inversion_matrix[ii] = ddot((int)geometry,(double*)curr_column_dict_transp_normalized,1,(double*)winner_column_dict_transp,1);
+        small_dgemv_n(geometry,ii,-1,dict_transp_normalized,curr_column_coeff_inversion_matrix,1,curr_column_dict_transp_normalized);
+        new_norm = small_dnrm2(geometry,curr_column_dict_transp_normalized);
+        small_dscal(geometry,1 / new_norm,curr_column_dict_transp_normalized);
+        curr_column_coeff_inversion_matrix[ii] = small_ddot(geometry,curr_column_dict_transp_normalized,winner_column_dict_transp);
 
-        o_coeffs[ii] = ddot((int)geometry,(double*)curr_column_dict_transp_normalized,1,(double*)observation,1);
-        o_coeffs_idx[ii] = max_idx;
+        o_coeffs[ii] = small_ddot(geometry,curr_column_dict_transp_normalized,observation);
+        o_coeffs_idx[ii] = (coeff_idx_t)max_idx;
 
-        daxpy((int)geometry,-o_coeffs[ii],(double*)curr_column_dict_transp_normalized,1,(double*)residual,1);
+        small_daxpy(geometry,-o_coeffs[ii],curr_column_dict_transp_normalized,residual);
     }
 
-    dtrsv('U','N','N',(int)coeff_count,(double*)coeff_inversion_matrix,(int)coeff_count,(double*)o_coeffs,1);
+    small_dtrsv('U','N',coeff_count,coeff_inversion_matrix,coeff_count,o_coeffs);
 }
 
 void
 optimized_orthogonal_matching_pursuit(
     double* restrict        o_coeffs,
-    size_t* restrict        o_coeffs_idx,
+    coeff_idx_t* restrict   o_coeffs_idx,
     size_t                  geometry,
     size_t                  word_count,
     const double* restrict  dict,
@@ -254,8 +296,8 @@ optimized_orthogonal_matching_pursuit(
     curr_column_dict_transp_tilde = dict_transp_tilde;
 
     for (ii = 0; ii < word_count; ii++) {
-        new_norm = dnrm2((int)geometry,(double*)curr_column_dict_transp_tilde,1);
-        dscal((int)geometry,1 / new_norm,(double*)curr_column_dict_transp_tilde,1);
+        new_norm = small_dnrm2(geometry,curr_column_dict_transp_tilde);
+        small_dscal(geometry,1 / new_norm,curr_column_dict_transp_tilde);
         curr_column_dict_transp_tilde += geometry;
     }
 
@@ -267,10 +309,10 @@ optimized_orthogonal_matching_pursuit(
 
         for (jj = 0; jj < word_count; jj++) {
             if (!used_column_mask[jj]) {
-                observation_column_tilde_dot[jj] = ddot((int)geometry,(double*)observation,1,(double*)curr_column_dict_transp_tilde,1);
+                observation_column_tilde_dot[jj] = small_ddot(geometry,observation,curr_column_dict_transp_tilde);
                 memcpy(local_residual,residual,geometry * sizeof(double));
-                daxpy((int)geometry,-observation_column_tilde_dot[jj],(double*)curr_column_dict_transp_tilde,1,(double*)local_residual,1);
-                next_residual_norm = dnrm2((int)geometry,(double*)local_residual,1);
+                small_daxpy(geometry,-observation_column_tilde_dot[jj],curr_column_dict_transp_tilde,local_residual);
+                next_residual_norm = small_dnrm2(geometry,local_residual);
 
                 if (next_residual_norm < min_next_residual) {
                     min_next_residual = next_residual_norm;
@@ -286,27 +328,27 @@ optimized_orthogonal_matching_pursuit(
         curr_column_dict_transp_normalized = dict_transp_normalized + ii * geometry;
         curr_column_coeff_inversion_matrix = coeff_inversion_matrix + ii * coeff_count;
 
-        dgemv('T',(int)geometry,(int)ii,1,(double*)dict_transp_normalized,(int)geometry,(double*)winner_column_dict_transp,1,0,(double*)curr_column_coeff_inversion_matrix,1);
+        small_dgemv_t(geometry,ii,1,dict_transp_normalized,winner_column_dict_transp,0,curr_column_coeff_inversion_matrix);
         memcpy(curr_column_dict_transp_normalized,winner_column_dict_transp_tilde,geometry * sizeof(double));
-        curr_column_coeff_inversion_matrix[ii] = ddot((int)geometry,(double*)curr_column_dict_transp_normalized,1,(double*)winner_column_dict_transp,1);
+        curr_column_coeff_inversion_matrix[ii] = small_ddot(geometry,curr_column_dict_transp_normalized,winner_column_dict_transp);
 
         used_column_mask[min_idx] = true;
         memset(winner_column_dict_transp_tilde,0,geometry * sizeof(double));
 
         o_coeffs[ii] = observation_column_tilde_dot[min_idx];
-        o_coeffs_idx[ii] = min_idx;
+        o_coeffs_idx[ii] = (coeff_idx_t)min_idx;
 
-        daxpy((int)geometry,-o_coeffs[ii],(double*)curr_column_dict_transp_normalized,1,(double*)residual,1);
+        small_daxpy(geometry,-o_coeffs[ii],curr_column_dict_transp_normalized,residual);
 
         curr_column_dict_transp_tilde = dict_transp_tilde;
 
         for (jj = 0; jj < word_count; jj++) {
             if (!used_column_mask[jj]) {
-                column_tilde_proj_on_winner = ddot((int)geometry,(double*)curr_column_dict_transp_tilde,1,(double*)curr_column_dict_transp_normalized,1);
-                daxpy((int)geometry,-column_tilde_proj_on_winner,(double*)curr_column_dict_transp_normalized,1,(double*)curr_column_dict_transp_tilde,1);
-                new_norm = dnrm2((int)geometry,(double*)curr_column_dict_transp_tilde,1);
+                column_tilde_proj_on_winner = small_ddot(geometry,curr_column_dict_transp_tilde,curr_column_dict_transp_normalized);
+                small_daxpy(geometry,-column_tilde_proj_on_winner,curr_column_dict_transp_normalized,curr_column_dict_transp_tilde);
+                new_norm = small_dnrm2(geometry,curr_column_dict_transp_tilde);
                 if (new_norm >= 1e-6) {
-                    dscal((int)geometry,1 / new_norm,(double*)curr_column_dict_transp_tilde,1);
+                    small_dscal(geometry,1 / new_norm,curr_column_dict_transp_tilde);
                 }
             }
 
@@ -314,7 +356,123 @@ optimized_orthogonal_matching_pursuit(
         }
     }
 
-    dtrsv('U','N','N',(int)coeff_count,(double*)coeff_inversion_matrix,(int)coeff_count,(double*)o_coeffs,1);
+    small_dtrsv('U','N',coeff_count,coeff_inversion_matrix,coeff_count,o_coeffs);
+}
+
+void
+batch_orthogonal_matching_pursuit(
+    double* restrict        o_coeffs,
+    coeff_idx_t* restrict   o_coeffs_idx,
+    size_t                  geometry,
+    size_t                  word_count,
+    const double* restrict  dict,
+    const double* restrict  dict_transp,
+    const double* restrict  dict_x_dict_transp,
+    size_t                  coeff_count,
+    const void* restrict    coding_params,
+    const double* restrict  observation,
+    void* restrict          coding_tmps) {
+    char* restrict    curr_coding_tmps;
+    double* restrict  initial_similarities;
+    double* restrict  similarities;
+    double* restrict  gram_cholesky;
+    double* restrict  gram_cholesky_row;
+    bool* restrict    used_column_mask;
+    double            max_similarity;
+    size_t            max_idx;
+    double            new_diagonal;
+    size_t            selected_count;
+    size_t            ii;
+    size_t            jj;
+
+    curr_coding_tmps = (char* restrict)coding_tmps;
+
+    initial_similarities = (double* restrict)curr_coding_tmps;
+    curr_coding_tmps += word_count * sizeof(double);
+    similarities = (double* restrict)curr_coding_tmps;
+    curr_coding_tmps += word_count * sizeof(double);
+    gram_cholesky = (double* restrict)curr_coding_tmps;
+    curr_coding_tmps += coeff_count * coeff_count * sizeof(double);
+    gram_cholesky_row = (double* restrict)curr_coding_tmps;
+    curr_coding_tmps += coeff_count * sizeof(double);
+    used_column_mask = (bool* restrict)curr_coding_tmps;
+    curr_coding_tmps += word_count * sizeof(bool);
+
+    /* Batch OMP in the style of Rubinstein et al. The observation touches the dictionary only once, through
+       "initial_similarities" = D * x. Afterwards every step works with "dict_x_dict_transp": the Cholesky factor of
+       the Gram matrix of the selected atoms grows by one row, the coefficients are the solution of two triangular
+       systems, and the similarities are D * x - G_I * coeffs. The residual itself is never formed. */
+
+    dgemv('N',(int)word_count,(int)geometry,1,(double*)dict,(int)word_count,(double*)observation,1,0,initial_similarities,1);
+    memcpy(similarities,initial_similarities,word_count * sizeof(double));
+    memset(used_column_mask,0,word_count * sizeof(bool));
+
+    selected_count = 0;
+
+    for (ii = 0; ii < coeff_count; ii++) {
+	max_similarity = 0;
+	max_idx = word_count;
+
+	for (jj = 0; jj < word_count; jj++) {
+	    if (!used_column_mask[jj] && (fabs(similarities[jj]) > max_similarity)) {
+		max_similarity = fabs(similarities[jj]);
+		max_idx = jj;
+	    }
+	}
+
+	if (max_idx == word_count) {
+	    break;
+	}
+
+	for (jj = 0; jj < ii; jj++) {
+	    gram_cholesky_row[jj] = dict_x_dict_transp[max_idx * word_count + o_coeffs_idx[jj]];
+	}
+
+	if (ii > 0) {
+	    small_dtrsv('L','N',ii,gram_cholesky,coeff_count,gram_cholesky_row);
+	}
+
+	new_diagonal = dict_x_dict_transp[max_idx * word_count + max_idx] - small_ddot(ii,gram_cholesky_row,gram_cholesky_row);
+
+	/* An atom in the span of the selected ones would make the factor singular. */
+
+	if (new_diagonal <= 1e-10) {
+	    break;
+	}
+
+	for (jj = 0; jj < ii; jj++) {
+	    gram_cholesky[jj * coeff_count + ii] = gram_cholesky_row[jj];
+	}
+
+	gram_cholesky[ii * coeff_count + ii] = sqrt(new_diagonal);
+	used_column_mask[max_idx] = true;
+	o_coeffs_idx[ii] = (coeff_idx_t)max_idx;
+	selected_count = ii + 1;
+
+	for (jj = 0; jj < selected_count; jj++) {
+	    o_coeffs[jj] = initial_similarities[o_coeffs_idx[jj]];
+	}
+
+	small_dtrsv('L','N',selected_count,gram_cholesky,coeff_count,o_coeffs);
+	small_dtrsv('L','T',selected_count,gram_cholesky,coeff_count,o_coeffs);
+
+	memcpy(similarities,initial_similarities,word_count * sizeof(double));
+
+	for (jj = 0; jj < selected_count; jj++) {
+	    small_daxpy(word_count,-o_coeffs[jj],dict_x_dict_transp + o_coeffs_idx[jj] * word_count,similarities);
+	}
+    }
+
+    /* When the observation is exhausted early, the remaining slots hold distinct unused atoms with zero weight. */
+
+    for (ii = selected_count, jj = 0; ii < coeff_count; ii++, jj++) {
+	while (used_column_mask[jj]) {
+	    jj += 1;
+	}
+
+	o_coeffs[ii] = 0;
+	o_coeffs_idx[ii] = (coeff_idx_t)jj;
+    }
 }
 
 #define SPARSE_NET_INITIAL_STEP 0.001
@@ -349,8 +507,8 @@ _sparse_net_cost_value(
     params = (struct _sparse_net_cost_params*)params_t;
 
     dgemv('N',(int)params->geometry,(int)params->word_count,1,(double*)params->dict_transp,(int)params->geometry,(double*)current_coeffs->data,1,0,params->local_coeffs,1);
-    daxpy((int)params->geometry,-1,(double*)params->observation,1,params->local_coeffs,1);
-    norm = dnrm2((int)params->geometry,(double*)params->local_coeffs,1);
+    small_daxpy(params->geometry,-1,params->observation,params->local_coeffs);
+    norm = small_dnrm2(params->geometry,params->local_coeffs);
     approx_term = 0.5 * norm * norm;
 
     reg_term_sum = 0;
@@ -398,7 +556,7 @@ _sparse_net_cost_value_grad(
 void
 sparse_net(
     double* restrict        o_coeffs,
-    size_t* restrict        o_coeffs_idx,
+    coeff_idx_t* restrict   o_coeffs_idx,
     size_t                  geometry,
     size_t                  word_count,
     const double* restrict  dict,
@@ -410,7 +568,6 @@ sparse_net(
     void* restrict          coding_tmps) {
     char* restrict                  curr_coding_tmps;
     double* restrict                initial_coeffs;
-    size_t* restrict                initial_coeffs_idx;
     double* restrict                local_coeffs;
     double                          lambda_sigma_ratio;
     double                          sigma;
@@ -428,8 +585,6 @@ sparse_net(
     
     initial_coeffs = (double* restrict)curr_coding_tmps;
     curr_coding_tmps += word_count * sizeof(double);
-    initial_coeffs_idx = (size_t* restrict)curr_coding_tmps;
-    curr_coding_tmps += word_count * sizeof(size_t);
     local_coeffs = (double* restrict)curr_coding_tmps;
     curr_coding_tmps += geometry * sizeof(double);
 
@@ -443,8 +598,6 @@ sparse_net(
         initial_coeffs[ii] = 0.1 * gsl_rng_uniform(rnd_generator) - 0.05;
     }
 
-    fill_idx_1n(initial_coeffs_idx,word_count);
-
     initial_coeffs_block.size = word_count;
     initial_coeffs_block.data = initial_coeffs;
     initial_coeffs_vector.size = word_count;
@@ -488,8 +641,5 @@ sparse_net(
 
     gsl_multimin_fdfminimizer_free(minimizer);
 
-    sort_by_abs_coeffs(initial_coeffs,initial_coeffs_idx,word_count);
-
-    memcpy(o_coeffs,initial_coeffs,coeff_count * sizeof(double));
-    memcpy(o_coeffs_idx,initial_coeffs_idx,coeff_count * sizeof(size_t));
+    top_k_by_abs(o_coeffs,o_coeffs_idx,word_count,coeff_count,initial_coeffs);
 }
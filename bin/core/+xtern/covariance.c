@@ -0,0 +1,137 @@
+#include <string.h>
+
+#include "acml/acml.h"
+
+#include "covariance.h"
+
+/* The running state is a mean and a scatter matrix (the sum of outer products of centered observations). Only the
+   upper triangle of a scatter matrix is maintained until "covariance_finish" is called. */
+
+size_t
+covariance_tmps_length(
+    size_t  geometry,
+    size_t  chunk_count) {
+    return geometry * chunk_count * sizeof(double) + // for "chunk_centered".
+           geometry * sizeof(double) +               // for "chunk_mean".
+           geometry * geometry * sizeof(double);     // for "chunk_scatter".
+}
+
+void
+covariance_accumulate(
+    double* restrict        io_mean,
+    double* restrict        io_scatter,
+    size_t* restrict        io_count,
+    size_t                  geometry,
+    size_t                  count,
+    const double* restrict  sample,
+    size_t                  chunk_count,
+    void* restrict          tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  chunk_centered;
+    double* restrict  chunk_mean;
+    double* restrict  chunk_scatter;
+    size_t            curr_chunk_count;
+    size_t            ii;
+    size_t            jj;
+
+    curr_tmps = (char*)tmps;
+    chunk_centered = (double*)curr_tmps;
+    curr_tmps += geometry * chunk_count * sizeof(double);
+    chunk_mean = (double*)curr_tmps;
+    curr_tmps += geometry * sizeof(double);
+    chunk_scatter = (double*)curr_tmps;
+    curr_tmps += geometry * geometry * sizeof(double);
+
+    /* Each chunk is centered on its own mean, reduced to a scatter matrix with one "dsyrk" and then merged into the
+       running state. Centering per chunk keeps the sums well conditioned even when the data is far from the origin. */
+
+    for (ii = 0; ii < count; ii += chunk_count) {
+        curr_chunk_count = (count - ii) < chunk_count ? (count - ii) : chunk_count;
+
+        memcpy(chunk_centered,sample + ii * geometry,geometry * curr_chunk_count * sizeof(double));
+
+        memset(chunk_mean,0,geometry * sizeof(double));
+        for (jj = 0; jj < curr_chunk_count; jj++) {
+            daxpy((int)geometry,1,chunk_centered + jj * geometry,1,chunk_mean,1);
+        }
+        dscal((int)geometry,1.0 / (double)curr_chunk_count,chunk_mean,1);
+
+        for (jj = 0; jj < curr_chunk_count; jj++) {
+            daxpy((int)geometry,-1,chunk_mean,1,chunk_centered + jj * geometry,1);
+        }
+
+        dsyrk('U','N',(int)geometry,(int)curr_chunk_count,1,chunk_centered,(int)geometry,0,chunk_scatter,(int)geometry);
+
+        covariance_merge(io_mean,io_scatter,io_count,geometry,chunk_mean,chunk_scatter,curr_chunk_count);
+    }
+}
+
+void
+covariance_merge(
+    double* restrict        io_mean,
+    double* restrict        io_scatter,
+    size_t* restrict        io_count,
+    size_t                  geometry,
+    const double* restrict  other_mean,
+    const double* restrict  other_scatter,
+    size_t                  other_count) {
+    double  new_count;
+    double  correction;
+    double  delta_jj;
+    size_t  ii;
+    size_t  jj;
+
+    if (other_count == 0) {
+        return;
+    }
+
+    if (*io_count == 0) {
+        memcpy(io_mean,other_mean,geometry * sizeof(double));
+        memcpy(io_scatter,other_scatter,geometry * geometry * sizeof(double));
+        *io_count = other_count;
+        return;
+    }
+
+    /* Pairwise update of Chan, Golub and LeVeque: the scatter of the union is the sum of the two scatters plus a
+       rank-one correction along the difference of the means. */
+
+    new_count = (double)(*io_count + other_count);
+    correction = (double)*io_count * (double)other_count / new_count;
+
+    for (jj = 0; jj < geometry; jj++) {
+        delta_jj = other_mean[jj] - io_mean[jj];
+
+        for (ii = 0; ii <= jj; ii++) {
+            io_scatter[jj * geometry + ii] += other_scatter[jj * geometry + ii] + correction * (other_mean[ii] - io_mean[ii]) * delta_jj;
+        }
+    }
+
+    for (ii = 0; ii < geometry; ii++) {
+        io_mean[ii] += (double)other_count / new_count * (other_mean[ii] - io_mean[ii]);
+    }
+
+    *io_count = *io_count + other_count;
+}
+
+void
+covariance_finish(
+    double* restrict  io_scatter,
+    size_t            geometry,
+    size_t            count) {
+    double  norm;
+    size_t  ii;
+    size_t  jj;
+
+    /* Turns the scatter matrix into the unbiased covariance estimate, with both triangles filled in. */
+
+    norm = count > 1 ? 1.0 / (double)(count - 1) : 0;
+
+    for (jj = 0; jj < geometry; jj++) {
+        for (ii = 0; ii < jj; ii++) {
+            io_scatter[jj * geometry + ii] *= norm;
+            io_scatter[ii * geometry + jj] = io_scatter[jj * geometry + ii];
+        }
+
+        io_scatter[jj * geometry + jj] *= norm;
+    }
+}
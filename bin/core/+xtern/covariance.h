@@ -0,0 +1,16 @@
+#ifndef _COVARIANCE_H
+#define _COVARIANCE_H
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern size_t  covariance_tmps_length(size_t geometry,size_t chunk_count);
+
+extern void    covariance_accumulate(double* restrict io_mean,double* restrict io_scatter,size_t* restrict io_count,size_t geometry,size_t count,const double* restrict sample,size_t chunk_count,void* restrict tmps);
+extern void    covariance_merge(double* restrict io_mean,double* restrict io_scatter,size_t* restrict io_count,size_t geometry,const double* restrict other_mean,const double* restrict other_scatter,size_t other_count);
+extern void    covariance_finish(double* restrict io_scatter,size_t geometry,size_t count);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,624 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "csc_file.h"
+
+/* A CSC file holds a sparse matrix which is built one chunk of columns at a time, and which is never fully in memory
+   for either the writer or the reader. After a fixed header come the columns, in order. Each column is its count of
+   nonzeros as a 32 bit integer, the values as doubles, the length in bytes of the row indices as a 32 bit integer and
+   the row indices themselves. Indices are either raw 32 bit integers or, for columns with ascending indices, the
+   differences between consecutive ones as base 128 varints, which are one or two bytes each for most coded images.
+   Values are either doubles, IEEE half precision floats, 8 bit integers scaled by a per column double, or 8 bit
+   positions into a codebook of at most 256 distinct doubles, shared by the whole file. The last two need 1 byte per
+   value, and the codebook is exact for the few distinct values of the "GLOBAL_ORDER" nonlinearity. The codebook, and
+   after it a table with the offset of every column, plus one for the end of the last column, follow the columns, and
+   the header is rewritten on close to point to them. Version 1 files have a shorter header and only doubles for
+   values, and are still read. All numbers are in the byte order of the host. */
+
+#define INITIAL_COL_OFFSETS_CAPACITY 1024
+
+size_t
+csc_varint_delta_max_length(
+    size_t  count) {
+    return count * ((sizeof(size_t) * 8 + 6) / 7);
+}
+
+size_t
+csc_varint_delta_encode(
+    uint8_t* restrict       o_bytes,
+    size_t                  count,
+    const size_t* restrict  idx) {
+    size_t  length;
+    size_t  previous;
+    size_t  delta;
+    size_t  ii;
+
+    length = 0;
+    previous = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	delta = idx[ii] - previous;
+	previous = idx[ii];
+
+	while (delta >= 0x80) {
+	    o_bytes[length] = (uint8_t)((delta & 0x7f) | 0x80);
+	    length += 1;
+	    delta >>= 7;
+	}
+
+	o_bytes[length] = (uint8_t)delta;
+	length += 1;
+    }
+
+    return length;
+}
+
+void
+csc_varint_delta_decode(
+    size_t* restrict         o_idx,
+    size_t                   count,
+    const uint8_t* restrict  bytes) {
+    size_t  previous;
+    size_t  delta;
+    size_t  shift;
+    size_t  ii;
+
+    previous = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	delta = 0;
+	shift = 0;
+
+	while (*bytes & 0x80) {
+	    delta |= (size_t)(*bytes & 0x7f) << shift;
+	    shift += 7;
+	    bytes += 1;
+	}
+
+	delta |= (size_t)*bytes << shift;
+	bytes += 1;
+
+	previous += delta;
+	o_idx[ii] = previous;
+    }
+}
+
+size_t
+csc_value_length(
+    enum csc_value_encoding  value_encoding,
+    size_t                   count) {
+    if (value_encoding == VALUE_FLOAT64) {
+	return count * sizeof(double);
+    } else if (value_encoding == VALUE_FLOAT16) {
+	return count * sizeof(uint16_t);
+    } else if (value_encoding == VALUE_INT8) {
+	return count > 0 ? sizeof(double) + count * sizeof(int8_t) : 0;
+    } else {
+	return count * sizeof(uint8_t);
+    }
+}
+
+void
+csc_float16_encode(
+    uint8_t* restrict       o_bytes,
+    size_t                  count,
+    const double* restrict  values) {
+    uint64_t  bits;
+    uint64_t  mantissa;
+    uint64_t  remainder;
+    uint64_t  halfway;
+    int       exponent;
+    uint16_t  half;
+    size_t    shift;
+    size_t    ii;
+
+    /* Conversion works on the bits of the double directly, rounding to nearest even, so no value is rounded twice.
+       Values too large for a half become infinities and values too small become zeros of the same sign. */
+
+    for (ii = 0; ii < count; ii++) {
+	memcpy(&bits,values + ii,sizeof(uint64_t));
+
+	half = (uint16_t)((bits >> 48) & 0x8000);
+	exponent = (int)((bits >> 52) & 0x7ff);
+	mantissa = bits & 0xfffffffffffffULL;
+
+	if (exponent == 0x7ff) {
+	    half |= (uint16_t)(mantissa != 0 ? 0x7e00 : 0x7c00);
+	} else if (exponent - 1008 >= 31) {
+	    half |= 0x7c00;
+	} else if (exponent - 1008 >= 1) {
+	    remainder = mantissa & 0x3ffffffffffULL;
+	    halfway = 0x20000000000ULL;
+	    half |= (uint16_t)(((uint64_t)(exponent - 1008) << 10) | (mantissa >> 42));
+
+	    if ((remainder > halfway) || ((remainder == halfway) && (half & 1))) {
+		half += 1;
+	    }
+	} else if (exponent - 1008 >= -10) {
+	    mantissa |= 0x10000000000000ULL;
+	    shift = (size_t)(43 - (exponent - 1008));
+	    remainder = mantissa & ((1ULL << shift) - 1);
+	    halfway = 1ULL << (shift - 1);
+	    half |= (uint16_t)(mantissa >> shift);
+
+	    if ((remainder > halfway) || ((remainder == halfway) && (half & 1))) {
+		half += 1;
+	    }
+	}
+
+	memcpy(o_bytes + ii * sizeof(uint16_t),&half,sizeof(uint16_t));
+    }
+}
+
+void
+csc_float16_decode(
+    double* restrict         o_values,
+    size_t                   count,
+    const uint8_t* restrict  bytes) {
+    uint16_t  half;
+    int       exponent;
+    double    magnitude;
+    size_t    ii;
+
+    for (ii = 0; ii < count; ii++) {
+	memcpy(&half,bytes + ii * sizeof(uint16_t),sizeof(uint16_t));
+
+	exponent = (half >> 10) & 0x1f;
+
+	if (exponent == 0) {
+	    magnitude = ldexp((double)(half & 0x3ff),-24);
+	} else if (exponent == 0x1f) {
+	    magnitude = (half & 0x3ff) != 0 ? NAN : HUGE_VAL;
+	} else {
+	    magnitude = ldexp((double)((half & 0x3ff) | 0x400),exponent - 25);
+	}
+
+	o_values[ii] = (half & 0x8000) ? -magnitude : magnitude;
+    }
+}
+
+void
+csc_int8_encode(
+    uint8_t* restrict       o_bytes,
+    size_t                  count,
+    const double* restrict  values) {
+    double  max_abs;
+    double  scale;
+    double  level;
+    int8_t  quantized;
+    size_t  ii;
+
+    if (count == 0) {
+	return;
+    }
+
+    /* Levels are symmetric around zero, so values of both signs keep the same precision. */
+
+    max_abs = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	if (fabs(values[ii]) > max_abs) {
+	    max_abs = fabs(values[ii]);
+	}
+    }
+
+    scale = max_abs / 127;
+    memcpy(o_bytes,&scale,sizeof(double));
+
+    for (ii = 0; ii < count; ii++) {
+	level = scale > 0 ? round(values[ii] / scale) : 0;
+	quantized = (int8_t)(level > 127 ? 127 : level < -127 ? -127 : level);
+	o_bytes[sizeof(double) + ii] = (uint8_t)quantized;
+    }
+}
+
+void
+csc_int8_decode(
+    double* restrict         o_values,
+    size_t                   count,
+    const uint8_t* restrict  bytes) {
+    double  scale;
+    size_t  ii;
+
+    if (count == 0) {
+	return;
+    }
+
+    memcpy(&scale,bytes,sizeof(double));
+
+    for (ii = 0; ii < count; ii++) {
+	o_values[ii] = scale * (double)(int8_t)bytes[sizeof(double) + ii];
+    }
+}
+
+bool
+csc_codebook_encode(
+    uint8_t* restrict       o_bytes,
+    double* restrict        io_codebook,
+    size_t* restrict        io_codebook_count,
+    size_t                  count,
+    const double* restrict  values) {
+    size_t  code;
+    size_t  ii;
+
+    /* Values enter the codebook in the order they are first seen. Consecutive values are often equal, so the last
+       code is tried first. */
+
+    code = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	if ((code >= *io_codebook_count) || (io_codebook[code] != values[ii])) {
+	    for (code = 0; (code < *io_codebook_count) && (io_codebook[code] != values[ii]); code++) {
+	    }
+
+	    if (code == *io_codebook_count) {
+		if (*io_codebook_count == CSC_CODEBOOK_MAX_COUNT) {
+		    return false;
+		}
+
+		io_codebook[code] = values[ii];
+		*io_codebook_count += 1;
+	    }
+	}
+
+	o_bytes[ii] = (uint8_t)code;
+    }
+
+    return true;
+}
+
+void
+csc_codebook_decode(
+    double* restrict         o_values,
+    size_t                   count,
+    const double* restrict   codebook,
+    const uint8_t* restrict  bytes) {
+    size_t  ii;
+
+    for (ii = 0; ii < count; ii++) {
+	o_values[ii] = codebook[bytes[ii]];
+    }
+}
+
+bool
+csc_file_writer_open(
+    struct csc_file_writer* restrict  o_writer,
+    const char* restrict              path,
+    size_t                            row_count,
+    enum csc_index_encoding           index_encoding,
+    enum csc_value_encoding           value_encoding) {
+    o_writer->file = fopen(path,"wb");
+
+    if (o_writer->file == NULL) {
+	return false;
+    }
+
+    memset(&o_writer->header,0,sizeof(struct csc_file_header));
+    o_writer->header.magic = CSC_FILE_MAGIC;
+    o_writer->header.version = CSC_FILE_VERSION;
+    o_writer->header.index_encoding = (uint64_t)index_encoding;
+    o_writer->header.row_count = row_count;
+    o_writer->header.value_encoding = (uint64_t)value_encoding;
+
+    o_writer->col_offsets = (uint64_t*)malloc(INITIAL_COL_OFFSETS_CAPACITY * sizeof(uint64_t));
+    o_writer->col_offsets_capacity = INITIAL_COL_OFFSETS_CAPACITY;
+    o_writer->current_offset = sizeof(struct csc_file_header);
+    o_writer->index_buffer = NULL;
+    o_writer->index_buffer_capacity = 0;
+    o_writer->value_buffer = NULL;
+    o_writer->value_buffer_capacity = 0;
+    o_writer->codebook_count = 0;
+    o_writer->codebook_overflow = false;
+
+    /* The header is a placeholder until the writer is closed. */
+
+    if (fwrite(&o_writer->header,sizeof(struct csc_file_header),1,o_writer->file) != 1) {
+	fclose(o_writer->file);
+	free(o_writer->col_offsets);
+	return false;
+    }
+
+    return true;
+}
+
+bool
+csc_file_writer_append(
+    struct csc_file_writer* restrict  io_writer,
+    size_t                            col_count,
+    const double* restrict            pr,
+    const size_t* restrict            ir,
+    const size_t* restrict            jc) {
+    enum csc_value_encoding  value_encoding;
+    const double*            col_pr;
+    uint32_t                 col_nnz;
+    const uint8_t*           values;
+    size_t                   value_length;
+    uint32_t                 index_length;
+    size_t                   ii;
+    size_t                   jj;
+    bool                     ok;
+
+    if (io_writer->header.col_count + col_count + 1 > io_writer->col_offsets_capacity) {
+	while (io_writer->header.col_count + col_count + 1 > io_writer->col_offsets_capacity) {
+	    io_writer->col_offsets_capacity *= 2;
+	}
+
+	io_writer->col_offsets = (uint64_t*)realloc(io_writer->col_offsets,io_writer->col_offsets_capacity * sizeof(uint64_t));
+    }
+
+    value_encoding = (enum csc_value_encoding)io_writer->header.value_encoding;
+    ok = true;
+
+    for (ii = 0; ok && (ii < col_count); ii++) {
+	col_nnz = (uint32_t)(jc[ii + 1] - jc[ii]);
+	col_pr = pr + jc[ii] - jc[0];
+	value_length = csc_value_length(value_encoding,col_nnz);
+
+	if ((value_encoding != VALUE_FLOAT64) && (value_length > io_writer->value_buffer_capacity)) {
+	    io_writer->value_buffer_capacity = value_length;
+	    io_writer->value_buffer = (uint8_t*)realloc(io_writer->value_buffer,io_writer->value_buffer_capacity);
+	}
+
+	if (value_encoding == VALUE_FLOAT64) {
+	    values = (const uint8_t*)col_pr;
+	} else if (value_encoding == VALUE_FLOAT16) {
+	    csc_float16_encode(io_writer->value_buffer,col_nnz,col_pr);
+	    values = io_writer->value_buffer;
+	} else if (value_encoding == VALUE_INT8) {
+	    csc_int8_encode(io_writer->value_buffer,col_nnz,col_pr);
+	    values = io_writer->value_buffer;
+	} else {
+	    ok = csc_codebook_encode(io_writer->value_buffer,io_writer->codebook,&io_writer->codebook_count,col_nnz,col_pr);
+	    io_writer->codebook_overflow = !ok;
+	    values = io_writer->value_buffer;
+	}
+
+	if (csc_varint_delta_max_length(col_nnz) > io_writer->index_buffer_capacity) {
+	    io_writer->index_buffer_capacity = csc_varint_delta_max_length(col_nnz);
+	    io_writer->index_buffer = (uint8_t*)realloc(io_writer->index_buffer,io_writer->index_buffer_capacity);
+	}
+
+	if (io_writer->header.index_encoding == INDEX_RAW) {
+	    for (jj = 0; jj < col_nnz; jj++) {
+		((uint32_t*)io_writer->index_buffer)[jj] = (uint32_t)ir[jc[ii] - jc[0] + jj];
+	    }
+
+	    index_length = col_nnz * (uint32_t)sizeof(uint32_t);
+	} else {
+	    index_length = (uint32_t)csc_varint_delta_encode(io_writer->index_buffer,col_nnz,ir + jc[ii] - jc[0]);
+	}
+
+	io_writer->col_offsets[io_writer->header.col_count] = io_writer->current_offset;
+
+	ok = ok && (fwrite(&col_nnz,sizeof(uint32_t),1,io_writer->file) == 1);
+	ok = ok && (fwrite(values,1,value_length,io_writer->file) == value_length);
+	ok = ok && (fwrite(&index_length,sizeof(uint32_t),1,io_writer->file) == 1);
+	ok = ok && (fwrite(io_writer->index_buffer,1,index_length,io_writer->file) == index_length);
+
+	io_writer->current_offset += 2 * sizeof(uint32_t) + value_length + index_length;
+	io_writer->header.col_count += 1;
+	io_writer->header.nnz += col_nnz;
+    }
+
+    return ok;
+}
+
+bool
+csc_file_writer_close(
+    struct csc_file_writer* restrict  io_writer) {
+    uint64_t  padding;
+    size_t    padding_length;
+    bool      ok;
+
+    /* The codebook and the offsets table are aligned, so a reader can use them in place. */
+
+    padding = 0;
+    padding_length = (sizeof(uint64_t) - io_writer->current_offset % sizeof(uint64_t)) % sizeof(uint64_t);
+
+    io_writer->col_offsets[io_writer->header.col_count] = io_writer->current_offset;
+    io_writer->header.codebook_offset = io_writer->current_offset + padding_length;
+    io_writer->header.codebook_count = io_writer->codebook_count;
+    io_writer->header.col_offsets_offset = io_writer->header.codebook_offset + io_writer->codebook_count * sizeof(double);
+    io_writer->header.file_length = io_writer->header.col_offsets_offset + (io_writer->header.col_count + 1) * sizeof(uint64_t);
+
+    ok = fwrite(&padding,1,padding_length,io_writer->file) == padding_length;
+    ok = ok && fwrite(io_writer->codebook,sizeof(double),io_writer->codebook_count,io_writer->file) == io_writer->codebook_count;
+    ok = ok && fwrite(io_writer->col_offsets,sizeof(uint64_t),io_writer->header.col_count + 1,io_writer->file) == io_writer->header.col_count + 1;
+    ok = ok && (fseek(io_writer->file,0,SEEK_SET) == 0);
+    ok = ok && (fwrite(&io_writer->header,sizeof(struct csc_file_header),1,io_writer->file) == 1);
+    ok = (fclose(io_writer->file) == 0) && ok;
+
+    free(io_writer->value_buffer);
+    free(io_writer->index_buffer);
+    free(io_writer->col_offsets);
+
+    io_writer->file = NULL;
+    io_writer->col_offsets = NULL;
+    io_writer->index_buffer = NULL;
+    io_writer->value_buffer = NULL;
+
+    return ok;
+}
+
+bool
+csc_file_open(
+    struct csc_file* restrict  o_file,
+    const char* restrict       path) {
+    int          fd;
+    struct stat  file_stat;
+    void*        map;
+
+    fd = open(path,O_RDONLY);
+
+    if (fd == -1) {
+	return false;
+    }
+
+    if ((fstat(fd,&file_stat) != 0) || ((size_t)file_stat.st_size < CSC_FILE_V1_HEADER_LENGTH)) {
+	close(fd);
+	return false;
+    }
+
+    map = mmap(NULL,(size_t)file_stat.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+	return false;
+    }
+
+    memset(&o_file->header,0,sizeof(struct csc_file_header));
+    memcpy(&o_file->header,map,CSC_FILE_V1_HEADER_LENGTH);
+
+    if ((o_file->header.version == CSC_FILE_VERSION) && ((size_t)file_stat.st_size >= sizeof(struct csc_file_header))) {
+	memcpy(&o_file->header,map,sizeof(struct csc_file_header));
+    }
+
+    /* A file whose writer was never closed still has the placeholder header, and is rejected here. */
+
+    if ((o_file->header.magic != CSC_FILE_MAGIC) || (o_file->header.version < 1) || (o_file->header.version > CSC_FILE_VERSION) ||
+	(o_file->header.index_encoding > INDEX_VARINT_DELTA) || (o_file->header.value_encoding > VALUE_CODEBOOK) ||
+	(o_file->header.file_length != (uint64_t)file_stat.st_size) ||
+	(o_file->header.col_offsets_offset + (o_file->header.col_count + 1) * sizeof(uint64_t) != o_file->header.file_length) ||
+	(o_file->header.col_offsets_offset % sizeof(uint64_t) != 0) || (o_file->header.codebook_count > CSC_CODEBOOK_MAX_COUNT) ||
+	(o_file->header.codebook_offset % sizeof(uint64_t) != 0) ||
+	(o_file->header.codebook_offset + o_file->header.codebook_count * sizeof(double) > o_file->header.col_offsets_offset)) {
+	munmap(map,(size_t)file_stat.st_size);
+	return false;
+    }
+
+    madvise(map,(size_t)file_stat.st_size,MADV_SEQUENTIAL);
+
+    o_file->map = map;
+    o_file->data = (const char*)map;
+    o_file->col_offsets = (const uint64_t*)((const char*)map + o_file->header.col_offsets_offset);
+    o_file->codebook = (const double*)((const char*)map + o_file->header.codebook_offset);
+
+    return true;
+}
+
+void
+csc_file_close(
+    struct csc_file* restrict  io_file) {
+    munmap(io_file->map,io_file->header.file_length);
+
+    io_file->map = NULL;
+    io_file->data = NULL;
+    io_file->col_offsets = NULL;
+    io_file->codebook = NULL;
+}
+
+size_t
+csc_file_chunk_nnz(
+    const struct csc_file* restrict  file,
+    size_t                           first,
+    size_t                           count) {
+    uint32_t  col_nnz;
+    size_t    nnz;
+    size_t    ii;
+
+    if (first >= file->header.col_count) {
+	return 0;
+    }
+
+    if (count > file->header.col_count - first) {
+	count = file->header.col_count - first;
+    }
+
+    nnz = 0;
+
+    for (ii = first; ii < first + count; ii++) {
+	memcpy(&col_nnz,file->data + file->col_offsets[ii],sizeof(uint32_t));
+	nnz += col_nnz;
+    }
+
+    return nnz;
+}
+
+size_t
+csc_file_read_chunk(
+    double* restrict                 o_pr,
+    size_t* restrict                 o_ir,
+    size_t* restrict                 o_jc,
+    const struct csc_file* restrict  file,
+    size_t                           first,
+    size_t                           count) {
+    enum csc_value_encoding  value_encoding;
+    const char*              column;
+    const uint8_t*           values;
+    uint32_t                 col_nnz;
+    uint32_t                 raw_idx;
+    size_t                   current_nnz;
+    size_t                   kept_nnz;
+    size_t                   ii;
+    size_t                   jj;
+
+    if (first >= file->header.col_count) {
+	o_jc[0] = 0;
+	return 0;
+    }
+
+    if (count > file->header.col_count - first) {
+	count = file->header.col_count - first;
+    }
+
+    /* Columns are packed, so values and raw indices are copied out rather than read in place. */
+
+    value_encoding = (enum csc_value_encoding)file->header.value_encoding;
+    current_nnz = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	column = file->data + file->col_offsets[first + ii];
+	memcpy(&col_nnz,column,sizeof(uint32_t));
+	values = (const uint8_t*)(column + sizeof(uint32_t));
+
+	if (value_encoding == VALUE_FLOAT64) {
+	    memcpy(o_pr + current_nnz,values,col_nnz * sizeof(double));
+	} else if (value_encoding == VALUE_FLOAT16) {
+	    csc_float16_decode(o_pr + current_nnz,col_nnz,values);
+	} else if (value_encoding == VALUE_INT8) {
+	    csc_int8_decode(o_pr + current_nnz,col_nnz,values);
+	} else {
+	    csc_codebook_decode(o_pr + current_nnz,col_nnz,file->codebook,values);
+	}
+
+	column += 2 * sizeof(uint32_t) + csc_value_length(value_encoding,col_nnz);
+
+	if (file->header.index_encoding == INDEX_RAW) {
+	    for (jj = 0; jj < col_nnz; jj++) {
+		memcpy(&raw_idx,column + jj * sizeof(uint32_t),sizeof(uint32_t));
+		o_ir[current_nnz + jj] = raw_idx;
+	    }
+	} else {
+	    csc_varint_delta_decode(o_ir + current_nnz,col_nnz,(const uint8_t*)column);
+	}
+
+	o_jc[ii] = current_nnz;
+
+	/* Values too small for a lossy encoding come back as zeros, and are dropped, as MATLAB never stores them. */
+
+	if ((value_encoding == VALUE_FLOAT16) || (value_encoding == VALUE_INT8)) {
+	    kept_nnz = 0;
+
+	    for (jj = 0; jj < col_nnz; jj++) {
+		if (o_pr[current_nnz + jj] != 0) {
+		    o_pr[current_nnz + kept_nnz] = o_pr[current_nnz + jj];
+		    o_ir[current_nnz + kept_nnz] = o_ir[current_nnz + jj];
+		    kept_nnz += 1;
+		}
+	    }
+
+	    current_nnz += kept_nnz;
+	} else {
+	    current_nnz += col_nnz;
+	}
+    }
+
+    o_jc[count] = current_nnz;
+
+    return count;
+}
@@ -0,0 +1,88 @@
+#ifndef _CSC_FILE_H
+#define _CSC_FILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+#define CSC_FILE_MAGIC 0x31435343454c4946ULL
+#define CSC_FILE_VERSION 2
+#define CSC_FILE_V1_HEADER_LENGTH (8 * sizeof(uint64_t))
+#define CSC_CODEBOOK_MAX_COUNT 256
+
+enum csc_index_encoding {
+    INDEX_RAW,
+    INDEX_VARINT_DELTA
+};
+
+enum csc_value_encoding {
+    VALUE_FLOAT64,
+    VALUE_FLOAT16,
+    VALUE_INT8,
+    VALUE_CODEBOOK
+};
+
+struct csc_file_header {
+    uint64_t  magic;
+    uint64_t  version;
+    uint64_t  index_encoding;
+    uint64_t  row_count;
+    uint64_t  col_count;
+    uint64_t  nnz;
+    uint64_t  col_offsets_offset;
+    uint64_t  file_length;
+    uint64_t  value_encoding;
+    uint64_t  codebook_offset;
+    uint64_t  codebook_count;
+};
+
+struct csc_file_writer {
+    FILE*                   file;
+    struct csc_file_header  header;
+    uint64_t*               col_offsets;
+    size_t                  col_offsets_capacity;
+    uint64_t                current_offset;
+    uint8_t*                index_buffer;
+    size_t                  index_buffer_capacity;
+    uint8_t*                value_buffer;
+    size_t                  value_buffer_capacity;
+    double                  codebook[CSC_CODEBOOK_MAX_COUNT];
+    size_t                  codebook_count;
+    bool                    codebook_overflow;
+};
+
+struct csc_file {
+    struct csc_file_header  header;
+    void*                   map;
+    const char*             data;
+    const uint64_t*         col_offsets;
+    const double*           codebook;
+};
+
+extern size_t  csc_varint_delta_max_length(size_t count);
+extern size_t  csc_varint_delta_encode(uint8_t* restrict o_bytes,size_t count,const size_t* restrict idx);
+extern void    csc_varint_delta_decode(size_t* restrict o_idx,size_t count,const uint8_t* restrict bytes);
+extern size_t  csc_value_length(enum csc_value_encoding value_encoding,size_t count);
+extern void    csc_float16_encode(uint8_t* restrict o_bytes,size_t count,const double* restrict values);
+extern void    csc_float16_decode(double* restrict o_values,size_t count,const uint8_t* restrict bytes);
+extern void    csc_int8_encode(uint8_t* restrict o_bytes,size_t count,const double* restrict values);
+extern void    csc_int8_decode(double* restrict o_values,size_t count,const uint8_t* restrict bytes);
+extern bool    csc_codebook_encode(uint8_t* restrict o_bytes,double* restrict io_codebook,size_t* restrict io_codebook_count,size_t count,const double* restrict values);
+extern void    csc_codebook_decode(double* restrict o_values,size_t count,const double* restrict codebook,const uint8_t* restrict bytes);
+
+extern bool    csc_file_writer_open(struct csc_file_writer* restrict o_writer,const char* restrict path,size_t row_count,enum csc_index_encoding index_encoding,enum csc_value_encoding value_encoding);
+extern bool    csc_file_writer_append(struct csc_file_writer* restrict io_writer,size_t col_count,const double* restrict pr,const size_t* restrict ir,const size_t* restrict jc);
+extern bool    csc_file_writer_close(struct csc_file_writer* restrict io_writer);
+
+extern bool    csc_file_open(struct csc_file* restrict o_file,const char* restrict path);
+extern void    csc_file_close(struct csc_file* restrict io_file);
+extern size_t  csc_file_chunk_nnz(const struct csc_file* restrict file,size_t first,size_t count);
+extern size_t  csc_file_read_chunk(double* restrict o_pr,size_t* restrict o_ir,size_t* restrict o_jc,const struct csc_file* restrict file,size_t first,size_t count);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dataset_file.h"
+
+/* A dataset file is a fixed header followed by the observations, stored contiguously one after the other in column
+   major order, each "row_count" x "col_count" x "layer_count" values of one type. Records have "col_count" and
+   "layer_count" equal to one, and "kind" tells them apart from single column images. When present, one based label
+   indices follow as 32 bit integers, and then the label names, separated by newlines. The observations start on a
+   page boundary, so a mapped file can be used in place, and only the pages actually touched are read from disk. All
+   numbers are in the byte order of the host. */
+
+#define WRITE_CHUNK_LENGTH 65536
+
+static size_t
+align_up(
+    size_t  value,
+    size_t  alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t
+dataset_dtype_size(
+    enum dataset_dtype  dtype) {
+    if (dtype == DTYPE_FLOAT64) {
+	return sizeof(double);
+    } else if (dtype == DTYPE_FLOAT32) {
+	return sizeof(float);
+    } else {
+	return sizeof(uint8_t);
+    }
+}
+
+void
+dataset_file_header_init(
+    struct dataset_file_header* restrict  o_header,
+    enum dataset_kind                     kind,
+    enum dataset_dtype                    dtype,
+    size_t                                row_count,
+    size_t                                col_count,
+    size_t                                layer_count,
+    size_t                                count,
+    bool                                  has_labels,
+    size_t                                label_names_length) {
+    size_t  data_length;
+
+    data_length = row_count * col_count * layer_count * count * dataset_dtype_size(dtype);
+
+    memset(o_header,0,sizeof(struct dataset_file_header));
+
+    o_header->magic = DATASET_FILE_MAGIC;
+    o_header->version = DATASET_FILE_VERSION;
+    o_header->kind = (uint64_t)kind;
+    o_header->dtype = (uint64_t)dtype;
+    o_header->row_count = row_count;
+    o_header->col_count = col_count;
+    o_header->layer_count = layer_count;
+    o_header->count = count;
+    o_header->has_labels = has_labels ? 1 : 0;
+    o_header->label_names_length = has_labels ? label_names_length : 0;
+    o_header->data_offset = align_up(sizeof(struct dataset_file_header),DATASET_FILE_ALIGNMENT);
+    o_header->labels_offset = align_up(o_header->data_offset + data_length,sizeof(uint64_t));
+    o_header->label_names_offset = o_header->labels_offset + (has_labels ? count * sizeof(uint32_t) : 0);
+    o_header->file_length = o_header->label_names_offset + o_header->label_names_length;
+}
+
+bool
+dataset_file_write(
+    const char* restrict                        path,
+    const struct dataset_file_header* restrict  header,
+    const double* restrict                      sample,
+    const uint32_t* restrict                    labels_idx,
+    const char* restrict                        label_names) {
+    FILE*    file;
+    char     chunk[WRITE_CHUNK_LENGTH];
+    size_t   value_size;
+    size_t   values_count;
+    size_t   chunk_values_count;
+    size_t   written;
+    size_t   ii;
+    size_t   jj;
+    bool     ok;
+
+    file = fopen(path,"wb");
+
+    if (file == NULL) {
+	return false;
+    }
+
+    value_size = dataset_dtype_size((enum dataset_dtype)header->dtype);
+    values_count = header->row_count * header->col_count * header->layer_count * header->count;
+    ok = fwrite(header,sizeof(struct dataset_file_header),1,file) == 1;
+    ok = ok && (fseek(file,(long)header->data_offset,SEEK_SET) == 0);
+
+    /* Values are narrowed to the stored type a chunk at a time, so no copy of the whole sample is ever made. */
+
+    for (ii = 0; ok && (ii < values_count); ii += chunk_values_count) {
+	chunk_values_count = values_count - ii < WRITE_CHUNK_LENGTH / value_size ? values_count - ii : WRITE_CHUNK_LENGTH / value_size;
+
+	for (jj = 0; jj < chunk_values_count; jj++) {
+	    if (header->dtype == DTYPE_FLOAT64) {
+		((double*)chunk)[jj] = sample[ii + jj];
+	    } else if (header->dtype == DTYPE_FLOAT32) {
+		((float*)chunk)[jj] = (float)sample[ii + jj];
+	    } else {
+		((uint8_t*)chunk)[jj] = (uint8_t)sample[ii + jj];
+	    }
+	}
+
+	written = fwrite(chunk,value_size,chunk_values_count,file);
+	ok = written == chunk_values_count;
+    }
+
+    if (ok && header->has_labels) {
+	ok = fseek(file,(long)header->labels_offset,SEEK_SET) == 0;
+	ok = ok && (fwrite(labels_idx,sizeof(uint32_t),header->count,file) == header->count);
+	ok = ok && (fwrite(label_names,1,header->label_names_length,file) == header->label_names_length);
+    }
+
+    ok = ok && (ftruncate(fileno(file),(off_t)header->file_length) == 0);
+    ok = (fclose(file) == 0) && ok;
+
+    return ok;
+}
+
+bool
+dataset_file_open(
+    struct dataset_file* restrict  o_file,
+    const char* restrict           path) {
+    int                         fd;
+    struct stat                 file_stat;
+    struct dataset_file_header  expected;
+    void*                       map;
+
+    fd = open(path,O_RDONLY);
+
+    if (fd == -1) {
+	return false;
+    }
+
+    if ((fstat(fd,&file_stat) != 0) || ((size_t)file_stat.st_size < sizeof(struct dataset_file_header))) {
+	close(fd);
+	return false;
+    }
+
+    map = mmap(NULL,(size_t)file_stat.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+	return false;
+    }
+
+    memcpy(&o_file->header,map,sizeof(struct dataset_file_header));
+
+    /* The header is trusted only if it is exactly the one a writer would have produced for the same shape. */
+
+    if ((o_file->header.magic != DATASET_FILE_MAGIC) || (o_file->header.version != DATASET_FILE_VERSION) || (o_file->header.kind > KIND_IMAGE) ||
+	(o_file->header.dtype > DTYPE_UINT8)) {
+	munmap(map,(size_t)file_stat.st_size);
+	return false;
+    }
+
+    dataset_file_header_init(&expected,(enum dataset_kind)o_file->header.kind,(enum dataset_dtype)o_file->header.dtype,
+			     o_file->header.row_count,o_file->header.col_count,o_file->header.layer_count,o_file->header.count,
+			     o_file->header.has_labels != 0,o_file->header.label_names_length);
+
+    if ((memcmp(&expected,&o_file->header,sizeof(struct dataset_file_header)) != 0) || (expected.file_length != (uint64_t)file_stat.st_size)) {
+	munmap(map,(size_t)file_stat.st_size);
+	return false;
+    }
+
+    madvise(map,(size_t)file_stat.st_size,MADV_SEQUENTIAL);
+
+    o_file->geometry = o_file->header.row_count * o_file->header.col_count * o_file->header.layer_count;
+    o_file->observation_length = o_file->geometry * dataset_dtype_size((enum dataset_dtype)o_file->header.dtype);
+    o_file->map = map;
+    o_file->data = (const char*)map + o_file->header.data_offset;
+    o_file->labels_idx = o_file->header.has_labels ? (const uint32_t*)((const char*)map + o_file->header.labels_offset) : NULL;
+    o_file->label_names = o_file->header.has_labels ? (const char*)map + o_file->header.label_names_offset : NULL;
+
+    return true;
+}
+
+void
+dataset_file_close(
+    struct dataset_file* restrict  io_file) {
+    munmap(io_file->map,io_file->header.file_length);
+
+    io_file->map = NULL;
+    io_file->data = NULL;
+    io_file->labels_idx = NULL;
+    io_file->label_names = NULL;
+}
+
+void
+dataset_convert(
+    double* restrict      o_values,
+    enum dataset_dtype    dtype,
+    size_t                count,
+    const void* restrict  values) {
+    size_t  ii;
+
+    if (dtype == DTYPE_FLOAT64) {
+	memcpy(o_values,values,count * sizeof(double));
+    } else if (dtype == DTYPE_FLOAT32) {
+	for (ii = 0; ii < count; ii++) {
+	    o_values[ii] = (double)((const float*)values)[ii];
+	}
+    } else {
+	for (ii = 0; ii < count; ii++) {
+	    o_values[ii] = (double)((const uint8_t*)values)[ii];
+	}
+    }
+}
+
+const void*
+dataset_file_observation(
+    const struct dataset_file* restrict  file,
+    size_t                               observation_idx) {
+    return file->data + observation_idx * file->observation_length;
+}
+
+size_t
+dataset_file_read_chunk(
+    double* restrict                     o_chunk,
+    const struct dataset_file* restrict  file,
+    size_t                               first,
+    size_t                               count) {
+    if (first >= file->header.count) {
+	return 0;
+    }
+
+    if (count > file->header.count - first) {
+	count = file->header.count - first;
+    }
+
+    dataset_convert(o_chunk,(enum dataset_dtype)file->header.dtype,count * file->geometry,dataset_file_observation(file,first));
+
+    return count;
+}
@@ -0,0 +1,65 @@
+#ifndef _DATASET_FILE_H
+#define _DATASET_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+#define DATASET_FILE_MAGIC 0x3154455354414458ULL
+#define DATASET_FILE_VERSION 1
+#define DATASET_FILE_ALIGNMENT 4096
+
+enum dataset_kind {
+    KIND_RECORD,
+    KIND_IMAGE
+};
+
+enum dataset_dtype {
+    DTYPE_FLOAT64,
+    DTYPE_FLOAT32,
+    DTYPE_UINT8
+};
+
+struct dataset_file_header {
+    uint64_t  magic;
+    uint64_t  version;
+    uint64_t  kind;
+    uint64_t  dtype;
+    uint64_t  row_count;
+    uint64_t  col_count;
+    uint64_t  layer_count;
+    uint64_t  count;
+    uint64_t  has_labels;
+    uint64_t  label_names_length;
+    uint64_t  data_offset;
+    uint64_t  labels_offset;
+    uint64_t  label_names_offset;
+    uint64_t  file_length;
+};
+
+struct dataset_file {
+    struct dataset_file_header  header;
+    size_t                      geometry;
+    size_t                      observation_length;
+    void*                       map;
+    const char*                 data;
+    const uint32_t*             labels_idx;
+    const char*                 label_names;
+};
+
+extern size_t  dataset_dtype_size(enum dataset_dtype dtype);
+
+extern void    dataset_file_header_init(struct dataset_file_header* restrict o_header,enum dataset_kind kind,enum dataset_dtype dtype,size_t row_count,size_t col_count,size_t layer_count,size_t count,bool has_labels,size_t label_names_length);
+extern bool    dataset_file_write(const char* restrict path,const struct dataset_file_header* restrict header,const double* restrict sample,const uint32_t* restrict labels_idx,const char* restrict label_names);
+extern bool    dataset_file_open(struct dataset_file* restrict o_file,const char* restrict path);
+extern void    dataset_file_close(struct dataset_file* restrict io_file);
+extern void    dataset_convert(double* restrict o_values,enum dataset_dtype dtype,size_t count,const void* restrict values);
+extern const void*  dataset_file_observation(const struct dataset_file* restrict file,size_t observation_idx);
+extern size_t  dataset_file_read_chunk(double* restrict o_chunk,const struct dataset_file* restrict file,size_t first,size_t count);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "dictionary_handle.h"
+
+/* A handle owns one copy of a dictionary, together with its transpose and Gram matrix, for as long as the caller
+   keeps it. It is built once, in the aligned layout of "dictionary_state", and every coder afterwards reads the
+   three arrays in place. Handles cross the MATLAB boundary as their address, and are only ever dereferenced after
+   being found among the live handles of the registry, so destroyed or made up ids are rejected. The MEX files link
+   against "libxtern", so they share this one registry, and every process has its own. Storage is allocated with
+   "malloc", not "mxMalloc", so it outlives the call which built it. */
+
+static pthread_mutex_t            _registry_control = PTHREAD_MUTEX_INITIALIZER;
+static struct dictionary_handle*  _registry_first = NULL;
+
+bool
+dictionary_handle_create(
+    struct dictionary_handle**  o_handle,
+    size_t                      geometry,
+    size_t                      word_count,
+    const double* restrict      dict) {
+    struct dictionary_handle*  handle;
+    void*                      storage;
+
+    handle = (struct dictionary_handle*)malloc(sizeof(struct dictionary_handle));
+
+    if (handle == NULL) {
+	return false;
+    }
+
+    if (posix_memalign(&storage,DICTIONARY_STATE_ALIGNMENT,dictionary_state_length(geometry,word_count)) != 0) {
+	free(handle);
+	return false;
+    }
+
+    handle->storage = storage;
+    dictionary_state_init(&handle->state,geometry,word_count,dict,storage);
+
+    pthread_mutex_lock(&_registry_control);
+    handle->next = _registry_first;
+    _registry_first = handle;
+    pthread_mutex_unlock(&_registry_control);
+
+    *o_handle = handle;
+
+    return true;
+}
+
+bool
+dictionary_handle_destroy(
+    struct dictionary_handle*  handle) {
+    struct dictionary_handle**  link;
+    bool                        found;
+
+    found = false;
+
+    pthread_mutex_lock(&_registry_control);
+
+    for (link = &_registry_first; *link != NULL; link = &(*link)->next) {
+	if (*link == handle) {
+	    *link = handle->next;
+	    found = true;
+	    break;
+	}
+    }
+
+    pthread_mutex_unlock(&_registry_control);
+
+    if (!found) {
+	return false;
+    }
+
+    free(handle->storage);
+    free(handle);
+
+    return true;
+}
+
+uint64_t
+dictionary_handle_to_id(
+    const struct dictionary_handle*  handle) {
+    return (uint64_t)(uintptr_t)handle;
+}
+
+struct dictionary_handle*
+dictionary_handle_from_id(
+    uint64_t  id) {
+    struct dictionary_handle*  handle;
+
+    if (id == 0) {
+	return NULL;
+    }
+
+    /* Only the addresses of live handles are compared against "id", so an unknown one is never dereferenced. */
+
+    pthread_mutex_lock(&_registry_control);
+
+    for (handle = _registry_first; handle != NULL; handle = handle->next) {
+	if (dictionary_handle_to_id(handle) == id) {
+	    break;
+	}
+    }
+
+    pthread_mutex_unlock(&_registry_control);
+
+    return handle;
+}
@@ -0,0 +1,25 @@
+#ifndef _DICTIONARY_HANDLE_H
+#define _DICTIONARY_HANDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base_defines.h"
+#include "dictionary_state.h"
+
+BEGIN_C_DECLS
+
+struct dictionary_handle {
+    struct dictionary_state    state;
+    void*                      storage;
+    struct dictionary_handle*  next;
+};
+
+extern bool                       dictionary_handle_create(struct dictionary_handle** o_handle,size_t geometry,size_t word_count,const double* restrict dict);
+extern bool                       dictionary_handle_destroy(struct dictionary_handle* handle);
+extern uint64_t                   dictionary_handle_to_id(const struct dictionary_handle* handle);
+extern struct dictionary_handle*  dictionary_handle_from_id(uint64_t id);
+
+END_C_DECLS
+
+#endif
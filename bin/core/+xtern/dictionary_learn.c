@@ -0,0 +1,338 @@
+#include <string.h>
+#include <math.h>
+
+#include "acml/acml.h"
+
+#include "latools.h"
+#include "random_tools.h"
+#include "dictionary_learn.h"
+
+/* Online dictionary learning in the style of Mairal et al. Observations are coded in mini-batches, and the codes
+   are folded into the running statistics "coeffs_outer" = sum(a * a') ("word_count" x "word_count") and
+   "sample_coeffs_outer" = sum(x * a') ("geometry" x "word_count"). The dictionary is then improved by one pass of
+   block coordinate descent over its atoms, which only needs these statistics, not the observations themselves. */
+
+size_t
+online_learn_tmps_length(
+    size_t  geometry,
+    size_t  word_count) {
+    return geometry * sizeof(double); // for "atom_update" or "residual".
+}
+
+size_t
+neural_gas_tmps_length(
+    size_t  geometry,
+    size_t  word_count) {
+    return geometry * sizeof(double); // for "residual".
+}
+
+size_t
+ksvd_tmps_length(
+    size_t  geometry,
+    size_t  sample_count) {
+    return geometry * sizeof(double) +     // for "atom_update".
+           sample_count * sizeof(double);  // for "usage_coeffs".
+}
+
+void
+draw_batch(
+    size_t* restrict  o_batch_idx,
+    uint64_t          seed,
+    size_t            batch,
+    size_t            batch_size,
+    size_t            sample_count) {
+    size_t  ii;
+
+    /* Each batch owns a stream, so the observations used do not depend on the number of workers. */
+
+    for (ii = 0; ii < batch_size; ii++) {
+	o_batch_idx[ii] = counter_rng_uniform_int(seed,batch,ii,sample_count);
+    }
+}
+
+void
+code_residual(
+    double* restrict             o_residual,
+    size_t                       geometry,
+    const double* restrict       dict_transp,
+    size_t                       coeff_count,
+    const double* restrict       coeffs,
+    const coeff_idx_t* restrict  coeffs_idx,
+    const double* restrict       observation) {
+    size_t  ii;
+
+    memcpy(o_residual,observation,geometry * sizeof(double));
+
+    for (ii = 0; ii < coeff_count; ii++) {
+	daxpy((int)geometry,-coeffs[ii],(double*)dict_transp + coeffs_idx[ii] * geometry,1,o_residual,1);
+    }
+}
+
+double
+reconstruction_error(
+    size_t                       geometry,
+    const double* restrict       dict_transp,
+    size_t                       coeff_count,
+    const double* restrict       coeffs,
+    const coeff_idx_t* restrict  coeffs_idx,
+    const double* restrict       observation,
+    void* restrict               tmps) {
+    double* restrict  residual;
+
+    residual = (double*)tmps;
+
+    code_residual(residual,geometry,dict_transp,coeff_count,coeffs,coeffs_idx,observation);
+
+    return ddot((int)geometry,residual,1,residual,1);
+}
+
+void
+accumulate_statistics(
+    double* restrict             io_coeffs_outer,
+    double* restrict             io_sample_coeffs_outer,
+    size_t                       geometry,
+    size_t                       word_count,
+    size_t                       coeff_count,
+    const double* restrict       coeffs,
+    const coeff_idx_t* restrict  coeffs_idx,
+    const double* restrict       observation) {
+    size_t  ii;
+    size_t  jj;
+
+    /* Codes have at most "coeff_count" nonzeros, so only those rows and columns of the statistics change. */
+
+    for (ii = 0; ii < coeff_count; ii++) {
+	for (jj = 0; jj < coeff_count; jj++) {
+	    io_coeffs_outer[coeffs_idx[jj] * word_count + coeffs_idx[ii]] += coeffs[ii] * coeffs[jj];
+	}
+
+	daxpy((int)geometry,coeffs[ii],(double*)observation,1,io_sample_coeffs_outer + coeffs_idx[ii] * geometry,1);
+    }
+}
+
+void
+update_dictionary_bcd(
+    double* restrict        io_dict_transp,
+    size_t                  geometry,
+    size_t                  word_count,
+    const double* restrict  coeffs_outer,
+    const double* restrict  sample_coeffs_outer,
+    void* restrict          tmps) {
+    double* restrict  atom_update;
+    double*           atom;
+    double            atom_norm;
+    size_t            ii;
+
+    atom_update = (double*)tmps;
+
+    /* For atom "ii": u = (b_ii - D * a_ii) / A(ii,ii) + d_ii, followed by a projection back on the unit sphere, which
+       is where the rest of the code expects atoms to be. Atoms which were never used keep their current value. */
+
+    for (ii = 0; ii < word_count; ii++) {
+	if (coeffs_outer[ii * word_count + ii] <= 0) {
+	    continue;
+	}
+
+	atom = io_dict_transp + ii * geometry;
+
+	memcpy(atom_update,sample_coeffs_outer + ii * geometry,geometry * sizeof(double));
+	dgemv('N',(int)geometry,(int)word_count,-1,io_dict_transp,(int)geometry,(double*)coeffs_outer + ii * word_count,1,1,atom_update,1);
+	dscal((int)geometry,1.0 / coeffs_outer[ii * word_count + ii],atom_update,1);
+	daxpy((int)geometry,1,atom,1,atom_update,1);
+
+	atom_norm = dnrm2((int)geometry,atom_update,1);
+
+	if (atom_norm > 0) {
+	    memcpy(atom,atom_update,geometry * sizeof(double));
+	    dscal((int)geometry,1.0 / atom_norm,atom,1);
+	}
+    }
+}
+
+void
+neural_gas_step(
+    struct dictionary_state* restrict  io_state,
+    size_t                             coeff_count,
+    double* restrict                   io_coeffs,
+    coeff_idx_t* restrict              io_coeffs_idx,
+    double                             learn_rate,
+    double                             neight_size,
+    const double* restrict             observation) {
+    double*  atom;
+    double   step;
+    double   atom_norm;
+    size_t   ii;
+
+    /* Atoms are ranked by the magnitude of their coefficient. Atoms with a zero coefficient are not moved by the
+       update, so only the "coeff_count" coded ones need ranking, and only those need renormalizing afterwards. Atom
+       "ii" moves as d_ii += rate * exp(-rank / neight_size) * a_ii * (x - a_ii * d_ii). */
+
+    sort_by_abs_coeffs(io_coeffs,io_coeffs_idx,coeff_count);
+
+    for (ii = 0; ii < coeff_count; ii++) {
+	if (io_coeffs[ii] == 0) {
+	    continue;
+	}
+
+	atom = io_state->dict_transp + io_coeffs_idx[ii] * io_state->geometry;
+	step = learn_rate * exp(-(double)(ii + 1) / neight_size) * io_coeffs[ii];
+
+	dscal((int)io_state->geometry,1 - step * io_coeffs[ii],atom,1);
+	daxpy((int)io_state->geometry,step,(double*)observation,1,atom,1);
+
+	atom_norm = dnrm2((int)io_state->geometry,atom,1);
+
+	if (atom_norm > 0) {
+	    dscal((int)io_state->geometry,1.0 / atom_norm,atom,1);
+	}
+
+	dictionary_state_touch_atom(io_state,io_coeffs_idx[ii]);
+    }
+}
+
+/* K-SVD in the style of Aharon et al. After all observations are coded, atoms are revisited one at a time. Atom "j"
+   and its coefficients are replaced by the best rank one approximation of E_j, the residuals of the observations
+   which use "j" with the contribution of "j" added back. E_j is never formed: it is read through the running
+   residuals "R" ("geometry" x "sample_count") and the current atom, so an update costs time proportional to the
+   number of observations using the atom. The rank one approximation comes from a few power iterations started at
+   the current atom, which is a good guess once learning settles. */
+
+void
+build_atom_usage(
+    size_t* restrict             o_usage_offsets,
+    size_t* restrict             o_usage_members,
+    size_t                       word_count,
+    size_t                       sample_count,
+    size_t                       coeff_count,
+    const double* restrict       coeffs,
+    const coeff_idx_t* restrict  coeffs_idx) {
+    size_t  ii;
+
+    /* Counting sort of code slots by atom. Slots with a zero coefficient do not use their atom. */
+
+    memset(o_usage_offsets,0,(word_count + 1) * sizeof(size_t));
+
+    for (ii = 0; ii < sample_count * coeff_count; ii++) {
+	if (coeffs[ii] != 0) {
+	    o_usage_offsets[coeffs_idx[ii] + 1] += 1;
+	}
+    }
+
+    for (ii = 0; ii < word_count; ii++) {
+	o_usage_offsets[ii + 1] += o_usage_offsets[ii];
+    }
+
+    for (ii = 0; ii < sample_count * coeff_count; ii++) {
+	if (coeffs[ii] != 0) {
+	    o_usage_members[o_usage_offsets[coeffs_idx[ii]]] = ii;
+	    o_usage_offsets[coeffs_idx[ii]] += 1;
+	}
+    }
+
+    for (ii = word_count; ii > 0; ii--) {
+	o_usage_offsets[ii] = o_usage_offsets[ii - 1];
+    }
+
+    o_usage_offsets[0] = 0;
+}
+
+static void
+ksvd_usage_coeffs(
+    double* restrict        o_usage_coeffs,
+    size_t                  geometry,
+    size_t                  coeff_count,
+    const double* restrict  atom,
+    const double* restrict  residuals,
+    const double* restrict  coeffs,
+    size_t                  usage_count,
+    const size_t* restrict  usage_members,
+    const double* restrict  direction) {
+    double  atom_dot;
+    size_t  ii;
+
+    /* Computes E_j' * direction. */
+
+    atom_dot = ddot((int)geometry,(double*)atom,1,(double*)direction,1);
+
+    for (ii = 0; ii < usage_count; ii++) {
+	o_usage_coeffs[ii] = ddot((int)geometry,(double*)residuals + (usage_members[ii] / coeff_count) * geometry,1,(double*)direction,1) +
+			     coeffs[usage_members[ii]] * atom_dot;
+    }
+}
+
+void
+ksvd_update_atom(
+    double* restrict        io_dict_transp,
+    double* restrict        io_residuals,
+    double* restrict        io_coeffs,
+    size_t                  geometry,
+    size_t                  coeff_count,
+    size_t                  atom_idx,
+    size_t                  usage_count,
+    const size_t* restrict  usage_members,
+    size_t                  power_iter_count,
+    void* restrict          tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  atom_update;
+    double* restrict  usage_coeffs;
+    double*           atom;
+    double*           residual;
+    double            atom_weight;
+    double            atom_update_norm;
+    size_t            iter;
+    size_t            ii;
+
+    curr_tmps = (char*)tmps;
+
+    atom_update = (double*)curr_tmps;
+    curr_tmps += geometry * sizeof(double);
+    usage_coeffs = (double*)curr_tmps;
+
+    /* An unused atom is left as it is. */
+
+    if (usage_count == 0) {
+	return;
+    }
+
+    atom = io_dict_transp + atom_idx * geometry;
+
+    memcpy(atom_update,atom,geometry * sizeof(double));
+
+    for (iter = 0; iter < power_iter_count; iter++) {
+	ksvd_usage_coeffs(usage_coeffs,geometry,coeff_count,atom,io_residuals,io_coeffs,usage_count,usage_members,atom_update);
+
+	atom_weight = 0;
+
+	for (ii = 0; ii < usage_count; ii++) {
+	    atom_weight += usage_coeffs[ii] * io_coeffs[usage_members[ii]];
+	}
+
+	dcopy((int)geometry,atom,1,atom_update,1);
+	dscal((int)geometry,atom_weight,atom_update,1);
+
+	for (ii = 0; ii < usage_count; ii++) {
+	    daxpy((int)geometry,usage_coeffs[ii],io_residuals + (usage_members[ii] / coeff_count) * geometry,1,atom_update,1);
+	}
+
+	atom_update_norm = dnrm2((int)geometry,atom_update,1);
+
+	/* A zero E_j means the observations are already exactly represented without this atom. */
+
+	if (atom_update_norm == 0) {
+	    return;
+	}
+
+	dscal((int)geometry,1.0 / atom_update_norm,atom_update,1);
+    }
+
+    ksvd_usage_coeffs(usage_coeffs,geometry,coeff_count,atom,io_residuals,io_coeffs,usage_count,usage_members,atom_update);
+
+    for (ii = 0; ii < usage_count; ii++) {
+	residual = io_residuals + (usage_members[ii] / coeff_count) * geometry;
+	daxpy((int)geometry,io_coeffs[usage_members[ii]],atom,1,residual,1);
+	daxpy((int)geometry,-usage_coeffs[ii],atom_update,1,residual,1);
+	io_coeffs[usage_members[ii]] = usage_coeffs[ii];
+    }
+
+    memcpy(atom,atom_update,geometry * sizeof(double));
+}
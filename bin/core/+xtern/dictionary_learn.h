@@ -0,0 +1,26 @@
+#ifndef _DICTIONARY_LEARN_H
+#define _DICTIONARY_LEARN_H
+
+#include <stdint.h>
+
+#include "base_defines.h"
+#include "dictionary_state.h"
+
+BEGIN_C_DECLS
+
+extern size_t  online_learn_tmps_length(size_t geometry,size_t word_count);
+extern size_t  neural_gas_tmps_length(size_t geometry,size_t word_count);
+extern size_t  ksvd_tmps_length(size_t geometry,size_t sample_count);
+
+extern void    draw_batch(size_t* restrict o_batch_idx,uint64_t seed,size_t batch,size_t batch_size,size_t sample_count);
+extern void    code_residual(double* restrict o_residual,size_t geometry,const double* restrict dict_transp,size_t coeff_count,const double* restrict coeffs,const coeff_idx_t* restrict coeffs_idx,const double* restrict observation);
+extern double  reconstruction_error(size_t geometry,const double* restrict dict_transp,size_t coeff_count,const double* restrict coeffs,const coeff_idx_t* restrict coeffs_idx,const double* restrict observation,void* restrict tmps);
+extern void    accumulate_statistics(double* restrict io_coeffs_outer,double* restrict io_sample_coeffs_outer,size_t geometry,size_t word_count,size_t coeff_count,const double* restrict coeffs,const coeff_idx_t* restrict coeffs_idx,const double* restrict observation);
+extern void    update_dictionary_bcd(double* restrict io_dict_transp,size_t geometry,size_t word_count,const double* restrict coeffs_outer,const double* restrict sample_coeffs_outer,void* restrict tmps);
+extern void    neural_gas_step(struct dictionary_state* restrict io_state,size_t coeff_count,double* restrict io_coeffs,coeff_idx_t* restrict io_coeffs_idx,double learn_rate,double neight_size,const double* restrict observation);
+extern void    build_atom_usage(size_t* restrict o_usage_offsets,size_t* restrict o_usage_members,size_t word_count,size_t sample_count,size_t coeff_count,const double* restrict coeffs,const coeff_idx_t* restrict coeffs_idx);
+extern void    ksvd_update_atom(double* restrict io_dict_transp,double* restrict io_residuals,double* restrict io_coeffs,size_t geometry,size_t coeff_count,size_t atom_idx,size_t usage_count,const size_t* restrict usage_members,size_t power_iter_count,void* restrict tmps);
+
+END_C_DECLS
+
+#endif
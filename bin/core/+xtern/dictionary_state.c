@@ -0,0 +1,160 @@
+#include <string.h>
+
+#include "acml/acml.h"
+
+#include "dictionary_state.h"
+
+/* Learners change the atoms in "dict_transp", where they are contiguous, and record which ones they touched. The
+   row major "dict" copy and the Gram matrix "dict_x_dict_transp" are brought up to date only when a coder needs them,
+   by "dictionary_state_sync". A few touched atoms cost one product with the whole dictionary each, for their Gram
+   column, and a strided copy of that column into their Gram row. When about half the atoms or more were touched, a
+   single rank "geometry" update of the upper triangle is cheaper, and the lower one is filled from it. Every array
+   starts at a multiple of "DICTIONARY_STATE_ALIGNMENT" bytes from "storage", so all are aligned when it is. */
+
+static size_t
+aligned_length(
+    size_t  length) {
+    return (length + DICTIONARY_STATE_ALIGNMENT - 1) / DICTIONARY_STATE_ALIGNMENT * DICTIONARY_STATE_ALIGNMENT;
+}
+
+size_t
+dictionary_state_length(
+    size_t  geometry,
+    size_t  word_count) {
+    return aligned_length(word_count * geometry * sizeof(double)) +   // for "dict".
+           aligned_length(geometry * word_count * sizeof(double)) +   // for "dict_transp".
+           aligned_length(word_count * word_count * sizeof(double)) + // for "dict_x_dict_transp".
+           aligned_length(word_count * sizeof(size_t)) +              // for "stale_idx".
+           word_count * sizeof(bool);                                 // for "stale".
+}
+
+void
+dictionary_state_init(
+    struct dictionary_state* restrict  o_state,
+    size_t                             geometry,
+    size_t                             word_count,
+    const double* restrict             dict,
+    void* restrict                     storage) {
+    char*   curr_storage;
+    size_t  ii;
+    size_t  jj;
+
+    curr_storage = (char*)storage;
+
+    o_state->geometry = geometry;
+    o_state->word_count = word_count;
+    o_state->dict = (double*)curr_storage;
+    curr_storage += aligned_length(word_count * geometry * sizeof(double));
+    o_state->dict_transp = (double*)curr_storage;
+    curr_storage += aligned_length(geometry * word_count * sizeof(double));
+    o_state->dict_x_dict_transp = (double*)curr_storage;
+    curr_storage += aligned_length(word_count * word_count * sizeof(double));
+    o_state->stale_idx = (size_t*)curr_storage;
+    curr_storage += aligned_length(word_count * sizeof(size_t));
+    o_state->stale = (bool*)curr_storage;
+
+    for (ii = 0; ii < word_count; ii++) {
+	for (jj = 0; jj < geometry; jj++) {
+	    o_state->dict_transp[ii * geometry + jj] = dict[jj * word_count + ii];
+	}
+    }
+
+    memset(o_state->stale,0,word_count * sizeof(bool));
+    o_state->stale_count = 0;
+
+    dictionary_state_touch_all(o_state);
+    dictionary_state_sync(o_state);
+}
+
+void
+dictionary_state_wrap(
+    struct dictionary_state* restrict  o_state,
+    size_t                             geometry,
+    size_t                             word_count,
+    const double*                      dict,
+    const double*                      dict_transp,
+    const double*                      dict_x_dict_transp) {
+    /* Describes arrays the caller already has, such as those MATLAB passes in, without copying them. Such a state is
+       only read by coders, and must never be touched or synced. */
+
+    o_state->geometry = geometry;
+    o_state->word_count = word_count;
+    o_state->dict = (double*)dict;
+    o_state->dict_transp = (double*)dict_transp;
+    o_state->dict_x_dict_transp = (double*)dict_x_dict_transp;
+    o_state->stale_idx = NULL;
+    o_state->stale = NULL;
+    o_state->stale_count = 0;
+}
+
+void
+dictionary_state_touch_atom(
+    struct dictionary_state* restrict  io_state,
+    size_t                             atom_idx) {
+    if (io_state->stale[atom_idx]) {
+	return;
+    }
+
+    io_state->stale[atom_idx] = true;
+    io_state->stale_idx[io_state->stale_count] = atom_idx;
+    io_state->stale_count += 1;
+}
+
+void
+dictionary_state_touch_all(
+    struct dictionary_state* restrict  io_state) {
+    size_t  ii;
+
+    for (ii = 0; ii < io_state->word_count; ii++) {
+	io_state->stale[ii] = true;
+	io_state->stale_idx[ii] = ii;
+    }
+
+    io_state->stale_count = io_state->word_count;
+}
+
+void
+dictionary_state_sync(
+    struct dictionary_state* restrict  io_state) {
+    size_t   geometry;
+    size_t   word_count;
+    size_t   atom_idx;
+    double*  gram_column;
+    size_t   ii;
+    size_t   jj;
+
+    geometry = io_state->geometry;
+    word_count = io_state->word_count;
+
+    if (io_state->stale_count == 0) {
+	return;
+    }
+
+    for (ii = 0; ii < io_state->stale_count; ii++) {
+	atom_idx = io_state->stale_idx[ii];
+	dcopy((int)geometry,io_state->dict_transp + atom_idx * geometry,1,io_state->dict + atom_idx,(int)word_count);
+    }
+
+    if (2 * io_state->stale_count >= word_count) {
+	dsyrk('U','T',(int)word_count,(int)geometry,1,io_state->dict_transp,(int)geometry,0,io_state->dict_x_dict_transp,(int)word_count);
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = ii + 1; jj < word_count; jj++) {
+		io_state->dict_x_dict_transp[ii * word_count + jj] = io_state->dict_x_dict_transp[jj * word_count + ii];
+	    }
+	}
+    } else {
+	for (ii = 0; ii < io_state->stale_count; ii++) {
+	    atom_idx = io_state->stale_idx[ii];
+	    gram_column = io_state->dict_x_dict_transp + atom_idx * word_count;
+	    dgemv('T',(int)geometry,(int)word_count,1,io_state->dict_transp,(int)geometry,io_state->dict_transp + atom_idx * geometry,1,0,gram_column,1);
+	    dcopy((int)word_count,gram_column,1,io_state->dict_x_dict_transp + atom_idx,(int)word_count);
+	}
+    }
+
+    for (ii = 0; ii < io_state->stale_count; ii++) {
+	io_state->stale[io_state->stale_idx[ii]] = false;
+    }
+
+    io_state->stale_count = 0;
+}
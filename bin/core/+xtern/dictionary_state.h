@@ -0,0 +1,33 @@
+#ifndef _DICTIONARY_STATE_H
+#define _DICTIONARY_STATE_H
+
+#include <stdbool.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+#define DICTIONARY_STATE_ALIGNMENT 64
+
+struct dictionary_state {
+    size_t   geometry;
+    size_t   word_count;
+    double*  dict;
+    double*  dict_transp;
+    double*  dict_x_dict_transp;
+    size_t*  stale_idx;
+    bool*    stale;
+    size_t   stale_count;
+};
+
+extern size_t  dictionary_state_length(size_t geometry,size_t word_count);
+
+extern void    dictionary_state_init(struct dictionary_state* restrict o_state,size_t geometry,size_t word_count,const double* restrict dict,void* restrict storage);
+extern void    dictionary_state_wrap(struct dictionary_state* restrict o_state,size_t geometry,size_t word_count,const double* dict,const double* dict_transp,const double* dict_x_dict_transp);
+extern void    dictionary_state_touch_atom(struct dictionary_state* restrict io_state,size_t atom_idx);
+extern void    dictionary_state_touch_all(struct dictionary_state* restrict io_state);
+extern void    dictionary_state_sync(struct dictionary_state* restrict io_state);
+
+END_C_DECLS
+
+#endif
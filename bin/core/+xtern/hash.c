@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+
+/* A 64 bit, non cryptographic hash, which consumes eight bytes per step. Its only use is naming cache entries, so
+   it must be fast on large dictionaries and datasets, and differ between inputs with overwhelming probability, but
+   need not resist deliberate collisions. Feeding one hash as the seed of the next chains several buffers into one
+   hash. */
+
+#define HASH_PRIME_1 0x9e3779b97f4a7c15ULL
+#define HASH_PRIME_2 0xc2b2ae3d27d4eb4fULL
+#define HASH_PRIME_3 0x165667b19e3779f9ULL
+
+static uint64_t
+rotl(
+    uint64_t  value,
+    unsigned  shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static uint64_t
+mix_word(
+    uint64_t  hash,
+    uint64_t  word) {
+    word *= HASH_PRIME_2;
+    word = rotl(word,31);
+    word *= HASH_PRIME_1;
+
+    return rotl(hash ^ word,27) * HASH_PRIME_1 + HASH_PRIME_3;
+}
+
+uint64_t
+hash_bytes(
+    uint64_t              seed,
+    size_t                length,
+    const void* restrict  bytes) {
+    const uint8_t*  current;
+    uint64_t        hash;
+    uint64_t        word;
+    size_t          ii;
+
+    current = (const uint8_t*)bytes;
+    hash = seed ^ ((uint64_t)length * HASH_PRIME_1);
+
+    for (ii = 0; ii + sizeof(uint64_t) <= length; ii += sizeof(uint64_t)) {
+	memcpy(&word,current + ii,sizeof(uint64_t));
+	hash = mix_word(hash,word);
+    }
+
+    if (ii < length) {
+	word = 0;
+	memcpy(&word,current + ii,length - ii);
+	hash = mix_word(hash,word);
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+void
+hash_to_string(
+    char* restrict  o_string,
+    uint64_t        hash) {
+    snprintf(o_string,17,"%016llx",(unsigned long long)hash);
+}
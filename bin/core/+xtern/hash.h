@@ -0,0 +1,15 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern uint64_t  hash_bytes(uint64_t seed,size_t length,const void* restrict bytes);
+extern void      hash_to_string(char* restrict o_string,uint64_t hash);
+
+END_C_DECLS
+
+#endif
@@ -6,62 +6,260 @@
 #include "image_coder.h"
 #include "coding_methods.h"
 #include "latools.h"
+#include "hash.h"
+
+/* Seed of the feature hash. Changing it changes every hashed feature, and invalidates classifiers trained on them. */
+
+#define FEATURE_HASH_SEED 0x3a8f05c5e1c6b7d3ULL
+
+static inline double
+_reduce_value(
+    enum reduce_type  reduce_type,
+    double            current,
+    double            new_value) {
+    switch (reduce_type) {
+    case MAX_NO_SIGN:
+	return current < fabs(new_value) ? fabs(new_value) : current;
+    case MAX_KEEP_SIGN:
+	return fabs(current) < fabs(new_value) ? new_value : current;
+    case SUM_ABS:
+	return current + fabs(new_value);
+    default:
+	return current + new_value * new_value;
+    }
+}
 
-typedef double (*reduce_function)(double,double);
+CPU_DISPATCH static void
+_extract_patch_centered(
+    double* restrict        o_patch,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    size_t                  patch_row_count,
+    size_t                  patch_col_count,
+    enum channel_mode       channel_mode,
+    size_t                  rr,
+    size_t                  cc,
+    const double* restrict  observation) {
+    double* restrict         patch_layer;
+    const double* restrict   observation_layer;
+    double* restrict         patch_ptr;
+    const double* restrict   curr_observation_col;
+    size_t                   patch_side_row;
+    size_t                   patch_init_row;
+    size_t                   patch_final_row;
+    size_t                   patch_skipped_initial_rows;
+    size_t                   patch_skipped_final_rows;
+    size_t                   patch_side_col;
+    size_t                   patch_init_col;
+    size_t                   patch_final_col;
+    size_t                   patch_skipped_initial_cols;
+    double                   patch_sum_values;
+    double                   patch_mean;
+    size_t                   ll;
+    size_t                   cc_1;
+    size_t                   rr_1;
+    size_t                   ii;
+
+    /* We're using "(row|col)_count" here becase we can allow patches
+       to extend in the whole image, not just the pixels in the reduce areas. */
+
+    patch_side_row = (patch_row_count - 1) / 2;
+    patch_init_row = rr < patch_side_row ? 0 : (rr - patch_side_row);
+    patch_final_row = row_count < (rr + patch_side_row + 1) ? row_count : (rr + patch_side_row + 1);
+    patch_skipped_initial_rows = rr < patch_side_row ? (patch_side_row - rr) : 0;
+    patch_skipped_final_rows = row_count < (rr + patch_side_row + 1) ? (rr + patch_side_row + 1 - row_count) : 0;
+
+    patch_side_col = (patch_col_count - 1) / 2;
+    patch_init_col = cc < patch_side_col ? 0 : (cc - patch_side_col);
+    patch_final_col = col_count < (cc + patch_side_col + 1) ? col_count : (cc + patch_side_col + 1);
+    patch_skipped_initial_cols = cc < patch_side_col ? (patch_side_col - cc) : 0;
+
+    memset(o_patch,0,patch_row_count * patch_col_count * layer_count * sizeof(double));
+
+    /* The patch has the layout of a "patch_row_count" x "patch_col_count" x "layer_count" image, as MATLAB flattens
+       it. With "JOINT" channels the mean of the whole patch is substracted, and with "PER_CHANNEL" ones, the mean of
+       each layer, as each is coded on its own. */
+
+    patch_sum_values = 0;
+
+    for (ll = 0; ll < layer_count; ll++) {
+	patch_layer = o_patch + ll * patch_row_count * patch_col_count;
+	observation_layer = observation + ll * row_count * col_count;
+
+	patch_ptr = patch_layer + patch_skipped_initial_cols * patch_row_count + patch_skipped_initial_rows;
+	curr_observation_col = observation_layer + patch_init_col * row_count;
+
+	for (cc_1 = patch_init_col; cc_1 < patch_final_col; cc_1++) {
+	    for (rr_1 = patch_init_row; rr_1 < patch_final_row; rr_1++) {
+		*patch_ptr = *(curr_observation_col + rr_1);
+		patch_sum_values += *(curr_observation_col + rr_1);
+		patch_ptr++;
+	    }
 
-static double
-_max_no_sign(
-    double  current,
-    double  new_value) {
-    double  fnew_value;
+	    patch_ptr += patch_skipped_initial_rows + patch_skipped_final_rows;
+	    curr_observation_col += row_count;
+	}
 
-    fnew_value = fabs(new_value);
+	if (channel_mode == PER_CHANNEL) {
+	    patch_mean = patch_sum_values / (double)(patch_row_count * patch_col_count);
 
-    if (current < fnew_value) {
-	return fnew_value;
-    } else {
-	return current;
+	    for (ii = 0; ii < patch_row_count * patch_col_count; ii++) {
+		patch_layer[ii] = patch_layer[ii] - patch_mean;
+	    }
+
+	    patch_sum_values = 0;
+	}
+    }
+
+    /* Substract mean from each patch element. */
+
+    if (channel_mode == JOINT) {
+	patch_mean = patch_sum_values / (double)(patch_row_count * patch_col_count * layer_count);
+
+	for (ii = 0; ii < patch_row_count * patch_col_count * layer_count; ii++) {
+	    o_patch[ii] = o_patch[ii] - patch_mean;
+	}
     }
 }
 
-static double
-_max_keep_sign(
-    double  current,
-    double  new_value) {
-    if (fabs(current) < fabs(new_value)) {
-	return new_value;
-    } else {
-	return current;
+CPU_DISPATCH static size_t
+_reduce_cell(
+    double* restrict        o_coeffs,
+    coeff_idx_t* restrict   o_coeffs_idx,
+    size_t                  cell_idx,
+    size_t                  cell_count,
+    size_t                  word_count,
+    size_t                  coeff_count,
+    enum reduce_type        reduce_type,
+    size_t                  reduce_spread_2,
+    const double* restrict       coded_patches,
+    const coeff_idx_t* restrict  coded_patches_idx,
+    size_t* restrict             curr_indices) {
+    double  final_result;
+    bool    set_final_result;
+    size_t  coeffs_count;
+    size_t  jj;
+    size_t  kk;
+
+    /* Every patch of the cell has its coefficients sorted by word, so a single merge over all words reduces them. */
+
+    memset(curr_indices,0,reduce_spread_2 * sizeof(size_t));
+    coeffs_count = 0;
+
+    for (jj = 0; jj < word_count; jj++) {
+	final_result = 0;
+	set_final_result = false;
+
+	for (kk = 0; kk < reduce_spread_2; kk++) {
+	    if (curr_indices[kk] < coeff_count && (coded_patches_idx[kk * coeff_count + curr_indices[kk]] == jj)) {
+		final_result = _reduce_value(reduce_type,final_result,coded_patches[kk * coeff_count + curr_indices[kk]]);
+		curr_indices[kk]++;
+		set_final_result = true;
+	    }
+	}
+
+	if (set_final_result && final_result != 0) {
+	    o_coeffs[coeffs_count] = final_result;
+	    o_coeffs_idx[coeffs_count] = (coeff_idx_t)(cell_idx + jj * cell_count);
+	    coeffs_count++;
+	}
     }
+
+    return coeffs_count;
 }
 
-static double
-_sum_abs(
-    double  current,
-    double  new_value) {
-    return current + fabs(new_value);
+static size_t
+_hash_features(
+    double* restrict       o_coeffs,
+    coeff_idx_t* restrict  o_coeffs_idx,
+    size_t                 hashed_geometry,
+    size_t                 coeffs_count,
+    double* restrict       io_coeffs,
+    coeff_idx_t* restrict  io_coeffs_idx) {
+    size_t    feature_idx;
+    uint64_t  feature_hash;
+    double    bucket_value;
+    size_t    current_count;
+    size_t    ii;
+
+    /* Every feature goes to the bucket given by its hash, with a sign given by the hash's top bit, so colliding
+       features cancel out on average instead of piling up. Hashing happens in place, in the unhashed buffers, since
+       there may be more features than buckets, and only the merged buckets are written to the output. The index is
+       hashed as a "size_t", so buckets do not depend on how wide indices are kept. */
+
+    for (ii = 0; ii < coeffs_count; ii++) {
+	feature_idx = io_coeffs_idx[ii];
+	feature_hash = hash_bytes(FEATURE_HASH_SEED,sizeof(size_t),&feature_idx);
+	io_coeffs_idx[ii] = (coeff_idx_t)(feature_hash % hashed_geometry);
+	io_coeffs[ii] = (feature_hash >> 63) != 0 ? -io_coeffs[ii] : io_coeffs[ii];
+    }
+
+    sort_by_idxs(io_coeffs,io_coeffs_idx,coeffs_count);
+
+    current_count = 0;
+    ii = 0;
+
+    while (ii < coeffs_count) {
+	o_coeffs_idx[current_count] = io_coeffs_idx[ii];
+	bucket_value = 0;
+
+	for (; (ii < coeffs_count) && (io_coeffs_idx[ii] == o_coeffs_idx[current_count]); ii++) {
+	    bucket_value += io_coeffs[ii];
+	}
+
+	if (bucket_value != 0) {
+	    o_coeffs[current_count] = bucket_value;
+	    current_count += 1;
+	}
+    }
+
+    return current_count;
+}
+
+static inline size_t
+_channel_count(
+    size_t             layer_count,
+    enum channel_mode  channel_mode) {
+    switch (channel_mode) {
+    case JOINT:
+	return 1;
+    case PER_CHANNEL:
+	return layer_count;
+    default:
+	exit(EXIT_FAILURE);
+    }
 }
 
-static double
-_sum_sqr(
-    double  current,
-    double  new_value) {
-    return current + new_value * new_value;
+static inline size_t
+_patch_geometry(
+    size_t             layer_count,
+    size_t             patch_row_count,
+    size_t             patch_col_count,
+    enum channel_mode  channel_mode) {
+    return patch_row_count * patch_col_count * (layer_count / _channel_count(layer_count,channel_mode));
 }
 
 size_t
 code_image_new_geometry(
     size_t                    row_count,
     size_t                    col_count,
+    size_t                    layer_count,
     size_t                    word_count,
+    enum channel_mode         channel_mode,
     enum polarity_split_type  polarity_split_type,
-    size_t                    reduce_spread) {
+    size_t                    reduce_spread,
+    size_t                    hashed_geometry) {
     size_t  aftcoding_row_count;
     size_t  aftcoding_col_count;
     size_t  polarity_split_multiplier;
     size_t  aftreduce_row_count;
     size_t  aftreduce_col_count;
 
+    if (hashed_geometry != 0) {
+	return hashed_geometry;
+    }
+
     aftcoding_row_count = row_count - (row_count % reduce_spread);
     aftcoding_col_count = col_count - (col_count % reduce_spread);
 
@@ -76,199 +274,257 @@ code_image_new_geometry(
     aftreduce_row_count = aftcoding_row_count / reduce_spread;
     aftreduce_col_count = aftcoding_col_count / reduce_spread;
 
-    return polarity_split_multiplier * aftreduce_row_count * aftreduce_col_count * word_count;
+    return polarity_split_multiplier * aftreduce_row_count * aftreduce_col_count * word_count * _channel_count(layer_count,channel_mode);
+}
+
+bool
+code_image_idx_fits(
+    size_t                    row_count,
+    size_t                    col_count,
+    size_t                    layer_count,
+    size_t                    word_count,
+    enum channel_mode         channel_mode,
+    enum polarity_split_type  polarity_split_type,
+    size_t                    reduce_spread,
+    size_t                    hashed_geometry) {
+    size_t  unhashed_geometry;
+
+    /* Features are indexed before they are hashed, so the unhashed geometry must fit as well as the hashed one. */
+
+    unhashed_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,0);
+
+    return ((unhashed_geometry == 0) || (unhashed_geometry - 1 <= COEFF_IDX_MAX)) &&
+	((hashed_geometry == 0) || (hashed_geometry - 1 <= COEFF_IDX_MAX));
 }
 
 size_t
 code_image_coding_tmps_length(
-    size_t            row_count,
-    size_t            col_count,
-    size_t            patch_row_count,
-    size_t            patch_col_count,
-    enum coding_type  coding_type,
-    size_t            word_count,
-    size_t            coeff_count,
-    size_t            reduce_spread) {
+    size_t             row_count,
+    size_t             col_count,
+    size_t             layer_count,
+    size_t             patch_row_count,
+    size_t             patch_col_count,
+    enum channel_mode  channel_mode,
+    enum coding_type   coding_type,
+    size_t             word_count,
+    size_t             coeff_count,
+    size_t             reduce_spread,
+    size_t             hashed_geometry) {
     size_t  coding_tmps_length;
     size_t  aftcoding_row_count;
-    size_t  aftcoding_col_count;
 
     coding_tmps_length = 0;
 
     aftcoding_row_count = row_count - (row_count % reduce_spread);
-    aftcoding_col_count = col_count - (col_count % reduce_spread);
 
-    coding_tmps_length += patch_row_count * patch_col_count * sizeof(double);
-    coding_tmps_length += coeff_count * aftcoding_row_count * aftcoding_col_count * sizeof(double);
-    coding_tmps_length += coeff_count * aftcoding_row_count * aftcoding_col_count * sizeof(size_t);
-
-    if (coding_type == CORRELATION) {
-	coding_tmps_length += correlation_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-    } else if (coding_type == MATCHING_PURSUIT) {
-	coding_tmps_length += matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-    } else if (coding_type == ORTHOGONAL_MATCHING_PURSUIT) {
-	coding_tmps_length += orthogonal_matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-    } else if (coding_type == OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT) {
-	coding_tmps_length += optimized_orthogonal_matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-    } else if (coding_type == SPARSE_NET) {
-	coding_tmps_length += sparse_net_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-    } else {
-	exit(EXIT_FAILURE);
+    coding_tmps_length += code_image_band_tmps_length(col_count,layer_count,patch_row_count,patch_col_count,channel_mode,coding_type,word_count,coeff_count,reduce_spread,aftcoding_row_count);
+
+    if (hashed_geometry != 0) {
+	coding_tmps_length += code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,aftcoding_row_count) * sizeof(double);
+	coding_tmps_length += code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,aftcoding_row_count) * sizeof(coeff_idx_t);
     }
 
+    return coding_tmps_length;
+}
+
+size_t
+code_image_band_row_count(
+    size_t  row_count,
+    size_t  reduce_spread,
+    size_t  max_band_count) {
+    size_t  aftreduce_row_count;
+    size_t  band_cell_row_count;
+
+    /* Bands are made of whole reduce cells, so that no cell is split between two bands. */
+
+    aftreduce_row_count = row_count / reduce_spread;
+    band_cell_row_count = (aftreduce_row_count + max_band_count - 1) / max_band_count;
+
+    if (band_cell_row_count == 0) {
+	band_cell_row_count = 1;
+    }
+
+    return band_cell_row_count * reduce_spread;
+}
+
+size_t
+code_image_band_count(
+    size_t  row_count,
+    size_t  reduce_spread,
+    size_t  band_row_count) {
+    size_t  aftcoding_row_count;
+
+    aftcoding_row_count = row_count - (row_count % reduce_spread);
+
+    return (aftcoding_row_count + band_row_count - 1) / band_row_count;
+}
+
+size_t
+code_image_band_max_coeff_count(
+    size_t             col_count,
+    size_t             layer_count,
+    enum channel_mode  channel_mode,
+    size_t             coeff_count,
+    size_t             reduce_spread,
+    size_t             band_row_count) {
+    size_t  aftcoding_col_count;
+
+    aftcoding_col_count = col_count - (col_count % reduce_spread);
+
+    return coeff_count * _channel_count(layer_count,channel_mode) * band_row_count * aftcoding_col_count;
+}
+
+size_t
+code_image_band_tmps_length(
+    size_t             col_count,
+    size_t             layer_count,
+    size_t             patch_row_count,
+    size_t             patch_col_count,
+    enum channel_mode  channel_mode,
+    enum coding_type   coding_type,
+    size_t             word_count,
+    size_t             coeff_count,
+    size_t             reduce_spread,
+    size_t             band_row_count) {
+    size_t  coding_tmps_length;
+
+    coding_tmps_length = 0;
+
+    coding_tmps_length += patch_row_count * patch_col_count * layer_count * sizeof(double);
+    coding_tmps_length += code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,band_row_count) * sizeof(double);
+    coding_tmps_length += code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,band_row_count) * sizeof(coeff_idx_t);
+
+    coding_tmps_length += coding_type_tmps_length(coding_type,_patch_geometry(layer_count,patch_row_count,patch_col_count,channel_mode),word_count,coeff_count);
+
     coding_tmps_length += reduce_spread * reduce_spread * sizeof(size_t);
 
     return coding_tmps_length;
 }
 
-void
-code_image(
-    size_t* restrict          o_coeff_count,
-    double* restrict          o_coeffs,
-    size_t* restrict          o_coeffs_idx,
-    size_t                    geometry,
-    size_t                    row_count,
-    size_t                    col_count,
-    size_t                    patch_row_count,
-    size_t                    patch_col_count,
-    enum coding_type          coding_type,
-    size_t                    word_count,
-    const double* restrict    dict,
-    const double* restrict    dict_transp,
-    const double* restrict    dict_x_dict_transp,
-    size_t                    coeff_count,
-    const void* restrict      coding_params,
-    enum nonlinear_type       nonlinear_type,
-    const double* restrict    nonlinear_modulator,
-    enum polarity_split_type  polarity_split_type,
-    enum reduce_type          reduce_type,
-    size_t                    reduce_spread,
-    const double* restrict    observation,
-    void* restrict            coding_tmps) {
+size_t
+code_image_merge_bands_tmps_length(
+    size_t  band_count,
+    size_t  band_capacity,
+    size_t  hashed_geometry) {
+    size_t  merge_tmps_length;
+
+    merge_tmps_length = 0;
+
+    merge_tmps_length += band_count * sizeof(size_t);
+
+    if (hashed_geometry != 0) {
+	merge_tmps_length += band_count * band_capacity * sizeof(double);
+	merge_tmps_length += band_count * band_capacity * sizeof(coeff_idx_t);
+    }
+
+    return merge_tmps_length;
+}
+
+static void
+_code_band(
+    size_t* restrict                                o_coeff_count,
+    double* restrict                                o_coeffs,
+    coeff_idx_t* restrict                           o_coeffs_idx,
+    size_t                                          geometry,
+    size_t                                          row_count,
+    size_t                                          col_count,
+    size_t                                          layer_count,
+    size_t                                          patch_row_count,
+    size_t                                          patch_col_count,
+    enum channel_mode                               channel_mode,
+    enum coding_type                                coding_type,
+    size_t                                          word_count,
+    const struct dictionary_state* const* restrict  dicts,
+    size_t                                          coeff_count,
+    const void* restrict                            coding_params,
+    enum nonlinear_type                             nonlinear_type,
+    const double* restrict                          nonlinear_modulator,
+    enum polarity_split_type                        polarity_split_type,
+    enum reduce_type                                reduce_type,
+    size_t                                          reduce_spread,
+    size_t                                          band_first_row,
+    size_t                                          band_row_count,
+    const double* restrict                          observation,
+    char* restrict                                  coding_tmps) {
     char* restrict          curr_coding_tmps;
-    size_t                  aftcoding_row_count;
+    size_t                  channel_count;
+    size_t                  patch_geometry;
+    size_t                  patch_coeff_count;
+    size_t                  channel_word_count;
     size_t                  aftcoding_col_count;
+    size_t                  band_patch_count;
+    size_t                  band_cell_row_count;
     double* restrict        coded_patches;
-    size_t* restrict        coded_patches_idx;
+    coeff_idx_t* restrict   coded_patches_idx;
     size_t                  polarity_split_multiplier;
     size_t                  aftreduce_row_count;
     size_t                  aftreduce_col_count;
 
-    curr_coding_tmps = (char* restrict)coding_tmps;
+    curr_coding_tmps = coding_tmps;
+
+    /* With "PER_CHANNEL" channels, each layer of a patch is coded against its own dictionary, "dicts[ll]", and gets
+       its own block of "coeff_count" coefficients and "word_count" words. With "JOINT" channels, "dicts" holds just
+       one. Past the coding layer, a patch then looks like one coded against a single dictionary of
+       "channel_word_count" words. */
+
+    channel_count = _channel_count(layer_count,channel_mode);
+    patch_geometry = _patch_geometry(layer_count,patch_row_count,patch_col_count,channel_mode);
+    patch_coeff_count = coeff_count * channel_count;
+    channel_word_count = word_count * channel_count;
 
     /* Coding layer. */
 
     {
 	double* restrict         patch_for_coding;
-	double* restrict         patch_for_coding_ptr;
-	const double*  restrict  curr_observation_col;
 	char* restrict           coder_coding_tmps;
 	coding_method_t          coding_method;
-	size_t                   patch_side_row;
-	size_t                   patch_init_row;
-	size_t                   patch_final_row;
-	size_t                   patch_skipped_initial_rows;
-	size_t                   patch_skipped_final_rows;
-	size_t                   patch_side_col;
-	size_t                   patch_init_col;
-	size_t                   patch_final_col;
-	size_t                   patch_skipped_initial_cols;
 	size_t                   curr_patch_offset;
-	double                   patch_sum_values;
-	double                   patch_mean;
+	double* restrict         curr_coded_patch;
+	coeff_idx_t* restrict    curr_coded_patch_idx;
 	size_t                   cc;
 	size_t                   rr;
-	size_t                   rr_1;
-	size_t                   cc_1;
+	size_t                   ll;
 	size_t                   ii;
 
-	aftcoding_row_count = row_count - (row_count % reduce_spread);
 	aftcoding_col_count = col_count - (col_count % reduce_spread);
+	band_patch_count = band_row_count * aftcoding_col_count;
+	band_cell_row_count = band_row_count / reduce_spread;
 
 	patch_for_coding = (double* restrict)curr_coding_tmps;
-	curr_coding_tmps += patch_row_count * patch_col_count * sizeof(double);
+	curr_coding_tmps += patch_row_count * patch_col_count * layer_count * sizeof(double);
 	coded_patches = (double* restrict)curr_coding_tmps;
-	curr_coding_tmps += coeff_count * aftcoding_row_count * aftcoding_col_count * sizeof(double);
-	coded_patches_idx = (size_t* restrict)curr_coding_tmps;
-	curr_coding_tmps += coeff_count * aftcoding_row_count * aftcoding_col_count * sizeof(size_t);
-
-	if (coding_type == CORRELATION) {
-	    coding_method = correlation;
-	    coder_coding_tmps = curr_coding_tmps;
-	    curr_coding_tmps += correlation_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-	} else if (coding_type == MATCHING_PURSUIT) {
-	    coding_method = matching_pursuit;
-	    coder_coding_tmps = curr_coding_tmps;
-	    curr_coding_tmps += matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-	} else if (coding_type == ORTHOGONAL_MATCHING_PURSUIT) {
-	    coding_method = orthogonal_matching_pursuit;
-	    coder_coding_tmps = curr_coding_tmps;
-	    curr_coding_tmps += orthogonal_matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-	} else if (coding_type == OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT) {
-	    coding_method = optimized_orthogonal_matching_pursuit;
-	    coder_coding_tmps = curr_coding_tmps;
-	    curr_coding_tmps += optimized_orthogonal_matching_pursuit_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-	} else if (coding_type == SPARSE_NET) {
-	    coding_method = sparse_net;
-	    coder_coding_tmps = curr_coding_tmps;
-	    curr_coding_tmps += sparse_net_coding_tmps_length(patch_row_count * patch_col_count,word_count,coeff_count);
-	} else {
-	    exit(EXIT_FAILURE);
-	}
+	curr_coding_tmps += patch_coeff_count * band_patch_count * sizeof(double);
+	coded_patches_idx = (coeff_idx_t* restrict)curr_coding_tmps;
+	curr_coding_tmps += patch_coeff_count * band_patch_count * sizeof(coeff_idx_t);
+
+	coding_method = coding_type_method(coding_type);
+	coder_coding_tmps = curr_coding_tmps;
+	curr_coding_tmps += coding_type_tmps_length(coding_type,patch_geometry,word_count,coeff_count);
 
 	for (cc = 0; cc < aftcoding_col_count; cc++) {
-	    for (rr = 0; rr < aftcoding_row_count; rr++) {
+	    for (rr = band_first_row; rr < band_first_row + band_row_count; rr++) {
 		/* Copy patch to temporary storage before actual coding. */
 
-		/* We're using "(row|col)_count" here becase we can allow patches
-		   to extend in the whole image, not just the pixels in the reduce areas. */
-
-		patch_side_row = (patch_row_count - 1) / 2;
-		patch_init_row = rr < patch_side_row ? 0 : (rr - patch_side_row);
-		patch_final_row = row_count < (rr + patch_side_row + 1) ? row_count : (rr + patch_side_row + 1);
-		patch_skipped_initial_rows = rr < patch_side_row ? (patch_side_row - rr) : 0;
-		patch_skipped_final_rows = row_count < (rr + patch_side_row + 1) ? (rr + patch_side_row + 1 - row_count) : 0;
+		_extract_patch_centered(patch_for_coding,row_count,col_count,layer_count,patch_row_count,patch_col_count,channel_mode,rr,cc,observation);
 
-		patch_side_col = (patch_col_count - 1) / 2;
-		patch_init_col = cc < patch_side_col ? 0 : (cc - patch_side_col);
-		patch_final_col = col_count < (cc + patch_side_col + 1) ? col_count : (cc + patch_side_col + 1);
-		patch_skipped_initial_cols = cc < patch_side_col ? (patch_side_col - cc) : 0;
+		/* Perform actual coding. */
 
-		memset(patch_for_coding,0,patch_row_count * patch_col_count * sizeof(double));
+		curr_patch_offset = (cc / reduce_spread) * band_cell_row_count * (reduce_spread * reduce_spread) +
+		                    ((rr - band_first_row) / reduce_spread) * (reduce_spread * reduce_spread) +
+		                    (cc % reduce_spread) * reduce_spread + (rr % reduce_spread);
 
-		patch_for_coding_ptr = patch_for_coding + patch_skipped_initial_cols * patch_row_count + patch_skipped_initial_rows;
-		curr_observation_col = observation + patch_init_col * row_count;
+		for (ll = 0; ll < channel_count; ll++) {
+		    curr_coded_patch = coded_patches + curr_patch_offset * patch_coeff_count + ll * coeff_count;
+		    curr_coded_patch_idx = coded_patches_idx + curr_patch_offset * patch_coeff_count + ll * coeff_count;
 
-		patch_sum_values = 0;
+		    coding_method(curr_coded_patch,curr_coded_patch_idx,
+				  patch_geometry,word_count,dicts[ll]->dict,dicts[ll]->dict_transp,dicts[ll]->dict_x_dict_transp,coeff_count,
+				  coding_params,patch_for_coding + ll * patch_geometry,coder_coding_tmps);
 
-		for (cc_1 = patch_init_col; cc_1 < patch_final_col; cc_1++) {
-		    for (rr_1 = patch_init_row; rr_1 < patch_final_row; rr_1++) {
-			*patch_for_coding_ptr = *(curr_observation_col + rr_1);
-			patch_sum_values += *(curr_observation_col + rr_1);
-			patch_for_coding_ptr++;
+		    for (ii = 0; ii < coeff_count; ii++) {
+			curr_coded_patch_idx[ii] = (coeff_idx_t)(curr_coded_patch_idx[ii] + ll * word_count);
 		    }
-
-		    patch_for_coding_ptr += patch_skipped_initial_rows + patch_skipped_final_rows;
-		    curr_observation_col += row_count;
 		}
-
-		/* Substract mean from each patch element. */
-
-		patch_mean = patch_sum_values / (patch_row_count * patch_col_count);
-
-		for (ii = 0; ii < patch_row_count * patch_col_count; ii++) {
-		    patch_for_coding[ii] = patch_for_coding[ii] - patch_mean;
-		}
-
-		/* Perform actual coding. */
-
-		curr_patch_offset = (cc / reduce_spread) * (row_count / reduce_spread) * (reduce_spread * reduce_spread) +
-		                    (rr / reduce_spread) * (reduce_spread * reduce_spread) +
-		                    (cc % reduce_spread) * reduce_spread + (rr % reduce_spread);
-
-		coding_method(coded_patches + curr_patch_offset * coeff_count,coded_patches_idx + curr_patch_offset * coeff_count,
-			      patch_row_count * patch_col_count,word_count,dict,dict_transp,dict_x_dict_transp,coeff_count,
-			      coding_params,patch_for_coding,coder_coding_tmps);
 	    }
 	}
     }
@@ -279,7 +535,7 @@ code_image(
     } else if (nonlinear_type == LOGISTIC) {
 	size_t  ii;
 
-    	for (ii = 0; ii < aftcoding_row_count * aftcoding_col_count * coeff_count; ii++) {
+    	for (ii = 0; ii < band_patch_count * patch_coeff_count; ii++) {
     	    coded_patches[ii] = 1 / (1 + exp(-coded_patches[ii])) - 0.5;
     	}
     } else if (nonlinear_type == GLOBAL_ORDER) {
@@ -289,35 +545,35 @@ code_image(
 
 	coded_patches_curr = coded_patches;
 
-	for (ii = 0; ii < aftcoding_row_count * aftcoding_col_count; ii++) {
-	    for (jj = 0; jj < coeff_count; jj++) {
+	for (ii = 0; ii < band_patch_count; ii++) {
+	    for (jj = 0; jj < patch_coeff_count; jj++) {
 		if (coded_patches_curr[jj] > 0) {
-		    coded_patches_curr[jj] = nonlinear_modulator[jj];
+		    coded_patches_curr[jj] = nonlinear_modulator[jj % coeff_count];
 		} else if (coded_patches_curr[jj] < 0){
-		    coded_patches_curr[jj] = -nonlinear_modulator[jj];
+		    coded_patches_curr[jj] = -nonlinear_modulator[jj % coeff_count];
 		} else {
 		    coded_patches_curr[jj] = 0;
 		}
 	    }
 
-	    coded_patches_curr += coeff_count;
+	    coded_patches_curr += patch_coeff_count;
 	}
     } else {
 	exit(EXIT_FAILURE);
     }
 
     {
-	double* restrict  coded_patches_curr;
-	size_t* restrict  coded_patches_idx_curr;
-	size_t            ii;
+	double* restrict       coded_patches_curr;
+	coeff_idx_t* restrict  coded_patches_idx_curr;
+	size_t                 ii;
 
 	coded_patches_curr = coded_patches;
 	coded_patches_idx_curr = coded_patches_idx;
 
-	for (ii = 0; ii < aftcoding_row_count * aftcoding_col_count; ii++) {
-	    sort_by_idxs(coded_patches_curr,coded_patches_idx_curr,coeff_count);
-	    coded_patches_curr += coeff_count;
-	    coded_patches_idx_curr += coeff_count;
+	for (ii = 0; ii < band_patch_count; ii++) {
+	    sort_by_idxs(coded_patches_curr,coded_patches_idx_curr,patch_coeff_count);
+	    coded_patches_curr += patch_coeff_count;
+	    coded_patches_idx_curr += patch_coeff_count;
 	}
     }
 
@@ -326,11 +582,11 @@ code_image(
     if (polarity_split_type == NONE) {
 	polarity_split_multiplier = 1;
     } else if (polarity_split_type == NO_SIGN || polarity_split_type == KEEP_SIGN) {
-	double* restrict  coded_patches_ptr;
-	size_t* restrict  coded_patches_idx_ptr;
-	double            polarity_multiplier;
-	size_t            ii;
-	size_t            jj;
+	double* restrict       coded_patches_ptr;
+	coeff_idx_t* restrict  coded_patches_idx_ptr;
+	double                 polarity_multiplier;
+	size_t                 ii;
+	size_t                 jj;
 
     	coded_patches_ptr = coded_patches;
     	coded_patches_idx_ptr = coded_patches_idx;
@@ -341,15 +597,15 @@ code_image(
     	    polarity_multiplier = 1;
     	}
 
-    	for (ii = 0; ii < aftcoding_row_count * aftcoding_col_count; ii++) {
-    	    for (jj = 0; jj < coeff_count; jj++,coded_patches_ptr++,coded_patches_idx_ptr++) {
+    	for (ii = 0; ii < band_patch_count; ii++) {
+    	    for (jj = 0; jj < patch_coeff_count; jj++,coded_patches_ptr++,coded_patches_idx_ptr++) {
     		if (*coded_patches_ptr < 0) {
     		    *coded_patches_ptr = polarity_multiplier * *coded_patches_ptr;
-    		    *coded_patches_idx_ptr += word_count;
+    		    *coded_patches_idx_ptr = (coeff_idx_t)(*coded_patches_idx_ptr + channel_word_count);
     		}
     	    }
 
-    	    sort_by_idxs(coded_patches_ptr - coeff_count,coded_patches_idx_ptr - coeff_count,coeff_count);
+    	    sort_by_idxs(coded_patches_ptr - patch_coeff_count,coded_patches_idx_ptr - patch_coeff_count,patch_coeff_count);
     	}
 
 	polarity_split_multiplier = 2;
@@ -360,19 +616,16 @@ code_image(
     /* Reduce layer - HERE BE DRAGONS. */
 
     {
-	size_t            reduce_spread_2;
-	size_t* restrict  curr_indices;
-	double* restrict  coded_patches_ptr;
-	size_t* restrict  coded_patches_idx_ptr;
-	double            final_result;
-	bool              set_final_result;
-	size_t            coeffs_count;
-	reduce_function   reduce_function;
-	size_t            ii;
-	size_t            jj;
-	size_t            kk;
-
-	aftreduce_row_count = aftcoding_row_count / reduce_spread;
+	size_t                 reduce_spread_2;
+	size_t* restrict       curr_indices;
+	double* restrict       coded_patches_ptr;
+	coeff_idx_t* restrict  coded_patches_idx_ptr;
+	size_t                 coeffs_count;
+	size_t                 cell_idx;
+	size_t                 ii;
+	size_t                 jj;
+
+	aftreduce_row_count = row_count / reduce_spread;
 	aftreduce_col_count = aftcoding_col_count / reduce_spread;
 
 	reduce_spread_2 = reduce_spread * reduce_spread;
@@ -385,55 +638,34 @@ code_image(
 
 	coeffs_count = 0;
 
+	/* Cells of the band are numbered as in the whole image, so features of different bands never collide. */
+
 	if (reduce_type == SUBSAMPLE) {
-	    for (ii = 0; ii < aftreduce_row_count * aftreduce_col_count; ii++) {
-		for (jj = 0; jj < coeff_count; jj++) {
+	    for (ii = 0; ii < band_cell_row_count * aftreduce_col_count; ii++) {
+		cell_idx = (ii / band_cell_row_count) * aftreduce_row_count + band_first_row / reduce_spread + ii % band_cell_row_count;
+
+		for (jj = 0; jj < patch_coeff_count; jj++) {
 		    o_coeffs[coeffs_count] = coded_patches_ptr[jj];
-		    o_coeffs_idx[coeffs_count] = ii + coded_patches_idx_ptr[jj] * aftreduce_row_count * aftreduce_col_count;
+		    o_coeffs_idx[coeffs_count] = (coeff_idx_t)(cell_idx + coded_patches_idx_ptr[jj] * aftreduce_row_count * aftreduce_col_count);
 		    coeffs_count++;
 		}
 
-		coded_patches_ptr += reduce_spread * reduce_spread * coeff_count;
-		coded_patches_idx_ptr += reduce_spread * reduce_spread * coeff_count;
+		coded_patches_ptr += reduce_spread * reduce_spread * patch_coeff_count;
+		coded_patches_idx_ptr += reduce_spread * reduce_spread * patch_coeff_count;
 	    }
 
 	    sort_by_idxs(o_coeffs,o_coeffs_idx,coeffs_count);
 	    *o_coeff_count = coeffs_count;
 	} else if (reduce_type == MAX_NO_SIGN || reduce_type == MAX_KEEP_SIGN || reduce_type == SUM_ABS || reduce_type == SUM_SQR) {
-	    if (reduce_type == MAX_NO_SIGN) {
-		reduce_function = _max_no_sign;
-	    } else if (reduce_type == MAX_KEEP_SIGN) {
-		reduce_function = _max_keep_sign;
-	    } else if (reduce_type == SUM_ABS) {
-		reduce_function = _sum_abs;
-	    } else {
-		reduce_function = _sum_sqr;
-	    }
-
-	    for (ii = 0; ii < aftreduce_row_count * aftreduce_col_count; ii++) {
-		memset(curr_indices,0,reduce_spread_2 * sizeof(size_t));
+	    for (ii = 0; ii < band_cell_row_count * aftreduce_col_count; ii++) {
+		cell_idx = (ii / band_cell_row_count) * aftreduce_row_count + band_first_row / reduce_spread + ii % band_cell_row_count;
 
-		for (jj = 0; jj < word_count * polarity_split_multiplier; jj++) {
-		    final_result = 0;
-		    set_final_result = false;
+		coeffs_count += _reduce_cell(o_coeffs + coeffs_count,o_coeffs_idx + coeffs_count,
+					     cell_idx,aftreduce_row_count * aftreduce_col_count,channel_word_count * polarity_split_multiplier,patch_coeff_count,
+					     reduce_type,reduce_spread_2,coded_patches_ptr,coded_patches_idx_ptr,curr_indices);
 
-		    for (kk = 0; kk < reduce_spread_2; kk++) {
-			if (curr_indices[kk] < coeff_count && (coded_patches_idx_ptr[kk * coeff_count + curr_indices[kk]] == jj)) {
-			    final_result = reduce_function(final_result,coded_patches_ptr[kk * coeff_count + curr_indices[kk]]);
-			    curr_indices[kk]++;
-			    set_final_result = true;
-			}
-		    }
-
-		    if (set_final_result && final_result != 0) {
-			o_coeffs[coeffs_count] = final_result;
-			o_coeffs_idx[coeffs_count] = ii + jj * aftreduce_row_count * aftreduce_col_count;
-			coeffs_count++;
-		    }
-		}
-
-		coded_patches_ptr += reduce_spread * reduce_spread * coeff_count;
-		coded_patches_idx_ptr += reduce_spread * reduce_spread * coeff_count;
+		coded_patches_ptr += reduce_spread * reduce_spread * patch_coeff_count;
+		coded_patches_idx_ptr += reduce_spread * reduce_spread * patch_coeff_count;
 	    }
 
 	    sort_by_idxs(o_coeffs,o_coeffs_idx,coeffs_count);
@@ -443,3 +675,188 @@ code_image(
 	}
     }
 }
+
+void
+code_image(
+    size_t* restrict                                o_coeff_count,
+    double* restrict                                o_coeffs,
+    coeff_idx_t* restrict                           o_coeffs_idx,
+    size_t                                          geometry,
+    size_t                                          row_count,
+    size_t                                          col_count,
+    size_t                                          layer_count,
+    size_t                                          patch_row_count,
+    size_t                                          patch_col_count,
+    enum channel_mode                               channel_mode,
+    enum coding_type                                coding_type,
+    size_t                                          word_count,
+    const struct dictionary_state* const* restrict  dicts,
+    size_t                                          coeff_count,
+    const void* restrict                            coding_params,
+    enum nonlinear_type                             nonlinear_type,
+    const double* restrict                          nonlinear_modulator,
+    enum polarity_split_type                        polarity_split_type,
+    enum reduce_type                                reduce_type,
+    size_t                                          reduce_spread,
+    size_t                                          hashed_geometry,
+    const double* restrict                          observation,
+    void* restrict                                  coding_tmps) {
+    char* restrict          curr_coding_tmps;
+    size_t                  aftcoding_row_count;
+    size_t                  reduced_max_coeff_count;
+    double* restrict        reduced_coeffs;
+    coeff_idx_t* restrict   reduced_coeffs_idx;
+    size_t                  reduced_coeff_count;
+
+    curr_coding_tmps = (char* restrict)coding_tmps;
+
+    aftcoding_row_count = row_count - (row_count % reduce_spread);
+
+    /* The whole image is coded as a single band. With hashing, the reduced features are an intermediate result,
+       which can be larger than the output. */
+
+    if (hashed_geometry != 0) {
+	reduced_max_coeff_count = code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,aftcoding_row_count);
+
+	curr_coding_tmps += code_image_band_tmps_length(col_count,layer_count,patch_row_count,patch_col_count,channel_mode,coding_type,word_count,coeff_count,reduce_spread,aftcoding_row_count);
+	reduced_coeffs = (double* restrict)curr_coding_tmps;
+	curr_coding_tmps += reduced_max_coeff_count * sizeof(double);
+	reduced_coeffs_idx = (coeff_idx_t* restrict)curr_coding_tmps;
+	curr_coding_tmps += reduced_max_coeff_count * sizeof(coeff_idx_t);
+    } else {
+	reduced_coeffs = o_coeffs;
+	reduced_coeffs_idx = o_coeffs_idx;
+    }
+
+    _code_band(&reduced_coeff_count,reduced_coeffs,reduced_coeffs_idx,geometry,row_count,col_count,layer_count,patch_row_count,patch_col_count,
+	       channel_mode,coding_type,word_count,dicts,coeff_count,coding_params,nonlinear_type,nonlinear_modulator,
+	       polarity_split_type,reduce_type,reduce_spread,0,aftcoding_row_count,observation,(char* restrict)coding_tmps);
+
+    /* Hashing layer. */
+
+    if (hashed_geometry != 0) {
+	*o_coeff_count = _hash_features(o_coeffs,o_coeffs_idx,hashed_geometry,reduced_coeff_count,reduced_coeffs,reduced_coeffs_idx);
+    } else {
+	*o_coeff_count = reduced_coeff_count;
+    }
+}
+
+void
+code_image_band(
+    size_t* restrict                                o_coeff_count,
+    double* restrict                                o_coeffs,
+    coeff_idx_t* restrict                           o_coeffs_idx,
+    size_t                                          geometry,
+    size_t                                          row_count,
+    size_t                                          col_count,
+    size_t                                          layer_count,
+    size_t                                          patch_row_count,
+    size_t                                          patch_col_count,
+    enum channel_mode                               channel_mode,
+    enum coding_type                                coding_type,
+    size_t                                          word_count,
+    const struct dictionary_state* const* restrict  dicts,
+    size_t                                          coeff_count,
+    const void* restrict                            coding_params,
+    enum nonlinear_type                             nonlinear_type,
+    const double* restrict                          nonlinear_modulator,
+    enum polarity_split_type                        polarity_split_type,
+    enum reduce_type                                reduce_type,
+    size_t                                          reduce_spread,
+    size_t                                          band_row_count,
+    size_t                                          band_idx,
+    const double* restrict                          observation,
+    void* restrict                                  coding_tmps) {
+    size_t  aftcoding_row_count;
+    size_t  band_first_row;
+    size_t  curr_band_row_count;
+
+    /* A band covers "band_row_count" rows of patch centers, except for the last one, which covers what is left. The
+       patches near the edges of the band still read the rows of the neighbouring bands, so for deterministic coders
+       the result does not depend on how the image is split. "SPARSE_NET" draws from "coding_param", and its result
+       follows the draws each band gets. Features are unhashed and sorted, and "code_image_merge_bands" assembles
+       them into the features of the whole image. */
+
+    aftcoding_row_count = row_count - (row_count % reduce_spread);
+    band_first_row = band_idx * band_row_count;
+    curr_band_row_count = aftcoding_row_count - band_first_row < band_row_count ? aftcoding_row_count - band_first_row : band_row_count;
+
+    _code_band(o_coeff_count,o_coeffs,o_coeffs_idx,geometry,row_count,col_count,layer_count,patch_row_count,patch_col_count,
+	       channel_mode,coding_type,word_count,dicts,coeff_count,coding_params,nonlinear_type,nonlinear_modulator,
+	       polarity_split_type,reduce_type,reduce_spread,band_first_row,curr_band_row_count,observation,(char* restrict)coding_tmps);
+}
+
+void
+code_image_merge_bands(
+    size_t* restrict             o_coeff_count,
+    double* restrict             o_coeffs,
+    coeff_idx_t* restrict        o_coeffs_idx,
+    size_t                       band_count,
+    size_t                       band_capacity,
+    const size_t* restrict       bands_coeff_count,
+    const double* restrict       bands_coeffs,
+    const coeff_idx_t* restrict  bands_coeffs_idx,
+    size_t                       hashed_geometry,
+    void* restrict               merge_tmps) {
+    char* restrict          curr_merge_tmps;
+    size_t* restrict        bands_cursor;
+    double* restrict        merged_coeffs;
+    coeff_idx_t* restrict   merged_coeffs_idx;
+    size_t                  merged_count;
+    size_t                  min_band;
+    size_t                  ii;
+
+    curr_merge_tmps = (char* restrict)merge_tmps;
+
+    bands_cursor = (size_t* restrict)curr_merge_tmps;
+    curr_merge_tmps += band_count * sizeof(size_t);
+
+    if (hashed_geometry != 0) {
+	merged_coeffs = (double* restrict)curr_merge_tmps;
+	curr_merge_tmps += band_count * band_capacity * sizeof(double);
+	merged_coeffs_idx = (coeff_idx_t* restrict)curr_merge_tmps;
+	curr_merge_tmps += band_count * band_capacity * sizeof(coeff_idx_t);
+    } else {
+	merged_coeffs = o_coeffs;
+	merged_coeffs_idx = o_coeffs_idx;
+    }
+
+    /* The band "ii" is stored from "ii * band_capacity" onwards. Bands hold disjoint sets of cells, so no index
+       appears in two of them, and a plain k-way merge gives the sorted features of the whole image. There are only
+       a few bands, so the smallest head is found by a linear scan. */
+
+    for (ii = 0; ii < band_count; ii++) {
+	bands_cursor[ii] = 0;
+    }
+
+    merged_count = 0;
+
+    while (true) {
+	min_band = band_count;
+
+	for (ii = 0; ii < band_count; ii++) {
+	    if (bands_cursor[ii] < bands_coeff_count[ii] &&
+		(min_band == band_count ||
+		 bands_coeffs_idx[ii * band_capacity + bands_cursor[ii]] < bands_coeffs_idx[min_band * band_capacity + bands_cursor[min_band]])) {
+		min_band = ii;
+	    }
+	}
+
+	if (min_band == band_count) {
+	    break;
+	}
+
+	merged_coeffs[merged_count] = bands_coeffs[min_band * band_capacity + bands_cursor[min_band]];
+	merged_coeffs_idx[merged_count] = bands_coeffs_idx[min_band * band_capacity + bands_cursor[min_band]];
+	merged_count += 1;
+	bands_cursor[min_band] += 1;
+    }
+
+    /* Hashing layer. */
+
+    if (hashed_geometry != 0) {
+	*o_coeff_count = _hash_features(o_coeffs,o_coeffs_idx,hashed_geometry,merged_count,merged_coeffs,merged_coeffs_idx);
+    } else {
+	*o_coeff_count = merged_count;
+    }
+}
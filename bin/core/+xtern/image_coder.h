@@ -1,14 +1,17 @@
 #ifndef _IMAGE_CODER_H
 #define _IMAGE_CODER_H
 
+#include <stdbool.h>
+
 #include "base_defines.h"
+#include "coding_methods.h"
+#include "dictionary_state.h"
+
+BEGIN_C_DECLS
 
-enum coding_type {
-    CORRELATION,
-    MATCHING_PURSUIT,
-    ORTHOGONAL_MATCHING_PURSUIT,
-    OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,
-    SPARSE_NET
+enum channel_mode {
+    JOINT,
+    PER_CHANNEL
 };
 
 enum nonlinear_type {
@@ -31,8 +34,18 @@ enum reduce_type {
     SUM_SQR
 };
 
-extern size_t  code_image_new_geometry(size_t row_count,size_t col_count,size_t word_count,enum polarity_split_type polarity_split_type,size_t reduce_spread);
-extern size_t  code_image_coding_tmps_length(size_t row_count,size_t col_count,size_t patch_row_count,size_t patch_col_count,enum coding_type coding_type,size_t word_count,size_t coeff_count,size_t reduce_spread);
-extern void    code_image(size_t* restrict o_coeff_count,double* restrict o_coeffs,size_t* restrict o_coeffs_idx,size_t geometry,size_t row_count,size_t col_count,size_t patch_row_count,size_t patch_col_count,enum coding_type coding_type,size_t word_count,const double* restrict dict,const double* restrict dict_transp,const double* restrict dict_x_dict_transp,size_t coeff_count,const void* restrict coding_param,enum nonlinear_type nonlinear_type,const double* restrict nonlinear_modulator,enum polarity_split_type polarity_split_type,enum reduce_type reduce_type,size_t reduce_spread,const double* restrict observation,void* restrict coding_tmps);
+extern size_t  code_image_new_geometry(size_t row_count,size_t col_count,size_t layer_count,size_t word_count,enum channel_mode channel_mode,enum polarity_split_type polarity_split_type,size_t reduce_spread,size_t hashed_geometry);
+extern bool    code_image_idx_fits(size_t row_count,size_t col_count,size_t layer_count,size_t word_count,enum channel_mode channel_mode,enum polarity_split_type polarity_split_type,size_t reduce_spread,size_t hashed_geometry);
+extern size_t  code_image_coding_tmps_length(size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,enum channel_mode channel_mode,enum coding_type coding_type,size_t word_count,size_t coeff_count,size_t reduce_spread,size_t hashed_geometry);
+extern size_t  code_image_band_row_count(size_t row_count,size_t reduce_spread,size_t max_band_count);
+extern size_t  code_image_band_count(size_t row_count,size_t reduce_spread,size_t band_row_count);
+extern size_t  code_image_band_max_coeff_count(size_t col_count,size_t layer_count,enum channel_mode channel_mode,size_t coeff_count,size_t reduce_spread,size_t band_row_count);
+extern size_t  code_image_band_tmps_length(size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,enum channel_mode channel_mode,enum coding_type coding_type,size_t word_count,size_t coeff_count,size_t reduce_spread,size_t band_row_count);
+extern size_t  code_image_merge_bands_tmps_length(size_t band_count,size_t band_capacity,size_t hashed_geometry);
+extern void    code_image(size_t* restrict o_coeff_count,double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t geometry,size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,enum channel_mode channel_mode,enum coding_type coding_type,size_t word_count,const struct dictionary_state* const* restrict dicts,size_t coeff_count,const void* restrict coding_param,enum nonlinear_type nonlinear_type,const double* restrict nonlinear_modulator,enum polarity_split_type polarity_split_type,enum reduce_type reduce_type,size_t reduce_spread,size_t hashed_geometry,const double* restrict observation,void* restrict coding_tmps);
+extern void    code_image_band(size_t* restrict o_coeff_count,double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t geometry,size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,enum channel_mode channel_mode,enum coding_type coding_type,size_t word_count,const struct dictionary_state* const* restrict dicts,size_t coeff_count,const void* restrict coding_param,enum nonlinear_type nonlinear_type,const double* restrict nonlinear_modulator,enum polarity_split_type polarity_split_type,enum reduce_type reduce_type,size_t reduce_spread,size_t band_row_count,size_t band_idx,const double* restrict observation,void* restrict coding_tmps);
+extern void    code_image_merge_bands(size_t* restrict o_coeff_count,double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t band_count,size_t band_capacity,const size_t* restrict bands_coeff_count,const double* restrict bands_coeffs,const coeff_idx_t* restrict bands_coeffs_idx,size_t hashed_geometry,void* restrict merge_tmps);
+
+END_C_DECLS
 
 #endif
@@ -0,0 +1,342 @@
+#include <string.h>
+#include <math.h>
+
+#include "random_tools.h"
+#include "image_deform.h"
+
+size_t
+image_deform_tmps_length(
+    size_t  row_count,
+    size_t  col_count) {
+    return row_count * col_count * sizeof(double) +                                // for "field_row".
+           row_count * col_count * sizeof(double) +                                // for "field_col".
+           row_count * col_count * sizeof(double) +                                // for "src_row".
+           row_count * col_count * sizeof(double) +                                // for "src_col".
+           row_count * col_count * sizeof(double) +                                // for "smooth_field" "pass".
+           ((row_count > col_count ? row_count : col_count) + 1) * sizeof(double); // for "smooth_field" "kernel".
+}
+
+void
+gaussian_kernel(
+    double* restrict  o_kernel,
+    size_t            half_width,
+    double            sigma) {
+    double  sum;
+    double  offset;
+    size_t  ii;
+
+    sum = 0;
+
+    for (ii = 0; ii < 2 * half_width + 1; ii++) {
+	offset = (double)ii - (double)half_width;
+	o_kernel[ii] = exp(-offset * offset / (2 * sigma * sigma));
+	sum += o_kernel[ii];
+    }
+
+    for (ii = 0; ii < 2 * half_width + 1; ii++) {
+	o_kernel[ii] = o_kernel[ii] / sum;
+    }
+}
+
+void
+random_field(
+    double* restrict  o_field,
+    size_t            row_count,
+    size_t            col_count,
+    uint64_t          seed,
+    size_t            stream,
+    size_t            counter_start) {
+    size_t  ii;
+
+    for (ii = 0; ii < row_count * col_count; ii++) {
+	o_field[ii] = 0.1 * counter_rng_uniform(seed,stream,counter_start + ii) - 0.05;
+    }
+}
+
+void
+smooth_field(
+    double* restrict  io_field,
+    size_t            row_count,
+    size_t            col_count,
+    double            sigma,
+    void* restrict    tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  pass;
+    double* restrict  kernel;
+    size_t            half_width;
+    double            acc;
+    size_t            first;
+    size_t            last;
+    size_t            ii;
+    size_t            jj;
+    size_t            kk;
+
+    curr_tmps = (char*)tmps;
+    pass = (double*)curr_tmps;
+    curr_tmps += row_count * col_count * sizeof(double);
+    kernel = (double*)curr_tmps;
+    curr_tmps += ((row_count > col_count ? row_count : col_count) + 1) * sizeof(double);
+
+    /* A two dimensional Gaussian is the product of two one dimensional ones, so the full "same" convolution with a
+       zero border is done as a pass along columns followed by a pass along rows. */
+
+    half_width = row_count / 2;
+    gaussian_kernel(kernel,half_width,sigma);
+
+    for (jj = 0; jj < col_count; jj++) {
+	for (ii = 0; ii < row_count; ii++) {
+	    first = ii >= half_width ? ii - half_width : 0;
+	    last = ii + half_width < row_count ? ii + half_width : row_count - 1;
+	    acc = 0;
+
+	    for (kk = first; kk <= last; kk++) {
+		acc += kernel[kk + half_width - ii] * io_field[jj * row_count + kk];
+	    }
+
+	    pass[jj * row_count + ii] = acc;
+	}
+    }
+
+    half_width = col_count / 2;
+    gaussian_kernel(kernel,half_width,sigma);
+
+    for (jj = 0; jj < col_count; jj++) {
+	first = jj >= half_width ? jj - half_width : 0;
+	last = jj + half_width < col_count ? jj + half_width : col_count - 1;
+
+	for (ii = 0; ii < row_count; ii++) {
+	    io_field[jj * row_count + ii] = 0;
+	}
+
+	for (kk = first; kk <= last; kk++) {
+	    for (ii = 0; ii < row_count; ii++) {
+		io_field[jj * row_count + ii] += kernel[kk + half_width - jj] * pass[kk * row_count + ii];
+	    }
+	}
+    }
+}
+
+bool
+image_bounds(
+    size_t* restrict        o_min_row,
+    size_t* restrict        o_max_row,
+    size_t* restrict        o_min_col,
+    size_t* restrict        o_max_col,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    const double* restrict  image) {
+    bool    found;
+    size_t  ii;
+    size_t  jj;
+    size_t  kk;
+
+    found = false;
+    *o_min_row = row_count;
+    *o_max_row = 0;
+    *o_min_col = col_count;
+    *o_max_col = 0;
+
+    for (kk = 0; kk < layer_count; kk++) {
+	for (jj = 0; jj < col_count; jj++) {
+	    for (ii = 0; ii < row_count; ii++) {
+		if (image[kk * row_count * col_count + jj * row_count + ii] != 0) {
+		    found = true;
+		    *o_min_row = ii < *o_min_row ? ii : *o_min_row;
+		    *o_max_row = ii > *o_max_row ? ii : *o_max_row;
+		    *o_min_col = jj < *o_min_col ? jj : *o_min_col;
+		    *o_max_col = jj > *o_max_col ? jj : *o_max_col;
+		}
+	    }
+	}
+    }
+
+    return found;
+}
+
+void
+build_deform_map(
+    double* restrict        o_src_row,
+    double* restrict        o_src_col,
+    size_t                  row_count,
+    size_t                  col_count,
+    double                  source_center_row,
+    double                  source_center_col,
+    double                  scaling_row,
+    double                  scaling_col,
+    double                  rotation,
+    double                  field_intensity,
+    const double* restrict  field_row,
+    const double* restrict  field_col) {
+    double  center_row;
+    double  center_col;
+    double  cos_rotation;
+    double  sin_rotation;
+    double  row;
+    double  col;
+    double  rotated_row;
+    double  rotated_col;
+    size_t  ii;
+    size_t  jj;
+
+    /* Maps every output pixel back to the source image. The displacement field is applied first, then the inverse
+       rotation around the image center, and last the inverse scaling, which also moves the center of the content
+       from "source_center_row" and "source_center_col" to the image center. A NULL field means no displacement. */
+
+    center_row = ((double)row_count - 1) / 2;
+    center_col = ((double)col_count - 1) / 2;
+    cos_rotation = cos(rotation);
+    sin_rotation = sin(rotation);
+
+    for (jj = 0; jj < col_count; jj++) {
+	for (ii = 0; ii < row_count; ii++) {
+	    row = (double)ii - center_row;
+	    col = (double)jj - center_col;
+
+	    if (field_row != NULL) {
+		row += field_intensity * field_row[jj * row_count + ii];
+		col += field_intensity * field_col[jj * row_count + ii];
+	    }
+
+	    rotated_row = cos_rotation * row - sin_rotation * col;
+	    rotated_col = sin_rotation * row + cos_rotation * col;
+
+	    o_src_row[jj * row_count + ii] = source_center_row + rotated_row / scaling_row;
+	    o_src_col[jj * row_count + ii] = source_center_col + rotated_col / scaling_col;
+	}
+    }
+}
+
+void
+bilinear_resample(
+    double* restrict        o_image,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    const double* restrict  src_row,
+    const double* restrict  src_col,
+    const double* restrict  image) {
+    const double* restrict  layer;
+    double                  row;
+    double                  col;
+    size_t                  row_0;
+    size_t                  col_0;
+    size_t                  row_1;
+    size_t                  col_1;
+    double                  row_w;
+    double                  col_w;
+    size_t                  ii;
+    size_t                  kk;
+
+    /* Source positions outside of the image read as zero. The same map is used for every layer. */
+
+    for (ii = 0; ii < row_count * col_count; ii++) {
+	row = src_row[ii];
+	col = src_col[ii];
+
+	if ((row < 0) || (row > (double)(row_count - 1)) || (col < 0) || (col > (double)(col_count - 1))) {
+	    for (kk = 0; kk < layer_count; kk++) {
+		o_image[kk * row_count * col_count + ii] = 0;
+	    }
+
+	    continue;
+	}
+
+	row_0 = (size_t)row;
+	col_0 = (size_t)col;
+	row_1 = row_0 + 1 < row_count ? row_0 + 1 : row_0;
+	col_1 = col_0 + 1 < col_count ? col_0 + 1 : col_0;
+	row_w = row - (double)row_0;
+	col_w = col - (double)col_0;
+
+	for (kk = 0; kk < layer_count; kk++) {
+	    layer = image + kk * row_count * col_count;
+	    o_image[kk * row_count * col_count + ii] =
+		(1 - col_w) * ((1 - row_w) * layer[col_0 * row_count + row_0] + row_w * layer[col_0 * row_count + row_1]) +
+		col_w * ((1 - row_w) * layer[col_1 * row_count + row_0] + row_w * layer[col_1 * row_count + row_1]);
+	}
+    }
+}
+
+void
+deform_image(
+    double* restrict        o_image,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    double                  scaling_max,
+    double                  rotation_max,
+    double                  field_smoothness,
+    double                  field_intensity,
+    uint64_t                seed,
+    size_t                  stream,
+    const double* restrict  image,
+    void* restrict          tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  field_row;
+    double* restrict  field_col;
+    double* restrict  src_row;
+    double* restrict  src_col;
+    double            scaling_row;
+    double            scaling_col;
+    double            rotation;
+    size_t            min_row;
+    size_t            max_row;
+    size_t            min_col;
+    size_t            max_col;
+    double            field_max;
+    size_t            ii;
+
+    curr_tmps = (char*)tmps;
+    field_row = (double*)curr_tmps;
+    curr_tmps += row_count * col_count * sizeof(double);
+    field_col = (double*)curr_tmps;
+    curr_tmps += row_count * col_count * sizeof(double);
+    src_row = (double*)curr_tmps;
+    curr_tmps += row_count * col_count * sizeof(double);
+    src_col = (double*)curr_tmps;
+    curr_tmps += row_count * col_count * sizeof(double);
+
+    /* Each image owns a stream. Counters 0 to 2 give the scaling and rotation, and the two fields use the next
+       2 * "row_count" * "col_count" counters. Scaling is around the center of the nonzero content of the image. */
+
+    scaling_row = 1 + scaling_max / 100 * (2 * counter_rng_uniform(seed,stream,0) - 1);
+    scaling_col = 1 + scaling_max / 100 * (2 * counter_rng_uniform(seed,stream,1) - 1);
+    rotation = rotation_max * (2 * counter_rng_uniform(seed,stream,2) - 1) * M_PI / 180;
+
+    if (!image_bounds(&min_row,&max_row,&min_col,&max_col,row_count,col_count,layer_count,image)) {
+	memset(o_image,0,row_count * col_count * layer_count * sizeof(double));
+	return;
+    }
+
+    if (field_smoothness > 0) {
+	random_field(field_row,row_count,col_count,seed,stream,3);
+	random_field(field_col,row_count,col_count,seed,stream,3 + row_count * col_count);
+	smooth_field(field_row,row_count,col_count,field_smoothness,curr_tmps);
+	smooth_field(field_col,row_count,col_count,field_smoothness,curr_tmps);
+
+	field_max = field_row[0];
+	for (ii = 1; ii < row_count * col_count; ii++) {
+	    field_max = field_row[ii] > field_max ? field_row[ii] : field_max;
+	}
+	for (ii = 0; ii < row_count * col_count; ii++) {
+	    field_row[ii] = field_row[ii] / field_max;
+	}
+
+	field_max = field_col[0];
+	for (ii = 1; ii < row_count * col_count; ii++) {
+	    field_max = field_col[ii] > field_max ? field_col[ii] : field_max;
+	}
+	for (ii = 0; ii < row_count * col_count; ii++) {
+	    field_col[ii] = field_col[ii] / field_max;
+	}
+
+	build_deform_map(src_row,src_col,row_count,col_count,((double)min_row + (double)max_row) / 2,((double)min_col + (double)max_col) / 2,
+			 scaling_row,scaling_col,rotation,field_intensity,field_row,field_col);
+    } else {
+	build_deform_map(src_row,src_col,row_count,col_count,((double)min_row + (double)max_row) / 2,((double)min_col + (double)max_col) / 2,
+			 scaling_row,scaling_col,rotation,0,NULL,NULL);
+    }
+
+    bilinear_resample(o_image,row_count,col_count,layer_count,src_row,src_col,image);
+}
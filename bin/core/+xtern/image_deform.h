@@ -0,0 +1,23 @@
+#ifndef _IMAGE_DEFORM_H
+#define _IMAGE_DEFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern size_t  image_deform_tmps_length(size_t row_count,size_t col_count);
+
+extern void    gaussian_kernel(double* restrict o_kernel,size_t half_width,double sigma);
+extern void    random_field(double* restrict o_field,size_t row_count,size_t col_count,uint64_t seed,size_t stream,size_t counter_start);
+extern void    smooth_field(double* restrict io_field,size_t row_count,size_t col_count,double sigma,void* restrict tmps);
+extern bool    image_bounds(size_t* restrict o_min_row,size_t* restrict o_max_row,size_t* restrict o_min_col,size_t* restrict o_max_col,size_t row_count,size_t col_count,size_t layer_count,const double* restrict image);
+extern void    build_deform_map(double* restrict o_src_row,double* restrict o_src_col,size_t row_count,size_t col_count,double source_center_row,double source_center_col,double scaling_row,double scaling_col,double rotation,double field_intensity,const double* restrict field_row,const double* restrict field_col);
+extern void    bilinear_resample(double* restrict o_image,size_t row_count,size_t col_count,size_t layer_count,const double* restrict src_row,const double* restrict src_col,const double* restrict image);
+extern void    deform_image(double* restrict o_image,size_t row_count,size_t col_count,size_t layer_count,double scaling_max,double rotation_max,double field_smoothness,double field_intensity,uint64_t seed,size_t stream,const double* restrict image,void* restrict tmps);
+
+END_C_DECLS
+
+#endif
@@ -1,31 +1,44 @@
 #include <math.h>
 #include <string.h>
+#include <stdbool.h>
 
 #include "latools.h"
 
 void
 fill_idx_1n(
-    size_t* restrict  o_idx,
-    size_t            count) {
+    coeff_idx_t* restrict  o_idx,
+    size_t                 count) {
     size_t  ii;
 
     for (ii = 0; ii < count; ii++) {
-        o_idx[ii] = ii;
+        o_idx[ii] = (coeff_idx_t)ii;
     }
 }
 
 void
-sort_by_abs_coeffs(
-    double* restrict  o_coeffs,
-    size_t* restrict  o_coeffs_idx,
-    size_t            count) {
-    size_t  median_idx;
-    double  tmp_median;
-    size_t  tmp_median_idx;
-    double  fabs_o_coeffs_ii;
-    double  fabs_o_coeffs_median_idx;
+widen_idx(
+    size_t* restrict             o_idx,
+    const coeff_idx_t* restrict  idx,
+    size_t                       count) {
     size_t  ii;
 
+    for (ii = 0; ii < count; ii++) {
+        o_idx[ii] = idx[ii];
+    }
+}
+
+void
+sort_by_abs_coeffs(
+    double* restrict       o_coeffs,
+    coeff_idx_t* restrict  o_coeffs_idx,
+    size_t                 count) {
+    size_t       median_idx;
+    double       tmp_median;
+    coeff_idx_t  tmp_median_idx;
+    double       fabs_o_coeffs_ii;
+    double       fabs_o_coeffs_median_idx;
+    size_t       ii;
+
     while (count > 1) {
         median_idx = 0;
 
@@ -59,13 +72,13 @@ sort_by_abs_coeffs(
 
 void
 sort_by_idxs(
-    double* restrict  o_coeffs,
-    size_t* restrict  o_coeffs_idx,
-    size_t            count) {
-    size_t  median_idx;
-    double  tmp_median;
-    size_t  tmp_median_idx;
-    size_t  ii;
+    double* restrict       o_coeffs,
+    coeff_idx_t* restrict  o_coeffs_idx,
+    size_t                 count) {
+    size_t       median_idx;
+    double       tmp_median;
+    coeff_idx_t  tmp_median_idx;
+    size_t       ii;
 
     while (count > 1) {
         median_idx = 0;
@@ -91,3 +104,114 @@ sort_by_idxs(
 	count = count - median_idx - 1;
     }
 }
+
+/* Heap order for "top_k_by_abs": a value is worse than another when it has a smaller magnitude, or an equal one and a
+   larger index, which is the order "sort_by_abs_coeffs" produces. */
+
+static bool
+_worse_by_abs(
+    const double* restrict  values,
+    size_t                  idx_a,
+    size_t                  idx_b) {
+    double  abs_a;
+    double  abs_b;
+
+    abs_a = fabs(values[idx_a]);
+    abs_b = fabs(values[idx_b]);
+
+    return (abs_a < abs_b) || ((abs_a == abs_b) && (idx_a > idx_b));
+}
+
+static void
+_sift_down_by_abs(
+    coeff_idx_t* restrict   io_heap,
+    size_t                  heap_count,
+    size_t                  root,
+    const double* restrict  values) {
+    size_t       child;
+    coeff_idx_t  tmp_idx;
+
+    while (2 * root + 1 < heap_count) {
+	child = 2 * root + 1;
+
+	if ((child + 1 < heap_count) && _worse_by_abs(values,io_heap[child + 1],io_heap[child])) {
+	    child = child + 1;
+	}
+
+	if (!_worse_by_abs(values,io_heap[child],io_heap[root])) {
+	    break;
+	}
+
+	tmp_idx = io_heap[root];
+	io_heap[root] = io_heap[child];
+	io_heap[child] = tmp_idx;
+	root = child;
+    }
+}
+
+CPU_DISPATCH void
+top_k_by_abs(
+    double* restrict        o_coeffs,
+    coeff_idx_t* restrict   o_coeffs_idx,
+    size_t                  count,
+    size_t                  k,
+    const double* restrict  values) {
+    size_t       heap_count;
+    coeff_idx_t  tmp_idx;
+    size_t       ii;
+
+    /* A min-heap of the best "k" indices seen so far is kept in "o_coeffs_idx", with the worst of them at its root.
+       This costs O(count log k), instead of the O(count log count) of sorting all values, and a value which does not
+       beat the root, as most do not, costs a single comparison. The heap is finally sorted in place, best first. */
+
+    for (ii = 0; ii < k; ii++) {
+	o_coeffs_idx[ii] = (coeff_idx_t)ii;
+    }
+
+    for (ii = k / 2; ii > 0; ii--) {
+	_sift_down_by_abs(o_coeffs_idx,k,ii - 1,values);
+    }
+
+    for (ii = k; ii < count; ii++) {
+	if ((k > 0) && _worse_by_abs(values,o_coeffs_idx[0],ii)) {
+	    o_coeffs_idx[0] = (coeff_idx_t)ii;
+	    _sift_down_by_abs(o_coeffs_idx,k,0,values);
+	}
+    }
+
+    for (heap_count = k; heap_count > 1; heap_count--) {
+	tmp_idx = o_coeffs_idx[0];
+	o_coeffs_idx[0] = o_coeffs_idx[heap_count - 1];
+	o_coeffs_idx[heap_count - 1] = tmp_idx;
+	_sift_down_by_abs(o_coeffs_idx,heap_count - 1,0,values);
+    }
+
+    for (ii = 0; ii < k; ii++) {
+	o_coeffs[ii] = values[o_coeffs_idx[ii]];
+    }
+}
+
+CPU_DISPATCH size_t
+abs_argmax(
+    size_t                  count,
+    const double* restrict  values) {
+    double  max_abs;
+    size_t  ii;
+
+    /* The maximum is found first, in a loop without branches which vectorizes, and its first position afterwards.
+       Like "idamax", ties go to the smallest index. */
+
+    max_abs = 0;
+
+    for (ii = 0; ii < count; ii++) {
+	max_abs = fabs(values[ii]) > max_abs ? fabs(values[ii]) : max_abs;
+    }
+
+    for (ii = 0; ii < count; ii++) {
+	if (fabs(values[ii]) == max_abs) {
+	    return ii;
+	}
+    }
+
+    return 0;
+}
@@ -3,8 +3,16 @@
 
 #include "base_defines.h"
 
-extern void  fill_idx_1n(size_t* restrict o_idx,size_t count);
-extern void  sort_by_abs_coeffs(double* restrict o_coeffs,size_t* restrict o_coeffs_idx,size_t count);
-extern void  sort_by_idxs(double* restrict o_coeffs,size_t* restrict o_coeffs_idx,size_t count);
+BEGIN_C_DECLS
+
+extern void  fill_idx_1n(coeff_idx_t* restrict o_idx,size_t count);
+extern void  widen_idx(size_t* restrict o_idx,const coeff_idx_t* restrict idx,size_t count);
+extern void  sort_by_abs_coeffs(double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t count);
+extern void  sort_by_idxs(double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t count);
+extern void  top_k_by_abs(double* restrict o_coeffs,coeff_idx_t* restrict o_coeffs_idx,size_t count,size_t k,const double* restrict values);
+
+extern size_t  abs_argmax(size_t count,const double* restrict values);
+
+END_C_DECLS
 
 #endif
@@ -0,0 +1,845 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "liblinear/linear.h"
+
+#include "linear_classifier.h"
+#include "task_control.h"
+
+/* Wrappers around liblinear, which train and apply several binary classifiers at once, one per worker. Samples come
+   in compressed sparse column form, with zero-based row indices. Every observation gets an extra constant feature of
+   one, so each classifier is stored as "geometry + 1" weights, the last of which is the bias. The Crammer-Singer
+   solver is the exception to the one classifier per worker rule, as it trains a scorer for every class jointly, but
+   its scorers are stored and applied just like the binary classifiers. */
+
+static const double
+EPS_DEFAULT[] = {
+    /* 0: L2R_LR */               0.01,
+    /* 1: L2R_L2LOSS_SVC_DUAL */  0.1,
+    /* 2: L2R_L2LOSS_SVC */       0.01,
+    /* 3: L2R_L1LOSS_SVC_DUAL */  0.1,
+    /* 4: MCSVM_CS */             0.1,
+    /* 5: L1R_L2LOSS_SVC */       0.01,
+    /* 6: L1R_LR */               0.01,
+    /* 7: L2R_LR_DUAL */          0.1
+};
+
+struct one_vs_all_global_info {
+    size_t                   geometry;
+    size_t                   train_sample_count;
+    const struct problem*    prob;
+    const struct parameter*  param;
+};
+
+struct one_vs_all_task_info {
+    double*  o_weights;
+    int      class_all;
+};
+
+struct one_vs_one_global_info {
+    size_t                   geometry;
+    size_t                   train_sample_count;
+    const double*            train_sample_pr;
+    const size_t*            train_sample_ir;
+    const size_t*            train_sample_jc;
+    const double*            labels_idx;
+    const struct parameter*  param;
+};
+
+struct one_vs_one_task_info {
+    double*  o_weights;
+    int      class_1;
+    int      class_2;
+};
+
+struct classify_global_info {
+    size_t               geometry;
+    size_t               classifiers_count;
+    const struct model*  local_models;
+};
+
+struct classify_sparse_global_info {
+    size_t         geometry;
+    size_t         classifiers_count;
+    const double*  weights_pr;
+    const size_t*  weights_ir;
+    const size_t*  weights_jc;
+};
+
+struct classify_task_info {
+    double*        o_decisions;
+    size_t         observation_count;
+    const double*  observation_pr;
+    const size_t*  observation_ir;
+};
+
+static size_t
+_fill_features(
+    struct feature_node* restrict  o_features,
+    size_t                         geometry,
+    size_t                         observation_count,
+    const double* restrict         observation_pr,
+    const size_t* restrict         observation_ir) {
+    size_t  ii;
+
+    for (ii = 0; ii < observation_count; ii++) {
+	o_features[ii].index = (int)observation_ir[ii] + 1;
+	o_features[ii].value = observation_pr[ii];
+    }
+
+    o_features[observation_count + 0].index = (int)geometry + 1;
+    o_features[observation_count + 0].value = 1;
+    o_features[observation_count + 1].index = -1;
+    o_features[observation_count + 1].value = 0;
+
+    return observation_count + 2;
+}
+
+static void
+_init_param(
+    struct parameter* restrict  o_param,
+    int                         method_code,
+    double                      reg_param) {
+    o_param->solver_type = method_code;
+    o_param->eps = linear_classifier_default_eps(method_code);
+    o_param->C = reg_param;
+    o_param->nr_weight = 0;
+    o_param->weight_label = NULL;
+    o_param->weight = NULL;
+    o_param->p = 0;
+}
+
+static void
+_do_one_vs_all_task(
+    size_t                                id,
+    const struct one_vs_all_global_info*  global_info,
+    void*                                 global_vars,
+    size_t                                task_info_count,
+    struct one_vs_all_task_info*          task_info) {
+    struct problem        local_prob;
+    struct feature_node*  temp_features;
+    double                temp_label;
+    struct model*         result_model;
+    size_t                ii;
+    size_t                jj;
+
+    local_prob.l = (int)global_info->train_sample_count;
+    local_prob.n = (int)global_info->geometry + 1;
+    local_prob.y = (double*)malloc(global_info->train_sample_count * sizeof(double));
+    local_prob.x = (struct feature_node**)malloc(global_info->train_sample_count * sizeof(struct feature_node*));
+    local_prob.bias = global_info->prob->bias;
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	memcpy(local_prob.x,global_info->prob->x,global_info->train_sample_count * sizeof(struct feature_node*));
+
+	/* Separate instances into "class" and "all" groups. */
+
+	for (jj = 0; jj < global_info->train_sample_count; jj++) {
+	    if (global_info->prob->y[jj] == task_info[ii].class_all) {
+		local_prob.y[jj] = +1;
+	    } else {
+		local_prob.y[jj] = -1;
+	    }
+	}
+
+	/* Make sure the first instance is of the "+1" class. This is needed so that the surface normal
+	   points "towards" the "class" instances and we get sane prediction in "linear_classifier_classify". */
+
+	for (jj = 0; jj < global_info->train_sample_count; jj++) {
+	    if (global_info->prob->y[jj] == task_info[ii].class_all) {
+		temp_features = local_prob.x[0];
+		local_prob.x[0] = local_prob.x[jj];
+		local_prob.x[jj] = temp_features;
+
+		temp_label = local_prob.y[0];
+		local_prob.y[0] = local_prob.y[jj];
+		local_prob.y[jj] = temp_label;
+
+		break;
+	    }
+	}
+
+	/* Train the binary classifier and copy the resulting surface normal ("weights") into the results
+	   buffer. */
+
+	result_model = train(&local_prob,global_info->param);
+
+	memcpy(task_info[ii].o_weights,result_model->w,(global_info->geometry + 1) * sizeof(double));
+
+	free_model_content(result_model);
+    }
+
+    free(local_prob.x);
+    free(local_prob.y);
+}
+
+static void
+_do_one_vs_one_task(
+    size_t                                id,
+    const struct one_vs_one_global_info*  global_info,
+    void*                                 global_vars,
+    size_t                                task_info_count,
+    struct one_vs_one_task_info*          task_info) {
+    struct problem        local_prob;
+    struct feature_node*  prob_x_t;
+    size_t                current_observation;
+    struct feature_node*  prob_x_t_curr;
+    size_t                observation_count;
+    struct model*         result_model;
+    size_t                class1_count;
+    size_t                class1_space_count;
+    size_t                class2_count;
+    size_t                class2_space_count;
+    size_t                ii;
+    size_t                jj;
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	/* Determine number of instances of each class. */
+
+	class1_count = 0;
+	class1_space_count = 0;
+	class2_count = 0;
+	class2_space_count = 0;
+
+	for (jj = 0; jj < global_info->train_sample_count; jj++) {
+	    if (global_info->labels_idx[jj] == task_info[ii].class_1) {
+		class1_count = class1_count + 1;
+		class1_space_count = class1_space_count + global_info->train_sample_jc[jj + 1] - global_info->train_sample_jc[jj];
+	    } else if (global_info->labels_idx[jj] == task_info[ii].class_2) {
+		class2_count = class2_count + 1;
+		class2_space_count = class2_space_count + global_info->train_sample_jc[jj + 1] - global_info->train_sample_jc[jj];
+	    }
+	}
+
+	local_prob.l = (int)class1_count + (int)class2_count;
+	local_prob.n = (int)global_info->geometry + 1;
+	local_prob.y = (double*)malloc((class1_count + class2_count) * sizeof(double));
+	local_prob.x = (struct feature_node**)malloc((class1_count + class2_count) * sizeof(struct feature_node*));
+	local_prob.bias = 1;
+	prob_x_t = (struct feature_node*)malloc((class1_space_count + 2 * class1_count + class2_space_count + 2 * class2_count) * sizeof(struct feature_node));
+
+	/* Instances of the first class come first, so the surface normal points "towards" them. */
+
+	current_observation = 0;
+	prob_x_t_curr = prob_x_t;
+
+	for (jj = 0; jj < global_info->train_sample_count; jj++) {
+	    if (global_info->labels_idx[jj] == task_info[ii].class_1) {
+		observation_count = global_info->train_sample_jc[jj + 1] - global_info->train_sample_jc[jj];
+
+		local_prob.x[current_observation] = prob_x_t_curr;
+		local_prob.y[current_observation] = +1;
+
+		current_observation = current_observation + 1;
+		prob_x_t_curr = prob_x_t_curr + _fill_features(prob_x_t_curr,global_info->geometry,observation_count,
+							       global_info->train_sample_pr + global_info->train_sample_jc[jj],
+							       global_info->train_sample_ir + global_info->train_sample_jc[jj]);
+	    }
+	}
+
+	for (jj = 0; jj < global_info->train_sample_count; jj++) {
+	    if (global_info->labels_idx[jj] == task_info[ii].class_2) {
+		observation_count = global_info->train_sample_jc[jj + 1] - global_info->train_sample_jc[jj];
+
+		local_prob.x[current_observation] = prob_x_t_curr;
+		local_prob.y[current_observation] = -1;
+
+		current_observation = current_observation + 1;
+		prob_x_t_curr = prob_x_t_curr + _fill_features(prob_x_t_curr,global_info->geometry,observation_count,
+							       global_info->train_sample_pr + global_info->train_sample_jc[jj],
+							       global_info->train_sample_ir + global_info->train_sample_jc[jj]);
+	    }
+	}
+
+	/* Train with local problem. */
+
+	result_model = train(&local_prob,global_info->param);
+
+	memcpy(task_info[ii].o_weights,result_model->w,(global_info->geometry + 1) * sizeof(double));
+
+	/* Free memory. */
+
+	free_model_content(result_model);
+	free(prob_x_t);
+	free(local_prob.x);
+	free(local_prob.y);
+    }
+}
+
+static void
+_do_classify_task(
+    size_t                              id,
+    const struct classify_global_info*  global_info,
+    void*                               global_vars,
+    size_t                              task_info_count,
+    struct classify_task_info*          task_info) {
+    struct feature_node*  observation_features;
+    size_t                ii;
+    size_t                jj;
+
+    observation_features = (struct feature_node*)malloc((global_info->geometry + 2) * sizeof(struct feature_node));
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	_fill_features(observation_features,global_info->geometry,task_info[ii].observation_count,task_info[ii].observation_pr,task_info[ii].observation_ir);
+
+	for (jj = 0; jj < global_info->classifiers_count; jj++) {
+	    predict_values(&global_info->local_models[jj],observation_features,&task_info[ii].o_decisions[jj]);
+	}
+    }
+
+    free(observation_features);
+}
+
+static void
+_do_classify_sparse_task(
+    size_t                                     id,
+    const struct classify_sparse_global_info*  global_info,
+    void*                                      global_vars,
+    size_t                                     task_info_count,
+    struct classify_task_info*                 task_info) {
+    size_t  ii;
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	linear_classifier_decide_sparse(task_info[ii].o_decisions,global_info->geometry,global_info->classifiers_count,
+					global_info->weights_pr,global_info->weights_ir,global_info->weights_jc,
+					task_info[ii].observation_count,task_info[ii].observation_pr,task_info[ii].observation_ir);
+    }
+}
+
+bool
+linear_classifier_method_valid(
+    int  method_code) {
+    return (method_code >= 0) && ((size_t)method_code < sizeof(EPS_DEFAULT) / sizeof(EPS_DEFAULT[0]));
+}
+
+double
+linear_classifier_default_eps(
+    int  method_code) {
+    /* Unsupported methods get a negative tolerance, which the liblinear parameter check rejects. */
+
+    if (!linear_classifier_method_valid(method_code)) {
+	return -1;
+    }
+
+    return EPS_DEFAULT[method_code];
+}
+
+bool
+linear_classifier_has_sparse_weights(
+    int  method_code) {
+    return (method_code == L1R_L2LOSS_SVC) || (method_code == L1R_LR);
+}
+
+size_t
+linear_classifier_one_vs_one_count(
+    size_t  classes_count) {
+    return classes_count * (classes_count - 1) / 2;
+}
+
+bool
+linear_classifier_train_one_vs_all(
+    double* restrict        o_weights,
+    const char**            o_error_message,
+    size_t                  geometry,
+    size_t                  train_sample_count,
+    const double* restrict  train_sample_pr,
+    const size_t* restrict  train_sample_ir,
+    const size_t* restrict  train_sample_jc,
+    size_t                  classes_count,
+    const double* restrict  labels_idx,
+    int                     method_code,
+    double                  reg_param,
+    size_t                  num_workers) {
+    struct problem                  prob;
+    struct feature_node*            prob_x_t;
+    struct feature_node*            prob_x_t_curr;
+    struct parameter                param;
+    struct one_vs_all_global_info   global_info;
+    struct one_vs_all_task_info*    task_info;
+    size_t                          ii;
+
+    /* Build problem and parameter structures. All classifiers share the features of the whole sample, and differ
+       only in the labels. */
+
+    prob.l = (int)train_sample_count;
+    prob.n = (int)geometry + 1;
+    prob.y = (double*)labels_idx;
+    prob.x = (struct feature_node**)malloc(train_sample_count * sizeof(struct feature_node*));
+    prob.bias = 1;
+
+    prob_x_t = (struct feature_node*)malloc((train_sample_jc[train_sample_count] + 2 * train_sample_count) * sizeof(struct feature_node));
+    prob_x_t_curr = prob_x_t;
+
+    for (ii = 0; ii < train_sample_count; ii++) {
+	prob.x[ii] = prob_x_t_curr;
+	prob_x_t_curr = prob_x_t_curr + _fill_features(prob_x_t_curr,geometry,train_sample_jc[ii + 1] - train_sample_jc[ii],
+						       train_sample_pr + train_sample_jc[ii],train_sample_ir + train_sample_jc[ii]);
+    }
+
+    _init_param(&param,method_code,reg_param);
+
+    /* Call "check_parameter" to validate our problem and parameters structures. */
+
+    *o_error_message = check_parameter(&prob,&param);
+
+    if (*o_error_message != NULL) {
+	free(prob_x_t);
+	free(prob.x);
+	return false;
+    }
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.train_sample_count = train_sample_count;
+    global_info.prob = &prob;
+    global_info.param = &param;
+
+    task_info = (struct one_vs_all_task_info*)malloc(classes_count * sizeof(struct one_vs_all_task_info));
+
+    for (ii = 0; ii < classes_count; ii++) {
+	task_info[ii].o_weights = o_weights + ii * (geometry + 1);
+	task_info[ii].class_all = (int)ii + 1;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,classes_count,sizeof(struct one_vs_all_task_info),task_info,(task_fn_x_t)_do_one_vs_all_task,num_workers);
+
+    /* Free memory. */
+
+    free(task_info);
+    free(prob_x_t);
+    free(prob.x);
+
+    return true;
+}
+
+bool
+linear_classifier_train_one_vs_one(
+    double* restrict        o_weights,
+    const char**            o_error_message,
+    size_t                  geometry,
+    size_t                  train_sample_count,
+    const double* restrict  train_sample_pr,
+    const size_t* restrict  train_sample_ir,
+    const size_t* restrict  train_sample_jc,
+    size_t                  classes_count,
+    const double* restrict  labels_idx,
+    int                     method_code,
+    double                  reg_param,
+    size_t                  num_workers) {
+    struct problem                  check_prob;
+    struct parameter                param;
+    struct one_vs_one_global_info   global_info;
+    struct one_vs_one_task_info*    task_info;
+    size_t                          classifiers_count;
+    size_t                          classifier_index;
+    size_t                          ii;
+    size_t                          jj;
+
+    classifiers_count = linear_classifier_one_vs_one_count(classes_count);
+
+    /* Build parameter structure. It is validated once here rather than by every worker, as "check_parameter" looks
+       at the parameters alone, which all classifiers share. */
+
+    _init_param(&param,method_code,reg_param);
+
+    check_prob.l = (int)train_sample_count;
+    check_prob.n = (int)geometry + 1;
+    check_prob.y = (double*)labels_idx;
+    check_prob.x = NULL;
+    check_prob.bias = 1;
+
+    *o_error_message = check_parameter(&check_prob,&param);
+
+    if (*o_error_message != NULL) {
+	return false;
+    }
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.train_sample_count = train_sample_count;
+    global_info.train_sample_pr = train_sample_pr;
+    global_info.train_sample_ir = train_sample_ir;
+    global_info.train_sample_jc = train_sample_jc;
+    global_info.labels_idx = labels_idx;
+    global_info.param = &param;
+
+    task_info = (struct one_vs_one_task_info*)malloc(classifiers_count * sizeof(struct one_vs_one_task_info));
+
+    classifier_index = 0;
+
+    for (ii = 0; ii < classes_count; ii++) {
+	for (jj = ii + 1; jj < classes_count; jj++) {
+	    task_info[classifier_index].o_weights = o_weights + classifier_index * (geometry + 1);
+	    task_info[classifier_index].class_1 = (int)ii + 1;
+	    task_info[classifier_index].class_2 = (int)jj + 1;
+
+	    classifier_index = classifier_index + 1;
+	}
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,classifiers_count,sizeof(struct one_vs_one_task_info),task_info,(task_fn_x_t)_do_one_vs_one_task,num_workers);
+
+    /* Free memory. */
+
+    free(task_info);
+
+    return true;
+}
+
+bool
+linear_classifier_train_crammer_singer(
+    double* restrict        o_weights,
+    const char**            o_error_message,
+    size_t                  geometry,
+    size_t                  train_sample_count,
+    const double* restrict  train_sample_pr,
+    const size_t* restrict  train_sample_ir,
+    const size_t* restrict  train_sample_jc,
+    size_t                  classes_count,
+    const double* restrict  labels_idx,
+    double                  reg_param) {
+    struct problem        prob;
+    struct feature_node*  prob_x_t;
+    struct feature_node*  prob_x_t_curr;
+    struct parameter      param;
+    struct model*         result_model;
+    size_t                class_weights_idx;
+    size_t                ii;
+    size_t                jj;
+
+    /* Build problem and parameter structures. */
+
+    prob.l = (int)train_sample_count;
+    prob.n = (int)geometry + 1;
+    prob.y = (double*)labels_idx;
+    prob.x = (struct feature_node**)malloc(train_sample_count * sizeof(struct feature_node*));
+    prob.bias = 1;
+
+    prob_x_t = (struct feature_node*)malloc((train_sample_jc[train_sample_count] + 2 * train_sample_count) * sizeof(struct feature_node));
+    prob_x_t_curr = prob_x_t;
+
+    for (ii = 0; ii < train_sample_count; ii++) {
+	prob.x[ii] = prob_x_t_curr;
+	prob_x_t_curr = prob_x_t_curr + _fill_features(prob_x_t_curr,geometry,train_sample_jc[ii + 1] - train_sample_jc[ii],
+						       train_sample_pr + train_sample_jc[ii],train_sample_ir + train_sample_jc[ii]);
+    }
+
+    _init_param(&param,MCSVM_CS,reg_param);
+
+    /* Call "check_parameter" to validate our problem and parameters structures. */
+
+    *o_error_message = check_parameter(&prob,&param);
+
+    if (*o_error_message != NULL) {
+	free(prob_x_t);
+	free(prob.x);
+	return false;
+    }
+
+    /* Train all the scorers in one solve. liblinear stores them interleaved, feature by feature, and in the order in
+       which classes first appear in the sample, so they are copied out one class at a time, into the column of the
+       class. A class without training observations keeps a zero scorer. */
+
+    result_model = train(&prob,&param);
+
+    memset(o_weights,0,classes_count * (geometry + 1) * sizeof(double));
+
+    for (ii = 0; ii < (size_t)result_model->nr_class; ii++) {
+	class_weights_idx = (size_t)result_model->label[ii] - 1;
+
+	for (jj = 0; jj < geometry + 1; jj++) {
+	    o_weights[class_weights_idx * (geometry + 1) + jj] = result_model->w[jj * (size_t)result_model->nr_class + ii];
+	}
+    }
+
+    /* Free memory. */
+
+    free_and_destroy_model(&result_model);
+    free(prob_x_t);
+    free(prob.x);
+
+    return true;
+}
+
+void
+linear_classifier_feature_map(
+    size_t* restrict        o_feature_map,
+    size_t                  geometry,
+    size_t                  feature_count,
+    const size_t* restrict  feature_ids) {
+    size_t  ii;
+
+    /* Classifiers trained on a compacted sample only know the features in "feature_ids", which are the ones that
+       fired for at least one training observation, and refer to them by their position in it. */
+
+    for (ii = 0; ii < geometry; ii++) {
+	o_feature_map[ii] = LINEAR_CLASSIFIER_UNUSED_FEATURE;
+    }
+
+    for (ii = 0; ii < feature_count; ii++) {
+	o_feature_map[feature_ids[ii]] = ii;
+    }
+}
+
+size_t
+linear_classifier_compact(
+    double* restrict        io_observation_pr,
+    size_t* restrict        io_observation_ir,
+    size_t                  observation_count,
+    const size_t* restrict  feature_map) {
+    size_t  current_count;
+    size_t  ii;
+
+    /* Features unknown to the classifiers would have had a zero weight, so dropping them leaves decisions unchanged.
+       With "feature_ids" sorted, the map is increasing, and so are the compacted indices. */
+
+    current_count = 0;
+
+    for (ii = 0; ii < observation_count; ii++) {
+	if (feature_map[io_observation_ir[ii]] != LINEAR_CLASSIFIER_UNUSED_FEATURE) {
+	    io_observation_pr[current_count] = io_observation_pr[ii];
+	    io_observation_ir[current_count] = feature_map[io_observation_ir[ii]];
+	    current_count += 1;
+	}
+    }
+
+    return current_count;
+}
+
+void
+linear_classifier_weights_by_feature(
+    double* restrict        o_weights_by_feature,
+    size_t                  geometry,
+    size_t                  classifiers_count,
+    const double* restrict  weights) {
+    size_t  ii;
+    size_t  jj;
+
+    for (ii = 0; ii < geometry + 1; ii++) {
+	for (jj = 0; jj < classifiers_count; jj++) {
+	    o_weights_by_feature[ii * classifiers_count + jj] = weights[jj * (geometry + 1) + ii];
+	}
+    }
+}
+
+void
+linear_classifier_decide(
+    double* restrict        o_decisions,
+    size_t                  geometry,
+    size_t                  classifiers_count,
+    const double* restrict  weights_by_feature,
+    size_t                  observation_count,
+    const double* restrict  observation_pr,
+    const size_t* restrict  observation_ir) {
+    const double*  feature_weights;
+    double         value;
+    size_t         ii;
+    size_t         jj;
+
+    /* Computes what "predict_values" would for every binary classifier, straight from the coded observation. With
+       the weights laid out by feature, as "linear_classifier_weights_by_feature" produces them, each non-zero of the
+       observation reads one contiguous row, instead of one weight from every classifier. */
+
+    memcpy(o_decisions,weights_by_feature + geometry * classifiers_count,classifiers_count * sizeof(double));
+
+    for (ii = 0; ii < observation_count; ii++) {
+	feature_weights = weights_by_feature + observation_ir[ii] * classifiers_count;
+	value = observation_pr[ii];
+
+	for (jj = 0; jj < classifiers_count; jj++) {
+	    o_decisions[jj] += value * feature_weights[jj];
+	}
+    }
+}
+
+size_t
+linear_classifier_sparse_weights_count(
+    size_t                  geometry,
+    size_t                  classifiers_count,
+    const double* restrict  weights) {
+    size_t  weights_count;
+    size_t  ii;
+
+    weights_count = 0;
+
+    for (ii = 0; ii < classifiers_count * (geometry + 1); ii++) {
+	if (weights[ii] != 0) {
+	    weights_count += 1;
+	}
+    }
+
+    return weights_count;
+}
+
+void
+linear_classifier_sparse_weights(
+    double* restrict        o_weights_pr,
+    size_t* restrict        o_weights_ir,
+    size_t* restrict        o_weights_jc,
+    size_t                  geometry,
+    size_t                  classifiers_count,
+    const double* restrict  weights) {
+    size_t  current_count;
+    size_t  ii;
+    size_t  jj;
+
+    /* The non-zero weights are stored by feature, in compressed sparse row form, with "geometry + 2" row offsets and
+       the classifier as the column index. This is also the compressed sparse column form of the transposed weights,
+       so MATLAB sees them as a "classifiers_count" x "geometry + 1" sparse matrix. */
+
+    current_count = 0;
+
+    for (ii = 0; ii < geometry + 1; ii++) {
+	o_weights_jc[ii] = current_count;
+
+	for (jj = 0; jj < classifiers_count; jj++) {
+	    if (weights[jj * (geometry + 1) + ii] != 0) {
+		o_weights_pr[current_count] = weights[jj * (geometry + 1) + ii];
+		o_weights_ir[current_count] = jj;
+		current_count += 1;
+	    }
+	}
+    }
+
+    o_weights_jc[geometry + 1] = current_count;
+}
+
+void
+linear_classifier_decide_sparse(
+    double* restrict        o_decisions,
+    size_t                  geometry,
+    size_t                  classifiers_count,
+    const double* restrict  weights_pr,
+    const size_t* restrict  weights_ir,
+    const size_t* restrict  weights_jc,
+    size_t                  observation_count,
+    const double* restrict  observation_pr,
+    const size_t* restrict  observation_ir) {
+    double  value;
+    size_t  ii;
+    size_t  jj;
+
+    /* Like "linear_classifier_decide", but each non-zero of the observation only visits the classifiers which have a
+       non-zero weight for its feature. For L1 regularized models most features have none, and cost nothing. */
+
+    memset(o_decisions,0,classifiers_count * sizeof(double));
+
+    for (jj = weights_jc[geometry]; jj < weights_jc[geometry + 1]; jj++) {
+	o_decisions[weights_ir[jj]] = weights_pr[jj];
+    }
+
+    for (ii = 0; ii < observation_count; ii++) {
+	value = observation_pr[ii];
+
+	for (jj = weights_jc[observation_ir[ii]]; jj < weights_jc[observation_ir[ii] + 1]; jj++) {
+	    o_decisions[weights_ir[jj]] += value * weights_pr[jj];
+	}
+    }
+}
+
+void
+linear_classifier_classify_sparse(
+    double* restrict        o_decisions,
+    size_t                  geometry,
+    size_t                  sample_count,
+    const double* restrict  sample_pr,
+    const size_t* restrict  sample_ir,
+    const size_t* restrict  sample_jc,
+    size_t                  classifiers_count,
+    const double* restrict  weights_pr,
+    const size_t* restrict  weights_ir,
+    const size_t* restrict  weights_jc,
+    size_t                  num_workers) {
+    struct classify_sparse_global_info  global_info;
+    struct classify_task_info*          task_info;
+    size_t                              ii;
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.classifiers_count = classifiers_count;
+    global_info.weights_pr = weights_pr;
+    global_info.weights_ir = weights_ir;
+    global_info.weights_jc = weights_jc;
+
+    task_info = (struct classify_task_info*)malloc(sample_count * sizeof(struct classify_task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].o_decisions = o_decisions + ii * classifiers_count;
+	task_info[ii].observation_count = sample_jc[ii + 1] - sample_jc[ii];
+	task_info[ii].observation_pr = sample_pr + sample_jc[ii];
+	task_info[ii].observation_ir = sample_ir + sample_jc[ii];
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,sample_count,sizeof(struct classify_task_info),task_info,(task_fn_x_t)_do_classify_sparse_task,num_workers);
+
+    /* Free memory. */
+
+    free(task_info);
+}
+
+void
+linear_classifier_classify(
+    double* restrict        o_decisions,
+    size_t                  geometry,
+    size_t                  sample_count,
+    const double* restrict  sample_pr,
+    const size_t* restrict  sample_ir,
+    const size_t* restrict  sample_jc,
+    size_t                  classifiers_count,
+    const double* restrict  weights,
+    int                     method_code,
+    double                  reg_param,
+    size_t                  num_workers) {
+    int                          local_model_stub[] = {1,2};
+    struct model*                local_models;
+    struct classify_global_info  global_info;
+    struct classify_task_info*   task_info;
+    size_t                       ii;
+
+    /* Rebuild model structures. The scorers of a Crammer-Singer model are applied one at a time, like binary
+       classifiers, which "predict_values" only does for the binary solvers. */
+
+    local_models = (struct model*)malloc(classifiers_count * sizeof(struct model));
+
+    for (ii = 0; ii < classifiers_count; ii++) {
+	_init_param(&local_models[ii].param,method_code != MCSVM_CS ? method_code : L2R_L1LOSS_SVC_DUAL,reg_param);
+	local_models[ii].nr_class = 2;
+	local_models[ii].nr_feature = (int)geometry + 1;
+	local_models[ii].w = (double*)weights + ii * (geometry + 1);
+	local_models[ii].label = local_model_stub;
+	local_models[ii].bias = 1;
+    }
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.classifiers_count = classifiers_count;
+    global_info.local_models = local_models;
+
+    task_info = (struct classify_task_info*)malloc(sample_count * sizeof(struct classify_task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].o_decisions = o_decisions + ii * classifiers_count;
+	task_info[ii].observation_count = sample_jc[ii + 1] - sample_jc[ii];
+	task_info[ii].observation_pr = sample_pr + sample_jc[ii];
+	task_info[ii].observation_ir = sample_ir + sample_jc[ii];
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,sample_count,sizeof(struct classify_task_info),task_info,(task_fn_x_t)_do_classify_task,num_workers);
+
+    /* Free memory. */
+
+    free(task_info);
+    free(local_models);
+}
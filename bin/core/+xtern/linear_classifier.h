@@ -0,0 +1,31 @@
+#ifndef _LINEAR_CLASSIFIER_H
+#define _LINEAR_CLASSIFIER_H
+
+#include <stdbool.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+#define LINEAR_CLASSIFIER_UNUSED_FEATURE ((size_t)-1)
+
+extern bool    linear_classifier_method_valid(int method_code);
+extern double  linear_classifier_default_eps(int method_code);
+extern bool    linear_classifier_has_sparse_weights(int method_code);
+extern size_t  linear_classifier_one_vs_one_count(size_t classes_count);
+extern bool    linear_classifier_train_one_vs_all(double* restrict o_weights,const char** o_error_message,size_t geometry,size_t train_sample_count,const double* restrict train_sample_pr,const size_t* restrict train_sample_ir,const size_t* restrict train_sample_jc,size_t classes_count,const double* restrict labels_idx,int method_code,double reg_param,size_t num_workers);
+extern bool    linear_classifier_train_one_vs_one(double* restrict o_weights,const char** o_error_message,size_t geometry,size_t train_sample_count,const double* restrict train_sample_pr,const size_t* restrict train_sample_ir,const size_t* restrict train_sample_jc,size_t classes_count,const double* restrict labels_idx,int method_code,double reg_param,size_t num_workers);
+extern bool    linear_classifier_train_crammer_singer(double* restrict o_weights,const char** o_error_message,size_t geometry,size_t train_sample_count,const double* restrict train_sample_pr,const size_t* restrict train_sample_ir,const size_t* restrict train_sample_jc,size_t classes_count,const double* restrict labels_idx,double reg_param);
+extern void    linear_classifier_feature_map(size_t* restrict o_feature_map,size_t geometry,size_t feature_count,const size_t* restrict feature_ids);
+extern size_t  linear_classifier_compact(double* restrict io_observation_pr,size_t* restrict io_observation_ir,size_t observation_count,const size_t* restrict feature_map);
+extern void    linear_classifier_weights_by_feature(double* restrict o_weights_by_feature,size_t geometry,size_t classifiers_count,const double* restrict weights);
+extern void    linear_classifier_decide(double* restrict o_decisions,size_t geometry,size_t classifiers_count,const double* restrict weights_by_feature,size_t observation_count,const double* restrict observation_pr,const size_t* restrict observation_ir);
+extern size_t  linear_classifier_sparse_weights_count(size_t geometry,size_t classifiers_count,const double* restrict weights);
+extern void    linear_classifier_sparse_weights(double* restrict o_weights_pr,size_t* restrict o_weights_ir,size_t* restrict o_weights_jc,size_t geometry,size_t classifiers_count,const double* restrict weights);
+extern void    linear_classifier_decide_sparse(double* restrict o_decisions,size_t geometry,size_t classifiers_count,const double* restrict weights_pr,const size_t* restrict weights_ir,const size_t* restrict weights_jc,size_t observation_count,const double* restrict observation_pr,const size_t* restrict observation_ir);
+extern void    linear_classifier_classify_sparse(double* restrict o_decisions,size_t geometry,size_t sample_count,const double* restrict sample_pr,const size_t* restrict sample_ir,const size_t* restrict sample_jc,size_t classifiers_count,const double* restrict weights_pr,const size_t* restrict weights_ir,const size_t* restrict weights_jc,size_t num_workers);
+extern void    linear_classifier_classify(double* restrict o_decisions,size_t geometry,size_t sample_count,const double* restrict sample_pr,const size_t* restrict sample_ir,const size_t* restrict sample_jc,size_t classifiers_count,const double* restrict weights,int method_code,double reg_param,size_t num_workers);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,356 @@
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "acml/acml.h"
+
+#include "nn_index.h"
+
+static bool
+_comes_after(
+    double  a_dist,
+    size_t  a_idx,
+    double  b_dist,
+    size_t  b_idx) {
+    return (a_dist > b_dist) || ((a_dist == b_dist) && (a_idx > b_idx));
+}
+
+static void
+_heap_sift_down(
+    double* restrict  dist,
+    size_t* restrict  idx,
+    size_t            count,
+    size_t            pos,
+    bool              worst_on_top) {
+    size_t  child;
+    size_t  best;
+    double  tmp_dist;
+    size_t  tmp_idx;
+
+    while (true) {
+        best = pos;
+
+        for (child = 2 * pos + 1; (child <= 2 * pos + 2) && (child < count); child++) {
+            if (worst_on_top ? _comes_after(dist[child],idx[child],dist[best],idx[best])
+		             : _comes_after(dist[best],idx[best],dist[child],idx[child])) {
+                best = child;
+            }
+        }
+
+        if (best == pos) {
+            break;
+        }
+
+        tmp_dist = dist[pos];
+        dist[pos] = dist[best];
+        dist[best] = tmp_dist;
+        tmp_idx = idx[pos];
+        idx[pos] = idx[best];
+        idx[best] = tmp_idx;
+        pos = best;
+    }
+}
+
+static void
+_heap_sift_up(
+    double* restrict  dist,
+    size_t* restrict  idx,
+    size_t            pos,
+    bool              worst_on_top) {
+    size_t  parent;
+    double  tmp_dist;
+    size_t  tmp_idx;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+
+        if (worst_on_top ? !_comes_after(dist[pos],idx[pos],dist[parent],idx[parent])
+	                 : !_comes_after(dist[parent],idx[parent],dist[pos],idx[pos])) {
+            break;
+        }
+
+        tmp_dist = dist[pos];
+        dist[pos] = dist[parent];
+        dist[parent] = tmp_dist;
+        tmp_idx = idx[pos];
+        idx[pos] = idx[parent];
+        idx[parent] = tmp_idx;
+        pos = parent;
+    }
+}
+
+/* Keeps the "neighbour_count" closest candidates seen so far in a heap with the farthest one on top. */
+
+static void
+_offer_neighbour(
+    double* restrict  o_neighbours_dist,
+    size_t* restrict  o_neighbours_idx,
+    size_t* restrict  o_found_count,
+    size_t            neighbour_count,
+    double            dist,
+    size_t            idx) {
+    if (*o_found_count < neighbour_count) {
+        o_neighbours_dist[*o_found_count] = dist;
+        o_neighbours_idx[*o_found_count] = idx;
+        _heap_sift_up(o_neighbours_dist,o_neighbours_idx,*o_found_count,true);
+        *o_found_count = *o_found_count + 1;
+    } else if (_comes_after(o_neighbours_dist[0],o_neighbours_idx[0],dist,idx)) {
+        o_neighbours_dist[0] = dist;
+        o_neighbours_idx[0] = idx;
+        _heap_sift_down(o_neighbours_dist,o_neighbours_idx,neighbour_count,0,true);
+    }
+}
+
+/* Turns the heap into an ascending list of neighbours and pads unfilled positions. */
+
+static void
+_finish_neighbours(
+    double* restrict  o_neighbours_dist,
+    size_t* restrict  o_neighbours_idx,
+    size_t            found_count,
+    size_t            neighbour_count,
+    size_t            sample_count) {
+    double  tmp_dist;
+    size_t  tmp_idx;
+    size_t  ii;
+
+    for (ii = found_count; ii > 1; ii--) {
+        tmp_dist = o_neighbours_dist[0];
+        o_neighbours_dist[0] = o_neighbours_dist[ii - 1];
+        o_neighbours_dist[ii - 1] = tmp_dist;
+        tmp_idx = o_neighbours_idx[0];
+        o_neighbours_idx[0] = o_neighbours_idx[ii - 1];
+        o_neighbours_idx[ii - 1] = tmp_idx;
+        _heap_sift_down(o_neighbours_dist,o_neighbours_idx,ii - 1,0,true);
+    }
+
+    for (ii = found_count; ii < neighbour_count; ii++) {
+        o_neighbours_dist[ii] = HUGE_VAL;
+        o_neighbours_idx[ii] = sample_count;
+    }
+}
+
+static double
+_squared_distance(
+    size_t                  geometry,
+    const double* restrict  sample,
+    const double* restrict  sample_norms,
+    size_t                  idx,
+    const double* restrict  observation,
+    double                  observation_norm) {
+    double  dist;
+
+    dist = sample_norms[idx] - 2 * ddot((int)geometry,(double*)sample + idx * geometry,1,(double*)observation,1) + observation_norm;
+
+    return dist > 0 ? dist : 0;
+}
+
+size_t
+nearest_centroid_tmps_length(
+    size_t  geometry,
+    size_t  list_count) {
+    return list_count * sizeof(double); // for "centroids_dists".
+}
+
+size_t
+ivf_nearest_neighbours_tmps_length(
+    size_t  geometry,
+    size_t  list_count,
+    size_t  neighbour_count) {
+    return list_count * sizeof(double) + // for "centroids_dists".
+           list_count * sizeof(size_t);  // for "centroids_idx".
+}
+
+void
+squared_norms(
+    double* restrict        o_norms,
+    size_t                  geometry,
+    size_t                  count,
+    const double* restrict  sample) {
+    size_t  ii;
+
+    for (ii = 0; ii < count; ii++) {
+        o_norms[ii] = ddot((int)geometry,(double*)sample + ii * geometry,1,(double*)sample + ii * geometry,1);
+    }
+}
+
+size_t
+nearest_centroid(
+    size_t                  geometry,
+    size_t                  list_count,
+    const double* restrict  centroids,
+    const double* restrict  centroids_norms,
+    const double* restrict  observation,
+    void* restrict          tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  centroids_dists;
+    size_t            best_idx;
+    size_t            ii;
+
+    curr_tmps = (char*)tmps;
+    centroids_dists = (double*)curr_tmps;
+    curr_tmps += list_count * sizeof(double);
+
+    /* The squared norm of "observation" is the same for all centroids, so it does not affect the ordering. */
+
+    memcpy(centroids_dists,centroids_norms,list_count * sizeof(double));
+    dgemv('T',(int)geometry,(int)list_count,-2,(double*)centroids,(int)geometry,(double*)observation,1,1,centroids_dists,1);
+
+    best_idx = 0;
+
+    for (ii = 1; ii < list_count; ii++) {
+        if (centroids_dists[ii] < centroids_dists[best_idx]) {
+            best_idx = ii;
+        }
+    }
+
+    return best_idx;
+}
+
+void
+kmeans_accumulate(
+    double* restrict        o_sums,
+    size_t* restrict        o_counts,
+    size_t                  geometry,
+    size_t                  count,
+    const double* restrict  sample,
+    const size_t* restrict  list_idx) {
+    size_t  ii;
+
+    for (ii = 0; ii < count; ii++) {
+        daxpy((int)geometry,1,(double*)sample + ii * geometry,1,o_sums + list_idx[ii] * geometry,1);
+        o_counts[list_idx[ii]] += 1;
+    }
+}
+
+void
+build_ivf_lists(
+    size_t* restrict        o_list_offsets,
+    size_t* restrict        o_list_members,
+    size_t                  sample_count,
+    size_t                  list_count,
+    const size_t* restrict  list_idx) {
+    size_t  ii;
+
+    /* Counting sort of observations by list. Members of a list keep their original relative order. */
+
+    memset(o_list_offsets,0,(list_count + 1) * sizeof(size_t));
+
+    for (ii = 0; ii < sample_count; ii++) {
+        o_list_offsets[list_idx[ii] + 1] += 1;
+    }
+
+    for (ii = 0; ii < list_count; ii++) {
+        o_list_offsets[ii + 1] += o_list_offsets[ii];
+    }
+
+    for (ii = 0; ii < sample_count; ii++) {
+        o_list_members[o_list_offsets[list_idx[ii]]] = ii;
+        o_list_offsets[list_idx[ii]] += 1;
+    }
+
+    for (ii = list_count; ii > 0; ii--) {
+        o_list_offsets[ii] = o_list_offsets[ii - 1];
+    }
+
+    o_list_offsets[0] = 0;
+}
+
+void
+exact_nearest_neighbours(
+    size_t* restrict        o_neighbours_idx,
+    double* restrict        o_neighbours_dist,
+    size_t                  geometry,
+    size_t                  sample_count,
+    const double* restrict  sample,
+    const double* restrict  sample_norms,
+    size_t                  neighbour_count,
+    const double* restrict  observation) {
+    double  observation_norm;
+    size_t  found_count;
+    size_t  ii;
+
+    observation_norm = ddot((int)geometry,(double*)observation,1,(double*)observation,1);
+    found_count = 0;
+
+    for (ii = 0; ii < sample_count; ii++) {
+        _offer_neighbour(o_neighbours_dist,o_neighbours_idx,&found_count,neighbour_count,
+			 _squared_distance(geometry,sample,sample_norms,ii,observation,observation_norm),ii);
+    }
+
+    _finish_neighbours(o_neighbours_dist,o_neighbours_idx,found_count,neighbour_count,sample_count);
+}
+
+void
+ivf_nearest_neighbours(
+    size_t* restrict        o_neighbours_idx,
+    double* restrict        o_neighbours_dist,
+    size_t                  geometry,
+    size_t                  sample_count,
+    const double* restrict  sample,
+    const double* restrict  sample_norms,
+    size_t                  list_count,
+    const double* restrict  centroids,
+    const double* restrict  centroids_norms,
+    const size_t* restrict  list_offsets,
+    const size_t* restrict  list_members,
+    size_t                  probe_count,
+    size_t                  neighbour_count,
+    const double* restrict  observation,
+    void* restrict          tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  centroids_dists;
+    size_t* restrict  centroids_idx;
+    double            observation_norm;
+    size_t            found_count;
+    size_t            probed_count;
+    size_t            heap_count;
+    size_t            list;
+    size_t            ii;
+
+    curr_tmps = (char*)tmps;
+    centroids_dists = (double*)curr_tmps;
+    curr_tmps += list_count * sizeof(double);
+    centroids_idx = (size_t*)curr_tmps;
+    curr_tmps += list_count * sizeof(size_t);
+
+    observation_norm = ddot((int)geometry,(double*)observation,1,(double*)observation,1);
+
+    /* Order lists by the distance of their centroid to "observation", closest first. */
+
+    memcpy(centroids_dists,centroids_norms,list_count * sizeof(double));
+    dgemv('T',(int)geometry,(int)list_count,-2,(double*)centroids,(int)geometry,(double*)observation,1,1,centroids_dists,1);
+
+    for (ii = 0; ii < list_count; ii++) {
+        centroids_idx[ii] = ii;
+    }
+
+    for (ii = list_count / 2; ii > 0; ii--) {
+        _heap_sift_down(centroids_dists,centroids_idx,list_count,ii - 1,false);
+    }
+
+    /* Scan the closest "probe_count" lists, and keep going if they did not hold enough neighbours. */
+
+    found_count = 0;
+    probed_count = 0;
+    heap_count = list_count;
+
+    while ((heap_count > 0) && ((probed_count < probe_count) || (found_count < neighbour_count))) {
+        list = centroids_idx[0];
+
+        heap_count = heap_count - 1;
+        centroids_dists[0] = centroids_dists[heap_count];
+        centroids_idx[0] = centroids_idx[heap_count];
+        _heap_sift_down(centroids_dists,centroids_idx,heap_count,0,false);
+
+        for (ii = list_offsets[list]; ii < list_offsets[list + 1]; ii++) {
+            _offer_neighbour(o_neighbours_dist,o_neighbours_idx,&found_count,neighbour_count,
+			     _squared_distance(geometry,sample,sample_norms,list_members[ii],observation,observation_norm),list_members[ii]);
+        }
+
+        probed_count = probed_count + 1;
+    }
+
+    _finish_neighbours(o_neighbours_dist,o_neighbours_idx,found_count,neighbour_count,sample_count);
+}
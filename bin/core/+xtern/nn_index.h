@@ -0,0 +1,20 @@
+#ifndef _NN_INDEX_H
+#define _NN_INDEX_H
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern size_t  nearest_centroid_tmps_length(size_t geometry,size_t list_count);
+extern size_t  ivf_nearest_neighbours_tmps_length(size_t geometry,size_t list_count,size_t neighbour_count);
+
+extern void    squared_norms(double* restrict o_norms,size_t geometry,size_t count,const double* restrict sample);
+extern size_t  nearest_centroid(size_t geometry,size_t list_count,const double* restrict centroids,const double* restrict centroids_norms,const double* restrict observation,void* restrict tmps);
+extern void    kmeans_accumulate(double* restrict o_sums,size_t* restrict o_counts,size_t geometry,size_t count,const double* restrict sample,const size_t* restrict list_idx);
+extern void    build_ivf_lists(size_t* restrict o_list_offsets,size_t* restrict o_list_members,size_t sample_count,size_t list_count,const size_t* restrict list_idx);
+extern void    exact_nearest_neighbours(size_t* restrict o_neighbours_idx,double* restrict o_neighbours_dist,size_t geometry,size_t sample_count,const double* restrict sample,const double* restrict sample_norms,size_t neighbour_count,const double* restrict observation);
+extern void    ivf_nearest_neighbours(size_t* restrict o_neighbours_idx,double* restrict o_neighbours_dist,size_t geometry,size_t sample_count,const double* restrict sample,const double* restrict sample_norms,size_t list_count,const double* restrict centroids,const double* restrict centroids_norms,const size_t* restrict list_offsets,const size_t* restrict list_members,size_t probe_count,size_t neighbour_count,const double* restrict observation,void* restrict tmps);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,202 @@
+#include <string.h>
+
+#include "random_tools.h"
+#include "patch_sampler.h"
+
+size_t
+patch_sampler_tmps_length(
+    size_t  row_count,
+    size_t  col_count,
+    size_t  layer_count) {
+    return (row_count + 1) * (col_count + 1) * sizeof(double) + // for "sum".
+           (row_count + 1) * (col_count + 1) * sizeof(double);  // for "sum_sqr".
+}
+
+void
+draw_patch_candidate(
+    size_t* restrict  o_image_idx,
+    size_t* restrict  o_row_skip,
+    size_t* restrict  o_col_skip,
+    uint64_t          seed,
+    size_t            slot,
+    size_t            attempt,
+    size_t            image_count,
+    size_t            row_count,
+    size_t            col_count,
+    size_t            patch_row_count,
+    size_t            patch_col_count) {
+    /* Each output slot owns a stream, and each attempt consumes three consecutive counters from it. */
+
+    *o_image_idx = counter_rng_uniform_int(seed,slot,3 * attempt + 0,image_count);
+    *o_row_skip = counter_rng_uniform_int(seed,slot,3 * attempt + 1,row_count - patch_row_count + 1);
+    *o_col_skip = counter_rng_uniform_int(seed,slot,3 * attempt + 2,col_count - patch_col_count + 1);
+}
+
+bool
+patch_sampler_use_integral(
+    size_t  candidate_count,
+    size_t  row_count,
+    size_t  col_count,
+    size_t  patch_row_count,
+    size_t  patch_col_count) {
+    /* Integral images cost one pass over the image, direct sums one pass over each candidate patch. */
+
+    return candidate_count * patch_row_count * patch_col_count > row_count * col_count;
+}
+
+CPU_DISPATCH void
+build_integral_images(
+    double* restrict        o_sum,
+    double* restrict        o_sum_sqr,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    const double* restrict  image) {
+    size_t  stride;
+    double  column_sum;
+    double  column_sum_sqr;
+    double  value;
+    size_t  ii;
+    size_t  jj;
+    size_t  ll;
+
+    /* Entry (ii,jj) holds the sum over rows [0,ii) and columns [0,jj) of all layers. */
+
+    stride = row_count + 1;
+
+    memset(o_sum,0,stride * sizeof(double));
+    memset(o_sum_sqr,0,stride * sizeof(double));
+
+    for (jj = 0; jj < col_count; jj++) {
+        o_sum[(jj + 1) * stride] = 0;
+        o_sum_sqr[(jj + 1) * stride] = 0;
+        column_sum = 0;
+        column_sum_sqr = 0;
+
+        for (ii = 0; ii < row_count; ii++) {
+            for (ll = 0; ll < layer_count; ll++) {
+                value = image[ll * row_count * col_count + jj * row_count + ii];
+                column_sum += value;
+                column_sum_sqr += value * value;
+            }
+
+            o_sum[(jj + 1) * stride + ii + 1] = o_sum[jj * stride + ii + 1] + column_sum;
+            o_sum_sqr[(jj + 1) * stride + ii + 1] = o_sum_sqr[jj * stride + ii + 1] + column_sum_sqr;
+        }
+    }
+}
+
+double
+patch_variance_integral(
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    size_t                  patch_row_count,
+    size_t                  patch_col_count,
+    size_t                  row_skip,
+    size_t                  col_skip,
+    const double* restrict  sum,
+    const double* restrict  sum_sqr) {
+    size_t  stride;
+    size_t  top_left;
+    size_t  top_right;
+    size_t  bottom_left;
+    size_t  bottom_right;
+    double  count;
+    double  patch_sum;
+    double  patch_sum_sqr;
+    double  variance;
+
+    stride = row_count + 1;
+    count = (double)(patch_row_count * patch_col_count * layer_count);
+
+    if (count < 2) {
+        return 0;
+    }
+
+    top_left = col_skip * stride + row_skip;
+    top_right = (col_skip + patch_col_count) * stride + row_skip;
+    bottom_left = col_skip * stride + row_skip + patch_row_count;
+    bottom_right = (col_skip + patch_col_count) * stride + row_skip + patch_row_count;
+
+    patch_sum = sum[bottom_right] - sum[top_right] - sum[bottom_left] + sum[top_left];
+    patch_sum_sqr = sum_sqr[bottom_right] - sum_sqr[top_right] - sum_sqr[bottom_left] + sum_sqr[top_left];
+    variance = (patch_sum_sqr - patch_sum * patch_sum / count) / (count - 1);
+
+    return variance > 0 ? variance : 0;
+}
+
+CPU_DISPATCH double
+patch_variance_direct(
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    size_t                  patch_row_count,
+    size_t                  patch_col_count,
+    size_t                  row_skip,
+    size_t                  col_skip,
+    const double* restrict  image) {
+    const double*  column;
+    double         count;
+    double         mean;
+    double         variance;
+    size_t         ii;
+    size_t         jj;
+    size_t         ll;
+
+    count = (double)(patch_row_count * patch_col_count * layer_count);
+
+    if (count < 2) {
+        return 0;
+    }
+
+    mean = 0;
+
+    for (ll = 0; ll < layer_count; ll++) {
+        for (jj = col_skip; jj < col_skip + patch_col_count; jj++) {
+            column = image + ll * row_count * col_count + jj * row_count;
+
+            for (ii = row_skip; ii < row_skip + patch_row_count; ii++) {
+                mean += column[ii];
+            }
+        }
+    }
+
+    mean = mean / count;
+    variance = 0;
+
+    for (ll = 0; ll < layer_count; ll++) {
+        for (jj = col_skip; jj < col_skip + patch_col_count; jj++) {
+            column = image + ll * row_count * col_count + jj * row_count;
+
+            for (ii = row_skip; ii < row_skip + patch_row_count; ii++) {
+                variance += (column[ii] - mean) * (column[ii] - mean);
+            }
+        }
+    }
+
+    return variance / (count - 1);
+}
+
+void
+extract_patch(
+    double* restrict        o_patch,
+    size_t                  row_count,
+    size_t                  col_count,
+    size_t                  layer_count,
+    size_t                  patch_row_count,
+    size_t                  patch_col_count,
+    size_t                  row_skip,
+    size_t                  col_skip,
+    const double* restrict  image) {
+    size_t  jj;
+    size_t  ll;
+
+    for (ll = 0; ll < layer_count; ll++) {
+        for (jj = 0; jj < patch_col_count; jj++) {
+            memcpy(o_patch + ll * patch_row_count * patch_col_count + jj * patch_row_count,
+                   image + ll * row_count * col_count + (col_skip + jj) * row_count + row_skip,
+                   patch_row_count * sizeof(double));
+        }
+    }
+}
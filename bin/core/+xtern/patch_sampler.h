@@ -0,0 +1,22 @@
+#ifndef _PATCH_SAMPLER_H
+#define _PATCH_SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern size_t  patch_sampler_tmps_length(size_t row_count,size_t col_count,size_t layer_count);
+
+extern void    draw_patch_candidate(size_t* restrict o_image_idx,size_t* restrict o_row_skip,size_t* restrict o_col_skip,uint64_t seed,size_t slot,size_t attempt,size_t image_count,size_t row_count,size_t col_count,size_t patch_row_count,size_t patch_col_count);
+extern bool    patch_sampler_use_integral(size_t candidate_count,size_t row_count,size_t col_count,size_t patch_row_count,size_t patch_col_count);
+extern void    build_integral_images(double* restrict o_sum,double* restrict o_sum_sqr,size_t row_count,size_t col_count,size_t layer_count,const double* restrict image);
+extern double  patch_variance_integral(size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,size_t row_skip,size_t col_skip,const double* restrict sum,const double* restrict sum_sqr);
+extern double  patch_variance_direct(size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,size_t row_skip,size_t col_skip,const double* restrict image);
+extern void    extract_patch(double* restrict o_patch,size_t row_count,size_t col_count,size_t layer_count,size_t patch_row_count,size_t patch_col_count,size_t row_skip,size_t col_skip,const double* restrict image);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,168 @@
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "acml/acml.h"
+
+#include "pipeline.h"
+
+/* Parameter layouts, all column-major:
+     OP_DC_OFFSET    - none.
+     OP_AFFINE       - [scale shift], an "input_geometry" x 2 matrix. Computes "scale .* x + shift".
+     OP_L2_NORMALIZE - none.
+     OP_LINEAR       - [matrix bias], an "output_geometry" x ("input_geometry" + 1) matrix. Computes "matrix * x + bias".
+   Only OP_LINEAR may change the geometry. */
+
+static void
+_apply_elementwise_ops(
+    size_t                               op_count,
+    const struct pipeline_op* restrict  ops,
+    size_t                               geometry,
+    size_t                               count,
+    double* restrict                     block) {
+    double* restrict  column;
+    const double*     scale;
+    const double*     shift;
+    double            acc;
+    size_t            ii;
+    size_t            jj;
+    size_t            kk;
+
+    /* Runs all the ops over one column before moving to the next one, so each column is read from memory once. */
+
+    for (jj = 0; jj < count; jj++) {
+	column = block + jj * geometry;
+
+	for (kk = 0; kk < op_count; kk++) {
+	    switch (ops[kk].type) {
+	    case OP_DC_OFFSET:
+		acc = 0;
+		for (ii = 0; ii < geometry; ii++) {
+		    acc += column[ii];
+		}
+		acc = acc / (double)geometry;
+		for (ii = 0; ii < geometry; ii++) {
+		    column[ii] -= acc;
+		}
+		break;
+	    case OP_AFFINE:
+		scale = ops[kk].params;
+		shift = ops[kk].params + geometry;
+		for (ii = 0; ii < geometry; ii++) {
+		    column[ii] = scale[ii] * column[ii] + shift[ii];
+		}
+		break;
+	    case OP_L2_NORMALIZE:
+		acc = 0;
+		for (ii = 0; ii < geometry; ii++) {
+		    acc += column[ii] * column[ii];
+		}
+		acc = sqrt(acc);
+		for (ii = 0; ii < geometry; ii++) {
+		    column[ii] = column[ii] / acc;
+		}
+		break;
+	    default:
+		exit(EXIT_FAILURE);
+	    }
+	}
+    }
+}
+
+size_t
+pipeline_max_geometry(
+    size_t                               op_count,
+    const struct pipeline_op* restrict  ops) {
+    size_t  max_geometry;
+    size_t  ii;
+
+    max_geometry = 0;
+
+    for (ii = 0; ii < op_count; ii++) {
+	if (ops[ii].input_geometry > max_geometry) {
+	    max_geometry = ops[ii].input_geometry;
+	}
+
+	if (ops[ii].output_geometry > max_geometry) {
+	    max_geometry = ops[ii].output_geometry;
+	}
+    }
+
+    return max_geometry;
+}
+
+size_t
+pipeline_tmps_length(
+    size_t                               op_count,
+    const struct pipeline_op* restrict  ops,
+    size_t                               block_count) {
+    size_t  max_geometry;
+
+    max_geometry = pipeline_max_geometry(op_count,ops);
+
+    return max_geometry * block_count * sizeof(double) + // for "block_a".
+	   max_geometry * block_count * sizeof(double);  // for "block_b".
+}
+
+void
+pipeline_code_block(
+    double* restrict                     o_sample_coded,
+    size_t                               op_count,
+    const struct pipeline_op* restrict  ops,
+    size_t                               count,
+    const double* restrict               sample,
+    void* restrict                       tmps) {
+    char* restrict    curr_tmps;
+    double* restrict  block_a;
+    double* restrict  block_b;
+    double* restrict  block_tmp;
+    size_t            max_geometry;
+    size_t            geometry;
+    size_t            run_start;
+    size_t            ii;
+    size_t            jj;
+
+    max_geometry = pipeline_max_geometry(op_count,ops);
+
+    curr_tmps = (char*)tmps;
+    block_a = (double*)curr_tmps;
+    curr_tmps += max_geometry * count * sizeof(double);
+    block_b = (double*)curr_tmps;
+    curr_tmps += max_geometry * count * sizeof(double);
+
+    geometry = op_count > 0 ? ops[0].input_geometry : 0;
+    memcpy(block_a,sample,geometry * count * sizeof(double));
+
+    /* Runs of elementwise ops are applied column by column. Linear ops are one GEMM over the whole block, with the bias
+       preloaded into the result. */
+
+    ii = 0;
+
+    while (ii < op_count) {
+	if (ops[ii].type == OP_LINEAR) {
+	    for (jj = 0; jj < count; jj++) {
+		memcpy(block_b + jj * ops[ii].output_geometry,ops[ii].params + ops[ii].output_geometry * ops[ii].input_geometry,ops[ii].output_geometry * sizeof(double));
+	    }
+
+	    dgemm('N','N',(int)ops[ii].output_geometry,(int)count,(int)ops[ii].input_geometry,
+		  1,(double*)ops[ii].params,(int)ops[ii].output_geometry,block_a,(int)ops[ii].input_geometry,
+		  1,block_b,(int)ops[ii].output_geometry);
+
+	    block_tmp = block_a;
+	    block_a = block_b;
+	    block_b = block_tmp;
+	    geometry = ops[ii].output_geometry;
+	    ii = ii + 1;
+	} else {
+	    run_start = ii;
+
+	    while ((ii < op_count) && (ops[ii].type != OP_LINEAR)) {
+		ii = ii + 1;
+	    }
+
+	    _apply_elementwise_ops(ii - run_start,ops + run_start,geometry,count,block_a);
+	}
+    }
+
+    memcpy(o_sample_coded,block_a,geometry * count * sizeof(double));
+}
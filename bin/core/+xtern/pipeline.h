@@ -0,0 +1,28 @@
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+enum pipeline_op_type {
+    OP_DC_OFFSET,
+    OP_AFFINE,
+    OP_L2_NORMALIZE,
+    OP_LINEAR
+};
+
+struct pipeline_op {
+    enum pipeline_op_type  type;
+    size_t                 input_geometry;
+    size_t                 output_geometry;
+    const double*          params;
+};
+
+extern size_t  pipeline_max_geometry(size_t op_count,const struct pipeline_op* restrict ops);
+extern size_t  pipeline_tmps_length(size_t op_count,const struct pipeline_op* restrict ops,size_t block_count);
+extern void    pipeline_code_block(double* restrict o_sample_coded,size_t op_count,const struct pipeline_op* restrict ops,size_t count,const double* restrict sample,void* restrict tmps);
+
+END_C_DECLS
+
+#endif
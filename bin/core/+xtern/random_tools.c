@@ -0,0 +1,42 @@
+#include "random_tools.h"
+
+/* Counter-based generator: the value for a given ("seed","stream","counter") triple is a pure function of it, so
+   independent workers can draw from disjoint streams without sharing state, and results do not depend on how work
+   is split between them. Mixing follows the SplitMix64 finalizer, applied twice. */
+
+static uint64_t
+_mix64(
+    uint64_t  x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t
+counter_rng(
+    uint64_t  seed,
+    uint64_t  stream,
+    uint64_t  counter) {
+    return _mix64(_mix64(seed + 0x9e3779b97f4a7c15ULL * (stream + 1)) ^ (counter + 0x632be59bd9b4e019ULL));
+}
+
+double
+counter_rng_uniform(
+    uint64_t  seed,
+    uint64_t  stream,
+    uint64_t  counter) {
+    return (double)(counter_rng(seed,stream,counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+size_t
+counter_rng_uniform_int(
+    uint64_t  seed,
+    uint64_t  stream,
+    uint64_t  counter,
+    size_t    n) {
+    size_t  result;
+
+    result = (size_t)(counter_rng_uniform(seed,stream,counter) * (double)n);
+
+    return result < n ? result : n - 1;
+}
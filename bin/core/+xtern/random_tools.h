@@ -0,0 +1,16 @@
+#ifndef _RANDOM_TOOLS_H
+#define _RANDOM_TOOLS_H
+
+#include <stdint.h>
+
+#include "base_defines.h"
+
+BEGIN_C_DECLS
+
+extern uint64_t  counter_rng(uint64_t seed,uint64_t stream,uint64_t counter);
+extern double    counter_rng_uniform(uint64_t seed,uint64_t stream,uint64_t counter);
+extern size_t    counter_rng_uniform_int(uint64_t seed,uint64_t stream,uint64_t counter,size_t n);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef _SMALL_KERNELS_H
+#define _SMALL_KERNELS_H
+
+#include <math.h>
+
+#include "acml/acml.h"
+
+#include "base_defines.h"
+
+/* Inlined replacements for the BLAS level 1 and 2 calls of the coding methods. Patches hold a hundred or so
+   elements and at most a few tens of atoms get selected, so a call into ACML costs about as much as the arithmetic it
+   does. Vectors of up to "SMALL_KERNELS_MAX_LENGTH" elements, matrices of up to "SMALL_KERNELS_MAX_AREA" elements
+   and triangular systems of up to "SMALL_KERNELS_MAX_ORDER" unknowns are handled here, and anything larger goes to
+   BLAS. The common patch geometries of 8x8, 9x9 and 11x11 get loops with a trip count known at compile time, which
+   the compiler fully unrolls and vectorizes. Sums use four accumulators, so they vectorize without "-ffast-math",
+   and may differ from the BLAS ones in the last bits. */
+
+#define SMALL_KERNELS_MAX_LENGTH 512
+#define SMALL_KERNELS_MAX_AREA 8192
+#define SMALL_KERNELS_MAX_ORDER 64
+
+#define SMALL_KERNELS_INLINE static inline __attribute__((always_inline))
+
+SMALL_KERNELS_INLINE double
+small_ddot_loop(
+    size_t                  length,
+    const double* restrict  x,
+    const double* restrict  y) {
+    double  acc[4];
+    size_t  main_length;
+    size_t  ii;
+
+    acc[0] = 0;
+    acc[1] = 0;
+    acc[2] = 0;
+    acc[3] = 0;
+    main_length = length - length % 4;
+
+    for (ii = 0; ii < main_length; ii += 4) {
+	acc[0] += x[ii + 0] * y[ii + 0];
+	acc[1] += x[ii + 1] * y[ii + 1];
+	acc[2] += x[ii + 2] * y[ii + 2];
+	acc[3] += x[ii + 3] * y[ii + 3];
+    }
+
+    for (ii = main_length; ii < length; ii++) {
+	acc[0] += x[ii] * y[ii];
+    }
+
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+SMALL_KERNELS_INLINE void
+small_daxpy_loop(
+    size_t                  length,
+    double                  alpha,
+    const double* restrict  x,
+    double* restrict        io_y) {
+    size_t  ii;
+
+    for (ii = 0; ii < length; ii++) {
+	io_y[ii] += alpha * x[ii];
+    }
+}
+
+SMALL_KERNELS_INLINE void
+small_dscal_loop(
+    size_t            length,
+    double            alpha,
+    double* restrict  io_x) {
+    size_t  ii;
+
+    for (ii = 0; ii < length; ii++) {
+	io_x[ii] *= alpha;
+    }
+}
+
+static inline double
+small_ddot(
+    size_t                  length,
+    const double* restrict  x,
+    const double* restrict  y) {
+    switch (length) {
+    case 64:
+	return small_ddot_loop(64,x,y);
+    case 81:
+	return small_ddot_loop(81,x,y);
+    case 121:
+	return small_ddot_loop(121,x,y);
+    default:
+	if (length <= SMALL_KERNELS_MAX_LENGTH) {
+	    return small_ddot_loop(length,x,y);
+	} else {
+	    return ddot((int)length,(double*)x,1,(double*)y,1);
+	}
+    }
+}
+
+static inline void
+small_daxpy(
+    size_t                  length,
+    double                  alpha,
+    const double* restrict  x,
+    double* restrict        io_y) {
+    switch (length) {
+    case 64:
+	small_daxpy_loop(64,alpha,x,io_y);
+	break;
+    case 81:
+	small_daxpy_loop(81,alpha,x,io_y);
+	break;
+    case 121:
+	small_daxpy_loop(121,alpha,x,io_y);
+	break;
+    default:
+	if (length <= SMALL_KERNELS_MAX_LENGTH) {
+	    small_daxpy_loop(length,alpha,x,io_y);
+	} else {
+	    daxpy((int)length,alpha,(double*)x,1,io_y,1);
+	}
+    }
+}
+
+static inline void
+small_dscal(
+    size_t            length,
+    double            alpha,
+    double* restrict  io_x) {
+    switch (length) {
+    case 64:
+	small_dscal_loop(64,alpha,io_x);
+	break;
+    case 81:
+	small_dscal_loop(81,alpha,io_x);
+	break;
+    case 121:
+	small_dscal_loop(121,alpha,io_x);
+	break;
+    default:
+	if (length <= SMALL_KERNELS_MAX_LENGTH) {
+	    small_dscal_loop(length,alpha,io_x);
+	} else {
+	    dscal((int)length,alpha,io_x,1);
+	}
+    }
+}
+
+static inline double
+small_dnrm2(
+    size_t                  length,
+    const double* restrict  x) {
+    /* Without the rescaling BLAS does, this overflows only for norms near 1e154, which patches never get close to. */
+
+    if (length <= SMALL_KERNELS_MAX_LENGTH) {
+	return sqrt(small_ddot(length,x,x));
+    } else {
+	return dnrm2((int)length,(double*)x,1);
+    }
+}
+
+static inline void
+small_dgemv_n(
+    size_t                  row_count,
+    size_t                  col_count,
+    double                  alpha,
+    const double* restrict  a,
+    const double* restrict  x,
+    double                  beta,
+    double* restrict        io_y) {
+    size_t  ii;
+
+    /* Computes "io_y = alpha * a * x + beta * io_y", for a column major "a" with "row_count" rows. */
+
+    if (row_count * col_count > SMALL_KERNELS_MAX_AREA) {
+	dgemv('N',(int)row_count,(int)col_count,alpha,(double*)a,(int)row_count,(double*)x,1,beta,io_y,1);
+	return;
+    }
+
+    if (beta == 0) {
+	for (ii = 0; ii < row_count; ii++) {
+	    io_y[ii] = 0;
+	}
+    } else if (beta != 1) {
+	small_dscal(row_count,beta,io_y);
+    }
+
+    for (ii = 0; ii < col_count; ii++) {
+	small_daxpy(row_count,alpha * x[ii],a + ii * row_count,io_y);
+    }
+}
+
+static inline void
+small_dgemv_t(
+    size_t                  row_count,
+    size_t                  col_count,
+    double                  alpha,
+    const double* restrict  a,
+    const double* restrict  x,
+    double                  beta,
+    double* restrict        io_y) {
+    size_t  ii;
+
+    /* Computes "io_y = alpha * a' * x + beta * io_y", for a column major "a" with "row_count" rows. */
+
+    if (row_count * col_count > SMALL_KERNELS_MAX_AREA) {
+	dgemv('T',(int)row_count,(int)col_count,alpha,(double*)a,(int)row_count,(double*)x,1,beta,io_y,1);
+	return;
+    }
+
+    for (ii = 0; ii < col_count; ii++) {
+	if (beta == 0) {
+	    io_y[ii] = alpha * small_ddot(row_count,a + ii * row_count,x);
+	} else {
+	    io_y[ii] = alpha * small_ddot(row_count,a + ii * row_count,x) + beta * io_y[ii];
+	}
+    }
+}
+
+static inline void
+small_dtrsv(
+    char                    uplo,
+    char                    trans,
+    size_t                  order,
+    const double* restrict  a,
+    size_t                  lda,
+    double* restrict        io_x) {
+    double  acc;
+    size_t  ii;
+    size_t  jj;
+
+    /* Solves "a * x = io_x" or "a' * x = io_x" in place, for a triangular, non unit, column major "a". Only the
+       upper non transposed system and both lower ones are used by the coding methods. */
+
+    if (order > SMALL_KERNELS_MAX_ORDER) {
+	dtrsv(uplo,trans,'N',(int)order,(double*)a,(int)lda,io_x,1);
+	return;
+    }
+
+    if ((uplo == 'U') && (trans == 'N')) {
+	for (ii = order; ii > 0; ii--) {
+	    acc = io_x[ii - 1];
+
+	    for (jj = ii; jj < order; jj++) {
+		acc -= a[jj * lda + ii - 1] * io_x[jj];
+	    }
+
+	    io_x[ii - 1] = acc / a[(ii - 1) * lda + ii - 1];
+	}
+    } else if ((uplo == 'L') && (trans == 'N')) {
+	for (ii = 0; ii < order; ii++) {
+	    acc = io_x[ii];
+
+	    for (jj = 0; jj < ii; jj++) {
+		acc -= a[jj * lda + ii] * io_x[jj];
+	    }
+
+	    io_x[ii] = acc / a[ii * lda + ii];
+	}
+    } else if ((uplo == 'L') && (trans == 'T')) {
+	for (ii = order; ii > 0; ii--) {
+	    acc = io_x[ii - 1] - small_ddot(order - ii,a + (ii - 1) * lda + ii,io_x + ii);
+	    io_x[ii - 1] = acc / a[(ii - 1) * lda + ii - 1];
+	}
+    } else {
+	dtrsv(uplo,trans,'N',(int)order,(double*)a,(int)lda,io_x,1);
+    }
+}
+
+#endif
@@ -16,6 +16,19 @@
 #include "coding_methods.h"
 #include "image_coder.h"
 #include "task_control.h"
+#include "nn_index.h"
+#include "random_tools.h"
+#include "patch_sampler.h"
+#include "covariance.h"
+#include "pipeline.h"
+#include "image_deform.h"
+#include "dictionary_learn.h"
+#include "dictionary_state.h"
+#include "dataset_file.h"
+#include "csc_file.h"
+#include "hash.h"
+#include "dictionary_handle.h"
+#include "small_kernels.h"
 
 struct global_info_x {
     int  alpha;
@@ -61,8 +74,8 @@ main(
     printf("  Function \"fill_idx_1n\".\n");
 
     {
-        size_t  o_idx[] = {0,0,0,0,0,0,0};
-        size_t  count = 7;
+        coeff_idx_t  o_idx[] = {0,0,0,0,0,0,0};
+        size_t       count = 7;
 
         fill_idx_1n(o_idx,count);
 
@@ -76,8 +89,8 @@ main(
     }
 
     {
-        size_t  o_idx[] = {0,0,0,0,0,0,0};
-        size_t  count = 4;
+        coeff_idx_t  o_idx[] = {0,0,0,0,0,0,0};
+        size_t       count = 4;
 
         fill_idx_1n(o_idx,count);
 
@@ -93,9 +106,9 @@ main(
     printf("  Function \"sort_by_abs_coeffs\".\n");
 
     {
-        double  o_coeffs[] =     {1,3,-2,4,9,-5,7,6,0,-8};
-        size_t  o_coeffs_idx[] = {0,1, 2,3,4, 5,6,7,8, 9};
-        size_t  count = 10;
+        double       o_coeffs[] =     {1,3,-2,4,9,-5,7,6,0,-8};
+        coeff_idx_t  o_coeffs_idx[] = {0,1, 2,3,4, 5,6,7,8, 9};
+        size_t       count = 10;
 
         sort_by_abs_coeffs(o_coeffs,o_coeffs_idx,count);
 
@@ -122,9 +135,9 @@ main(
     }
 
     {
-        double  o_coeffs[] =     {1,3,-3,2,7,9,-2,8,3,-4, 6,-3, 2, 1, 4,-5, 0, 5, 6,-7, 8, 9};
-        size_t  o_coeffs_idx[] = {0,1, 2,3,4,5, 6,7,8, 9,10,11,12,13,14,15,16,17,18,19,20,21};
-        size_t  count = 22;
+        double       o_coeffs[] =     {1,3,-3,2,7,9,-2,8,3,-4, 6,-3, 2, 1, 4,-5, 0, 5, 6,-7, 8, 9};
+        coeff_idx_t  o_coeffs_idx[] = {0,1, 2,3,4,5, 6,7,8, 9,10,11,12,13,14,15,16,17,18,19,20,21};
+        size_t       count = 22;
 
         sort_by_abs_coeffs(o_coeffs,o_coeffs_idx,count);
 
@@ -177,9 +190,9 @@ main(
     printf("  Function \"sort_by_idxs\".\n");
 
     {
-        double  o_coeffs[] = {4,3,-2,1};
-        size_t  o_coeffs_idx[] = {3,1,2,0};
-        size_t  count = 4;
+        double       o_coeffs[] = {4,3,-2,1};
+        coeff_idx_t  o_coeffs_idx[] = {3,1,2,0};
+        size_t       count = 4;
 
         sort_by_idxs(o_coeffs,o_coeffs_idx,count);
 
@@ -193,15 +206,86 @@ main(
         assert(o_coeffs_idx[3] == 3);
     }
 
+    printf("  Function \"top_k_by_abs\".\n");
+
+    {
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000,1000};
+        double       values[] = {1,-7,3,0,5,-3,2};
+
+        top_k_by_abs(o_coeffs,o_coeffs_idx,7,3,values);
+
+        assert(o_coeffs[0] == -7);
+        assert(o_coeffs[1] == 5);
+        assert(o_coeffs[2] == 3);
+        assert(o_coeffs_idx[0] == 1);
+        assert(o_coeffs_idx[1] == 4);
+        assert(o_coeffs_idx[2] == 2);
+    }
+
+    {
+        double       o_coeffs[] = {HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000};
+        double       values[] = {2,-4,4,1};
+
+        top_k_by_abs(o_coeffs,o_coeffs_idx,4,1,values);
+
+        assert(o_coeffs[0] == -4);
+        assert(o_coeffs_idx[0] == 1);
+    }
+
+    {
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000,1000,1000};
+        double       values[] = {-1,2,-2,1};
+
+        top_k_by_abs(o_coeffs,o_coeffs_idx,4,4,values);
+
+        assert(o_coeffs[0] == 2);
+        assert(o_coeffs[1] == -2);
+        assert(o_coeffs[2] == -1);
+        assert(o_coeffs[3] == 1);
+        assert(o_coeffs_idx[0] == 1);
+        assert(o_coeffs_idx[1] == 2);
+        assert(o_coeffs_idx[2] == 0);
+        assert(o_coeffs_idx[3] == 3);
+    }
+
+    printf("  Function \"widen_idx\".\n");
+
+    {
+        size_t       o_idx[] = {1000,1000,1000,1000};
+        coeff_idx_t  idx[] = {0,7,4294967295u,3};
+
+        widen_idx(o_idx,idx,3);
+
+        assert(o_idx[0] == 0);
+        assert(o_idx[1] == 7);
+        assert(o_idx[2] == 4294967295u);
+        assert(o_idx[3] == 1000);
+    }
+
+    printf("  Function \"abs_argmax\".\n");
+
+    {
+        double  values_1[] = {1,-7,3,7};
+        double  values_2[] = {0,0,0};
+        double  values_3[] = {-2};
+
+        assert(abs_argmax(4,values_1) == 1);
+        assert(abs_argmax(3,values_2) == 0);
+        assert(abs_argmax(1,values_3) == 0);
+    }
+
     printf("Testing \"coding_methods\".\n");
 
     printf("  Function \"correlation_coding_tmps_length\".\n");
 
     {
-	assert(correlation_coding_tmps_length(2,3,2) == 3 * sizeof(double) + 3 * sizeof(size_t));
-	assert(correlation_coding_tmps_length(1,3,2) == 3 * sizeof(double) + 3 * sizeof(size_t));
-	assert(correlation_coding_tmps_length(2,3,3) == 3 * sizeof(double) + 3 * sizeof(size_t));
-	assert(correlation_coding_tmps_length(2,5,2) == 5 * sizeof(double) + 5 * sizeof(size_t));
+	assert(correlation_coding_tmps_length(2,3,2) == 3 * sizeof(double));
+	assert(correlation_coding_tmps_length(1,3,2) == 3 * sizeof(double));
+	assert(correlation_coding_tmps_length(2,3,3) == 3 * sizeof(double));
+	assert(correlation_coding_tmps_length(2,5,2) == 5 * sizeof(double));
     }
 
     printf("  Function \"matching_pursuit_coding_tmps_length\".\n");
@@ -231,38 +315,64 @@ main(
 	assert(optimized_orthogonal_matching_pursuit_coding_tmps_length(2,5,2) == 5 * sizeof(bool) + 2 * sizeof(double) + 2 * 5 * sizeof(double) + 2 * 2 * sizeof(double) + 2 * 2 * sizeof(double) + 5 * sizeof(double) + 2 * sizeof(double));
     }
 
+    printf("  Function \"batch_orthogonal_matching_pursuit_coding_tmps_length\".\n");
+
+    {
+	assert(batch_orthogonal_matching_pursuit_coding_tmps_length(2,3,2) == 3 * sizeof(double) + 3 * sizeof(double) + 2 * 2 * sizeof(double) + 2 * sizeof(double) + 3 * sizeof(bool));
+	assert(batch_orthogonal_matching_pursuit_coding_tmps_length(1,3,2) == 3 * sizeof(double) + 3 * sizeof(double) + 2 * 2 * sizeof(double) + 2 * sizeof(double) + 3 * sizeof(bool));
+	assert(batch_orthogonal_matching_pursuit_coding_tmps_length(2,3,3) == 3 * sizeof(double) + 3 * sizeof(double) + 3 * 3 * sizeof(double) + 3 * sizeof(double) + 3 * sizeof(bool));
+	assert(batch_orthogonal_matching_pursuit_coding_tmps_length(2,5,2) == 5 * sizeof(double) + 5 * sizeof(double) + 2 * 2 * sizeof(double) + 2 * sizeof(double) + 5 * sizeof(bool));
+    }
+
     printf("  Function \"sparse_net_coding_tmps_length\".\n");
 
     {
-	assert(sparse_net_coding_tmps_length(2,3,2) == 3 * sizeof(double) + 3 * sizeof(size_t) + 2 * sizeof(double));
-	assert(sparse_net_coding_tmps_length(1,3,2) == 3 * sizeof(double) + 3 * sizeof(size_t) + 1 * sizeof(double));
-	assert(sparse_net_coding_tmps_length(2,3,3) == 3 * sizeof(double) + 3 * sizeof(size_t) + 2 * sizeof(double));
-	assert(sparse_net_coding_tmps_length(2,5,2) == 5 * sizeof(double) + 5 * sizeof(size_t) + 2 * sizeof(double));
+	assert(sparse_net_coding_tmps_length(2,3,2) == 3 * sizeof(double) + 2 * sizeof(double));
+	assert(sparse_net_coding_tmps_length(1,3,2) == 3 * sizeof(double) + 1 * sizeof(double));
+	assert(sparse_net_coding_tmps_length(2,3,3) == 3 * sizeof(double) + 2 * sizeof(double));
+	assert(sparse_net_coding_tmps_length(2,5,2) == 5 * sizeof(double) + 2 * sizeof(double));
+    }
+
+    printf("  Function \"coding_type_tmps_length\".\n");
+
+    {
+	assert(coding_type_tmps_length(CORRELATION,2,3,2) == correlation_coding_tmps_length(2,3,2));
+	assert(coding_type_tmps_length(MATCHING_PURSUIT,2,3,2) == matching_pursuit_coding_tmps_length(2,3,2));
+	assert(coding_type_tmps_length(ORTHOGONAL_MATCHING_PURSUIT,2,3,2) == orthogonal_matching_pursuit_coding_tmps_length(2,3,2));
+	assert(coding_type_tmps_length(OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,2,3,2) == optimized_orthogonal_matching_pursuit_coding_tmps_length(2,3,2));
+	assert(coding_type_tmps_length(SPARSE_NET,2,3,2) == sparse_net_coding_tmps_length(2,3,2));
+    }
+
+    printf("  Function \"coding_type_method\".\n");
+
+    {
+	assert(coding_type_method(CORRELATION) == correlation);
+	assert(coding_type_method(MATCHING_PURSUIT) == matching_pursuit);
+	assert(coding_type_method(ORTHOGONAL_MATCHING_PURSUIT) == orthogonal_matching_pursuit);
+	assert(coding_type_method(OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT) == optimized_orthogonal_matching_pursuit);
+	assert(coding_type_method(SPARSE_NET) == sparse_net);
     }
 
     printf("  Function \"correlation\".\n");
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,1,0,-1,1};
-        double   dict_transp[] = {1,0,0,-1,1,1};
-        double   dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,-3};
-        char*    coding_tmps;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,-3};
+        char*        coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
-        size_t*  similarities_idx;
 
         coding_tmps = malloc(correlation_coding_tmps_length(geometry,word_count,coeff_count));
 	curr_coding_tmps = coding_tmps;
         similarities = (double*)curr_coding_tmps;
 	curr_coding_tmps += word_count * sizeof(double);
-        similarities_idx = (size_t*)curr_coding_tmps;
-	curr_coding_tmps += word_count * sizeof(size_t);
 
         correlation(o_coeffs,o_coeffs_idx,geometry,word_count,dict,dict_transp,dict_x_dict_transp,coeff_count,NULL,observation,coding_tmps);
 
@@ -273,34 +383,28 @@ main(
         assert(similarities[0] == 4);
         assert(similarities[1] == 3);
         assert(similarities[2] == 1);
-        assert(similarities_idx[0] == 0);
-        assert(similarities_idx[1] == 1);
-        assert(similarities_idx[2] == 2);
 
         free(coding_tmps);
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,1,0,-1,1};
-        double   dict_transp[] = {1,0,0,-1,1,1};
-        double   dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,3};
-        char*    coding_tmps;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,3};
+        char*        coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
-        size_t*  similarities_idx;
 
         coding_tmps = malloc(correlation_coding_tmps_length(geometry,word_count,coeff_count));
 	curr_coding_tmps = coding_tmps;
         similarities = (double*)curr_coding_tmps;
 	curr_coding_tmps += word_count * sizeof(double);
-        similarities_idx = (size_t*)curr_coding_tmps;
-	curr_coding_tmps += word_count * sizeof(size_t);
 
         correlation(o_coeffs,o_coeffs_idx,geometry,word_count,dict,dict_transp,dict_x_dict_transp,coeff_count,NULL,observation,coding_tmps);
 
@@ -308,37 +412,31 @@ main(
         assert(o_coeffs[1] == 4);
         assert(o_coeffs_idx[0] == 2);
         assert(o_coeffs_idx[1] == 0);
-        assert(similarities[0] == 7);
-        assert(similarities[1] == 4);
-        assert(similarities[2] == -3);
-        assert(similarities_idx[0] == 2);
-        assert(similarities_idx[1] == 0);
-        assert(similarities_idx[2] == 1);
+        assert(similarities[0] == 4);
+        assert(similarities[1] == -3);
+        assert(similarities[2] == 7);
 
         free(coding_tmps);
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,1,0,-1,1};
-        double   dict_transp[] = {1,0,0,-1,1,1};
-        double   dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t   coeff_count = 2;
-        double   observation[] = {-4,3};
-        char*    coding_tmps;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
+        double       observation[] = {-4,3};
+        char*        coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
-        size_t*  similarities_idx;
 
         coding_tmps = malloc(correlation_coding_tmps_length(geometry,word_count,coeff_count));
 	curr_coding_tmps = coding_tmps;
         similarities = (double*)curr_coding_tmps;
 	curr_coding_tmps += word_count * sizeof(double);
-        similarities_idx = (size_t*)curr_coding_tmps;
-	curr_coding_tmps += word_count * sizeof(size_t);
 
         correlation(o_coeffs,o_coeffs_idx,geometry,word_count,dict,dict_transp,dict_x_dict_transp,coeff_count,NULL,observation,coding_tmps);
 
@@ -349,9 +447,6 @@ main(
         assert(similarities[0] == -4);
         assert(similarities[1] == -3);
         assert(similarities[2] == -1);
-        assert(similarities_idx[0] == 0);
-        assert(similarities_idx[1] == 1);
-        assert(similarities_idx[2] == 2);
 
         free(coding_tmps);
     }
@@ -359,15 +454,15 @@ main(
     printf("  Function \"matching_pursuit\".\n");
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,-3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,-3};
 	char*    coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
@@ -391,15 +486,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,3};
 	char*    coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
@@ -423,15 +518,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {-4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {-4,3};
 	char*    coding_tmps;
 	char*    curr_coding_tmps;
         double*  similarities;
@@ -457,15 +552,15 @@ main(
     printf("  Function \"orthogonal_matching_pursuit\".\n");
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,-3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,-3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
     	double*  similarities;
@@ -507,15 +602,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
     	double*  similarities;
@@ -557,15 +652,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {-4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {-4,3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
     	double*  similarities;
@@ -609,15 +704,15 @@ main(
     printf("  Function \"optimized_orthogonal_matching_pursuit\".\n");
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,-3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,-3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
 	bool*    used_column_mask;
@@ -668,15 +763,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {4,3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
 	bool*    used_column_mask;
@@ -727,15 +822,15 @@ main(
     }
 
     {
-        double   o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t   o_coeffs_idx[] = {1000,1000};
-        size_t   geometry = 2;
-        size_t   word_count = 3;
-        double   dict[] = {1,0,0.7071,0,-1,0.7071};
-        double   dict_transp[] = {1,0,0,-1,0.7071,0.7071};
-        double   dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
-        size_t   coeff_count = 2;
-        double   observation[] = {-4,3};
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,0.7071,0,-1,0.7071};
+        double       dict_transp[] = {1,0,0,-1,0.7071,0.7071};
+        double       dict_x_dict_transp[] = {1,0,0.7071,0,1,-0.7071,0.7071,-0.7071,1};
+        size_t       coeff_count = 2;
+        double       observation[] = {-4,3};
     	char*    coding_tmps;
     	char*    curr_coding_tmps;
 	bool*    used_column_mask;
@@ -785,17 +880,84 @@ main(
 	free(coding_tmps);
     }
 
+    printf("  Function \"batch_orthogonal_matching_pursuit\".\n");
+
+    {
+	double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+	coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+	double       dict[] = {1,0,0.6,0,1,0.8};
+	double       dict_transp[] = {1,0,0,1,0.6,0.8};
+	double       dict_x_dict_transp[] = {1,0,0.6,0,1,0.8,0.6,0.8,1};
+	double       observation[] = {1,2};
+	char*        coding_tmps;
+
+	coding_tmps = malloc(batch_orthogonal_matching_pursuit_coding_tmps_length(2,3,2));
+
+	batch_orthogonal_matching_pursuit(o_coeffs,o_coeffs_idx,2,3,dict,dict_transp,dict_x_dict_transp,2,NULL,observation,coding_tmps);
+
+	assert(o_coeffs_idx[0] == 2);
+	assert(o_coeffs_idx[1] == 0);
+	assert(fabs(o_coeffs[0] - 2.5) < 1e-8);
+	assert(fabs(o_coeffs[1] - (-0.5)) < 1e-8);
+
+	free(coding_tmps);
+    }
+
+    {
+	double       o_coeffs[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	coeff_idx_t  o_coeffs_idx[] = {1000,1000,1000};
+	double       dict[] = {1,0,0.6,0,1,0.8};
+	double       dict_transp[] = {1,0,0,1,0.6,0.8};
+	double       dict_x_dict_transp[] = {1,0,0.6,0,1,0.8,0.6,0.8,1};
+	double       observation[] = {1,2};
+	char*        coding_tmps;
+
+	coding_tmps = malloc(batch_orthogonal_matching_pursuit_coding_tmps_length(2,3,3));
+
+	batch_orthogonal_matching_pursuit(o_coeffs,o_coeffs_idx,2,3,dict,dict_transp,dict_x_dict_transp,3,NULL,observation,coding_tmps);
+
+	assert(o_coeffs_idx[0] == 2);
+	assert(o_coeffs_idx[1] == 0);
+	assert(o_coeffs_idx[2] == 1);
+	assert(fabs(o_coeffs[0] - 2.5) < 1e-8);
+	assert(fabs(o_coeffs[1] - (-0.5)) < 1e-8);
+	assert(o_coeffs[2] == 0);
+
+	free(coding_tmps);
+    }
+
+    {
+	double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+	coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+	double       dict[] = {1,0,0.6,0,1,0.8};
+	double       dict_transp[] = {1,0,0,1,0.6,0.8};
+	double       dict_x_dict_transp[] = {1,0,0.6,0,1,0.8,0.6,0.8,1};
+	double       observation[] = {0,0};
+	char*        coding_tmps;
+
+	coding_tmps = malloc(batch_orthogonal_matching_pursuit_coding_tmps_length(2,3,2));
+
+	batch_orthogonal_matching_pursuit(o_coeffs,o_coeffs_idx,2,3,dict,dict_transp,dict_x_dict_transp,2,NULL,observation,coding_tmps);
+
+	assert(o_coeffs_idx[0] == 0);
+	assert(o_coeffs_idx[1] == 1);
+	assert(o_coeffs[0] == 0);
+	assert(o_coeffs[1] == 0);
+
+	free(coding_tmps);
+    }
+
     printf("  Function \"sparse_net\".\n");
 
     {
-        double    o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t    o_coeffs_idx[] = {1000,1000};
-        size_t    geometry = 2;
-        size_t    word_count = 1;
-        double    dict[] = {1,0};
-        double    dict_transp[] = {1,0};
-        double    dict_x_dict_transp[] = {1};
-        size_t    coeff_count = 1;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 1;
+        double       dict[] = {1,0};
+        double       dict_transp[] = {1,0};
+        double       dict_x_dict_transp[] = {1};
+        size_t       coeff_count = 1;
 	double    lambda_sigma_ratio = 0.1;
 	gsl_rng*  rnd_generator;
 	void*     param_table[2];
@@ -815,14 +977,14 @@ main(
     }
 
     {
-        double    o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t    o_coeffs_idx[] = {1000,1000};
-        size_t    geometry = 2;
-        size_t    word_count = 3;
-        double    dict[] = {1,0,1,0,-1,1};
-        double    dict_transp[] = {1,0,0,-1,1,1};
-        double    dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t    coeff_count = 2;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
 	double    lambda_sigma_ratio = 0.1;
 	gsl_rng*  rnd_generator;
 	void*     param_table[2];
@@ -842,14 +1004,14 @@ main(
     }
 
     {
-        double    o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t    o_coeffs_idx[] = {1000,1000};
-        size_t    geometry = 2;
-        size_t    word_count = 3;
-        double    dict[] = {1,0,1,0,-1,1};
-        double    dict_transp[] = {1,0,0,-1,1,1};
-        double    dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t    coeff_count = 2;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
 	double    lambda_sigma_ratio = 0.1;
 	gsl_rng*  rnd_generator;
 	void*     param_table[2];
@@ -869,14 +1031,14 @@ main(
     }
 
     {
-        double    o_coeffs[] = {HUGE_VAL,HUGE_VAL};
-        size_t    o_coeffs_idx[] = {1000,1000};
-        size_t    geometry = 2;
-        size_t    word_count = 3;
-        double    dict[] = {1,0,1,0,-1,1};
-        double    dict_transp[] = {1,0,0,-1,1,1};
-        double    dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
-        size_t    coeff_count = 2;
+        double       o_coeffs[] = {HUGE_VAL,HUGE_VAL};
+        coeff_idx_t  o_coeffs_idx[] = {1000,1000};
+        size_t       geometry = 2;
+        size_t       word_count = 3;
+        double       dict[] = {1,0,1,0,-1,1};
+        double       dict_transp[] = {1,0,0,-1,1,1};
+        double       dict_x_dict_transp[] = {1,0,1,0,1,1,1,1,2};
+        size_t       coeff_count = 2;
 	double    lambda_sigma_ratio = 0.1;
 	gsl_rng*  rnd_generator;
 	void*     param_table[2];
@@ -900,134 +1062,2650 @@ main(
     printf("  Function \"code_image_new_geometry\".\n");
 
     {
-	assert(code_image_new_geometry(28,28,100,NONE,1) == 78400);
-	assert(code_image_new_geometry(28,28,100,NONE,2) == 19600);
-	assert(code_image_new_geometry(28,28,100,NONE,3) == 8100);
-	assert(code_image_new_geometry(28,28,100,NONE,4) == 4900);
-	assert(code_image_new_geometry(28,28,100,NONE,5) == 2500);
-	assert(code_image_new_geometry(28,28,100,NONE,6) == 1600);
-	assert(code_image_new_geometry(28,28,100,NONE,7) == 1600);
-	assert(code_image_new_geometry(28,28,100,NONE,8) == 900);
-	assert(code_image_new_geometry(28,28,100,NONE,10) == 400);
-	assert(code_image_new_geometry(28,28,100,NONE,11) == 400);
-	assert(code_image_new_geometry(28,28,100,NONE,12) == 400);
-	assert(code_image_new_geometry(28,28,100,NONE,13) == 400);
-	assert(code_image_new_geometry(28,28,100,NONE,14) == 400);
-	assert(code_image_new_geometry(28,28,100,NONE,15) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,16) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,17) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,18) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,19) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,20) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,21) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,22) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,23) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,24) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,25) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,26) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,27) == 100);
-	assert(code_image_new_geometry(28,28,100,NONE,28) == 100);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,1) == 156800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,2) == 39200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,3) == 16200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,4) == 9800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,5) == 5000);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,6) == 3200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,7) == 3200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,8) == 1800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,10) == 800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,11) == 800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,12) == 800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,13) == 800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,14) == 800);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,15) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,16) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,17) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,18) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,19) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,20) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,21) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,22) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,23) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,24) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,25) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,26) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,27) == 200);
-	assert(code_image_new_geometry(28,28,100,NO_SIGN,28) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,1) == 156800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,2) == 39200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,3) == 16200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,4) == 9800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,5) == 5000);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,6) == 3200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,7) == 3200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,8) == 1800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,10) == 800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,11) == 800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,12) == 800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,13) == 800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,14) == 800);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,15) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,16) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,17) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,18) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,19) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,20) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,21) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,22) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,23) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,24) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,25) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,26) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,27) == 200);
-	assert(code_image_new_geometry(28,28,100,KEEP_SIGN,28) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,1,0) == 78400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,2,0) == 19600);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,3,0) == 8100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,4,0) == 4900);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,5,0) == 2500);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,6,0) == 1600);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,7,0) == 1600);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,8,0) == 900);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,10,0) == 400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,11,0) == 400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,12,0) == 400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,13,0) == 400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,14,0) == 400);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,15,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,16,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,17,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,18,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,19,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,20,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,21,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,22,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,23,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,24,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,25,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,26,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,27,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,28,0) == 100);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,1,0) == 156800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,2,0) == 39200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,3,0) == 16200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,4,0) == 9800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,5,0) == 5000);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,6,0) == 3200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,7,0) == 3200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,8,0) == 1800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,10,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,11,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,12,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,13,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,14,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,15,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,16,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,17,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,18,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,19,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,20,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,21,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,22,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,23,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,24,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,25,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,26,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,27,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NO_SIGN,28,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,1,0) == 156800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,2,0) == 39200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,3,0) == 16200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,4,0) == 9800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,5,0) == 5000);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,6,0) == 3200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,7,0) == 3200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,8,0) == 1800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,10,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,11,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,12,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,13,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,14,0) == 800);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,15,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,16,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,17,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,18,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,19,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,20,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,21,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,22,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,23,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,24,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,25,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,26,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,27,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,28,0) == 200);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,NONE,1,1000) == 1000);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,4,1000) == 1000);
+	assert(code_image_new_geometry(28,28,1,100,JOINT,KEEP_SIGN,28,1000) == 1000);
+    }
+
+    printf("  Function \"code_image_idx_fits\".\n");
+
+    {
+	assert(code_image_idx_fits(28,28,1,100,JOINT,NONE,1,0));
+	assert(code_image_idx_fits(28,28,3,100,PER_CHANNEL,KEEP_SIGN,1,1024));
+	assert(code_image_idx_fits(28,28,1,100,JOINT,NONE,1,(size_t)1 << 32) == (COEFF_IDX_MAX >= ((size_t)1 << 32) - 1));
+	assert(code_image_idx_fits(28,28,1,100,JOINT,NONE,1,((size_t)1 << 32) + 1) == (COEFF_IDX_MAX > ((size_t)1 << 32) - 1));
+	assert(code_image_idx_fits(65536,65536,1,2,JOINT,NONE,1,16) == (COEFF_IDX_MAX > ((size_t)1 << 32) - 1));
     }
 
     printf("  Function \"code_image_coding_tmps_length\".\n");
 
     {
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,MATCHING_PURSUIT,100,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,ORTHOGONAL_MATCHING_PURSUIT,100,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,SPARSE_NET,100,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 100*sizeof(double) + 100*sizeof(size_t) + 9*9*sizeof(double) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,1) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,2) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,3) == 9*9*sizeof(double) + 27*27*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,9) == 9*9*sizeof(double) + 27*27*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,14) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,100,20,28) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(size_t)) + 100*(sizeof(double) + sizeof(size_t)) + 28*28*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,1) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 1*1*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,2) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 2*2*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,3) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 3*3*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,9) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 9*9*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,14) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 14*14*sizeof(size_t));
-	assert(code_image_coding_tmps_length(28,28,9,9,CORRELATION,200,10,28) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(size_t)) + 200*(sizeof(double) + sizeof(size_t)) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,MATCHING_PURSUIT,100,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,ORTHOGONAL_MATCHING_PURSUIT,100,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT,100,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(bool) + 9*9*sizeof(double) + 9*9*100*sizeof(double) + 9*9*10*sizeof(double) + 10*10*sizeof(double) + 100*sizeof(double) + 9*9*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,SPARSE_NET,100,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,1,0) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,2,0) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,3,0) == 9*9*sizeof(double) + 27*27*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,9,0) == 9*9*sizeof(double) + 27*27*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,14,0) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,20,28,0) == 9*9*sizeof(double) + 28*28*20*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,1,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 1*1*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,2,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,3,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,9,0) == 9*9*sizeof(double) + 27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 9*9*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,14,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 14*14*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,200,10,28,0) == 9*9*sizeof(double) + 28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 200*sizeof(double) + 28*28*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,3,1000) == 9*9*sizeof(double) + 2*27*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
+	assert(code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,14,1000) == 9*9*sizeof(double) + 2*28*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 14*14*sizeof(size_t));
+    }
+
+    printf("  Function \"code_image\".\n");
+
+    {
+	size_t                          row_count = 12;
+	size_t                          col_count = 12;
+	size_t                          patch_row_count = 3;
+	size_t                          patch_col_count = 3;
+	size_t                          geometry = 9;
+	size_t                          word_count = 6;
+	size_t                          coeff_count = 2;
+	size_t                          reduce_spread = 2;
+	double                          dict[6 * 9];
+	double                          dict_transp[9 * 6];
+	double                          dict_x_dict_transp[6 * 6];
+	struct dictionary_state         dict_state;
+	const struct dictionary_state*  dict_states[1];
+	double                          observation[12 * 12];
+	size_t                          new_geometry;
+	double*                         coeffs;
+	coeff_idx_t*                    coeffs_idx;
+	size_t                          coeffs_count;
+	double*                         hashed_coeffs;
+	coeff_idx_t*                    hashed_coeffs_idx;
+	size_t                          hashed_coeffs_count;
+	double                          coeffs_abs_sum;
+	double                          hashed_coeffs_abs_sum;
+	size_t                          many_buckets;
+	char*                           coding_tmps;
+	size_t                          ii;
+	size_t                          jj;
+	size_t                          kk;
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = 0; jj < geometry; jj++) {
+		dict[ii * geometry + jj] = sin((double)(ii * geometry + jj) * 1.3);
+		dict_transp[jj * word_count + ii] = dict[ii * geometry + jj];
+	    }
+	}
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = 0; jj < word_count; jj++) {
+		dict_x_dict_transp[ii * word_count + jj] = 0;
+
+		for (kk = 0; kk < geometry; kk++) {
+		    dict_x_dict_transp[ii * word_count + jj] += dict[ii * geometry + kk] * dict[jj * geometry + kk];
+		}
+	    }
+	}
+
+	for (ii = 0; ii < row_count * col_count; ii++) {
+	    observation[ii] = cos((double)ii * 0.7) + sin((double)ii * 0.011);
+	}
+
+	dictionary_state_wrap(&dict_state,geometry,word_count,dict,dict_transp,dict_x_dict_transp);
+	dict_states[0] = &dict_state;
+
+	new_geometry = code_image_new_geometry(row_count,col_count,1,word_count,JOINT,KEEP_SIGN,reduce_spread,0);
+	coeffs = (double*)malloc(new_geometry * sizeof(double));
+	coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,0));
+
+	code_image(&coeffs_count,coeffs,coeffs_idx,geometry,row_count,col_count,1,patch_row_count,patch_col_count,
+		   JOINT,CORRELATION,word_count,dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,0,observation,coding_tmps);
+
+	free(coding_tmps);
+
+	coeffs_abs_sum = 0;
+
+	for (ii = 0; ii < coeffs_count; ii++) {
+	    coeffs_abs_sum += fabs(coeffs[ii]);
+	}
+
+	/* With many more buckets than features, hashing only renames features and flips some signs. There can be no
+	   more buckets than 32 bit coefficient indices hold with "XTERN_COMPACT_IDX". */
+
+#if defined(XTERN_COMPACT_IDX)
+	many_buckets = (size_t)1 << 31;
+#else
+	many_buckets = (size_t)1 << 40;
+#endif
+
+	hashed_coeffs = (double*)malloc(new_geometry * sizeof(double));
+	hashed_coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,many_buckets));
+
+	code_image(&hashed_coeffs_count,hashed_coeffs,hashed_coeffs_idx,geometry,row_count,col_count,1,patch_row_count,patch_col_count,
+		   JOINT,CORRELATION,word_count,dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,many_buckets,observation,coding_tmps);
+
+	assert(hashed_coeffs_count == coeffs_count);
+
+	hashed_coeffs_abs_sum = 0;
+
+	for (ii = 0; ii < hashed_coeffs_count; ii++) {
+	    assert(hashed_coeffs_idx[ii] < many_buckets);
+	    assert((ii == 0) || (hashed_coeffs_idx[ii - 1] < hashed_coeffs_idx[ii]));
+	    hashed_coeffs_abs_sum += fabs(hashed_coeffs[ii]);
+	}
+
+	assert(fabs(hashed_coeffs_abs_sum - coeffs_abs_sum) < 1e-10);
+
+	free(coding_tmps);
+
+	/* With fewer buckets than features, collisions are accumulated, and the output fits in the buckets. */
+
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,16));
+
+	code_image(&hashed_coeffs_count,hashed_coeffs,hashed_coeffs_idx,geometry,row_count,col_count,1,patch_row_count,patch_col_count,
+		   JOINT,CORRELATION,word_count,dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,16,observation,coding_tmps);
+
+	assert(coeffs_count > 16);
+	assert(hashed_coeffs_count <= 16);
+
+	hashed_coeffs_abs_sum = 0;
+
+	for (ii = 0; ii < hashed_coeffs_count; ii++) {
+	    assert(hashed_coeffs_idx[ii] < 16);
+	    assert((ii == 0) || (hashed_coeffs_idx[ii - 1] < hashed_coeffs_idx[ii]));
+	    assert(hashed_coeffs[ii] != 0);
+	    hashed_coeffs_abs_sum += fabs(hashed_coeffs[ii]);
+	}
+
+	assert(hashed_coeffs_abs_sum <= coeffs_abs_sum + 1e-10);
+
+	free(coding_tmps);
+	free(hashed_coeffs_idx);
+	free(hashed_coeffs);
+	free(coeffs_idx);
+	free(coeffs);
+    }
+
+    printf("  Function \"code_image_band_row_count\".\n");
+
+    {
+	assert(code_image_band_row_count(28,1,1) == 28);
+	assert(code_image_band_row_count(28,1,4) == 7);
+	assert(code_image_band_row_count(28,1,5) == 6);
+	assert(code_image_band_row_count(28,2,4) == 8);
+	assert(code_image_band_row_count(28,3,4) == 9);
+	assert(code_image_band_row_count(28,7,8) == 7);
+	assert(code_image_band_row_count(28,30,2) == 30);
+    }
+
+    printf("  Function \"code_image_band_count\".\n");
+
+    {
+	assert(code_image_band_count(28,1,28) == 1);
+	assert(code_image_band_count(28,1,7) == 4);
+	assert(code_image_band_count(28,1,6) == 5);
+	assert(code_image_band_count(28,2,8) == 4);
+	assert(code_image_band_count(28,3,6) == 5);
+	assert(code_image_band_count(28,7,7) == 4);
+	assert(code_image_band_count(28,30,30) == 0);
+    }
+
+    printf("  Function \"code_image_band_max_coeff_count\".\n");
+
+    {
+	assert(code_image_band_max_coeff_count(28,1,JOINT,10,1,7) == 10*7*28);
+	assert(code_image_band_max_coeff_count(28,1,JOINT,10,3,6) == 10*6*27);
+	assert(code_image_band_max_coeff_count(28,1,JOINT,1,5,5) == 5*25);
+    }
+
+    printf("  Function \"code_image_band_tmps_length\".\n");
+
+    {
+	assert(code_image_band_tmps_length(28,1,9,9,JOINT,CORRELATION,100,10,1,28) == code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,1,0));
+	assert(code_image_band_tmps_length(28,1,9,9,JOINT,CORRELATION,100,10,3,27) == code_image_coding_tmps_length(28,28,1,9,9,JOINT,CORRELATION,100,10,3,0));
+	assert(code_image_band_tmps_length(28,1,9,9,JOINT,CORRELATION,100,10,2,8) == 9*9*sizeof(double) + 8*28*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 2*2*sizeof(size_t));
+	assert(code_image_band_tmps_length(28,1,9,9,JOINT,CORRELATION,100,10,3,6) == 9*9*sizeof(double) + 6*27*10*(sizeof(double) + sizeof(coeff_idx_t)) + 100*sizeof(double) + 3*3*sizeof(size_t));
+    }
+
+    printf("  Function \"code_image_merge_bands_tmps_length\".\n");
+
+    {
+	assert(code_image_merge_bands_tmps_length(4,100,0) == 4*sizeof(size_t));
+	assert(code_image_merge_bands_tmps_length(4,100,16) == 4*sizeof(size_t) + 4*100*(sizeof(double) + sizeof(coeff_idx_t)));
+    }
+
+    printf("  Functions \"code_image_band\" and \"code_image_merge_bands\".\n");
+
+    {
+	size_t                          row_count = 13;
+	size_t                          col_count = 12;
+	size_t                          patch_row_count = 3;
+	size_t                          patch_col_count = 3;
+	size_t                          geometry = 9;
+	size_t                          word_count = 6;
+	size_t                          coeff_count = 2;
+	size_t                          reduce_spread = 2;
+	double                          dict[6 * 9];
+	double                          dict_transp[9 * 6];
+	double                          dict_x_dict_transp[6 * 6];
+	struct dictionary_state         dict_state;
+	const struct dictionary_state*  dict_states[1];
+	double                          observation[13 * 12];
+	enum reduce_type                reduce_types[] = {SUBSAMPLE,MAX_NO_SIGN,MAX_KEEP_SIGN,SUM_ABS,SUM_SQR};
+	enum polarity_split_type        polarity_split_types[] = {NONE,KEEP_SIGN};
+	size_t                          hashed_geometries[] = {0,16};
+	size_t                          max_band_counts[] = {1,2,3,4,6,10};
+	size_t                          new_geometry;
+	double*                         coeffs;
+	coeff_idx_t*                    coeffs_idx;
+	size_t                          coeffs_count;
+	double*                         merged_coeffs;
+	coeff_idx_t*                    merged_coeffs_idx;
+	size_t                          merged_coeffs_count;
+	size_t                          band_row_count;
+	size_t                          band_count;
+	size_t                          band_capacity;
+	double*                         bands_coeffs;
+	coeff_idx_t*                    bands_coeffs_idx;
+	size_t*                         bands_coeff_count;
+	char*                           coding_tmps;
+	char*                           merge_tmps;
+	size_t                          rt;
+	size_t                          pt;
+	size_t                          ht;
+	size_t                          bt;
+	size_t                          ii;
+	size_t                          jj;
+	size_t                          kk;
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = 0; jj < geometry; jj++) {
+		dict[ii * geometry + jj] = sin((double)(ii * geometry + jj) * 1.3);
+		dict_transp[jj * word_count + ii] = dict[ii * geometry + jj];
+	    }
+	}
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = 0; jj < word_count; jj++) {
+		dict_x_dict_transp[ii * word_count + jj] = 0;
+
+		for (kk = 0; kk < geometry; kk++) {
+		    dict_x_dict_transp[ii * word_count + jj] += dict[ii * geometry + kk] * dict[jj * geometry + kk];
+		}
+	    }
+	}
+
+	for (ii = 0; ii < row_count * col_count; ii++) {
+	    observation[ii] = cos((double)ii * 0.7) + sin((double)ii * 0.011);
+	}
+
+	dictionary_state_wrap(&dict_state,geometry,word_count,dict,dict_transp,dict_x_dict_transp);
+	dict_states[0] = &dict_state;
+
+	/* Coding the image band by band and merging the bands should give exactly the features of the whole image. */
+
+	for (rt = 0; rt < sizeof(reduce_types) / sizeof(reduce_types[0]); rt++) {
+	    for (pt = 0; pt < sizeof(polarity_split_types) / sizeof(polarity_split_types[0]); pt++) {
+		for (ht = 0; ht < sizeof(hashed_geometries) / sizeof(hashed_geometries[0]); ht++) {
+		    new_geometry = code_image_new_geometry(row_count,col_count,1,word_count,JOINT,polarity_split_types[pt],reduce_spread,hashed_geometries[ht]);
+		    coeffs = (double*)malloc(new_geometry * sizeof(double));
+		    coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+		    coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,hashed_geometries[ht]));
+
+		    code_image(&coeffs_count,coeffs,coeffs_idx,geometry,row_count,col_count,1,patch_row_count,patch_col_count,
+			       JOINT,CORRELATION,word_count,dict_states,coeff_count,NULL,
+			       LINEAR,NULL,polarity_split_types[pt],reduce_types[rt],reduce_spread,hashed_geometries[ht],observation,coding_tmps);
+
+		    free(coding_tmps);
+
+		    for (bt = 0; bt < sizeof(max_band_counts) / sizeof(max_band_counts[0]); bt++) {
+			band_row_count = code_image_band_row_count(row_count,reduce_spread,max_band_counts[bt]);
+			band_count = code_image_band_count(row_count,reduce_spread,band_row_count);
+			band_capacity = code_image_band_max_coeff_count(col_count,1,JOINT,coeff_count,reduce_spread,band_row_count);
+
+			assert(band_count <= max_band_counts[bt]);
+
+			bands_coeffs = (double*)malloc(band_count * band_capacity * sizeof(double));
+			bands_coeffs_idx = (coeff_idx_t*)malloc(band_count * band_capacity * sizeof(coeff_idx_t));
+			bands_coeff_count = (size_t*)malloc(band_count * sizeof(size_t));
+			coding_tmps = (char*)malloc(code_image_band_tmps_length(col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,band_row_count));
+
+			for (ii = 0; ii < band_count; ii++) {
+			    code_image_band(&bands_coeff_count[ii],bands_coeffs + ii * band_capacity,bands_coeffs_idx + ii * band_capacity,
+					    geometry,row_count,col_count,1,patch_row_count,patch_col_count,
+					    JOINT,CORRELATION,word_count,dict_states,coeff_count,NULL,
+					    LINEAR,NULL,polarity_split_types[pt],reduce_types[rt],reduce_spread,band_row_count,ii,observation,coding_tmps);
+
+			    assert(bands_coeff_count[ii] <= band_capacity);
+			}
+
+			merged_coeffs = (double*)malloc(new_geometry * sizeof(double));
+			merged_coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+			merge_tmps = (char*)malloc(code_image_merge_bands_tmps_length(band_count,band_capacity,hashed_geometries[ht]));
+
+			code_image_merge_bands(&merged_coeffs_count,merged_coeffs,merged_coeffs_idx,band_count,band_capacity,
+					       bands_coeff_count,bands_coeffs,bands_coeffs_idx,hashed_geometries[ht],merge_tmps);
+
+			assert(merged_coeffs_count == coeffs_count);
+
+			for (ii = 0; ii < coeffs_count; ii++) {
+			    assert(merged_coeffs_idx[ii] == coeffs_idx[ii]);
+			    assert(merged_coeffs[ii] == coeffs[ii]);
+			}
+
+			free(merge_tmps);
+			free(merged_coeffs_idx);
+			free(merged_coeffs);
+			free(coding_tmps);
+			free(bands_coeff_count);
+			free(bands_coeffs_idx);
+			free(bands_coeffs);
+		    }
+
+		    free(coeffs_idx);
+		    free(coeffs);
+		}
+	    }
+	}
+    }
+
+    printf("  Function \"code_image\" with several layers.\n");
+
+    {
+	size_t                          row_count = 12;
+	size_t                          col_count = 12;
+	size_t                          layer_count = 3;
+	size_t                          patch_row_count = 3;
+	size_t                          patch_col_count = 3;
+	size_t                          word_count = 6;
+	size_t                          coeff_count = 2;
+	size_t                          reduce_spread = 2;
+	size_t                          cell_count = 6 * 6;
+	double                          dicts[3 * 6 * 9];
+	double                          dicts_transp[3 * 9 * 6];
+	double                          dicts_x_dicts_transp[3 * 6 * 6];
+	double                          joint_dict[6 * 27];
+	double                          joint_dict_transp[27 * 6];
+	double                          joint_dict_x_dict_transp[6 * 6];
+	struct dictionary_state         layer_dict_state[3];
+	const struct dictionary_state*  layer_dict_states[3];
+	struct dictionary_state         joint_dict_state;
+	const struct dictionary_state*  joint_dict_states[1];
+	double                          observation[12 * 12 * 3];
+	size_t                          new_geometry;
+	double*                         coeffs;
+	coeff_idx_t*                    coeffs_idx;
+	size_t                          coeffs_count;
+	double*                         layer_coeffs;
+	coeff_idx_t*                    layer_coeffs_idx;
+	size_t                          layer_coeffs_count;
+	size_t                          total_layer_coeffs_count;
+	size_t                          layer_feature;
+	size_t                          feature_idx;
+	char*                           coding_tmps;
+	size_t                          ll;
+	size_t                          ii;
+	size_t                          jj;
+	size_t                          kk;
+
+	for (ll = 0; ll < layer_count; ll++) {
+	    for (ii = 0; ii < word_count; ii++) {
+		for (jj = 0; jj < 9; jj++) {
+		    dicts[ll * word_count * 9 + jj * word_count + ii] = sin((double)(ll * word_count * 9 + ii * 9 + jj) * 1.3);
+		    dicts_transp[ll * 9 * word_count + ii * 9 + jj] = dicts[ll * word_count * 9 + jj * word_count + ii];
+		}
+	    }
+
+	    for (ii = 0; ii < word_count; ii++) {
+		for (jj = 0; jj < word_count; jj++) {
+		    dicts_x_dicts_transp[ll * word_count * word_count + ii * word_count + jj] = 0;
+
+		    for (kk = 0; kk < 9; kk++) {
+			dicts_x_dicts_transp[ll * word_count * word_count + ii * word_count + jj] += dicts_transp[ll * 9 * word_count + ii * 9 + kk] * dicts_transp[ll * 9 * word_count + jj * 9 + kk];
+		    }
+		}
+	    }
+	}
+
+	/* With "JOINT" channels and identical layers, every joint atom being the first dictionary's atom repeated for
+	   each layer, the correlations are those of the first layer alone, scaled by the number of layers. */
+
+	for (ll = 0; ll < layer_count; ll++) {
+	    for (ii = 0; ii < row_count * col_count; ii++) {
+		observation[ll * row_count * col_count + ii] = cos((double)ii * 0.7) + sin((double)ii * 0.011);
+	    }
+	}
+
+	for (ii = 0; ii < word_count; ii++) {
+	    for (ll = 0; ll < layer_count; ll++) {
+		for (jj = 0; jj < 9; jj++) {
+		    joint_dict[(ll * 9 + jj) * word_count + ii] = dicts[jj * word_count + ii];
+		    joint_dict_transp[ii * 27 + ll * 9 + jj] = dicts[jj * word_count + ii];
+		}
+	    }
+
+	    for (jj = 0; jj < word_count; jj++) {
+		joint_dict_x_dict_transp[ii * word_count + jj] = 3 * dicts_x_dicts_transp[ii * word_count + jj];
+	    }
+	}
+
+	for (ll = 0; ll < layer_count; ll++) {
+	    dictionary_state_wrap(&layer_dict_state[ll],9,word_count,dicts + ll * word_count * 9,dicts_transp + ll * 9 * word_count,dicts_x_dicts_transp + ll * word_count * word_count);
+	    layer_dict_states[ll] = &layer_dict_state[ll];
+	}
+
+	dictionary_state_wrap(&joint_dict_state,27,word_count,joint_dict,joint_dict_transp,joint_dict_x_dict_transp);
+	joint_dict_states[0] = &joint_dict_state;
+
+	new_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,JOINT,KEEP_SIGN,reduce_spread,0);
+
+	assert(new_geometry == code_image_new_geometry(row_count,col_count,1,word_count,JOINT,KEEP_SIGN,reduce_spread,0));
+	assert(code_image_coding_tmps_length(row_count,col_count,layer_count,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,0) ==
+	       code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,0) + 2*9*sizeof(double));
+
+	coeffs = (double*)malloc(new_geometry * sizeof(double));
+	coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,layer_count,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,0));
+
+	code_image(&coeffs_count,coeffs,coeffs_idx,row_count * col_count * layer_count,row_count,col_count,layer_count,patch_row_count,patch_col_count,
+		   JOINT,CORRELATION,word_count,joint_dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,0,observation,coding_tmps);
+
+	free(coding_tmps);
+
+	layer_coeffs = (double*)malloc(new_geometry * sizeof(double));
+	layer_coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,JOINT,CORRELATION,word_count,coeff_count,reduce_spread,0));
+
+	code_image(&layer_coeffs_count,layer_coeffs,layer_coeffs_idx,row_count * col_count,row_count,col_count,1,patch_row_count,patch_col_count,
+		   JOINT,CORRELATION,word_count,layer_dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,0,observation,coding_tmps);
+
+	assert(coeffs_count == layer_coeffs_count);
+
+	for (ii = 0; ii < coeffs_count; ii++) {
+	    assert(coeffs_idx[ii] == layer_coeffs_idx[ii]);
+	    assert(fabs(coeffs[ii] - 3 * layer_coeffs[ii]) < 1e-10);
+	}
+
+	free(coding_tmps);
+	free(layer_coeffs_idx);
+	free(layer_coeffs);
+	free(coeffs_idx);
+	free(coeffs);
+
+	/* With "PER_CHANNEL" channels, each layer is coded as a single layer image against its own dictionary, and its
+	   words come after those of the previous layers, on both sides of the polarity split. */
+
+	for (ii = 0; ii < row_count * col_count * layer_count; ii++) {
+	    observation[ii] = cos((double)ii * 0.7) + sin((double)ii * 0.011);
+	}
+
+	new_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,PER_CHANNEL,KEEP_SIGN,reduce_spread,0);
+
+	assert(new_geometry == 2 * cell_count * word_count * layer_count);
+
+	coeffs = (double*)malloc(new_geometry * sizeof(double));
+	coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,layer_count,patch_row_count,patch_col_count,PER_CHANNEL,CORRELATION,word_count,coeff_count,reduce_spread,0));
+
+	code_image(&coeffs_count,coeffs,coeffs_idx,row_count * col_count * layer_count,row_count,col_count,layer_count,patch_row_count,patch_col_count,
+		   PER_CHANNEL,CORRELATION,word_count,layer_dict_states,coeff_count,NULL,
+		   LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,0,observation,coding_tmps);
+
+	free(coding_tmps);
+
+	for (ii = 0; ii < coeffs_count; ii++) {
+	    assert((ii == 0) || (coeffs_idx[ii - 1] < coeffs_idx[ii]));
+	}
+
+	layer_coeffs = (double*)malloc(new_geometry * sizeof(double));
+	layer_coeffs_idx = (coeff_idx_t*)malloc(new_geometry * sizeof(coeff_idx_t));
+	coding_tmps = (char*)malloc(code_image_coding_tmps_length(row_count,col_count,1,patch_row_count,patch_col_count,PER_CHANNEL,CORRELATION,word_count,coeff_count,reduce_spread,0));
+
+	total_layer_coeffs_count = 0;
+
+	for (ll = 0; ll < layer_count; ll++) {
+	    code_image(&layer_coeffs_count,layer_coeffs,layer_coeffs_idx,row_count * col_count,row_count,col_count,1,patch_row_count,patch_col_count,
+		       PER_CHANNEL,CORRELATION,word_count,layer_dict_states + ll,coeff_count,NULL,
+		       LINEAR,NULL,KEEP_SIGN,MAX_KEEP_SIGN,reduce_spread,0,observation + ll * row_count * col_count,coding_tmps);
+
+	    for (ii = 0; ii < layer_coeffs_count; ii++) {
+		layer_feature = layer_coeffs_idx[ii] / cell_count;
+		feature_idx = layer_coeffs_idx[ii] % cell_count + ((layer_feature / word_count) * layer_count * word_count + ll * word_count + layer_feature % word_count) * cell_count;
+
+		for (jj = 0; (jj < coeffs_count) && (coeffs_idx[jj] != feature_idx); jj++) {
+		}
+
+		assert(jj < coeffs_count);
+		assert(coeffs[jj] == layer_coeffs[ii]);
+	    }
+
+	    total_layer_coeffs_count += layer_coeffs_count;
+	}
+
+	assert(coeffs_count == total_layer_coeffs_count);
+
+	free(coding_tmps);
+	free(layer_coeffs_idx);
+	free(layer_coeffs);
+	free(coeffs_idx);
+	free(coeffs);
+    }
+
+    printf("Testing \"nn_index\".\n");
+
+    printf("  Function \"nearest_centroid_tmps_length\".\n");
+
+    {
+	assert(nearest_centroid_tmps_length(2,3) == 3 * sizeof(double));
+	assert(nearest_centroid_tmps_length(5,3) == 3 * sizeof(double));
+	assert(nearest_centroid_tmps_length(2,7) == 7 * sizeof(double));
+    }
+
+    printf("  Function \"ivf_nearest_neighbours_tmps_length\".\n");
+
+    {
+	assert(ivf_nearest_neighbours_tmps_length(2,3,1) == 3 * sizeof(double) + 3 * sizeof(size_t));
+	assert(ivf_nearest_neighbours_tmps_length(5,3,1) == 3 * sizeof(double) + 3 * sizeof(size_t));
+	assert(ivf_nearest_neighbours_tmps_length(2,7,4) == 7 * sizeof(double) + 7 * sizeof(size_t));
+    }
+
+    printf("  Function \"squared_norms\".\n");
+
+    {
+	double  o_norms[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  sample[] = {1,2,0,0,-3,4};
+
+	squared_norms(o_norms,2,3,sample);
+
+	assert(o_norms[0] == 5);
+	assert(o_norms[1] == 0);
+	assert(o_norms[2] == 25);
+    }
+
+    printf("  Function \"nearest_centroid\".\n");
+
+    {
+	double  centroids[] = {0,0,4,0,0,4};
+	double  centroids_norms[] = {0,16,16};
+	double  observation_1[] = {1,1};
+	double  observation_2[] = {3,1};
+	double  observation_3[] = {1,3};
+	char*   tmps;
+
+	tmps = malloc(nearest_centroid_tmps_length(2,3));
+
+	assert(nearest_centroid(2,3,centroids,centroids_norms,observation_1,tmps) == 0);
+	assert(nearest_centroid(2,3,centroids,centroids_norms,observation_2,tmps) == 1);
+	assert(nearest_centroid(2,3,centroids,centroids_norms,observation_3,tmps) == 2);
+
+	free(tmps);
+    }
+
+    printf("  Function \"kmeans_accumulate\".\n");
+
+    {
+	double  o_sums[] = {0,0,0,0};
+	size_t  o_counts[] = {0,0};
+	double  sample[] = {1,2,3,4,5,6};
+	size_t  list_idx[] = {1,0,1};
+
+	kmeans_accumulate(o_sums,o_counts,2,3,sample,list_idx);
+
+	assert(o_sums[0] == 3);
+	assert(o_sums[1] == 4);
+	assert(o_sums[2] == 6);
+	assert(o_sums[3] == 8);
+	assert(o_counts[0] == 1);
+	assert(o_counts[1] == 2);
+    }
+
+    printf("  Function \"build_ivf_lists\".\n");
+
+    {
+	size_t  o_list_offsets[] = {1000,1000,1000,1000};
+	size_t  o_list_members[] = {1000,1000,1000,1000,1000};
+	size_t  list_idx[] = {2,0,2,2,0};
+
+	build_ivf_lists(o_list_offsets,o_list_members,5,3,list_idx);
+
+	assert(o_list_offsets[0] == 0);
+	assert(o_list_offsets[1] == 2);
+	assert(o_list_offsets[2] == 2);
+	assert(o_list_offsets[3] == 5);
+	assert(o_list_members[0] == 1);
+	assert(o_list_members[1] == 4);
+	assert(o_list_members[2] == 0);
+	assert(o_list_members[3] == 2);
+	assert(o_list_members[4] == 3);
+    }
+
+    printf("  Function \"exact_nearest_neighbours\".\n");
+
+    {
+	size_t  o_neighbours_idx[] = {1000,1000,1000};
+	double  o_neighbours_dist[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  sample[] = {0,0,1,0,0,2,3,3,1,1};
+	double  sample_norms[] = {0,1,4,18,2};
+	double  observation[] = {0.9,0.2};
+
+	exact_nearest_neighbours(o_neighbours_idx,o_neighbours_dist,2,5,sample,sample_norms,3,observation);
+
+	assert(o_neighbours_idx[0] == 1);
+	assert(o_neighbours_idx[1] == 4);
+	assert(o_neighbours_idx[2] == 0);
+	assert(fabs(o_neighbours_dist[0] - 0.05) < 1e-9);
+	assert(fabs(o_neighbours_dist[1] - 0.65) < 1e-9);
+	assert(fabs(o_neighbours_dist[2] - 0.85) < 1e-9);
+    }
+
+    {
+	size_t  o_neighbours_idx[] = {1000,1000};
+	double  o_neighbours_dist[] = {HUGE_VAL,HUGE_VAL};
+	double  sample[] = {2,0,0,0,1,0};
+	double  sample_norms[] = {4,0,1};
+	double  observation[] = {1,0};
+
+	exact_nearest_neighbours(o_neighbours_idx,o_neighbours_dist,2,3,sample,sample_norms,2,observation);
+
+	assert(o_neighbours_idx[0] == 2);
+	assert(o_neighbours_idx[1] == 0);
+	assert(o_neighbours_dist[0] == 0);
+	assert(o_neighbours_dist[1] == 1);
+    }
+
+    printf("  Function \"ivf_nearest_neighbours\".\n");
+
+    {
+	size_t  o_neighbours_idx[] = {1000,1000,1000};
+	double  o_neighbours_dist[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  sample[] = {0,0,1,0,0,2,3,3,1,1};
+	double  sample_norms[] = {0,1,4,18,2};
+	double  centroids[] = {0.5,0.25,1.5,2.5};
+	double  centroids_norms[] = {0.3125,8.5};
+	size_t  list_offsets[] = {0,3,5};
+	size_t  list_members[] = {0,1,4,2,3};
+	double  observation[] = {0.9,0.2};
+	char*   tmps;
+
+	tmps = malloc(ivf_nearest_neighbours_tmps_length(2,2,3));
+
+	ivf_nearest_neighbours(o_neighbours_idx,o_neighbours_dist,2,5,sample,sample_norms,2,centroids,centroids_norms,list_offsets,list_members,1,3,observation,tmps);
+
+	assert(o_neighbours_idx[0] == 1);
+	assert(o_neighbours_idx[1] == 4);
+	assert(o_neighbours_idx[2] == 0);
+	assert(fabs(o_neighbours_dist[0] - 0.05) < 1e-9);
+	assert(fabs(o_neighbours_dist[1] - 0.65) < 1e-9);
+	assert(fabs(o_neighbours_dist[2] - 0.85) < 1e-9);
+
+	free(tmps);
+    }
+
+    {
+	size_t  o_neighbours_idx[] = {1000,1000,1000,1000};
+	double  o_neighbours_dist[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  sample[] = {0,0,1,0,0,2,3,3,1,1};
+	double  sample_norms[] = {0,1,4,18,2};
+	double  centroids[] = {0.5,0.25,1.5,2.5};
+	double  centroids_norms[] = {0.3125,8.5};
+	size_t  list_offsets[] = {0,3,5};
+	size_t  list_members[] = {0,1,4,2,3};
+	double  observation[] = {0.9,0.2};
+	char*   tmps;
+
+	tmps = malloc(ivf_nearest_neighbours_tmps_length(2,2,4));
+
+	ivf_nearest_neighbours(o_neighbours_idx,o_neighbours_dist,2,5,sample,sample_norms,2,centroids,centroids_norms,list_offsets,list_members,1,4,observation,tmps);
+
+	assert(o_neighbours_idx[0] == 1);
+	assert(o_neighbours_idx[1] == 4);
+	assert(o_neighbours_idx[2] == 0);
+	assert(o_neighbours_idx[3] == 2);
+	assert(fabs(o_neighbours_dist[3] - 4.05) < 1e-9);
+
+	free(tmps);
+    }
+
+    {
+	size_t  o_neighbours_idx[] = {1000,1000};
+	double  o_neighbours_dist[] = {HUGE_VAL,HUGE_VAL};
+	double  sample[] = {0,0,1,0,0,2,3,3,1,1};
+	double  sample_norms[] = {0,1,4,18,2};
+	double  centroids[] = {0.5,0.25,1.5,2.5};
+	double  centroids_norms[] = {0.3125,8.5};
+	size_t  list_offsets[] = {0,3,5};
+	size_t  list_members[] = {0,1,4,2,3};
+	double  observation[] = {2.5,2.5};
+	char*   tmps;
+
+	tmps = malloc(ivf_nearest_neighbours_tmps_length(2,2,2));
+
+	ivf_nearest_neighbours(o_neighbours_idx,o_neighbours_dist,2,5,sample,sample_norms,2,centroids,centroids_norms,list_offsets,list_members,1,2,observation,tmps);
+
+	assert(o_neighbours_idx[0] == 3);
+	assert(o_neighbours_idx[1] == 2);
+	assert(fabs(o_neighbours_dist[0] - 0.5) < 1e-9);
+	assert(fabs(o_neighbours_dist[1] - 6.5) < 1e-9);
+
+	free(tmps);
+    }
+
+    printf("Testing \"random_tools\".\n");
+
+    printf("  Function \"counter_rng\".\n");
+
+    {
+	assert(counter_rng(10,0,0) == counter_rng(10,0,0));
+	assert(counter_rng(10,0,5) == counter_rng(10,0,5));
+	assert(counter_rng(10,0,0) != counter_rng(10,0,1));
+	assert(counter_rng(10,0,0) != counter_rng(10,1,0));
+	assert(counter_rng(10,0,0) != counter_rng(11,0,0));
+	assert(counter_rng(10,1,0) != counter_rng(10,0,1));
+    }
+
+    printf("  Function \"counter_rng_uniform\".\n");
+
+    {
+	double  mean;
+	double  value;
+	size_t  ii;
+
+	mean = 0;
+
+	for (ii = 0; ii < 10000; ii++) {
+	    value = counter_rng_uniform(7,3,ii);
+	    assert(value >= 0);
+	    assert(value < 1);
+	    mean += value;
+	}
+
+	mean = mean / 10000;
+
+	assert(fabs(mean - 0.5) < 0.02);
+    }
+
+    printf("  Function \"counter_rng_uniform_int\".\n");
+
+    {
+	size_t  hist[5] = {0,0,0,0,0};
+	size_t  value;
+	size_t  ii;
+
+	for (ii = 0; ii < 10000; ii++) {
+	    value = counter_rng_uniform_int(7,3,ii,5);
+	    assert(value < 5);
+	    hist[value] += 1;
+	}
+
+	for (ii = 0; ii < 5; ii++) {
+	    assert(hist[ii] > 1800);
+	    assert(hist[ii] < 2200);
+	}
+
+	assert(counter_rng_uniform_int(7,3,0,1) == 0);
+    }
+
+    printf("Testing \"patch_sampler\".\n");
+
+    printf("  Function \"patch_sampler_tmps_length\".\n");
+
+    {
+	assert(patch_sampler_tmps_length(28,28,1) == 29 * 29 * sizeof(double) + 29 * 29 * sizeof(double));
+	assert(patch_sampler_tmps_length(28,28,3) == 29 * 29 * sizeof(double) + 29 * 29 * sizeof(double));
+	assert(patch_sampler_tmps_length(4,6,1) == 5 * 7 * sizeof(double) + 5 * 7 * sizeof(double));
+    }
+
+    printf("  Function \"draw_patch_candidate\".\n");
+
+    {
+	size_t  image_idx;
+	size_t  row_skip;
+	size_t  col_skip;
+	size_t  other_image_idx;
+	size_t  other_row_skip;
+	size_t  other_col_skip;
+	size_t  ii;
+
+	for (ii = 0; ii < 1000; ii++) {
+	    draw_patch_candidate(&image_idx,&row_skip,&col_skip,10,ii % 7,ii,20,28,32,9,5);
+	    assert(image_idx < 20);
+	    assert(row_skip <= 28 - 9);
+	    assert(col_skip <= 32 - 5);
+	    draw_patch_candidate(&other_image_idx,&other_row_skip,&other_col_skip,10,ii % 7,ii,20,28,32,9,5);
+	    assert(other_image_idx == image_idx);
+	    assert(other_row_skip == row_skip);
+	    assert(other_col_skip == col_skip);
+	}
+
+	draw_patch_candidate(&image_idx,&row_skip,&col_skip,10,0,0,1,5,5,5,5);
+
+	assert(image_idx == 0);
+	assert(row_skip == 0);
+	assert(col_skip == 0);
+    }
+
+    printf("  Function \"patch_sampler_use_integral\".\n");
+
+    {
+	assert(patch_sampler_use_integral(1,28,28,9,9) == false);
+	assert(patch_sampler_use_integral(9,28,28,9,9) == false);
+	assert(patch_sampler_use_integral(10,28,28,9,9) == true);
+	assert(patch_sampler_use_integral(1,28,28,28,28) == false);
+	assert(patch_sampler_use_integral(2,28,28,28,28) == true);
+    }
+
+    printf("  Function \"build_integral_images\".\n");
+
+    {
+	double  o_sum[12];
+	double  o_sum_sqr[12];
+	double  image[] = {1,2,3,4,5,6,1,1,1,1,1,1};
+
+	build_integral_images(o_sum,o_sum_sqr,2,3,2,image);
+
+	assert(o_sum[0] == 0);
+	assert(o_sum[1] == 0);
+	assert(o_sum[2] == 0);
+	assert(o_sum[3] == 0);
+	assert(o_sum[4] == 2);
+	assert(o_sum[5] == 5);
+	assert(o_sum[6] == 0);
+	assert(o_sum[7] == 6);
+	assert(o_sum[8] == 14);
+	assert(o_sum[9] == 0);
+	assert(o_sum[10] == 12);
+	assert(o_sum[11] == 27);
+	assert(o_sum_sqr[4] == 2);
+	assert(o_sum_sqr[5] == 7);
+	assert(o_sum_sqr[8] == 34);
+	assert(o_sum_sqr[11] == 97);
+    }
+
+    printf("  Function \"patch_variance_integral\".\n");
+
+    {
+	double  sum[12];
+	double  sum_sqr[12];
+	double  image[] = {1,2,3,4,5,6,1,1,1,1,1,1};
+	double  patch_mean;
+	double  patch_variance;
+
+	build_integral_images(sum,sum_sqr,2,3,2,image);
+
+	patch_mean = (3 + 4 + 5 + 6 + 4) / 8.0;
+	patch_variance = (3 * (1 - patch_mean) * (1 - patch_mean) + (3 - patch_mean) * (3 - patch_mean) + (4 - patch_mean) * (4 - patch_mean) +
+			  (5 - patch_mean) * (5 - patch_mean) + (6 - patch_mean) * (6 - patch_mean) + (1 - patch_mean) * (1 - patch_mean)) / 7;
+
+	assert(fabs(patch_variance_integral(2,3,2,2,2,0,1,sum,sum_sqr) - patch_variance) < 1e-12);
+	assert(fabs(patch_variance_integral(2,3,2,2,3,0,0,sum,sum_sqr) - 36.25 / 11) < 1e-12);
+	assert(patch_variance_integral(2,3,2,1,1,1,2,sum,sum_sqr) == 12.5);
+    }
+
+    {
+	double  sum[4];
+	double  sum_sqr[4];
+	double  image[] = {7};
+
+	build_integral_images(sum,sum_sqr,1,1,1,image);
+
+	assert(patch_variance_integral(1,1,1,1,1,0,0,sum,sum_sqr) == 0);
+    }
+
+    printf("  Function \"patch_variance_direct\".\n");
+
+    {
+	double  image[] = {1,2,3,4,5,6,1,1,1,1,1,1};
+	double  sum[12];
+	double  sum_sqr[12];
+	size_t  ii;
+	size_t  jj;
+
+	build_integral_images(sum,sum_sqr,2,3,2,image);
+
+	assert(fabs(patch_variance_direct(2,3,1,2,3,0,0,image) - 3.5) < 1e-12);
+	assert(patch_variance_direct(2,3,2,1,1,1,2,image) == 12.5);
+	assert(patch_variance_direct(1,1,1,1,1,0,0,image) == 0);
+
+	for (ii = 0; ii < 2; ii++) {
+	    for (jj = 0; jj < 3; jj++) {
+		assert(fabs(patch_variance_direct(2,3,2,1,1,ii,jj,image) - patch_variance_integral(2,3,2,1,1,ii,jj,sum,sum_sqr)) < 1e-12);
+		assert(fabs(patch_variance_direct(2,3,2,2,1,0,jj,image) - patch_variance_integral(2,3,2,2,1,0,jj,sum,sum_sqr)) < 1e-12);
+	    }
+	}
+    }
+
+    printf("  Function \"extract_patch\".\n");
+
+    {
+	double  o_patch[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  image[] = {1,2,3,4,5,6,7,8,9,10,11,12};
+
+	extract_patch(o_patch,2,3,2,1,2,1,1,image);
+
+	assert(o_patch[0] == 4);
+	assert(o_patch[1] == 6);
+	assert(o_patch[2] == 10);
+	assert(o_patch[3] == 12);
+    }
+
+    {
+	double  o_patch[] = {HUGE_VAL,HUGE_VAL,HUGE_VAL,HUGE_VAL};
+	double  image[] = {1,2,3,4,5,6,7,8,9};
+
+	extract_patch(o_patch,3,3,1,2,2,1,0,image);
+
+	assert(o_patch[0] == 2);
+	assert(o_patch[1] == 3);
+	assert(o_patch[2] == 5);
+	assert(o_patch[3] == 6);
+    }
+
+    printf("Testing \"covariance\".\n");
+
+    printf("  Function \"covariance_tmps_length\".\n");
+
+    {
+	assert(covariance_tmps_length(2,3) == 2 * 3 * sizeof(double) + 2 * sizeof(double) + 2 * 2 * sizeof(double));
+	assert(covariance_tmps_length(5,3) == 5 * 3 * sizeof(double) + 5 * sizeof(double) + 5 * 5 * sizeof(double));
+	assert(covariance_tmps_length(2,256) == 2 * 256 * sizeof(double) + 2 * sizeof(double) + 2 * 2 * sizeof(double));
+    }
+
+    printf("  Function \"covariance_merge\".\n");
+
+    {
+	double  io_mean[] = {0,0};
+	double  io_scatter[] = {0,0,0,0};
+	size_t  io_count = 0;
+	double  other_mean[] = {1,2};
+	double  other_scatter[] = {2,-1,-1,4};
+
+	covariance_merge(io_mean,io_scatter,&io_count,2,other_mean,other_scatter,3);
+
+	assert(io_count == 3);
+	assert(io_mean[0] == 1);
+	assert(io_mean[1] == 2);
+	assert(io_scatter[0] == 2);
+	assert(io_scatter[2] == -1);
+	assert(io_scatter[3] == 4);
+    }
+
+    {
+	double  io_mean[] = {0,0};
+	double  io_scatter[] = {0,0,0,0};
+	size_t  io_count = 1;
+	double  other_mean[] = {2,4};
+	double  other_scatter[] = {0,0,0,0};
+
+	covariance_merge(io_mean,io_scatter,&io_count,2,other_mean,other_scatter,1);
+
+	assert(io_count == 2);
+	assert(io_mean[0] == 1);
+	assert(io_mean[1] == 2);
+	assert(io_scatter[0] == 2);
+	assert(io_scatter[2] == 4);
+	assert(io_scatter[3] == 8);
+    }
+
+    {
+	double  io_mean[] = {1,1};
+	double  io_scatter[] = {3,0,1,5};
+	size_t  io_count = 4;
+	double  other_mean[] = {7,7};
+	double  other_scatter[] = {9,9,9,9};
+
+	covariance_merge(io_mean,io_scatter,&io_count,2,other_mean,other_scatter,0);
+
+	assert(io_count == 4);
+	assert(io_mean[0] == 1);
+	assert(io_mean[1] == 1);
+	assert(io_scatter[0] == 3);
+	assert(io_scatter[2] == 1);
+	assert(io_scatter[3] == 5);
+    }
+
+    printf("  Function \"covariance_finish\".\n");
+
+    {
+	double  io_scatter[] = {4,1000,2,6};
+
+	covariance_finish(io_scatter,2,3);
+
+	assert(io_scatter[0] == 2);
+	assert(io_scatter[1] == 1);
+	assert(io_scatter[2] == 1);
+	assert(io_scatter[3] == 3);
+    }
+
+    printf("  Function \"covariance_accumulate\".\n");
+
+    {
+	double  io_mean[] = {0,0,0};
+	double  io_scatter[] = {0,0,0,0,0,0,0,0,0};
+	size_t  io_count = 0;
+	double  sample[] = {1,2,3,100,-2,5,7,0,1,-3,4,4,2,2,2,1000,1001,999,0,1,0};
+	double  mean[] = {0,0,0};
+	double  covariance[9];
+	char*   tmps;
+	size_t  chunk_count;
+	size_t  ii;
+	size_t  jj;
+	size_t  kk;
+
+	for (kk = 0; kk < 7; kk++) {
+	    for (ii = 0; ii < 3; ii++) {
+		mean[ii] += sample[kk * 3 + ii] / 7;
+	    }
+	}
+
+	for (ii = 0; ii < 3; ii++) {
+	    for (jj = 0; jj < 3; jj++) {
+		covariance[jj * 3 + ii] = 0;
+
+		for (kk = 0; kk < 7; kk++) {
+		    covariance[jj * 3 + ii] += (sample[kk * 3 + ii] - mean[ii]) * (sample[kk * 3 + jj] - mean[jj]) / 6;
+		}
+	    }
+	}
+
+	for (chunk_count = 1; chunk_count <= 8; chunk_count++) {
+	    memset(io_mean,0,3 * sizeof(double));
+	    memset(io_scatter,0,9 * sizeof(double));
+	    io_count = 0;
+
+	    tmps = malloc(covariance_tmps_length(3,chunk_count));
+
+	    covariance_accumulate(io_mean,io_scatter,&io_count,3,4,sample,chunk_count,tmps);
+	    covariance_accumulate(io_mean,io_scatter,&io_count,3,3,sample + 4 * 3,chunk_count,tmps);
+	    covariance_finish(io_scatter,3,io_count);
+
+	    assert(io_count == 7);
+
+	    for (ii = 0; ii < 3; ii++) {
+		assert(fabs(io_mean[ii] - mean[ii]) < 1e-9);
+	    }
+
+	    for (ii = 0; ii < 9; ii++) {
+		assert(fabs(io_scatter[ii] - covariance[ii]) < 1e-7);
+	    }
+
+	    free(tmps);
+	}
+    }
+
+    printf("Testing \"pipeline\".\n");
+
+    printf("  Function \"pipeline_tmps_length\".\n");
+
+    {
+	struct pipeline_op  ops[2];
+
+	ops[0].type = OP_AFFINE;
+	ops[0].input_geometry = 3;
+	ops[0].output_geometry = 3;
+	ops[0].params = NULL;
+	ops[1].type = OP_LINEAR;
+	ops[1].input_geometry = 3;
+	ops[1].output_geometry = 5;
+	ops[1].params = NULL;
+
+	assert(pipeline_max_geometry(1,ops) == 3);
+	assert(pipeline_max_geometry(2,ops) == 5);
+	assert(pipeline_tmps_length(1,ops,4) == 3 * 4 * sizeof(double) + 3 * 4 * sizeof(double));
+	assert(pipeline_tmps_length(2,ops,4) == 5 * 4 * sizeof(double) + 5 * 4 * sizeof(double));
+    }
+
+    printf("  Function \"pipeline_code_block\".\n");
+
+    {
+	double              sample[] = {1,2,3,4,6,8};
+	double              affine_params[] = {1,2,0.5,0,1,0};
+	double              linear_params[] = {1,0,0,1,1,0,1,1};
+	struct pipeline_op  ops[4];
+	double              o_sample_coded[6];
+	void*               tmps;
+
+	ops[0].type = OP_DC_OFFSET;
+	ops[0].input_geometry = 3;
+	ops[0].output_geometry = 3;
+	ops[0].params = NULL;
+	ops[1].type = OP_AFFINE;
+	ops[1].input_geometry = 3;
+	ops[1].output_geometry = 3;
+	ops[1].params = affine_params;
+	ops[2].type = OP_LINEAR;
+	ops[2].input_geometry = 3;
+	ops[2].output_geometry = 2;
+	ops[2].params = linear_params;
+	ops[3].type = OP_L2_NORMALIZE;
+	ops[3].input_geometry = 2;
+	ops[3].output_geometry = 2;
+	ops[3].params = NULL;
+
+	tmps = malloc(pipeline_tmps_length(4,ops,2));
+
+	pipeline_code_block(o_sample_coded,4,ops,2,sample,tmps);
+
+	assert(fabs(o_sample_coded[0] - 0.5 / sqrt(4.25)) < 1e-9);
+	assert(fabs(o_sample_coded[1] - 2 / sqrt(4.25)) < 1e-9);
+	assert(fabs(o_sample_coded[2] - 0) < 1e-9);
+	assert(fabs(o_sample_coded[3] - 1) < 1e-9);
+
+	pipeline_code_block(o_sample_coded,2,ops,2,sample,tmps);
+
+	assert(o_sample_coded[0] == -1);
+	assert(o_sample_coded[1] == 1);
+	assert(o_sample_coded[2] == 0.5);
+
+	pipeline_code_block(o_sample_coded,4,ops,1,sample + 3,tmps);
+
+	assert(fabs(o_sample_coded[0] - 0) < 1e-9);
+	assert(fabs(o_sample_coded[1] - 1) < 1e-9);
+
+	free(tmps);
+    }
+
+    printf("Testing \"image_deform\".\n");
+
+    printf("  Function \"image_deform_tmps_length\".\n");
+
+    {
+	assert(image_deform_tmps_length(3,4) == 5 * 3 * 4 * sizeof(double) + 5 * sizeof(double));
+	assert(image_deform_tmps_length(28,28) == 5 * 28 * 28 * sizeof(double) + 29 * sizeof(double));
+    }
+
+    printf("  Function \"gaussian_kernel\".\n");
+
+    {
+	double  o_kernel[5];
+	double  norm;
+
+	gaussian_kernel(o_kernel,2,1);
+
+	norm = 1 + 2 * exp(-0.5) + 2 * exp(-2);
+
+	assert(fabs(o_kernel[0] - exp(-2) / norm) < 1e-12);
+	assert(fabs(o_kernel[1] - exp(-0.5) / norm) < 1e-12);
+	assert(fabs(o_kernel[2] - 1 / norm) < 1e-12);
+	assert(o_kernel[3] == o_kernel[1]);
+	assert(o_kernel[4] == o_kernel[0]);
+    }
+
+    printf("  Function \"smooth_field\".\n");
+
+    {
+	double  io_field[25];
+	double  kernel[5];
+	double  sum;
+	void*   tmps;
+	size_t  ii;
+
+	memset(io_field,0,25 * sizeof(double));
+	io_field[12] = 1;
+	gaussian_kernel(kernel,2,1);
+	tmps = malloc(image_deform_tmps_length(5,5));
+
+	smooth_field(io_field,5,5,1,tmps);
+
+	sum = 0;
+	for (ii = 0; ii < 25; ii++) {
+	    assert(fabs(io_field[ii] - kernel[ii % 5] * kernel[ii / 5]) < 1e-12);
+	    sum += io_field[ii];
+	}
+
+	assert(fabs(sum - 1) < 1e-12);
+
+	free(tmps);
+    }
+
+    printf("  Function \"image_bounds\".\n");
+
+    {
+	double  image[] = {0,0,0,0,1,0,0,0,0,0,0,2};
+	double  empty[] = {0,0,0,0,0,0};
+	size_t  min_row;
+	size_t  max_row;
+	size_t  min_col;
+	size_t  max_col;
+
+	assert(image_bounds(&min_row,&max_row,&min_col,&max_col,3,4,1,image));
+	assert(min_row == 1);
+	assert(max_row == 2);
+	assert(min_col == 1);
+	assert(max_col == 3);
+
+	assert(image_bounds(&min_row,&max_row,&min_col,&max_col,2,3,1,image));
+	assert(min_row == 0);
+	assert(max_row == 0);
+	assert(min_col == 2);
+	assert(max_col == 2);
+
+	assert(!image_bounds(&min_row,&max_row,&min_col,&max_col,3,2,1,empty));
+    }
+
+    printf("  Function \"build_deform_map\".\n");
+
+    {
+	double  o_src_row[12];
+	double  o_src_col[12];
+	double  field_row[12];
+	double  field_col[12];
+	size_t  ii;
+
+	build_deform_map(o_src_row,o_src_col,3,4,1,1.5,1,1,0,0,NULL,NULL);
+
+	for (ii = 0; ii < 12; ii++) {
+	    assert(fabs(o_src_row[ii] - (double)(ii % 3)) < 1e-12);
+	    assert(fabs(o_src_col[ii] - (double)(ii / 3)) < 1e-12);
+	}
+
+	build_deform_map(o_src_row,o_src_col,3,4,2,1.5,2,0.5,0,0,NULL,NULL);
+
+	for (ii = 0; ii < 12; ii++) {
+	    assert(fabs(o_src_row[ii] - (2 + ((double)(ii % 3) - 1) / 2)) < 1e-12);
+	    assert(fabs(o_src_col[ii] - (1.5 + ((double)(ii / 3) - 1.5) * 2)) < 1e-12);
+	}
+
+	build_deform_map(o_src_row,o_src_col,3,3,1,1,1,1,M_PI / 2,0,NULL,NULL);
+
+	assert(fabs(o_src_row[0] - 2) < 1e-12);
+	assert(fabs(o_src_col[0] - 0) < 1e-12);
+	assert(fabs(o_src_row[4] - 1) < 1e-12);
+	assert(fabs(o_src_col[4] - 1) < 1e-12);
+
+	for (ii = 0; ii < 12; ii++) {
+	    field_row[ii] = 0.5;
+	    field_col[ii] = -1;
+	}
+
+	build_deform_map(o_src_row,o_src_col,3,4,1,1.5,1,1,0,0.5,field_row,field_col);
+
+	for (ii = 0; ii < 12; ii++) {
+	    assert(fabs(o_src_row[ii] - ((double)(ii % 3) + 0.25)) < 1e-12);
+	    assert(fabs(o_src_col[ii] - ((double)(ii / 3) - 0.5)) < 1e-12);
+	}
+    }
+
+    printf("  Function \"bilinear_resample\".\n");
+
+    {
+	double  image[] = {1,2,3,4,5,6,7,8,9,10,11,12};
+	double  src_row[6];
+	double  src_col[6];
+	double  o_image[12];
+	size_t  ii;
+
+	for (ii = 0; ii < 6; ii++) {
+	    src_row[ii] = (double)(ii % 2);
+	    src_col[ii] = (double)(ii / 2);
+	}
+
+	bilinear_resample(o_image,2,3,2,src_row,src_col,image);
+
+	for (ii = 0; ii < 12; ii++) {
+	    assert(o_image[ii] == image[ii]);
+	}
+
+	src_row[0] = 0.5;
+	src_col[0] = 0.5;
+	src_row[1] = 1;
+	src_col[1] = 1.25;
+	src_row[2] = -0.1;
+	src_col[2] = 0;
+	src_row[3] = 0;
+	src_col[3] = 2.1;
+
+	bilinear_resample(o_image,2,3,2,src_row,src_col,image);
+
+	assert(fabs(o_image[0] - 2.5) < 1e-12);
+	assert(fabs(o_image[1] - 4.5) < 1e-12);
+	assert(o_image[2] == 0);
+	assert(o_image[3] == 0);
+	assert(fabs(o_image[6] - 8.5) < 1e-12);
+	assert(fabs(o_image[7] - 10.5) < 1e-12);
+	assert(o_image[8] == 0);
+	assert(o_image[9] == 0);
+    }
+
+    printf("  Function \"deform_image\".\n");
+
+    {
+	double  image[25];
+	double  o_image_1[25];
+	double  o_image_2[25];
+	double  o_image_3[25];
+	void*   tmps;
+	size_t  ii;
+
+	memset(image,0,25 * sizeof(double));
+	image[6] = 1;
+	image[7] = 2;
+	image[8] = 3;
+	image[12] = 4;
+	image[16] = 5;
+	image[18] = 6;
+	tmps = malloc(image_deform_tmps_length(5,5));
+
+	deform_image(o_image_1,5,5,1,1e-9,1e-9,0,0,7,0,image,tmps);
+
+	for (ii = 0; ii < 25; ii++) {
+	    assert(fabs(o_image_1[ii] - image[ii]) < 1e-6);
+	}
+
+	deform_image(o_image_1,5,5,1,10,15,2,1.5,7,3,image,tmps);
+	deform_image(o_image_2,5,5,1,10,15,2,1.5,7,3,image,tmps);
+	deform_image(o_image_3,5,5,1,10,15,2,1.5,7,4,image,tmps);
+
+	assert(memcmp(o_image_1,o_image_2,25 * sizeof(double)) == 0);
+	assert(memcmp(o_image_1,o_image_3,25 * sizeof(double)) != 0);
+
+	memset(image,0,25 * sizeof(double));
+
+	deform_image(o_image_1,5,5,1,10,15,2,1.5,7,3,image,tmps);
+
+	for (ii = 0; ii < 25; ii++) {
+	    assert(o_image_1[ii] == 0);
+	}
+
+	free(tmps);
+    }
+
+    printf("Testing \"dictionary_learn\".\n");
+
+    printf("  Function \"online_learn_tmps_length\".\n");
+
+    {
+	assert(online_learn_tmps_length(2,3) == 2 * sizeof(double));
+	assert(online_learn_tmps_length(81,1024) == 81 * sizeof(double));
+    }
+
+    printf("  Function \"ksvd_tmps_length\".\n");
+
+    {
+	assert(ksvd_tmps_length(2,3) == 2 * sizeof(double) + 3 * sizeof(double));
+	assert(ksvd_tmps_length(81,10000) == 81 * sizeof(double) + 10000 * sizeof(double));
+    }
+
+    printf("  Function \"draw_batch\".\n");
+
+    {
+	size_t  o_batch_idx_1[64];
+	size_t  o_batch_idx_2[64];
+	size_t  o_batch_idx_3[64];
+	size_t  ii;
+
+	draw_batch(o_batch_idx_1,7,0,64,10);
+	draw_batch(o_batch_idx_2,7,0,64,10);
+	draw_batch(o_batch_idx_3,7,1,64,10);
+
+	for (ii = 0; ii < 64; ii++) {
+	    assert(o_batch_idx_1[ii] < 10);
+	    assert(o_batch_idx_3[ii] < 10);
+	    assert(o_batch_idx_1[ii] == o_batch_idx_2[ii]);
+	}
+
+	assert(memcmp(o_batch_idx_1,o_batch_idx_3,64 * sizeof(size_t)) != 0);
+    }
+
+    printf("  Function \"code_residual\".\n");
+
+    {
+	double       dict_transp[] = {1,0,0,0,1,0,0,0,1};
+	double       observation[] = {3,-2,1};
+	double       coeffs[] = {3,1};
+	coeff_idx_t  coeffs_idx[] = {0,2};
+	double       o_residual[3];
+
+	code_residual(o_residual,3,dict_transp,2,coeffs,coeffs_idx,observation);
+
+	assert(o_residual[0] == 0);
+	assert(o_residual[1] == -2);
+	assert(o_residual[2] == 0);
+    }
+
+    printf("  Function \"reconstruction_error\".\n");
+
+    {
+	double       dict_transp[] = {1,0,0,0,1,0,0,0,1};
+	double       observation[] = {3,-2,1};
+	double       coeffs[] = {3,1};
+	coeff_idx_t  coeffs_idx[] = {0,2};
+	double       tmps[3];
+
+	assert(reconstruction_error(3,dict_transp,2,coeffs,coeffs_idx,observation,tmps) == 4);
+	assert(reconstruction_error(3,dict_transp,0,coeffs,coeffs_idx,observation,tmps) == 14);
+	assert(observation[0] == 3);
+    }
+
+    printf("  Function \"accumulate_statistics\".\n");
+
+    {
+	double       io_coeffs_outer[9];
+	double       io_sample_coeffs_outer[6];
+	double       observation[] = {1,2};
+	double       coeffs[] = {2,-1};
+	coeff_idx_t  coeffs_idx[] = {2,0};
+
+	memset(io_coeffs_outer,0,9 * sizeof(double));
+	memset(io_sample_coeffs_outer,0,6 * sizeof(double));
+
+	accumulate_statistics(io_coeffs_outer,io_sample_coeffs_outer,2,3,2,coeffs,coeffs_idx,observation);
+	accumulate_statistics(io_coeffs_outer,io_sample_coeffs_outer,2,3,1,coeffs,coeffs_idx,observation);
+
+	assert(io_coeffs_outer[0] == 1);
+	assert(io_coeffs_outer[1] == 0);
+	assert(io_coeffs_outer[2] == -2);
+	assert(io_coeffs_outer[4] == 0);
+	assert(io_coeffs_outer[6] == -2);
+	assert(io_coeffs_outer[8] == 8);
+	assert(io_sample_coeffs_outer[0] == -1);
+	assert(io_sample_coeffs_outer[1] == -2);
+	assert(io_sample_coeffs_outer[2] == 0);
+	assert(io_sample_coeffs_outer[3] == 0);
+	assert(io_sample_coeffs_outer[4] == 4);
+	assert(io_sample_coeffs_outer[5] == 8);
+    }
+
+    printf("  Function \"update_dictionary_bcd\".\n");
+
+    {
+	double  io_dict_transp[] = {1,0,0,1};
+	double  coeffs_outer[] = {1,0,0,1};
+	double  sample_coeffs_outer[] = {1,0,0,1};
+	double  unused_coeffs_outer[] = {2,0,0,0};
+	double  moved_sample_coeffs_outer[] = {0,2,0,0};
+	double  tmps[2];
+
+	update_dictionary_bcd(io_dict_transp,2,2,coeffs_outer,sample_coeffs_outer,tmps);
+
+	assert(fabs(io_dict_transp[0] - 1) < 1e-12);
+	assert(fabs(io_dict_transp[1] - 0) < 1e-12);
+	assert(fabs(io_dict_transp[2] - 0) < 1e-12);
+	assert(fabs(io_dict_transp[3] - 1) < 1e-12);
+
+	update_dictionary_bcd(io_dict_transp,2,2,unused_coeffs_outer,moved_sample_coeffs_outer,tmps);
+
+	assert(fabs(io_dict_transp[0] - 0) < 1e-12);
+	assert(fabs(io_dict_transp[1] - 1) < 1e-12);
+	assert(io_dict_transp[2] == 0);
+	assert(io_dict_transp[3] == 1);
+    }
+
+    printf("  Function \"neural_gas_step\".\n");
+
+    {
+	double                   dict[] = {1,0,0,1};
+	char*                    storage;
+	struct dictionary_state  state;
+	double                   coeffs[] = {0.5,1};
+	coeff_idx_t              coeffs_idx[] = {0,1};
+	double                   observation[] = {1,1};
+
+	storage = malloc(dictionary_state_length(2,2));
+
+	dictionary_state_init(&state,2,2,dict,storage);
+	neural_gas_step(&state,2,coeffs,coeffs_idx,1,1,observation);
+
+	assert(coeffs[0] == 1);
+	assert(coeffs_idx[0] == 1);
+	assert(coeffs[1] == 0.5);
+	assert(coeffs_idx[1] == 0);
+	assert(state.stale_count == 2);
+	assert(fabs(state.dict_transp[0] - 0.997864803) < 1e-8);
+	assert(fabs(state.dict_transp[1] - 0.065313357) < 1e-8);
+	assert(fabs(state.dict_transp[2] - 0.345257762) < 1e-8);
+	assert(fabs(state.dict_transp[3] - 0.938507900) < 1e-8);
+
+	dictionary_state_sync(&state);
+
+	assert(state.dict[0] == state.dict_transp[0]);
+	assert(state.dict[1] == state.dict_transp[2]);
+	assert(state.dict[2] == state.dict_transp[1]);
+	assert(state.dict[3] == state.dict_transp[3]);
+	assert(fabs(state.dict_x_dict_transp[0] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[1] - 0.405817670) < 1e-8);
+	assert(fabs(state.dict_x_dict_transp[2] - 0.405817670) < 1e-8);
+	assert(fabs(state.dict_x_dict_transp[3] - 1) < 1e-12);
+
+	free(storage);
+    }
+
+    {
+	double                   dict[] = {1,0,0,1};
+	char*                    storage;
+	struct dictionary_state  state;
+	double                   coeffs[] = {0,0};
+	coeff_idx_t              coeffs_idx[] = {0,1};
+	double                   observation[] = {1,1};
+
+	storage = malloc(dictionary_state_length(2,2));
+
+	dictionary_state_init(&state,2,2,dict,storage);
+	neural_gas_step(&state,2,coeffs,coeffs_idx,1,1,observation);
+
+	assert(state.stale_count == 0);
+	assert(state.dict_transp[0] == 1);
+	assert(state.dict_transp[1] == 0);
+	assert(state.dict_transp[2] == 0);
+	assert(state.dict_transp[3] == 1);
+
+	free(storage);
+    }
+
+    printf("  Function \"build_atom_usage\".\n");
+
+    {
+	double       coeffs[] = {1,2,0,3,4,5};
+	coeff_idx_t  coeffs_idx[] = {0,2,1,0,2,1};
+	size_t       o_usage_offsets[4];
+	size_t       o_usage_members[6];
+
+	build_atom_usage(o_usage_offsets,o_usage_members,3,3,2,coeffs,coeffs_idx);
+
+	assert(o_usage_offsets[0] == 0);
+	assert(o_usage_offsets[1] == 2);
+	assert(o_usage_offsets[2] == 3);
+	assert(o_usage_offsets[3] == 5);
+	assert(o_usage_members[0] == 0);
+	assert(o_usage_members[1] == 3);
+	assert(o_usage_members[2] == 5);
+	assert(o_usage_members[3] == 1);
+	assert(o_usage_members[4] == 4);
+    }
+
+    printf("  Function \"ksvd_update_atom\".\n");
+
+    {
+	double  dict_transp[] = {1,0,0,1};
+	double  residuals[] = {0,1,0,2};
+	double  coeffs[] = {2,3};
+	size_t  usage_members[] = {0,1};
+	char*   tmps;
+
+	tmps = malloc(ksvd_tmps_length(2,2));
+
+	ksvd_update_atom(dict_transp,residuals,coeffs,2,1,0,2,usage_members,20,tmps);
+
+	assert(fabs(dict_transp[0] - 0.850650808) < 1e-8);
+	assert(fabs(dict_transp[1] - 0.525731112) < 1e-8);
+	assert(dict_transp[2] == 0);
+	assert(dict_transp[3] == 1);
+	assert(fabs(coeffs[0] - 2.227032729) < 1e-8);
+	assert(fabs(coeffs[1] - 3.603414649) < 1e-8);
+	assert(fabs(residuals[0] - 0.105572809) < 1e-8);
+	assert(fabs(residuals[1] - (-0.170820393)) < 1e-8);
+	assert(fabs(residuals[2] - (-0.065247584)) < 1e-8);
+	assert(fabs(residuals[3] - 0.105572809) < 1e-8);
+
+	free(tmps);
+    }
+
+    {
+	double  dict_transp[] = {1,0,0,1};
+	double  residuals[] = {0,1,0,2};
+	double  coeffs[] = {2,3};
+	size_t  usage_members[] = {0,1};
+	char*   tmps;
+
+	tmps = malloc(ksvd_tmps_length(2,2));
+
+	ksvd_update_atom(dict_transp,residuals,coeffs,2,1,1,0,usage_members,20,tmps);
+
+	assert(dict_transp[0] == 1);
+	assert(dict_transp[1] == 0);
+	assert(dict_transp[2] == 0);
+	assert(dict_transp[3] == 1);
+	assert(coeffs[0] == 2);
+	assert(coeffs[1] == 3);
+	assert(residuals[1] == 1);
+	assert(residuals[3] == 2);
+
+	free(tmps);
+    }
+
+    printf("Testing \"dictionary_state\".\n");
+
+    printf("  Function \"dictionary_state_init\".\n");
+
+    {
+	double                   dict[] = {1,0.6,0,0.8,0,0};
+	char*                    storage;
+	struct dictionary_state  state;
+
+	storage = malloc(dictionary_state_length(3,2));
+
+	dictionary_state_init(&state,3,2,dict,storage);
+
+	assert(state.geometry == 3);
+	assert(state.word_count == 2);
+	assert(state.stale_count == 0);
+	assert(!state.stale[0]);
+	assert(!state.stale[1]);
+	assert(state.dict[0] == 1);
+	assert(state.dict[1] == 0.6);
+	assert(state.dict[2] == 0);
+	assert(state.dict[3] == 0.8);
+	assert(state.dict[4] == 0);
+	assert(state.dict[5] == 0);
+	assert(state.dict_transp[0] == 1);
+	assert(state.dict_transp[1] == 0);
+	assert(state.dict_transp[2] == 0);
+	assert(state.dict_transp[3] == 0.6);
+	assert(state.dict_transp[4] == 0.8);
+	assert(state.dict_transp[5] == 0);
+	assert(fabs(state.dict_x_dict_transp[0] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[1] - 0.6) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[2] - 0.6) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[3] - 1) < 1e-12);
+	assert(((char*)state.dict_transp - storage) % DICTIONARY_STATE_ALIGNMENT == 0);
+	assert(((char*)state.dict_x_dict_transp - storage) % DICTIONARY_STATE_ALIGNMENT == 0);
+	assert(((char*)state.stale_idx - storage) % DICTIONARY_STATE_ALIGNMENT == 0);
+
+	free(storage);
+    }
+
+    printf("  Function \"dictionary_state_touch_atom\".\n");
+
+    {
+	double                   dict[] = {1,0,0,0,1,0};
+	char*                    storage;
+	struct dictionary_state  state;
+
+	storage = malloc(dictionary_state_length(2,3));
+
+	dictionary_state_init(&state,2,3,dict,storage);
+	dictionary_state_touch_atom(&state,2);
+	dictionary_state_touch_atom(&state,0);
+	dictionary_state_touch_atom(&state,2);
+
+	assert(state.stale_count == 2);
+	assert(state.stale_idx[0] == 2);
+	assert(state.stale_idx[1] == 0);
+	assert(state.stale[0]);
+	assert(!state.stale[1]);
+	assert(state.stale[2]);
+
+	free(storage);
+    }
+
+    printf("  Function \"dictionary_state_touch_all\".\n");
+
+    {
+	double                   dict[] = {1,0,0,0,1,0};
+	char*                    storage;
+	struct dictionary_state  state;
+
+	storage = malloc(dictionary_state_length(2,3));
+
+	dictionary_state_init(&state,2,3,dict,storage);
+	dictionary_state_touch_atom(&state,1);
+	dictionary_state_touch_all(&state);
+
+	assert(state.stale_count == 3);
+	assert(state.stale_idx[0] == 0);
+	assert(state.stale_idx[1] == 1);
+	assert(state.stale_idx[2] == 2);
+	assert(state.stale[0]);
+	assert(state.stale[1]);
+	assert(state.stale[2]);
+
+	free(storage);
+    }
+
+    printf("  Function \"dictionary_state_sync\".\n");
+
+    {
+	double                   dict[] = {1,0,0,0,0,1,0,0,0,0,1,0};
+	char*                    storage;
+	struct dictionary_state  state;
+
+	storage = malloc(dictionary_state_length(3,4));
+
+	dictionary_state_init(&state,3,4,dict,storage);
+
+	state.dict_transp[9] = 0.6;
+	state.dict_transp[10] = 0.8;
+	state.dict_transp[11] = 0;
+	dictionary_state_touch_atom(&state,3);
+	dictionary_state_sync(&state);
+
+	assert(state.stale_count == 0);
+	assert(!state.stale[3]);
+	assert(state.dict[3] == 0.6);
+	assert(state.dict[7] == 0.8);
+	assert(state.dict[11] == 0);
+	assert(fabs(state.dict_x_dict_transp[3] - 0.6) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[7] - 0.8) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[11] - 0) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[12] - 0.6) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[13] - 0.8) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[14] - 0) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[15] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[0] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[1] - 0) < 1e-12);
+
+	free(storage);
+    }
+
+    {
+	double                   dict[] = {1,0,0,0,0,1,0,0,0,0,1,0};
+	char*                    storage;
+	struct dictionary_state  state;
+
+	storage = malloc(dictionary_state_length(3,4));
+
+	dictionary_state_init(&state,3,4,dict,storage);
+
+	state.dict_transp[0] = 0;
+	state.dict_transp[1] = 1;
+	state.dict_transp[9] = 0.6;
+	state.dict_transp[10] = 0.8;
+	dictionary_state_touch_atom(&state,0);
+	dictionary_state_touch_atom(&state,3);
+	dictionary_state_sync(&state);
+
+	assert(state.stale_count == 0);
+	assert(state.dict[0] == 0);
+	assert(state.dict[4] == 1);
+	assert(fabs(state.dict_x_dict_transp[1] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[3] - 0.8) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[4] - 1) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[12] - 0.8) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[13] - 0.8) < 1e-12);
+	assert(fabs(state.dict_x_dict_transp[7] - 0.8) < 1e-12);
+
+	free(storage);
+    }
+
+    printf("Testing \"dataset_file\".\n");
+
+    printf("  Function \"dataset_file_header_init\".\n");
+
+    {
+	struct dataset_file_header  header;
+
+	dataset_file_header_init(&header,KIND_IMAGE,DTYPE_FLOAT32,3,2,1,5,true,4);
+
+	assert(header.magic == DATASET_FILE_MAGIC);
+	assert(header.kind == KIND_IMAGE);
+	assert(header.dtype == DTYPE_FLOAT32);
+	assert(header.count == 5);
+	assert(header.data_offset == DATASET_FILE_ALIGNMENT);
+	assert(header.labels_offset == DATASET_FILE_ALIGNMENT + 120);
+	assert(header.label_names_offset == DATASET_FILE_ALIGNMENT + 140);
+	assert(header.file_length == DATASET_FILE_ALIGNMENT + 144);
+    }
+
+    {
+	struct dataset_file_header  header;
+
+	dataset_file_header_init(&header,KIND_RECORD,DTYPE_UINT8,3,1,1,3,false,4);
+
+	assert(header.has_labels == 0);
+	assert(header.label_names_length == 0);
+	assert(header.labels_offset == DATASET_FILE_ALIGNMENT + 16);
+	assert(header.file_length == DATASET_FILE_ALIGNMENT + 16);
+    }
+
+    printf("  Function \"dataset_file_write\" and \"dataset_file_open\".\n");
+
+    {
+	char                        path[64];
+	double                      sample[] = {1,2,3,4,5,6,7,8,9,10,11,12};
+	uint32_t                    labels_idx[] = {1,2,1};
+	struct dataset_file_header  header;
+	struct dataset_file         file;
+	bool                        ok;
+
+	snprintf(path,64,"/tmp/xtern_test_dataset_%d",(int)getpid());
+	dataset_file_header_init(&header,KIND_IMAGE,DTYPE_FLOAT64,2,2,1,3,true,5);
+
+	ok = dataset_file_write(path,&header,sample,labels_idx,"a\nbb\n");
+	assert(ok);
+
+	ok = dataset_file_open(&file,path);
+	assert(ok);
+	assert(file.header.kind == KIND_IMAGE);
+	assert(file.geometry == 4);
+	assert(file.observation_length == 4 * sizeof(double));
+	assert(file.header.count == 3);
+	assert(((const double*)dataset_file_observation(&file,0))[0] == 1);
+	assert(((const double*)dataset_file_observation(&file,2))[3] == 12);
+	assert(file.labels_idx[1] == 2);
+	assert(memcmp(file.label_names,"a\nbb\n",5) == 0);
+
+	dataset_file_close(&file);
+	assert(file.map == NULL);
+
+	unlink(path);
+    }
+
+    {
+	char                        path[64];
+	double                      sample[] = {0,1.5,255,3};
+	struct dataset_file_header  header;
+	struct dataset_file         file;
+	bool                        ok;
+
+	snprintf(path,64,"/tmp/xtern_test_dataset_%d",(int)getpid());
+	dataset_file_header_init(&header,KIND_RECORD,DTYPE_UINT8,2,1,1,2,false,0);
+
+	ok = dataset_file_write(path,&header,sample,NULL,NULL);
+	assert(ok);
+
+	ok = dataset_file_open(&file,path);
+	assert(ok);
+	assert(file.labels_idx == NULL);
+	assert(file.label_names == NULL);
+	assert(((const uint8_t*)dataset_file_observation(&file,1))[0] == 255);
+	assert(((const uint8_t*)dataset_file_observation(&file,1))[1] == 3);
+
+	dataset_file_close(&file);
+
+	unlink(path);
+    }
+
+    {
+	char                        path[64];
+	double                      sample[] = {1,2};
+	struct dataset_file_header  header;
+	struct dataset_file         file;
+	FILE*                       raw;
+	bool                        ok;
+
+	snprintf(path,64,"/tmp/xtern_test_dataset_%d",(int)getpid());
+	dataset_file_header_init(&header,KIND_RECORD,DTYPE_FLOAT64,2,1,1,1,false,0);
+	header.magic = 0;
+
+	ok = dataset_file_write(path,&header,sample,NULL,NULL);
+	assert(ok);
+	ok = dataset_file_open(&file,path);
+	assert(!ok);
+
+	header.magic = DATASET_FILE_MAGIC;
+	ok = dataset_file_write(path,&header,sample,NULL,NULL);
+	assert(ok);
+	raw = fopen(path,"ab");
+	fputc(0,raw);
+	fclose(raw);
+	ok = dataset_file_open(&file,path);
+	assert(!ok);
+
+	unlink(path);
+
+	ok = dataset_file_open(&file,path);
+	assert(!ok);
+    }
+
+    printf("  Function \"dataset_convert\".\n");
+
+    {
+	float    values_f[] = {1.5f,-2.0f,0.25f};
+	uint8_t  values_u[] = {0,128,255};
+	double   o_values[3];
+
+	dataset_convert(o_values,DTYPE_FLOAT32,3,values_f);
+
+	assert(o_values[0] == 1.5);
+	assert(o_values[1] == -2);
+	assert(o_values[2] == 0.25);
+
+	dataset_convert(o_values,DTYPE_UINT8,3,values_u);
+
+	assert(o_values[0] == 0);
+	assert(o_values[1] == 128);
+	assert(o_values[2] == 255);
+    }
+
+    printf("  Function \"dataset_file_read_chunk\".\n");
+
+    {
+	char                        path[64];
+	double                      sample[] = {1,2,3,4,5,6,7,8,9,10};
+	double                      o_chunk[6];
+	struct dataset_file_header  header;
+	struct dataset_file         file;
+	size_t                      count;
+	bool                        ok;
+
+	snprintf(path,64,"/tmp/xtern_test_dataset_%d",(int)getpid());
+	dataset_file_header_init(&header,KIND_RECORD,DTYPE_FLOAT32,2,1,1,5,false,0);
+
+	ok = dataset_file_write(path,&header,sample,NULL,NULL);
+	assert(ok);
+	ok = dataset_file_open(&file,path);
+	assert(ok);
+
+	count = dataset_file_read_chunk(o_chunk,&file,0,3);
+
+	assert(count == 3);
+	assert(o_chunk[0] == 1);
+	assert(o_chunk[5] == 6);
+
+	count = dataset_file_read_chunk(o_chunk,&file,3,3);
+
+	assert(count == 2);
+	assert(o_chunk[0] == 7);
+	assert(o_chunk[3] == 10);
+
+	count = dataset_file_read_chunk(o_chunk,&file,5,3);
+
+	assert(count == 0);
+
+	dataset_file_close(&file);
+
+	unlink(path);
+    }
+
+    printf("Testing \"csc_file\".\n");
+
+    printf("  Function \"csc_varint_delta_encode\" and \"csc_varint_delta_decode\".\n");
+
+    {
+	size_t   idx[] = {0,3,130,131,20000};
+	uint8_t  bytes[64];
+	size_t   o_idx[5];
+	size_t   length;
+
+	length = csc_varint_delta_encode(bytes,5,idx);
+
+	assert(length == 7);
+	assert(bytes[0] == 0);
+	assert(bytes[1] == 3);
+	assert(bytes[2] == 127);
+	assert(bytes[3] == 1);
+	assert(bytes[4] == 0x9d);
+	assert(bytes[5] == 0x9b);
+	assert(bytes[6] == 0x01);
+
+	csc_varint_delta_decode(o_idx,5,bytes);
+
+	assert(memcmp(o_idx,idx,5 * sizeof(size_t)) == 0);
+    }
+
+    {
+	assert(csc_varint_delta_encode(NULL,0,NULL) == 0);
+	assert(csc_varint_delta_max_length(3) >= 3 * sizeof(size_t));
+    }
+
+    printf("  Function \"csc_value_length\".\n");
+
+    {
+	assert(csc_value_length(VALUE_FLOAT64,5) == 5 * sizeof(double));
+	assert(csc_value_length(VALUE_FLOAT16,5) == 5 * sizeof(uint16_t));
+	assert(csc_value_length(VALUE_INT8,5) == sizeof(double) + 5);
+	assert(csc_value_length(VALUE_INT8,0) == 0);
+	assert(csc_value_length(VALUE_CODEBOOK,5) == 5);
+    }
+
+    printf("  Function \"csc_float16_encode\" and \"csc_float16_decode\".\n");
+
+    {
+	double    values[] = {0,1,-2,0.5,65504,1e6,-1e6,5.960464477539063e-8,1e-9,1 + 1.0 / 4096,1 + 3.0 / 4096,0.1};
+	uint8_t   bytes[12 * sizeof(uint16_t)];
+	double    o_values[12];
+	uint16_t  half;
+
+	csc_float16_encode(bytes,12,values);
+
+	memcpy(&half,bytes + 1 * sizeof(uint16_t),sizeof(uint16_t));
+	assert(half == 0x3c00);
+	memcpy(&half,bytes + 2 * sizeof(uint16_t),sizeof(uint16_t));
+	assert(half == 0xc000);
+
+	csc_float16_decode(o_values,12,bytes);
+
+	assert(o_values[0] == 0);
+	assert(o_values[1] == 1);
+	assert(o_values[2] == -2);
+	assert(o_values[3] == 0.5);
+	assert(o_values[4] == 65504);
+	assert(o_values[5] == HUGE_VAL);
+	assert(o_values[6] == -HUGE_VAL);
+	assert(o_values[7] == 5.960464477539063e-8);
+	assert(o_values[8] == 0);
+	assert(o_values[9] == 1);
+	assert(o_values[10] == 1 + 4.0 / 4096);
+	assert(fabs(o_values[11] - 0.1) < 1e-4);
+    }
+
+    printf("  Function \"csc_int8_encode\" and \"csc_int8_decode\".\n");
+
+    {
+	double   values[] = {1,-2,0.5,2.54,0};
+	uint8_t  bytes[sizeof(double) + 5];
+	double   o_values[5];
+	size_t   ii;
+
+	csc_int8_encode(bytes,5,values);
+	csc_int8_decode(o_values,5,bytes);
+
+	for (ii = 0; ii < 5; ii++) {
+	    assert(fabs(o_values[ii] - values[ii]) <= 2.54 / 127 / 2);
+	}
+
+	assert(o_values[4] == 0);
+    }
+
+    {
+	double   values[] = {0,0};
+	uint8_t  bytes[sizeof(double) + 2];
+	double   o_values[2];
+
+	csc_int8_encode(bytes,2,values);
+	csc_int8_decode(o_values,2,bytes);
+
+	assert(o_values[0] == 0);
+	assert(o_values[1] == 0);
+    }
+
+    printf("  Function \"csc_codebook_encode\" and \"csc_codebook_decode\".\n");
+
+    {
+	double   values[] = {0.25,0.25,-1,0.25,3};
+	double   codebook[CSC_CODEBOOK_MAX_COUNT];
+	size_t   codebook_count;
+	uint8_t  bytes[5];
+	double   o_values[5];
+
+	codebook_count = 0;
+
+	assert(csc_codebook_encode(bytes,codebook,&codebook_count,5,values));
+	assert(codebook_count == 3);
+	assert(bytes[0] == 0);
+	assert(bytes[1] == 0);
+	assert(bytes[2] == 1);
+	assert(bytes[3] == 0);
+	assert(bytes[4] == 2);
+	assert(csc_codebook_encode(bytes,codebook,&codebook_count,2,values + 3));
+	assert(codebook_count == 3);
+
+	csc_codebook_decode(o_values,5,codebook,bytes);
+
+	assert(o_values[0] == 0.25);
+	assert(o_values[1] == 3);
+    }
+
+    {
+	double   values[CSC_CODEBOOK_MAX_COUNT + 1];
+	double   codebook[CSC_CODEBOOK_MAX_COUNT];
+	size_t   codebook_count;
+	uint8_t  bytes[CSC_CODEBOOK_MAX_COUNT + 1];
+	size_t   ii;
+
+	for (ii = 0; ii < CSC_CODEBOOK_MAX_COUNT + 1; ii++) {
+	    values[ii] = (double)ii;
+	}
+
+	codebook_count = 0;
+
+	assert(csc_codebook_encode(bytes,codebook,&codebook_count,CSC_CODEBOOK_MAX_COUNT,values));
+	assert(codebook_count == CSC_CODEBOOK_MAX_COUNT);
+	assert(bytes[CSC_CODEBOOK_MAX_COUNT - 1] == CSC_CODEBOOK_MAX_COUNT - 1);
+	assert(!csc_codebook_encode(bytes,codebook,&codebook_count,1,values + CSC_CODEBOOK_MAX_COUNT));
+    }
+
+    printf("  Function \"csc_file_writer_append\" and \"csc_file_read_chunk\".\n");
+
+    {
+	enum csc_index_encoding  encodings[] = {INDEX_RAW,INDEX_VARINT_DELTA,INDEX_VARINT_DELTA,INDEX_RAW};
+	enum csc_value_encoding  value_encodings[] = {VALUE_FLOAT64,VALUE_FLOAT64,VALUE_FLOAT16,VALUE_CODEBOOK};
+	char                     path[64];
+	double                   pr_1[] = {1,2,3};
+	size_t                   ir_1[] = {0,4,1};
+	size_t                   jc_1[] = {0,2,2,3};
+	double                   pr_2[] = {4,5,6};
+	size_t                   ir_2[] = {2,3,300};
+	size_t                   jc_2[] = {5,8};
+	struct csc_file_writer   writer;
+	struct csc_file          file;
+	double                   o_pr[6];
+	size_t                   o_ir[6];
+	size_t                   o_jc[5];
+	size_t                   count;
+	bool                     ok;
+	size_t                   ii;
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	for (ii = 0; ii < 4; ii++) {
+	    ok = csc_file_writer_open(&writer,path,400,encodings[ii],value_encodings[ii]);
+	    assert(ok);
+	    ok = csc_file_writer_append(&writer,3,pr_1,ir_1,jc_1);
+	    assert(ok);
+	    ok = csc_file_writer_append(&writer,1,pr_2,ir_2,jc_2);
+	    assert(ok);
+	    ok = csc_file_writer_close(&writer);
+	    assert(ok);
+
+	    ok = csc_file_open(&file,path);
+	    assert(ok);
+	    assert(file.header.row_count == 400);
+	    assert(file.header.col_count == 4);
+	    assert(file.header.nnz == 6);
+	    assert(file.header.index_encoding == encodings[ii]);
+	    assert(file.header.value_encoding == value_encodings[ii]);
+	    assert(file.header.codebook_count == (value_encodings[ii] == VALUE_CODEBOOK ? 6 : 0));
+	    assert(csc_file_chunk_nnz(&file,0,4) == 6);
+	    assert(csc_file_chunk_nnz(&file,1,2) == 1);
+	    assert(csc_file_chunk_nnz(&file,3,5) == 3);
+
+	    count = csc_file_read_chunk(o_pr,o_ir,o_jc,&file,0,10);
+
+	    assert(count == 4);
+	    assert(o_jc[0] == 0);
+	    assert(o_jc[1] == 2);
+	    assert(o_jc[2] == 2);
+	    assert(o_jc[3] == 3);
+	    assert(o_jc[4] == 6);
+	    assert(o_pr[0] == 1);
+	    assert(o_pr[5] == 6);
+	    assert(o_ir[1] == 4);
+	    assert(o_ir[2] == 1);
+	    assert(o_ir[5] == 300);
+
+	    count = csc_file_read_chunk(o_pr,o_ir,o_jc,&file,2,2);
+
+	    assert(count == 2);
+	    assert(o_jc[0] == 0);
+	    assert(o_jc[1] == 1);
+	    assert(o_jc[2] == 4);
+	    assert(o_pr[0] == 3);
+	    assert(o_ir[0] == 1);
+	    assert(o_ir[3] == 300);
+
+	    count = csc_file_read_chunk(o_pr,o_ir,o_jc,&file,4,2);
+
+	    assert(count == 0);
+	    assert(o_jc[0] == 0);
+
+	    csc_file_close(&file);
+	}
+
+	unlink(path);
+    }
+
+    {
+	char                    path[64];
+	double                  pr[] = {1};
+	size_t                  ir[] = {0};
+	size_t                  jc[] = {0,1};
+	struct csc_file_writer  writer;
+	struct csc_file         file;
+	bool                    ok;
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	ok = csc_file_writer_open(&writer,path,1,INDEX_RAW,VALUE_FLOAT64);
+	assert(ok);
+	ok = csc_file_writer_append(&writer,1,pr,ir,jc);
+	assert(ok);
+	fflush(writer.file);
+
+	ok = csc_file_open(&file,path);
+	assert(!ok);
+
+	ok = csc_file_writer_close(&writer);
+	assert(ok);
+	ok = csc_file_open(&file,path);
+	assert(ok);
+	assert(((uintptr_t)file.col_offsets) % sizeof(uint64_t) == 0);
+
+	csc_file_close(&file);
+	unlink(path);
+    }
+
+    {
+	char                    path[64];
+	struct csc_file_header  header;
+	uint32_t                col_nnz;
+	double                  value;
+	uint32_t                index_length;
+	uint32_t                idx;
+	uint32_t                padding;
+	uint64_t                col_offsets[2];
+	FILE*                   file_handle;
+	struct csc_file         file;
+	double                  o_pr[1];
+	size_t                  o_ir[1];
+	size_t                  o_jc[2];
+	bool                    ok;
+
+	/* A version 1 file, with the shorter header and double values. */
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	memset(&header,0,sizeof(struct csc_file_header));
+	header.magic = CSC_FILE_MAGIC;
+	header.version = 1;
+	header.index_encoding = INDEX_RAW;
+	header.row_count = 3;
+	header.col_count = 1;
+	header.nnz = 1;
+	header.col_offsets_offset = CSC_FILE_V1_HEADER_LENGTH + 24;
+	header.file_length = CSC_FILE_V1_HEADER_LENGTH + 24 + 2 * sizeof(uint64_t);
+	col_nnz = 1;
+	value = 7;
+	index_length = sizeof(uint32_t);
+	idx = 2;
+	padding = 0;
+	col_offsets[0] = CSC_FILE_V1_HEADER_LENGTH;
+	col_offsets[1] = CSC_FILE_V1_HEADER_LENGTH + 20;
+
+	file_handle = fopen(path,"wb");
+	fwrite(&header,CSC_FILE_V1_HEADER_LENGTH,1,file_handle);
+	fwrite(&col_nnz,sizeof(uint32_t),1,file_handle);
+	fwrite(&value,sizeof(double),1,file_handle);
+	fwrite(&index_length,sizeof(uint32_t),1,file_handle);
+	fwrite(&idx,sizeof(uint32_t),1,file_handle);
+	fwrite(&padding,sizeof(uint32_t),1,file_handle);
+	fwrite(col_offsets,sizeof(uint64_t),2,file_handle);
+	fclose(file_handle);
+
+	ok = csc_file_open(&file,path);
+	assert(ok);
+	assert(file.header.value_encoding == VALUE_FLOAT64);
+	assert(file.header.codebook_count == 0);
+	assert(csc_file_read_chunk(o_pr,o_ir,o_jc,&file,0,1) == 1);
+	assert(o_pr[0] == 7);
+	assert(o_ir[0] == 2);
+	assert(o_jc[1] == 1);
+
+	csc_file_close(&file);
+	unlink(path);
+    }
+
+    {
+	char                    path[64];
+	double                  pr[] = {0.5,-0.25,0.5,0.5};
+	size_t                  ir[] = {0,3,1,2};
+	size_t                  jc[] = {0,2,4};
+	struct csc_file_writer  writer;
+	struct csc_file         file;
+	double                  o_pr[4];
+	size_t                  o_ir[4];
+	size_t                  o_jc[3];
+	bool                    ok;
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	ok = csc_file_writer_open(&writer,path,4,INDEX_VARINT_DELTA,VALUE_CODEBOOK);
+	assert(ok);
+	ok = csc_file_writer_append(&writer,2,pr,ir,jc);
+	assert(ok);
+	ok = csc_file_writer_close(&writer);
+	assert(ok);
+
+	ok = csc_file_open(&file,path);
+	assert(ok);
+	assert(file.header.codebook_count == 2);
+	assert(((uintptr_t)file.codebook) % sizeof(uint64_t) == 0);
+	assert(csc_file_read_chunk(o_pr,o_ir,o_jc,&file,0,2) == 2);
+	assert(memcmp(o_pr,pr,4 * sizeof(double)) == 0);
+	assert(memcmp(o_ir,ir,4 * sizeof(size_t)) == 0);
+
+	csc_file_close(&file);
+	unlink(path);
+    }
+
+    {
+	char                    path[64];
+	double                  pr[CSC_CODEBOOK_MAX_COUNT + 1];
+	size_t                  ir[CSC_CODEBOOK_MAX_COUNT + 1];
+	size_t                  jc[] = {0,CSC_CODEBOOK_MAX_COUNT + 1};
+	struct csc_file_writer  writer;
+	bool                    ok;
+	size_t                  ii;
+
+	for (ii = 0; ii < CSC_CODEBOOK_MAX_COUNT + 1; ii++) {
+	    pr[ii] = (double)ii + 1;
+	    ir[ii] = ii;
+	}
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	ok = csc_file_writer_open(&writer,path,CSC_CODEBOOK_MAX_COUNT + 1,INDEX_VARINT_DELTA,VALUE_CODEBOOK);
+	assert(ok);
+	assert(!writer.codebook_overflow);
+	ok = csc_file_writer_append(&writer,1,pr,ir,jc);
+	assert(!ok);
+	assert(writer.codebook_overflow);
+
+	csc_file_writer_close(&writer);
+	unlink(path);
+    }
+
+    {
+	char                    path[64];
+	double                  pr[] = {1,0.001,-0.5};
+	size_t                  ir[] = {0,3,7};
+	size_t                  jc[] = {0,3};
+	struct csc_file_writer  writer;
+	struct csc_file         file;
+	double                  o_pr[3];
+	size_t                  o_ir[3];
+	size_t                  o_jc[2];
+	bool                    ok;
+
+	snprintf(path,64,"/tmp/xtern_test_csc_%d",(int)getpid());
+
+	ok = csc_file_writer_open(&writer,path,8,INDEX_VARINT_DELTA,VALUE_INT8);
+	assert(ok);
+	ok = csc_file_writer_append(&writer,1,pr,ir,jc);
+	assert(ok);
+	ok = csc_file_writer_close(&writer);
+	assert(ok);
+
+	ok = csc_file_open(&file,path);
+	assert(ok);
+	assert(file.header.nnz == 3);
+	assert(csc_file_chunk_nnz(&file,0,1) == 3);
+	assert(csc_file_read_chunk(o_pr,o_ir,o_jc,&file,0,1) == 1);
+	assert(o_jc[0] == 0);
+	assert(o_jc[1] == 2);
+	assert(o_pr[0] == 1);
+	assert(fabs(o_pr[1] + 0.5) < 1.0 / 254);
+	assert(o_ir[0] == 0);
+	assert(o_ir[1] == 7);
+
+	csc_file_close(&file);
+	unlink(path);
+    }
+
+    printf("Testing \"hash\".\n");
+
+    printf("  Function \"hash_bytes\".\n");
+
+    {
+	double    values[] = {1,2,3,4};
+	double    other_values[] = {1,2,3,4.0000001};
+	uint64_t  hash;
+
+	hash = hash_bytes(0,4 * sizeof(double),values);
+
+	assert(hash == hash_bytes(0,4 * sizeof(double),values));
+	assert(hash != hash_bytes(1,4 * sizeof(double),values));
+	assert(hash != hash_bytes(0,3 * sizeof(double),values));
+	assert(hash != hash_bytes(0,4 * sizeof(double),other_values));
+	assert(hash_bytes(0,0,NULL) != hash_bytes(1,0,NULL));
+    }
+
+    {
+	char      text[] = "abcdefghijk";
+	uint64_t  hash;
+
+	hash = hash_bytes(0,11,text);
+
+	assert(hash != hash_bytes(0,10,text));
+	assert(hash != hash_bytes(0,11,"abcdefghijl"));
+	assert(hash_bytes(hash_bytes(0,3,"abc"),3,"def") != hash_bytes(hash_bytes(0,3,"abd"),3,"def"));
+    }
+
+    printf("  Function \"hash_to_string\".\n");
+
+    {
+	char  o_string[17];
+
+	hash_to_string(o_string,0x0123456789abcdefULL);
+
+	assert(strcmp(o_string,"0123456789abcdef") == 0);
+
+	hash_to_string(o_string,1);
+
+	assert(strcmp(o_string,"0000000000000001") == 0);
+    }
+
+    printf("Testing \"dictionary_handle\".\n");
+
+    printf("  Functions \"dictionary_handle_create\" and \"dictionary_handle_destroy\".\n");
+
+    {
+	double                     dict[] = {1,0.6,0,0.8,0,0};
+	struct dictionary_handle   not_handle;
+	struct dictionary_handle*  handle;
+	bool                       ok;
+
+	ok = dictionary_handle_create(&handle,3,2,dict);
+
+	assert(ok);
+	assert(handle->state.geometry == 3);
+	assert(handle->state.word_count == 2);
+	assert((size_t)handle->state.dict % DICTIONARY_STATE_ALIGNMENT == 0);
+	assert((size_t)handle->state.dict_transp % DICTIONARY_STATE_ALIGNMENT == 0);
+	assert((size_t)handle->state.dict_x_dict_transp % DICTIONARY_STATE_ALIGNMENT == 0);
+	assert(memcmp(handle->state.dict,dict,6 * sizeof(double)) == 0);
+	assert(handle->state.dict_transp[0] == 1);
+	assert(handle->state.dict_transp[1] == 0);
+	assert(handle->state.dict_transp[2] == 0);
+	assert(handle->state.dict_transp[3] == 0.6);
+	assert(handle->state.dict_transp[4] == 0.8);
+	assert(handle->state.dict_transp[5] == 0);
+	assert(fabs(handle->state.dict_x_dict_transp[0] - 1) < 1e-12);
+	assert(fabs(handle->state.dict_x_dict_transp[1] - 0.6) < 1e-12);
+	assert(fabs(handle->state.dict_x_dict_transp[2] - 0.6) < 1e-12);
+	assert(fabs(handle->state.dict_x_dict_transp[3] - 1) < 1e-12);
+
+	ok = dictionary_handle_destroy(handle);
+
+	assert(ok);
+
+	ok = dictionary_handle_destroy(&not_handle);
+
+	assert(!ok);
+    }
+
+    printf("  Functions \"dictionary_handle_to_id\" and \"dictionary_handle_from_id\".\n");
+
+    {
+	double                     dict[] = {1,0,0,1};
+	uint64_t                   not_handle[4] = {0,0,0,0};
+	struct dictionary_handle*  handle;
+	uint64_t                   id;
+
+	dictionary_handle_create(&handle,2,2,dict);
+	id = dictionary_handle_to_id(handle);
+
+	assert(id != 0);
+	assert(dictionary_handle_from_id(id) == handle);
+	assert(dictionary_handle_from_id(0) == NULL);
+	assert(dictionary_handle_from_id(id + 1) == NULL);
+	assert(dictionary_handle_from_id((uint64_t)(size_t)not_handle) == NULL);
+	assert(dictionary_handle_from_id(0xdeadbeef0ULL) == NULL);
+
+	dictionary_handle_destroy(handle);
+
+	assert(dictionary_handle_from_id(id) == NULL);
+    }
+
+    printf("Testing \"small_kernels\".\n");
+
+    printf("  Functions \"small_ddot\", \"small_daxpy\", \"small_dscal\" and \"small_dnrm2\".\n");
+
+    {
+	size_t  lengths[] = {3,64,81,121,600};
+	double  x[600];
+	double  y[600];
+	double  y_blas[600];
+	double  dot;
+	size_t  ii;
+	size_t  jj;
+
+	for (ii = 0; ii < 5; ii++) {
+	    for (jj = 0; jj < lengths[ii]; jj++) {
+		x[jj] = sin((double)jj + 1);
+		y[jj] = cos((double)jj + 1);
+		y_blas[jj] = y[jj];
+	    }
+
+	    dot = ddot((int)lengths[ii],x,1,y,1);
+
+	    assert(fabs(small_ddot(lengths[ii],x,y) - dot) < 1e-12);
+	    assert(fabs(small_dnrm2(lengths[ii],x) - dnrm2((int)lengths[ii],x,1)) < 1e-12);
+
+	    small_daxpy(lengths[ii],-0.5,x,y);
+	    daxpy((int)lengths[ii],-0.5,x,1,y_blas,1);
+	    small_dscal(lengths[ii],3,y);
+	    dscal((int)lengths[ii],3,y_blas,1);
+
+	    for (jj = 0; jj < lengths[ii]; jj++) {
+		assert(fabs(y[jj] - y_blas[jj]) < 1e-12);
+	    }
+	}
+    }
+
+    printf("  Functions \"small_dgemv_n\" and \"small_dgemv_t\".\n");
+
+    {
+	double  a[] = {1,2,3,4,5,6};
+	double  x_n[] = {1,-1};
+	double  x_t[] = {1,0,-1};
+	double  y_n[] = {1,1,1};
+	double  y_t[] = {1,1};
+
+	small_dgemv_n(3,2,2,a,x_n,1,y_n);
+	small_dgemv_t(3,2,1,a,x_t,0,y_t);
+
+	assert(y_n[0] == -5);
+	assert(y_n[1] == -5);
+	assert(y_n[2] == -5);
+	assert(y_t[0] == -2);
+	assert(y_t[1] == -2);
+    }
+
+    printf("  Function \"small_dtrsv\".\n");
+
+    {
+	double  upper[] = {2,0,1,4};
+	double  lower[] = {2,1,0,4};
+	double  x_u[] = {4,8};
+	double  x_ln[] = {2,9};
+	double  x_lt[] = {4,8};
+
+	small_dtrsv('U','N',2,upper,2,x_u);
+	small_dtrsv('L','N',2,lower,2,x_ln);
+	small_dtrsv('L','T',2,lower,2,x_lt);
+
+	assert(x_u[0] == 1);
+	assert(x_u[1] == 2);
+	assert(x_ln[0] == 1);
+	assert(x_ln[1] == 2);
+	assert(x_lt[0] == 1);
+	assert(x_lt[1] == 2);
     }
 
     printf("Testing \"task_control\".\n");
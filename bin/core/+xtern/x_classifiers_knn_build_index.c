@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "mex.h"
+
+#include "acml/acml.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "nn_index.h"
+
+enum output_decoder {
+    O_CENTROIDS     = 0,
+    O_LIST_OFFSETS  = 1,
+    O_LIST_MEMBERS  = 2,
+    O_SAMPLE_NORMS  = 3,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE             = 0,
+    I_INITIAL_CENTROIDS  = 1,
+    I_MAX_ITER_COUNT     = 2,
+    I_NUM_WORKERS        = 3,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t         geometry;
+    size_t         list_count;
+    const double*  centroids;
+    const double*  centroids_norms;
+};
+
+struct global_vars {
+    double*          sums;
+    size_t*          counts;
+    size_t           changed_count;
+    pthread_mutex_t  sums_control;
+};
+
+struct task_info {
+    size_t*        list_idx;
+    const double*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    struct global_vars*        global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*    tmps;
+    double*  local_sums;
+    size_t*  local_counts;
+    size_t   local_changed_count;
+    size_t   new_list_idx;
+    size_t   ii;
+
+    if (task_info_count == 0) {
+	return;
+    }
+
+    tmps = (char*)malloc(nearest_centroid_tmps_length(global_info->geometry,global_info->list_count));
+    local_sums = (double*)calloc(global_info->list_count * global_info->geometry,sizeof(double));
+    local_counts = (size_t*)calloc(global_info->list_count,sizeof(size_t));
+    local_changed_count = 0;
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	new_list_idx = nearest_centroid(global_info->geometry,global_info->list_count,global_info->centroids,global_info->centroids_norms,task_info[ii].observation,tmps);
+
+	if (new_list_idx != *task_info[ii].list_idx) {
+	    *task_info[ii].list_idx = new_list_idx;
+	    local_changed_count += 1;
+	}
+    }
+
+    /* Observations and their list indices are contiguous for the tasks of one worker. */
+
+    kmeans_accumulate(local_sums,local_counts,global_info->geometry,task_info_count,task_info[0].observation,task_info[0].list_idx);
+
+    pthread_mutex_lock(&global_vars->sums_control);
+    daxpy((int)(global_info->list_count * global_info->geometry),1,local_sums,1,global_vars->sums,1);
+    for (ii = 0; ii < global_info->list_count; ii++) {
+	global_vars->counts[ii] += local_counts[ii];
+    }
+    global_vars->changed_count += local_changed_count;
+    pthread_mutex_unlock(&global_vars->sums_control);
+
+    free(local_counts);
+    free(local_sums);
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t              geometry;
+    size_t              sample_count;
+    const double*       sample;
+    size_t              list_count;
+    size_t              max_iter_count;
+    size_t              num_workers;
+    double*             centroids;
+    double*             centroids_norms;
+    size_t*             list_idx;
+    size_t*             list_offsets;
+    size_t*             list_members;
+    double*             o_list_offsets;
+    double*             o_list_members;
+    struct global_info  global_info;
+    struct global_vars  global_vars;
+    struct task_info*   task_info;
+    int                 pthread_res;
+    size_t              iter;
+    size_t              ii;
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    list_count = mxGetN(input[I_INITIAL_CENTROIDS]);
+    max_iter_count = (size_t)mxGetScalar(input[I_MAX_ITER_COUNT]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    output[O_CENTROIDS] = mxDuplicateArray(input[I_INITIAL_CENTROIDS]);
+    centroids = mxGetPr(output[O_CENTROIDS]);
+    output[O_SAMPLE_NORMS] = mxCreateDoubleMatrix(1,sample_count,mxREAL);
+
+    /* Build task distribution information. */
+
+    centroids_norms = (double*)mxMalloc(list_count * sizeof(double));
+    list_idx = (size_t*)mxMalloc(sample_count * sizeof(size_t));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	list_idx[ii] = list_count;
+    }
+
+    global_info.geometry = geometry;
+    global_info.list_count = list_count;
+    global_info.centroids = centroids;
+    global_info.centroids_norms = centroids_norms;
+
+    global_vars.sums = (double*)mxMalloc(list_count * geometry * sizeof(double));
+    global_vars.counts = (size_t*)mxMalloc(list_count * sizeof(size_t));
+    pthread_res = pthread_mutex_init(&global_vars.sums_control,NULL);
+    check_condition(pthread_res == 0,"master:SystemError","Could not create sums mutex.");
+
+    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].list_idx = list_idx + ii;
+	task_info[ii].observation = sample + ii * geometry;
+    }
+
+    /* Run workers and compute output. Each round is one Lloyd iteration: assign in parallel, then move centroids. */
+
+    for (iter = 0; iter < max_iter_count; iter++) {
+	squared_norms(centroids_norms,geometry,list_count,centroids);
+	memset(global_vars.sums,0,list_count * geometry * sizeof(double));
+	memset(global_vars.counts,0,list_count * sizeof(size_t));
+	global_vars.changed_count = 0;
+
+	run_workers_x(&global_info,&global_vars,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+	/* Empty lists keep their previous centroid. */
+
+	for (ii = 0; ii < list_count; ii++) {
+	    if (global_vars.counts[ii] > 0) {
+		memcpy(centroids + ii * geometry,global_vars.sums + ii * geometry,geometry * sizeof(double));
+		dscal((int)geometry,1.0 / (double)global_vars.counts[ii],centroids + ii * geometry,1);
+	    }
+	}
+
+	if (global_vars.changed_count == 0) {
+	    break;
+	}
+    }
+
+    /* Build "list_offsets", "list_members" and "sample_norms". */
+
+    list_offsets = (size_t*)mxMalloc((list_count + 1) * sizeof(size_t));
+    list_members = (size_t*)mxMalloc(sample_count * sizeof(size_t));
+
+    build_ivf_lists(list_offsets,list_members,sample_count,list_count,list_idx);
+    squared_norms(mxGetPr(output[O_SAMPLE_NORMS]),geometry,sample_count,sample);
+
+    output[O_LIST_OFFSETS] = mxCreateDoubleMatrix(list_count + 1,1,mxREAL);
+    o_list_offsets = mxGetPr(output[O_LIST_OFFSETS]);
+    for (ii = 0; ii <= list_count; ii++) {
+	o_list_offsets[ii] = (double)list_offsets[ii];
+    }
+
+    output[O_LIST_MEMBERS] = mxCreateDoubleMatrix(sample_count,1,mxREAL);
+    o_list_members = mxGetPr(output[O_LIST_MEMBERS]);
+    for (ii = 0; ii < sample_count; ii++) {
+	o_list_members[ii] = (double)list_members[ii];
+    }
+
+    /* Free memory and destroy objects. */
+
+    mxFree(task_info);
+    pthread_res = pthread_mutex_destroy(&global_vars.sums_control);
+    check_condition(pthread_res == 0,"master:SystemError","Could not destroy sums mutex.");
+    mxFree(global_vars.counts);
+    mxFree(global_vars.sums);
+    mxFree(list_members);
+    mxFree(list_offsets);
+    mxFree(list_idx);
+    mxFree(centroids_norms);
+}
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "nn_index.h"
+#include "dataset_file.h"
+
+enum output_decoder {
+    O_NEIGHBOURS_IDX   = 0,
+    O_NEIGHBOURS_DIST  = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_TRAIN_SAMPLE        = 0,
+    I_TRAIN_SAMPLE_NORMS  = 1,
+    I_CENTROIDS           = 2,
+    I_LIST_OFFSETS        = 3,
+    I_LIST_MEMBERS        = 4,
+    I_PROBE_COUNT         = 5,
+    I_NEIGHBOUR_COUNT     = 6,
+    I_SAMPLE              = 7,
+    I_NUM_WORKERS         = 8,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t              geometry;
+    size_t              train_sample_count;
+    const double*       train_sample;
+    const double*       train_sample_norms;
+    size_t              list_count;
+    const double*       centroids;
+    const double*       centroids_norms;
+    const size_t*       list_offsets;
+    const size_t*       list_members;
+    size_t              probe_count;
+    size_t              neighbour_count;
+    enum dataset_dtype  sample_dtype;
+};
+
+struct task_info {
+    size_t*      o_neighbours_idx;
+    double*      o_neighbours_dist;
+    const void*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*          tmps;
+    double*        observation_buffer;
+    const double*  observation;
+    size_t         ii;
+
+    tmps = (char*)malloc(ivf_nearest_neighbours_tmps_length(global_info->geometry,global_info->list_count,global_info->neighbour_count));
+    observation_buffer = (double*)malloc(global_info->geometry * sizeof(double));
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	if (global_info->sample_dtype == DTYPE_FLOAT64) {
+	    observation = (const double*)task_info[ii].observation;
+	} else {
+	    dataset_convert(observation_buffer,global_info->sample_dtype,global_info->geometry,task_info[ii].observation);
+	    observation = observation_buffer;
+	}
+
+	if (global_info->list_count == 0) {
+	    exact_nearest_neighbours(task_info[ii].o_neighbours_idx,task_info[ii].o_neighbours_dist,
+				     global_info->geometry,global_info->train_sample_count,global_info->train_sample,global_info->train_sample_norms,
+				     global_info->neighbour_count,observation);
+	} else {
+	    ivf_nearest_neighbours(task_info[ii].o_neighbours_idx,task_info[ii].o_neighbours_dist,
+				   global_info->geometry,global_info->train_sample_count,global_info->train_sample,global_info->train_sample_norms,
+				   global_info->list_count,global_info->centroids,global_info->centroids_norms,global_info->list_offsets,global_info->list_members,
+				   global_info->probe_count,global_info->neighbour_count,observation,tmps);
+	}
+    }
+
+    free(observation_buffer);
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t               geometry;
+    size_t               train_sample_count;
+    const double*        train_sample;
+    const double*        train_sample_norms;
+    size_t               list_count;
+    const double*        centroids;
+    double*              centroids_norms;
+    const double*        list_offsets_d;
+    const double*        list_members_d;
+    size_t*              list_offsets;
+    size_t*              list_members;
+    size_t               probe_count;
+    size_t               neighbour_count;
+    size_t               sample_count;
+    const char*          sample;
+    enum dataset_dtype   sample_dtype;
+    size_t               observation_length;
+    char*                sample_path;
+    struct dataset_file  sample_file;
+    bool                 ok;
+    size_t               num_workers;
+    size_t*              neighbours_idx;
+    double*              o_neighbours_idx;
+    struct global_info   global_info;
+    struct task_info*    task_info;
+    size_t               ii;
+
+    /* Extract relevant information from all inputs. An empty "centroids" selects exhaustive search. A string "sample"
+       is the path of a mapped dataset, whose observations are used as queries in place. */
+
+    geometry = mxGetM(input[I_TRAIN_SAMPLE]);
+    train_sample_count = mxGetN(input[I_TRAIN_SAMPLE]);
+    train_sample = mxGetPr(input[I_TRAIN_SAMPLE]);
+    train_sample_norms = mxGetPr(input[I_TRAIN_SAMPLE_NORMS]);
+    list_count = mxGetN(input[I_CENTROIDS]);
+    centroids = mxGetPr(input[I_CENTROIDS]);
+    list_offsets_d = mxGetPr(input[I_LIST_OFFSETS]);
+    list_members_d = mxGetPr(input[I_LIST_MEMBERS]);
+    probe_count = (size_t)mxGetScalar(input[I_PROBE_COUNT]);
+    neighbour_count = (size_t)mxGetScalar(input[I_NEIGHBOUR_COUNT]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    if (mxIsChar(input[I_SAMPLE])) {
+	sample_path = mxArrayToString(input[I_SAMPLE]);
+	ok = dataset_file_open(&sample_file,sample_path);
+	check_condition(ok,"master:NoLoad","Could not open dataset file.");
+
+	sample_count = (size_t)sample_file.header.count;
+	sample = sample_file.data;
+	sample_dtype = (enum dataset_dtype)sample_file.header.dtype;
+	observation_length = sample_file.observation_length;
+    } else {
+	sample_path = NULL;
+
+	sample_count = mxGetN(input[I_SAMPLE]);
+	sample = (const char*)mxGetPr(input[I_SAMPLE]);
+	sample_dtype = DTYPE_FLOAT64;
+	observation_length = geometry * sizeof(double);
+    }
+
+    centroids_norms = (double*)mxMalloc(list_count * sizeof(double));
+    list_offsets = (size_t*)mxMalloc((list_count + 1) * sizeof(size_t));
+    list_members = (size_t*)mxMalloc((list_count > 0 ? train_sample_count : 0) * sizeof(size_t));
+
+    if (list_count > 0) {
+	squared_norms(centroids_norms,geometry,list_count,centroids);
+
+	for (ii = 0; ii <= list_count; ii++) {
+	    list_offsets[ii] = (size_t)list_offsets_d[ii];
+	}
+
+	for (ii = 0; ii < train_sample_count; ii++) {
+	    list_members[ii] = (size_t)list_members_d[ii];
+	}
+    }
+
+    /* Build output structures. */
+
+    neighbours_idx = (size_t*)mxMalloc(neighbour_count * sample_count * sizeof(size_t));
+    output[O_NEIGHBOURS_DIST] = mxCreateDoubleMatrix(neighbour_count,sample_count,mxREAL);
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.train_sample_count = train_sample_count;
+    global_info.train_sample = train_sample;
+    global_info.train_sample_norms = train_sample_norms;
+    global_info.list_count = list_count;
+    global_info.centroids = centroids;
+    global_info.centroids_norms = centroids_norms;
+    global_info.list_offsets = list_offsets;
+    global_info.list_members = list_members;
+    global_info.probe_count = probe_count;
+    global_info.neighbour_count = neighbour_count;
+    global_info.sample_dtype = sample_dtype;
+
+    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].o_neighbours_idx = neighbours_idx + ii * neighbour_count;
+	task_info[ii].o_neighbours_dist = mxGetPr(output[O_NEIGHBOURS_DIST]) + ii * neighbour_count;
+	task_info[ii].observation = sample + ii * observation_length;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+    /* Build "neighbours_idx". Indices are one-based, as MATLAB expects them. */
+
+    output[O_NEIGHBOURS_IDX] = mxCreateDoubleMatrix(neighbour_count,sample_count,mxREAL);
+    o_neighbours_idx = mxGetPr(output[O_NEIGHBOURS_IDX]);
+    for (ii = 0; ii < neighbour_count * sample_count; ii++) {
+	o_neighbours_idx[ii] = (double)(neighbours_idx[ii] + 1);
+    }
+
+    /* Free memory. */
+
+    mxFree(task_info);
+
+    if (sample_path != NULL) {
+	dataset_file_close(&sample_file);
+	mxFree(sample_path);
+    }
+
+    mxFree(neighbours_idx);
+    mxFree(list_members);
+    mxFree(list_offsets);
+    mxFree(centroids_norms);
+}
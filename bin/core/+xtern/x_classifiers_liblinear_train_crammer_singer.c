@@ -0,0 +1,72 @@
+#include <stdbool.h>
+
+#include "mex.h"
+
+#include "liblinear/linear.h"
+
+#include "x_mex_interface.h"
+#include "linear_classifier.h"
+
+enum output_decoder {
+    O_WEIGHTS  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_TRAIN_SAMPLE  = 0,
+    I_CLASS_INFO    = 1,
+    I_REG_PARAM     = 2,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t          geometry;
+    size_t          train_sample_count;
+    const double*   train_sample_pr;
+    const size_t*   train_sample_ir;
+    const size_t*   train_sample_jc;
+    size_t          classes_count;
+    const double*   labels_idx;
+    double          reg_param;
+    size_t          classifiers_count;
+    double*         weights;
+    const char*     error_message;
+    bool            ok;
+
+    /* For proper output in MATLAB we set this to a correct-type wrapper around "mexPrintf". */
+
+    set_print_string_function(printf_wrapper);
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_TRAIN_SAMPLE]);
+    train_sample_count = mxGetN(input[I_TRAIN_SAMPLE]);
+    train_sample_pr = mxGetPr(input[I_TRAIN_SAMPLE]);
+    train_sample_ir = mxGetIr(input[I_TRAIN_SAMPLE]);
+    train_sample_jc = mxGetJc(input[I_TRAIN_SAMPLE]);
+    classes_count = (size_t)mxGetScalar(mxGetProperty(input[I_CLASS_INFO],0,"labels_count"));
+    labels_idx = mxGetPr(mxGetProperty(input[I_CLASS_INFO],0,"labels_idx"));
+    reg_param = mxGetScalar(input[I_REG_PARAM]);
+
+    classifiers_count = classes_count;
+
+    /* Compute output. All classes are trained in a single solve, so there are no workers to spread it over. */
+
+    weights = (double*)mxMalloc(classifiers_count * (geometry + 1) * sizeof(double));
+
+    ok = linear_classifier_train_crammer_singer(weights,&error_message,geometry,train_sample_count,train_sample_pr,train_sample_ir,train_sample_jc,
+						classes_count,labels_idx,reg_param);
+    check_condition(ok,"master:NoConvergence",error_message);
+
+    /* Build "output". */
+
+    output[O_WEIGHTS] = mxCreateDoubleMatrix(0,0,mxREAL);
+    mxSetPr(output[O_WEIGHTS],weights);
+    mxSetM(output[O_WEIGHTS],geometry + 1);
+    mxSetN(output[O_WEIGHTS],classifiers_count);
+}
@@ -0,0 +1,63 @@
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "linear_classifier.h"
+
+enum output_decoder {
+    O_CLASSIFIERS_DECISIONS  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE              = 0,
+    I_WEIGHTS_BY_FEATURE  = 1,
+    I_NUM_WORKERS         = 2,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t          geometry;
+    size_t          sample_count;
+    const double*   sample_pr;
+    const size_t*   sample_ir;
+    const size_t*   sample_jc;
+    size_t          classifiers_count;
+    const double*   weights_pr;
+    const size_t*   weights_ir;
+    const size_t*   weights_jc;
+    size_t          num_workers;
+    double*         classifiers_decisions;
+
+    /* Extract relevant information from all inputs. The weights come as a "classifiers_count" x "geometry + 1"
+       sparse matrix, whose compressed sparse column form holds the non-zero weights of every feature together. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample_pr = mxGetPr(input[I_SAMPLE]);
+    sample_ir = mxGetIr(input[I_SAMPLE]);
+    sample_jc = mxGetJc(input[I_SAMPLE]);
+    classifiers_count = mxGetM(input[I_WEIGHTS_BY_FEATURE]);
+    weights_pr = mxGetPr(input[I_WEIGHTS_BY_FEATURE]);
+    weights_ir = mxGetIr(input[I_WEIGHTS_BY_FEATURE]);
+    weights_jc = mxGetJc(input[I_WEIGHTS_BY_FEATURE]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Run workers and compute output. */
+
+    classifiers_decisions = (double*)mxMalloc(sample_count * classifiers_count * sizeof(double));
+
+    linear_classifier_classify_sparse(classifiers_decisions,geometry,sample_count,sample_pr,sample_ir,sample_jc,
+				      classifiers_count,weights_pr,weights_ir,weights_jc,num_workers);
+
+    /* Build "output". */
+
+    output[O_CLASSIFIERS_DECISIONS] = mxCreateDoubleMatrix(0,0,mxREAL);
+    mxSetPr(output[O_CLASSIFIERS_DECISIONS],classifiers_decisions);
+    mxSetM(output[O_CLASSIFIERS_DECISIONS],classifiers_count);
+    mxSetN(output[O_CLASSIFIERS_DECISIONS],sample_count);
+}
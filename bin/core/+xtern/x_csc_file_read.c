@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "csc_file.h"
+
+enum output_decoder {
+    O_SAMPLE  = 0,
+    O_INFO    = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_PATH   = 0,
+    I_FIRST  = 1,
+    I_COUNT  = 2,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    char*            path;
+    size_t           first;
+    size_t           count;
+    struct csc_file  file;
+    size_t           nnz;
+    double*          o_info;
+    bool             ok;
+
+    /* Extract relevant information from all inputs. The chunk is "count" columns starting at the zero based "first",
+       clamped to the end of the file. */
+
+    path = mxArrayToString(input[I_PATH]);
+    first = (size_t)mxGetScalar(input[I_FIRST]);
+    count = (size_t)mxGetScalar(input[I_COUNT]);
+
+    ok = csc_file_open(&file,path);
+    check_condition(ok,"master:NoLoad","Could not open coded file.");
+
+    if (first > file.header.col_count) {
+	first = (size_t)file.header.col_count;
+    }
+
+    if (count > file.header.col_count - first) {
+	count = (size_t)file.header.col_count - first;
+    }
+
+    /* Build output structures. */
+
+    nnz = csc_file_chunk_nnz(&file,first,count);
+    output[O_SAMPLE] = mxCreateSparse(file.header.row_count,count,nnz > 0 ? nnz : 1,mxREAL);
+
+    /* Build "sample". */
+
+    csc_file_read_chunk(mxGetPr(output[O_SAMPLE]),(size_t*)mxGetIr(output[O_SAMPLE]),(size_t*)mxGetJc(output[O_SAMPLE]),&file,first,count);
+
+    /* Build "info". */
+
+    output[O_INFO] = mxCreateDoubleMatrix(1,5,mxREAL);
+    o_info = mxGetPr(output[O_INFO]);
+    o_info[0] = (double)file.header.row_count;
+    o_info[1] = (double)file.header.col_count;
+    o_info[2] = (double)file.header.nnz;
+    o_info[3] = (double)file.header.index_encoding;
+    o_info[4] = (double)file.header.value_encoding;
+
+    /* Free memory and destroy objects. */
+
+    csc_file_close(&file);
+    mxFree(path);
+}
@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "csc_file.h"
+
+enum output_decoder {
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_PATH            = 0,
+    I_SAMPLE          = 1,
+    I_INDEX_ENCODING  = 2,
+    I_VALUE_ENCODING  = 3,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    char*                    path;
+    size_t                   row_count;
+    size_t                   col_count;
+    const double*            sample_pr;
+    const size_t*            sample_ir;
+    const size_t*            sample_jc;
+    enum csc_index_encoding  index_encoding;
+    enum csc_value_encoding  value_encoding;
+    struct csc_file_writer   writer;
+    bool                     ok;
+
+    /* Extract relevant information from all inputs. MATLAB keeps the row indices of each column ascending, as the
+       delta encoding requires. */
+
+    path = mxArrayToString(input[I_PATH]);
+    row_count = mxGetM(input[I_SAMPLE]);
+    col_count = mxGetN(input[I_SAMPLE]);
+    sample_pr = mxGetPr(input[I_SAMPLE]);
+    sample_ir = (const size_t*)mxGetIr(input[I_SAMPLE]);
+    sample_jc = (const size_t*)mxGetJc(input[I_SAMPLE]);
+    index_encoding = (enum csc_index_encoding)mxGetScalar(input[I_INDEX_ENCODING]);
+    value_encoding = (enum csc_value_encoding)mxGetScalar(input[I_VALUE_ENCODING]);
+
+    /* Build "path". */
+
+    ok = csc_file_writer_open(&writer,path,row_count,index_encoding,value_encoding);
+    check_condition(ok,"master:NoSave","Could not open coded file.");
+
+    ok = csc_file_writer_append(&writer,col_count,sample_pr,sample_ir,sample_jc);
+    ok = csc_file_writer_close(&writer) && ok;
+
+    /* Free memory. */
+
+    mxFree(path);
+
+    check_condition(ok,"master:NoSave","Could not write coded file.");
+}
@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "dataset_file.h"
+
+enum output_decoder {
+    O_SAMPLE       = 0,
+    O_LABELS_IDX   = 1,
+    O_LABEL_NAMES  = 2,
+    O_INFO         = 3,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_PATH   = 0,
+    I_FIRST  = 1,
+    I_COUNT  = 2,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    char*                path;
+    size_t               first;
+    size_t               count;
+    struct dataset_file  file;
+    mwSize               o_sample_dims[4];
+    char*                label_names;
+    double*              o_labels_idx;
+    double*              o_info;
+    bool                 ok;
+    size_t               ii;
+
+    /* Extract relevant information from all inputs. The chunk is "count" observations starting at the zero based
+       "first", clamped to the end of the file. */
+
+    path = mxArrayToString(input[I_PATH]);
+    first = (size_t)mxGetScalar(input[I_FIRST]);
+    count = (size_t)mxGetScalar(input[I_COUNT]);
+
+    ok = dataset_file_open(&file,path);
+    check_condition(ok,"master:NoLoad","Could not open dataset file.");
+
+    if (first > file.header.count) {
+	first = (size_t)file.header.count;
+    }
+
+    if (count > file.header.count - first) {
+	count = (size_t)file.header.count - first;
+    }
+
+    /* Build output structures. */
+
+    if (file.header.kind == KIND_RECORD) {
+	output[O_SAMPLE] = mxCreateDoubleMatrix(file.geometry,count,mxREAL);
+    } else {
+	o_sample_dims[0] = (mwSize)file.header.row_count;
+	o_sample_dims[1] = (mwSize)file.header.col_count;
+	o_sample_dims[2] = (mwSize)file.header.layer_count;
+	o_sample_dims[3] = count;
+	output[O_SAMPLE] = mxCreateNumericArray(4,o_sample_dims,mxDOUBLE_CLASS,mxREAL);
+    }
+
+    /* Build "sample". */
+
+    dataset_file_read_chunk(mxGetPr(output[O_SAMPLE]),&file,first,count);
+
+    /* Build "labels_idx" and "label_names". Both are empty for a dataset without labels. */
+
+    if (file.header.has_labels) {
+	output[O_LABELS_IDX] = mxCreateDoubleMatrix(1,count,mxREAL);
+	o_labels_idx = mxGetPr(output[O_LABELS_IDX]);
+	for (ii = 0; ii < count; ii++) {
+	    o_labels_idx[ii] = (double)file.labels_idx[first + ii];
+	}
+
+	label_names = (char*)mxMalloc(file.header.label_names_length + 1);
+	memcpy(label_names,file.label_names,file.header.label_names_length);
+	label_names[file.header.label_names_length] = '\0';
+	output[O_LABEL_NAMES] = mxCreateString(label_names);
+	mxFree(label_names);
+    } else {
+	output[O_LABELS_IDX] = mxCreateDoubleMatrix(1,0,mxREAL);
+	output[O_LABEL_NAMES] = mxCreateString("");
+    }
+
+    /* Build "info". */
+
+    output[O_INFO] = mxCreateDoubleMatrix(1,6,mxREAL);
+    o_info = mxGetPr(output[O_INFO]);
+    o_info[0] = (double)file.header.kind;
+    o_info[1] = (double)file.header.dtype;
+    o_info[2] = (double)file.header.row_count;
+    o_info[3] = (double)file.header.col_count;
+    o_info[4] = (double)file.header.layer_count;
+    o_info[5] = (double)file.header.count;
+
+    /* Free memory and destroy objects. */
+
+    dataset_file_close(&file);
+    mxFree(path);
+}
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "dataset_file.h"
+
+enum output_decoder {
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_PATH         = 0,
+    I_SAMPLE       = 1,
+    I_KIND         = 2,
+    I_DTYPE        = 3,
+    I_LABELS_IDX   = 4,
+    I_LABEL_NAMES  = 5,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    char*                       path;
+    enum dataset_kind           kind;
+    enum dataset_dtype          dtype;
+    const mwSize*               sample_dims;
+    size_t                      sample_dims_count;
+    size_t                      row_count;
+    size_t                      col_count;
+    size_t                      layer_count;
+    size_t                      count;
+    const double*               sample;
+    bool                        has_labels;
+    const double*               labels_idx_d;
+    uint32_t*                   labels_idx;
+    char*                       label_names;
+    size_t                      label_names_length;
+    struct dataset_file_header  header;
+    bool                        ok;
+    size_t                      ii;
+
+    /* Extract relevant information from all inputs. An empty "labels_idx" writes a dataset without labels. */
+
+    path = mxArrayToString(input[I_PATH]);
+    kind = (enum dataset_kind)mxGetScalar(input[I_KIND]);
+    dtype = (enum dataset_dtype)mxGetScalar(input[I_DTYPE]);
+    sample_dims_count = mxGetNumberOfDimensions(input[I_SAMPLE]);
+    sample_dims = mxGetDimensions(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    has_labels = !mxIsEmpty(input[I_LABELS_IDX]);
+    labels_idx_d = mxGetPr(input[I_LABELS_IDX]);
+
+    if (kind == KIND_RECORD) {
+	row_count = sample_dims[0];
+	col_count = 1;
+	layer_count = 1;
+	count = sample_dims[1];
+    } else {
+	row_count = sample_dims[0];
+	col_count = sample_dims[1];
+	layer_count = sample_dims_count >= 3 ? sample_dims[2] : 1;
+	count = sample_dims_count >= 4 ? sample_dims[3] : 1;
+    }
+
+    if (has_labels) {
+	label_names = mxArrayToString(input[I_LABEL_NAMES]);
+	label_names_length = mxGetNumberOfElements(input[I_LABEL_NAMES]);
+	labels_idx = (uint32_t*)mxMalloc(count * sizeof(uint32_t));
+
+	for (ii = 0; ii < count; ii++) {
+	    labels_idx[ii] = (uint32_t)labels_idx_d[ii];
+	}
+    } else {
+	label_names = NULL;
+	label_names_length = 0;
+	labels_idx = NULL;
+    }
+
+    /* Build "path". */
+
+    dataset_file_header_init(&header,kind,dtype,row_count,col_count,layer_count,count,has_labels,label_names_length);
+    ok = dataset_file_write(path,&header,sample,labels_idx,label_names);
+    check_condition(ok,"master:NoSave","Could not write dataset file.");
+
+    /* Free memory. */
+
+    mxFree(labels_idx);
+    mxFree(label_names);
+    mxFree(path);
+}
@@ -0,0 +1,45 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "dictionary_handle.h"
+
+enum output_decoder {
+    O_HANDLE  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_DICT  = 0,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                     word_count;
+    size_t                     geometry;
+    const double*              dict;
+    struct dictionary_handle*  handle;
+    bool                       ok;
+
+    /* Extract relevant information from all inputs. */
+
+    word_count = mxGetM(input[I_DICT]);
+    geometry = mxGetN(input[I_DICT]);
+    dict = mxGetPr(input[I_DICT]);
+
+    /* Build "handle". The transpose and the Gram matrix are derived here, once for the lifetime of the handle. */
+
+    ok = dictionary_handle_create(&handle,geometry,word_count,dict);
+    check_condition(ok,"master:SystemError","Could not allocate dictionary handle.");
+
+    output[O_HANDLE] = mxCreateNumericMatrix(1,1,mxUINT64_CLASS,mxREAL);
+    *(uint64_t*)mxGetData(output[O_HANDLE]) = dictionary_handle_to_id(handle);
+}
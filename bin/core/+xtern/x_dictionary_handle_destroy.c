@@ -0,0 +1,38 @@
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "dictionary_handle.h"
+
+enum output_decoder {
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_HANDLE  = 0,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    struct dictionary_handle*  handle;
+    bool                       destroyed;
+
+    /* Extract relevant information from all inputs. */
+
+    check_condition(mxIsUint64(input[I_HANDLE]) && (mxGetNumberOfElements(input[I_HANDLE]) == 1),
+		    "master:InvalidHandle","Dictionary handle must be a \"uint64\" scalar.");
+    handle = dictionary_handle_from_id(*(const uint64_t*)mxGetData(input[I_HANDLE]));
+    check_condition(handle != NULL,"master:InvalidHandle","Invalid dictionary handle.");
+
+    /* Free memory and destroy objects. */
+
+    destroyed = dictionary_handle_destroy(handle);
+    check_condition(destroyed,"master:InvalidHandle","Invalid dictionary handle.");
+}
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mex.h"
+
+#include "acml/acml.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "coding_methods.h"
+#include "dictionary_state.h"
+#include "dictionary_learn.h"
+
+#define POWER_ITER_COUNT 3
+
+enum output_decoder {
+    O_DICT       = 0,
+    O_SAVED_MSE  = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE          = 0,
+    I_INITIAL_DICT    = 1,
+    I_COEFF_COUNT     = 2,
+    I_MAX_ITER_COUNT  = 3,
+    I_NUM_WORKERS     = 4,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t         geometry;
+    size_t         word_count;
+    const double*  dict;
+    const double*  dict_transp;
+    const double*  dict_x_dict_transp;
+    size_t         coeff_count;
+};
+
+struct task_info {
+    double*        o_coeffs;
+    coeff_idx_t*   o_coeffs_idx;
+    double*        o_residual;
+    double*        o_error;
+    const double*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*   coding_tmps;
+    size_t  ii;
+
+    coding_tmps = (char*)malloc(batch_orthogonal_matching_pursuit_coding_tmps_length(global_info->geometry,global_info->word_count,global_info->coeff_count));
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	batch_orthogonal_matching_pursuit(task_info[ii].o_coeffs,task_info[ii].o_coeffs_idx,
+					  global_info->geometry,global_info->word_count,global_info->dict,global_info->dict_transp,global_info->dict_x_dict_transp,
+					  global_info->coeff_count,NULL,task_info[ii].observation,coding_tmps);
+	code_residual(task_info[ii].o_residual,global_info->geometry,global_info->dict_transp,global_info->coeff_count,
+		      task_info[ii].o_coeffs,task_info[ii].o_coeffs_idx,task_info[ii].observation);
+	*task_info[ii].o_error = ddot((int)global_info->geometry,task_info[ii].o_residual,1,task_info[ii].o_residual,1);
+    }
+
+    free(coding_tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                   geometry;
+    size_t                   sample_count;
+    const double*            sample;
+    size_t                   word_count;
+    const double*            initial_dict;
+    size_t                   coeff_count;
+    size_t                   max_iter_count;
+    size_t                   num_workers;
+    char*                    dict_storage;
+    struct dictionary_state  dict_state;
+    double*                  coeffs;
+    coeff_idx_t*             coeffs_idx;
+    double*                  residuals;
+    double*                  errors;
+    size_t*                  usage_offsets;
+    size_t*                  usage_members;
+    char*                    learn_tmps;
+    double*                  o_saved_mse;
+    struct global_info       global_info;
+    struct task_info*        task_info;
+    size_t                   iter;
+    size_t                   ii;
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    word_count = mxGetM(input[I_INITIAL_DICT]);
+    initial_dict = mxGetPr(input[I_INITIAL_DICT]);
+    coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
+    max_iter_count = (size_t)mxGetScalar(input[I_MAX_ITER_COUNT]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    output[O_DICT] = mxCreateDoubleMatrix(word_count,geometry,mxREAL);
+    output[O_SAVED_MSE] = mxCreateDoubleMatrix(1,max_iter_count,mxREAL);
+    o_saved_mse = mxGetPr(output[O_SAVED_MSE]);
+
+    /* Build task distribution information. */
+
+    dict_storage = (char*)mxMalloc(dictionary_state_length(geometry,word_count));
+    coeffs = (double*)mxMalloc(sample_count * coeff_count * sizeof(double));
+    coeffs_idx = (coeff_idx_t*)mxMalloc(sample_count * coeff_count * sizeof(coeff_idx_t));
+    residuals = (double*)mxMalloc(geometry * sample_count * sizeof(double));
+    errors = (double*)mxMalloc(sample_count * sizeof(double));
+    usage_offsets = (size_t*)mxMalloc((word_count + 1) * sizeof(size_t));
+    usage_members = (size_t*)mxMalloc(sample_count * coeff_count * sizeof(size_t));
+    learn_tmps = (char*)mxMalloc(ksvd_tmps_length(geometry,sample_count));
+
+    dictionary_state_init(&dict_state,geometry,word_count,initial_dict,dict_storage);
+
+    global_info.geometry = geometry;
+    global_info.word_count = word_count;
+    global_info.dict = dict_state.dict;
+    global_info.dict_transp = dict_state.dict_transp;
+    global_info.dict_x_dict_transp = dict_state.dict_x_dict_transp;
+    global_info.coeff_count = coeff_count;
+
+    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].o_coeffs = coeffs + ii * coeff_count;
+	task_info[ii].o_coeffs_idx = coeffs_idx + ii * coeff_count;
+	task_info[ii].o_residual = residuals + ii * geometry;
+	task_info[ii].o_error = errors + ii;
+	task_info[ii].observation = sample + ii * geometry;
+    }
+
+    /* Run workers and compute output. Each iteration codes the whole sample in parallel, then updates the atoms one
+       after the other, each seeing the coefficients and residuals left by the previous ones. */
+
+    for (iter = 0; iter < max_iter_count; iter++) {
+	dictionary_state_sync(&dict_state);
+
+	run_workers_x(&global_info,NULL,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+	o_saved_mse[iter] = 0;
+
+	for (ii = 0; ii < sample_count; ii++) {
+	    o_saved_mse[iter] += errors[ii];
+	}
+
+	o_saved_mse[iter] = o_saved_mse[iter] / (double)sample_count;
+
+	build_atom_usage(usage_offsets,usage_members,word_count,sample_count,coeff_count,coeffs,coeffs_idx);
+
+	for (ii = 0; ii < word_count; ii++) {
+	    if (usage_offsets[ii + 1] > usage_offsets[ii]) {
+		ksvd_update_atom(dict_state.dict_transp,residuals,coeffs,geometry,coeff_count,ii,
+				 usage_offsets[ii + 1] - usage_offsets[ii],usage_members + usage_offsets[ii],POWER_ITER_COUNT,learn_tmps);
+		dictionary_state_touch_atom(&dict_state,ii);
+	    }
+	}
+    }
+
+    /* Build "dict". */
+
+    dictionary_state_sync(&dict_state);
+    memcpy(mxGetPr(output[O_DICT]),dict_state.dict,word_count * geometry * sizeof(double));
+
+    /* Free memory. */
+
+    mxFree(task_info);
+    mxFree(learn_tmps);
+    mxFree(usage_members);
+    mxFree(usage_offsets);
+    mxFree(errors);
+    mxFree(residuals);
+    mxFree(coeffs_idx);
+    mxFree(coeffs);
+    mxFree(dict_storage);
+}
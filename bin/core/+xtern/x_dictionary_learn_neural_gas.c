@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <gsl/gsl_rng.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "coding_methods.h"
+#include "dictionary_state.h"
+#include "dictionary_learn.h"
+
+enum output_decoder {
+    O_DICT       = 0,
+    O_SAVED_MSE  = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE                = 0,
+    I_INITIAL_DICT          = 1,
+    I_CODING_TYPE           = 2,
+    I_CODING_PARAMS         = 3,
+    I_COEFF_COUNT           = 4,
+    I_LEARN_RATE_SCHEDULE   = 5,
+    I_NEIGHT_SIZE_SCHEDULE  = 6,
+    I_SEED                  = 7,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                   geometry;
+    size_t                   sample_count;
+    const double*            sample;
+    size_t                   word_count;
+    const double*            initial_dict;
+    enum coding_type         coding_type;
+    const double*            coding_params;
+    size_t                   coeff_count;
+    const double*            learn_rate_schedule;
+    const double*            neight_size_schedule;
+    size_t                   max_iter_count;
+    uint64_t                 seed;
+    char*                    dict_storage;
+    struct dictionary_state  dict_state;
+    double*                  coeffs;
+    coeff_idx_t*             coeffs_idx;
+    char*                    coding_tmps;
+    char*                    learn_tmps;
+    coding_method_t          coding_method;
+    double                   local_lambda_sigma_ratio;
+    gsl_rng*                 rnd_generator;
+    void*                    param_table[2] = {NULL,NULL};
+    size_t                   observation_idx;
+    const double*            observation;
+    double*                  o_saved_mse;
+    size_t                   iter;
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    word_count = mxGetM(input[I_INITIAL_DICT]);
+    initial_dict = mxGetPr(input[I_INITIAL_DICT]);
+    coding_type = (enum coding_type)mxGetScalar(input[I_CODING_TYPE]);
+    coding_params = mxGetPr(input[I_CODING_PARAMS]);
+    coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
+    learn_rate_schedule = mxGetPr(input[I_LEARN_RATE_SCHEDULE]);
+    neight_size_schedule = mxGetPr(input[I_NEIGHT_SIZE_SCHEDULE]);
+    max_iter_count = mxGetNumberOfElements(input[I_LEARN_RATE_SCHEDULE]);
+    seed = (uint64_t)mxGetScalar(input[I_SEED]);
+
+    /* Build output structures. */
+
+    output[O_DICT] = mxCreateDoubleMatrix(word_count,geometry,mxREAL);
+    output[O_SAVED_MSE] = mxCreateDoubleMatrix(1,max_iter_count,mxREAL);
+    o_saved_mse = mxGetPr(output[O_SAVED_MSE]);
+
+    /* Build coding information. Each iteration codes a single observation and moves a handful of atoms, so the
+       whole schedule runs on this thread, and only the Gram rows and columns of the moved atoms are refreshed, just
+       before the next observation is coded. */
+
+    dict_storage = (char*)mxMalloc(dictionary_state_length(geometry,word_count));
+    coeffs = (double*)mxMalloc(coeff_count * sizeof(double));
+    coeffs_idx = (coeff_idx_t*)mxMalloc(coeff_count * sizeof(coeff_idx_t));
+    coding_tmps = (char*)mxMalloc(coding_type_tmps_length(coding_type,geometry,word_count,coeff_count));
+    learn_tmps = (char*)mxMalloc(neural_gas_tmps_length(geometry,word_count));
+    coding_method = coding_type_method(coding_type);
+    rnd_generator = NULL;
+
+    dictionary_state_init(&dict_state,geometry,word_count,initial_dict,dict_storage);
+
+    if (coding_type == SPARSE_NET) {
+	local_lambda_sigma_ratio = coding_params[0];
+	rnd_generator = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(rnd_generator,(unsigned long)seed);
+
+	param_table[0] = &local_lambda_sigma_ratio;
+	param_table[1] = rnd_generator;
+    }
+
+    /* Run the schedule and compute output. */
+
+    for (iter = 0; iter < max_iter_count; iter++) {
+	draw_batch(&observation_idx,seed,iter,1,sample_count);
+	observation = sample + observation_idx * geometry;
+
+	dictionary_state_sync(&dict_state);
+	coding_method(coeffs,coeffs_idx,geometry,word_count,dict_state.dict,dict_state.dict_transp,dict_state.dict_x_dict_transp,
+		      coeff_count,&param_table,observation,coding_tmps);
+	neural_gas_step(&dict_state,coeff_count,coeffs,coeffs_idx,learn_rate_schedule[iter],neight_size_schedule[iter],observation);
+
+	o_saved_mse[iter] = sqrt(reconstruction_error(geometry,dict_state.dict_transp,coeff_count,coeffs,coeffs_idx,observation,learn_tmps));
+    }
+
+    /* Build "dict". */
+
+    dictionary_state_sync(&dict_state);
+    memcpy(mxGetPr(output[O_DICT]),dict_state.dict,word_count * geometry * sizeof(double));
+
+    /* Free memory. */
+
+    if (rnd_generator != NULL) {
+	gsl_rng_free(rnd_generator);
+    }
+
+    mxFree(learn_tmps);
+    mxFree(coding_tmps);
+    mxFree(coeffs_idx);
+    mxFree(coeffs);
+    mxFree(dict_storage);
+}
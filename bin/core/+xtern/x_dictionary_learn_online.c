@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <gsl/gsl_rng.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "coding_methods.h"
+#include "dictionary_state.h"
+#include "dictionary_learn.h"
+
+enum output_decoder {
+    O_DICT       = 0,
+    O_SAVED_MSE  = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE          = 0,
+    I_INITIAL_DICT    = 1,
+    I_CODING_TYPE     = 2,
+    I_CODING_PARAMS   = 3,
+    I_COEFF_COUNT     = 4,
+    I_BATCH_SIZE      = 5,
+    I_MAX_ITER_COUNT  = 6,
+    I_SEED            = 7,
+    I_NUM_WORKERS     = 8,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t            geometry;
+    enum coding_type  coding_type;
+    size_t            word_count;
+    const double*     dict;
+    const double*     dict_transp;
+    const double*     dict_x_dict_transp;
+    size_t            coeff_count;
+    const double*     coding_params;
+};
+
+struct task_info {
+    double*        o_coeffs;
+    coeff_idx_t*   o_coeffs_idx;
+    double*        o_error;
+    const double*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*            coding_tmps;
+    char*            learn_tmps;
+    coding_method_t  coding_method;
+    double           local_lambda_sigma_ratio;
+    gsl_rng*         rnd_generator;
+    void*            param_table[2] = {NULL,NULL};
+    size_t           ii;
+
+    coding_tmps = (char*)malloc(coding_type_tmps_length(global_info->coding_type,global_info->geometry,global_info->word_count,global_info->coeff_count));
+    learn_tmps = (char*)malloc(online_learn_tmps_length(global_info->geometry,global_info->word_count));
+    coding_method = coding_type_method(global_info->coding_type);
+    rnd_generator = NULL;
+
+    if (global_info->coding_type == SPARSE_NET) {
+	local_lambda_sigma_ratio = global_info->coding_params[0];
+	rnd_generator = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(rnd_generator,id);
+
+	param_table[0] = &local_lambda_sigma_ratio;
+	param_table[1] = rnd_generator;
+    }
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	coding_method(task_info[ii].o_coeffs,task_info[ii].o_coeffs_idx,
+		      global_info->geometry,global_info->word_count,global_info->dict,global_info->dict_transp,global_info->dict_x_dict_transp,
+		      global_info->coeff_count,&param_table,task_info[ii].observation,coding_tmps);
+	*task_info[ii].o_error = reconstruction_error(global_info->geometry,global_info->dict_transp,global_info->coeff_count,
+						      task_info[ii].o_coeffs,task_info[ii].o_coeffs_idx,task_info[ii].observation,learn_tmps);
+    }
+
+    if (rnd_generator != NULL) {
+	gsl_rng_free(rnd_generator);
+    }
+
+    free(learn_tmps);
+    free(coding_tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                   geometry;
+    size_t                   sample_count;
+    const double*            sample;
+    size_t                   word_count;
+    const double*            initial_dict;
+    enum coding_type         coding_type;
+    const double*            coding_params;
+    size_t                   coeff_count;
+    size_t                   batch_size;
+    size_t                   max_iter_count;
+    uint64_t                 seed;
+    size_t                   num_workers;
+    char*                    dict_storage;
+    struct dictionary_state  dict_state;
+    double*                  coeffs_outer;
+    double*                  sample_coeffs_outer;
+    double*                  batch_coeffs;
+    coeff_idx_t*             batch_coeffs_idx;
+    double*                  batch_errors;
+    size_t*                  batch_idx;
+    char*                    learn_tmps;
+    double*                  o_saved_mse;
+    struct global_info       global_info;
+    struct task_info*        task_info;
+    size_t                   iter;
+    size_t                   ii;
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    word_count = mxGetM(input[I_INITIAL_DICT]);
+    initial_dict = mxGetPr(input[I_INITIAL_DICT]);
+    coding_type = (enum coding_type)mxGetScalar(input[I_CODING_TYPE]);
+    coding_params = mxGetPr(input[I_CODING_PARAMS]);
+    coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
+    batch_size = (size_t)mxGetScalar(input[I_BATCH_SIZE]);
+    max_iter_count = (size_t)mxGetScalar(input[I_MAX_ITER_COUNT]);
+    seed = (uint64_t)mxGetScalar(input[I_SEED]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    output[O_DICT] = mxCreateDoubleMatrix(word_count,geometry,mxREAL);
+    output[O_SAVED_MSE] = mxCreateDoubleMatrix(1,max_iter_count,mxREAL);
+    o_saved_mse = mxGetPr(output[O_SAVED_MSE]);
+
+    /* Build task distribution information. Atoms are columns of "dict_transp", which is what the updates work on. */
+
+    dict_storage = (char*)mxMalloc(dictionary_state_length(geometry,word_count));
+    coeffs_outer = (double*)mxCalloc(word_count * word_count,sizeof(double));
+    sample_coeffs_outer = (double*)mxCalloc(geometry * word_count,sizeof(double));
+    batch_coeffs = (double*)mxMalloc(batch_size * coeff_count * sizeof(double));
+    batch_coeffs_idx = (coeff_idx_t*)mxMalloc(batch_size * coeff_count * sizeof(coeff_idx_t));
+    batch_errors = (double*)mxMalloc(batch_size * sizeof(double));
+    batch_idx = (size_t*)mxMalloc(batch_size * sizeof(size_t));
+    learn_tmps = (char*)mxMalloc(online_learn_tmps_length(geometry,word_count));
+
+    dictionary_state_init(&dict_state,geometry,word_count,initial_dict,dict_storage);
+
+    global_info.geometry = geometry;
+    global_info.coding_type = coding_type;
+    global_info.word_count = word_count;
+    global_info.dict = dict_state.dict;
+    global_info.dict_transp = dict_state.dict_transp;
+    global_info.dict_x_dict_transp = dict_state.dict_x_dict_transp;
+    global_info.coeff_count = coeff_count;
+    global_info.coding_params = coding_params;
+
+    task_info = (struct task_info*)mxMalloc(batch_size * sizeof(struct task_info));
+
+    for (ii = 0; ii < batch_size; ii++) {
+	task_info[ii].o_coeffs = batch_coeffs + ii * coeff_count;
+	task_info[ii].o_coeffs_idx = batch_coeffs_idx + ii * coeff_count;
+	task_info[ii].o_error = batch_errors + ii;
+    }
+
+    /* Run workers and compute output. Each iteration codes one mini-batch in parallel, then folds the codes into the
+       statistics in batch order and updates the atoms. The cost of an iteration depends on "batch_size", not on the
+       size of the sample. */
+
+    for (iter = 0; iter < max_iter_count; iter++) {
+	draw_batch(batch_idx,seed,iter,batch_size,sample_count);
+
+	for (ii = 0; ii < batch_size; ii++) {
+	    task_info[ii].observation = sample + batch_idx[ii] * geometry;
+	}
+
+	run_workers_x(&global_info,NULL,batch_size,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+	o_saved_mse[iter] = 0;
+
+	for (ii = 0; ii < batch_size; ii++) {
+	    accumulate_statistics(coeffs_outer,sample_coeffs_outer,geometry,word_count,coeff_count,
+				  batch_coeffs + ii * coeff_count,batch_coeffs_idx + ii * coeff_count,task_info[ii].observation);
+	    o_saved_mse[iter] += batch_errors[ii];
+	}
+
+	o_saved_mse[iter] = o_saved_mse[iter] / (double)batch_size;
+
+	update_dictionary_bcd(dict_state.dict_transp,geometry,word_count,coeffs_outer,sample_coeffs_outer,learn_tmps);
+	dictionary_state_touch_all(&dict_state);
+	dictionary_state_sync(&dict_state);
+    }
+
+    /* Build "dict". */
+
+    memcpy(mxGetPr(output[O_DICT]),dict_state.dict,word_count * geometry * sizeof(double));
+
+    /* Free memory. */
+
+    mxFree(task_info);
+    mxFree(learn_tmps);
+    mxFree(batch_idx);
+    mxFree(batch_errors);
+    mxFree(batch_coeffs_idx);
+    mxFree(batch_coeffs);
+    mxFree(sample_coeffs_outer);
+    mxFree(coeffs_outer);
+    mxFree(dict_storage);
+}
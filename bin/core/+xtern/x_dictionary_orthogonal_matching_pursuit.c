@@ -44,18 +44,22 @@ do_task(
     void*                      global_vars,
     size_t                     task_info_count,
     struct task_info*          task_info) {
-    char*    coding_tmps;
-    size_t   ii;
+    char*         coding_tmps;
+    coeff_idx_t*  coeffs_idx;
+    size_t        ii;
 
     coding_tmps = (char*)malloc(orthogonal_matching_pursuit_coding_tmps_length(global_info->geometry,global_info->word_count,global_info->coeff_count));
+    coeffs_idx = (coeff_idx_t*)malloc(global_info->coeff_count * sizeof(coeff_idx_t));
 
     for (ii = 0; ii < task_info_count; ii++) {
-        orthogonal_matching_pursuit(task_info[ii].o_coeffs_pr,task_info[ii].o_coeffs_ir,
+        orthogonal_matching_pursuit(task_info[ii].o_coeffs_pr,coeffs_idx,
                                     global_info->geometry,global_info->word_count,global_info->dict,global_info->dict_transp,global_info->dict_x_dict_transp,
                                     global_info->coeff_count,NULL,task_info[ii].observation,coding_tmps);
-        sort_by_idxs(task_info[ii].o_coeffs_pr,task_info[ii].o_coeffs_ir,global_info->coeff_count);
+        sort_by_idxs(task_info[ii].o_coeffs_pr,coeffs_idx,global_info->coeff_count);
+        widen_idx(task_info[ii].o_coeffs_ir,coeffs_idx,global_info->coeff_count);
     }
 
+    free(coeffs_idx);
     free(coding_tmps);
 }
 
@@ -85,10 +89,7 @@ mexFunction(
     /* Extract relevant information from all inputs. */
 
     geometry = mxGetM(input[I_SAMPLE]);
-    word_count = mxGetM(input[I_DICT]);
-    dict = mxGetPr(input[I_DICT]);
-    dict_transp = mxGetPr(input[I_DICT_TRANSP]);
-    dict_x_dict_transp = mxGetPr(input[I_DICT_X_DICT_TRANSP]);
+    extract_dictionary(&word_count,&dict,&dict_transp,&dict_x_dict_transp,input[I_DICT],input[I_DICT_TRANSP],input[I_DICT_X_DICT_TRANSP]);
     coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
     sample_count = mxGetN(input[I_SAMPLE]);
     sample = mxGetPr(input[I_SAMPLE]);
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "image_deform.h"
+
+enum output_decoder {
+    O_SAMPLE_CODED  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE            = 0,
+    I_SCALING_MAX       = 1,
+    I_ROTATION_MAX      = 2,
+    I_FIELD_SMOOTHNESS  = 3,
+    I_FIELD_INTENSITY   = 4,
+    I_SEED              = 5,
+    I_NUM_WORKERS       = 6,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t    row_count;
+    size_t    col_count;
+    size_t    layer_count;
+    double    scaling_max;
+    double    rotation_max;
+    double    field_smoothness;
+    double    field_intensity;
+    uint64_t  seed;
+};
+
+struct task_info {
+    double*        o_image;
+    size_t         image_idx;
+    const double*  image;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*   tmps;
+    size_t  ii;
+
+    tmps = (char*)malloc(image_deform_tmps_length(global_info->row_count,global_info->col_count));
+
+    /* The stream of an image is its index, so the result depends only on "seed" and not on "num_workers". */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	deform_image(task_info[ii].o_image,global_info->row_count,global_info->col_count,global_info->layer_count,
+		     global_info->scaling_max,global_info->rotation_max,global_info->field_smoothness,global_info->field_intensity,
+		     global_info->seed,task_info[ii].image_idx,task_info[ii].image,tmps);
+    }
+
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t              row_count;
+    size_t              col_count;
+    size_t              layer_count;
+    size_t              image_count;
+    size_t              image_size;
+    const mwSize*       sample_dims;
+    size_t              sample_dims_count;
+    const double*       sample;
+    double              scaling_max;
+    double              rotation_max;
+    double              field_smoothness;
+    double              field_intensity;
+    uint64_t            seed;
+    size_t              num_workers;
+    mwSize              o_sample_coded_dims[4];
+    double*             o_sample_coded;
+    struct global_info  global_info;
+    struct task_info*   task_info;
+    size_t              ii;
+
+    /* Extract relevant information from all inputs. A zero "field_smoothness" disables field deformations. */
+
+    sample_dims_count = mxGetNumberOfDimensions(input[I_SAMPLE]);
+    sample_dims = mxGetDimensions(input[I_SAMPLE]);
+    row_count = sample_dims[0];
+    col_count = sample_dims[1];
+    layer_count = sample_dims_count >= 3 ? sample_dims[2] : 1;
+    image_count = sample_dims_count >= 4 ? sample_dims[3] : 1;
+    image_size = row_count * col_count * layer_count;
+    sample = mxGetPr(input[I_SAMPLE]);
+    scaling_max = mxGetScalar(input[I_SCALING_MAX]);
+    rotation_max = mxGetScalar(input[I_ROTATION_MAX]);
+    field_smoothness = mxGetScalar(input[I_FIELD_SMOOTHNESS]);
+    field_intensity = mxGetScalar(input[I_FIELD_INTENSITY]);
+    seed = (uint64_t)mxGetScalar(input[I_SEED]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    o_sample_coded_dims[0] = row_count;
+    o_sample_coded_dims[1] = col_count;
+    o_sample_coded_dims[2] = layer_count;
+    o_sample_coded_dims[3] = image_count;
+    output[O_SAMPLE_CODED] = mxCreateNumericArray(4,o_sample_coded_dims,mxDOUBLE_CLASS,mxREAL);
+    o_sample_coded = mxGetPr(output[O_SAMPLE_CODED]);
+
+    /* Build task distribution information. */
+
+    global_info.row_count = row_count;
+    global_info.col_count = col_count;
+    global_info.layer_count = layer_count;
+    global_info.scaling_max = scaling_max;
+    global_info.rotation_max = rotation_max;
+    global_info.field_smoothness = field_smoothness;
+    global_info.field_intensity = field_intensity;
+    global_info.seed = seed;
+
+    task_info = (struct task_info*)mxMalloc(image_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < image_count; ii++) {
+	task_info[ii].o_image = o_sample_coded + ii * image_size;
+	task_info[ii].image_idx = ii;
+	task_info[ii].image = sample + ii * image_size;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,image_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+    /* Free memory. */
+
+    mxFree(task_info);
+}
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "patch_sampler.h"
+
+#define MAX_ROUND_COUNT 100000
+
+enum output_decoder {
+    O_PATCHES  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE             = 0,
+    I_PATCHES_COUNT      = 1,
+    I_PATCH_ROW_COUNT    = 2,
+    I_PATCH_COL_COUNT    = 3,
+    I_REQUIRED_VARIANCE  = 4,
+    I_SEED               = 5,
+    I_NUM_WORKERS        = 6,
+    INPUTS_COUNT
+};
+
+struct candidate {
+    size_t  slot;
+    size_t  image_idx;
+    size_t  row_skip;
+    size_t  col_skip;
+    bool    accepted;
+};
+
+struct global_info {
+    size_t         row_count;
+    size_t         col_count;
+    size_t         layer_count;
+    size_t         patch_row_count;
+    size_t         patch_col_count;
+    double         required_variance;
+    const double*  sample;
+    double*        o_patches;
+};
+
+struct task_info {
+    struct candidate*  candidates;
+    size_t             candidate_count;
+};
+
+static int
+compare_candidates(
+    const void*  a,
+    const void*  b) {
+    const struct candidate*  ca;
+    const struct candidate*  cb;
+
+    ca = (const struct candidate*)a;
+    cb = (const struct candidate*)b;
+
+    if (ca->image_idx != cb->image_idx) {
+	return ca->image_idx < cb->image_idx ? -1 : 1;
+    }
+
+    return ca->slot < cb->slot ? -1 : (ca->slot > cb->slot ? 1 : 0);
+}
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*              tmps;
+    double*            sum;
+    double*            sum_sqr;
+    size_t             image_size;
+    size_t             patch_size;
+    const double*      image;
+    struct candidate*  candidate;
+    bool               use_integral;
+    double             variance;
+    size_t             ii;
+    size_t             jj;
+
+    image_size = global_info->row_count * global_info->col_count * global_info->layer_count;
+    patch_size = global_info->patch_row_count * global_info->patch_col_count * global_info->layer_count;
+
+    tmps = (char*)malloc(patch_sampler_tmps_length(global_info->row_count,global_info->col_count,global_info->layer_count));
+    sum = (double*)tmps;
+    sum_sqr = (double*)(tmps + (global_info->row_count + 1) * (global_info->col_count + 1) * sizeof(double));
+
+    /* Each task holds all the candidates of one image for this round. */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	image = global_info->sample + task_info[ii].candidates[0].image_idx * image_size;
+	use_integral = patch_sampler_use_integral(task_info[ii].candidate_count,global_info->row_count,global_info->col_count,
+						  global_info->patch_row_count,global_info->patch_col_count);
+
+	if (use_integral) {
+	    build_integral_images(sum,sum_sqr,global_info->row_count,global_info->col_count,global_info->layer_count,image);
+	}
+
+	for (jj = 0; jj < task_info[ii].candidate_count; jj++) {
+	    candidate = &task_info[ii].candidates[jj];
+
+	    if (use_integral) {
+		variance = patch_variance_integral(global_info->row_count,global_info->col_count,global_info->layer_count,
+						   global_info->patch_row_count,global_info->patch_col_count,
+						   candidate->row_skip,candidate->col_skip,sum,sum_sqr);
+	    } else {
+		variance = patch_variance_direct(global_info->row_count,global_info->col_count,global_info->layer_count,
+						 global_info->patch_row_count,global_info->patch_col_count,
+						 candidate->row_skip,candidate->col_skip,image);
+	    }
+
+	    if (variance >= global_info->required_variance) {
+		extract_patch(global_info->o_patches + candidate->slot * patch_size,
+			      global_info->row_count,global_info->col_count,global_info->layer_count,
+			      global_info->patch_row_count,global_info->patch_col_count,
+			      candidate->row_skip,candidate->col_skip,image);
+		candidate->accepted = true;
+	    }
+	}
+    }
+
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t              row_count;
+    size_t              col_count;
+    size_t              layer_count;
+    size_t              image_count;
+    const mwSize*       sample_dims;
+    size_t              sample_dims_count;
+    const double*       sample;
+    size_t              patches_count;
+    size_t              patch_row_count;
+    size_t              patch_col_count;
+    double              required_variance;
+    uint64_t            seed;
+    size_t              num_workers;
+    mwSize              o_patches_dims[4];
+    size_t*             pending_slots;
+    size_t              pending_count;
+    size_t              candidate_count;
+    struct candidate*   candidates;
+    struct global_info  global_info;
+    struct task_info*   task_info;
+    size_t              task_info_count;
+    size_t              round;
+    size_t              ii;
+
+    /* Extract relevant information from all inputs. */
+
+    sample_dims_count = mxGetNumberOfDimensions(input[I_SAMPLE]);
+    sample_dims = mxGetDimensions(input[I_SAMPLE]);
+    row_count = sample_dims[0];
+    col_count = sample_dims[1];
+    layer_count = sample_dims_count >= 3 ? sample_dims[2] : 1;
+    image_count = sample_dims_count >= 4 ? sample_dims[3] : 1;
+    sample = mxGetPr(input[I_SAMPLE]);
+    patches_count = (size_t)mxGetScalar(input[I_PATCHES_COUNT]);
+    patch_row_count = (size_t)mxGetScalar(input[I_PATCH_ROW_COUNT]);
+    patch_col_count = (size_t)mxGetScalar(input[I_PATCH_COL_COUNT]);
+    required_variance = mxGetScalar(input[I_REQUIRED_VARIANCE]);
+    seed = (uint64_t)mxGetScalar(input[I_SEED]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    o_patches_dims[0] = patch_row_count;
+    o_patches_dims[1] = patch_col_count;
+    o_patches_dims[2] = layer_count;
+    o_patches_dims[3] = patches_count;
+    output[O_PATCHES] = mxCreateNumericArray(4,o_patches_dims,mxDOUBLE_CLASS,mxREAL);
+
+    /* Build task distribution information. */
+
+    global_info.row_count = row_count;
+    global_info.col_count = col_count;
+    global_info.layer_count = layer_count;
+    global_info.patch_row_count = patch_row_count;
+    global_info.patch_col_count = patch_col_count;
+    global_info.required_variance = required_variance;
+    global_info.sample = sample;
+    global_info.o_patches = mxGetPr(output[O_PATCHES]);
+
+    pending_slots = (size_t*)mxMalloc(patches_count * sizeof(size_t));
+    candidates = (struct candidate*)mxMalloc(patches_count * sizeof(struct candidate));
+    task_info = (struct task_info*)mxMalloc(patches_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < patches_count; ii++) {
+	pending_slots[ii] = ii;
+    }
+
+    pending_count = patches_count;
+
+    /* Run workers and compute output. In each round every still empty slot draws one candidate from its own
+       stream, so the result depends only on "seed" and not on "num_workers". Candidates are grouped by image
+       so an image is read, and possibly integrated, once per round. */
+
+    for (round = 0; pending_count > 0; round++) {
+	check_condition(round < MAX_ROUND_COUNT,"master:NoConvergence","Could not find enough patches with the required variance.");
+
+	for (ii = 0; ii < pending_count; ii++) {
+	    candidates[ii].slot = pending_slots[ii];
+	    candidates[ii].accepted = false;
+	    draw_patch_candidate(&candidates[ii].image_idx,&candidates[ii].row_skip,&candidates[ii].col_skip,
+				 seed,pending_slots[ii],round,image_count,row_count,col_count,patch_row_count,patch_col_count);
+	}
+
+	qsort(candidates,pending_count,sizeof(struct candidate),compare_candidates);
+
+	task_info_count = 0;
+
+	for (ii = 0; ii < pending_count; ii++) {
+	    if ((ii == 0) || (candidates[ii].image_idx != candidates[ii - 1].image_idx)) {
+		task_info[task_info_count].candidates = candidates + ii;
+		task_info[task_info_count].candidate_count = 0;
+		task_info_count += 1;
+	    }
+
+	    task_info[task_info_count - 1].candidate_count += 1;
+	}
+
+	run_workers_x(&global_info,NULL,task_info_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,
+		      num_workers < task_info_count ? num_workers : task_info_count);
+
+	candidate_count = pending_count;
+	pending_count = 0;
+
+	for (ii = 0; ii < candidate_count; ii++) {
+	    if (!candidates[ii].accepted) {
+		pending_slots[pending_count] = candidates[ii].slot;
+		pending_count += 1;
+	    }
+	}
+    }
+
+    /* Free memory. */
+
+    mxFree(task_info);
+    mxFree(candidates);
+    mxFree(pending_slots);
+}
@@ -0,0 +1,317 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "latools.h"
+#include "image_coder.h"
+#include "dataset_file.h"
+#include "linear_classifier.h"
+
+enum output_decoder {
+    O_CLASSIFIERS_DECISIONS  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_ROW_COUNT            = 0,
+    I_COL_COUNT            = 1,
+    I_PATCH_ROW_COUNT      = 2,
+    I_PATCH_COL_COUNT      = 3,
+    I_CHANNEL_MODE         = 4,
+    I_CODING_TYPE          = 5,
+    I_DICT                 = 6,
+    I_DICT_TRANSP          = 7,
+    I_DICT_X_DICT_TRANSP   = 8,
+    I_COEFF_COUNT          = 9,
+    I_CODING_PARAMS        = 10,
+    I_NONLINEAR_TYPE       = 11,
+    I_NONLINEAR_MODULATOR  = 12,
+    I_POLARITY_SPLIT_TYPE  = 13,
+    I_REDUCE_TYPE          = 14,
+    I_REDUCE_SPREAD        = 15,
+    I_HASHED_GEOMETRY      = 16,
+    I_SAMPLE               = 17,
+    I_MODEL_WEIGHTS        = 18,
+    I_FEATURE_IDS          = 19,
+    I_NUM_WORKERS          = 20,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t                                 geometry;
+    size_t                                 new_geometry;
+    size_t                                 row_count;
+    size_t                                 col_count;
+    size_t                                 layer_count;
+    size_t                                 patch_row_count;
+    size_t                                 patch_col_count;
+    enum channel_mode                      channel_mode;
+    enum coding_type                       coding_type;
+    size_t                                 word_count;
+    const struct dictionary_state* const*  dicts;
+    size_t                                 coeff_count;
+    const void*                            coding_params;
+    enum nonlinear_type                    nonlinear_type;
+    const double*                          nonlinear_modulator;
+    enum polarity_split_type               polarity_split_type;
+    enum reduce_type                       reduce_type;
+    size_t                                 reduce_spread;
+    size_t                                 hashed_geometry;
+    enum dataset_dtype                     sample_dtype;
+    const size_t*                          feature_map;
+    size_t                                 classifiers_geometry;
+    size_t                                 classifiers_count;
+    const double*                          weights_by_feature;
+};
+
+struct task_info {
+    double*      o_decisions;
+    const void*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    size_t         o_coeffs_count;
+    double*        o_coeffs;
+    coeff_idx_t*   o_coeffs_idx;
+    size_t*        o_features_idx;
+    char*          coding_tmps;
+    double*        observation_buffer;
+    const double*  observation;
+    void*          param_table[2] = {NULL,NULL};
+    size_t         ii;
+
+    o_coeffs = (double*)malloc(global_info->new_geometry * sizeof(double));
+    o_coeffs_idx = (coeff_idx_t*)malloc(global_info->new_geometry * sizeof(coeff_idx_t));
+    o_features_idx = (size_t*)malloc(global_info->new_geometry * sizeof(size_t));
+    coding_tmps = (char*)malloc(code_image_coding_tmps_length(global_info->row_count,global_info->col_count,global_info->layer_count,global_info->patch_row_count,global_info->patch_col_count,
+							      global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->coeff_count,global_info->reduce_spread,global_info->hashed_geometry));
+    observation_buffer = (double*)malloc(global_info->geometry * sizeof(double));
+
+    make_param_table(param_table,global_info->coding_type,(const double*)global_info->coding_params,id);
+
+    /* The coded observation only ever lives in the worker's buffers, and is reduced to the decisions of all the
+       classifiers right after "code_image" produces it, while it is still in cache. */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	if (global_info->sample_dtype == DTYPE_FLOAT64) {
+	    observation = (const double*)task_info[ii].observation;
+	} else {
+	    dataset_convert(observation_buffer,global_info->sample_dtype,global_info->geometry,task_info[ii].observation);
+	    observation = observation_buffer;
+	}
+
+	code_image(&o_coeffs_count,o_coeffs,o_coeffs_idx,
+		   global_info->geometry,global_info->row_count,global_info->col_count,global_info->layer_count,
+		   global_info->patch_row_count,global_info->patch_col_count,
+		   global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->dicts,global_info->coeff_count,&param_table,
+		   global_info->nonlinear_type,global_info->nonlinear_modulator,global_info->polarity_split_type,global_info->reduce_type,global_info->reduce_spread,global_info->hashed_geometry,
+		   observation,coding_tmps);
+
+	widen_idx(o_features_idx,o_coeffs_idx,o_coeffs_count);
+
+	if (global_info->feature_map != NULL) {
+	    o_coeffs_count = linear_classifier_compact(o_coeffs,o_features_idx,o_coeffs_count,global_info->feature_map);
+	}
+
+	linear_classifier_decide(task_info[ii].o_decisions,global_info->classifiers_geometry,global_info->classifiers_count,global_info->weights_by_feature,
+				 o_coeffs_count,o_coeffs,o_features_idx);
+    }
+
+    free_param_table(param_table,global_info->coding_type);
+
+    free(observation_buffer);
+    free(coding_tmps);
+    free(o_features_idx);
+    free(o_coeffs_idx);
+    free(o_coeffs);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                           geometry;
+    size_t                           row_count;
+    size_t                           col_count;
+    size_t                           layer_count;
+    size_t                           patch_row_count;
+    size_t                           patch_col_count;
+    enum channel_mode                channel_mode;
+    enum coding_type                 coding_type;
+    size_t                           word_count;
+    const struct dictionary_state**  dicts;
+    size_t                           coeff_count;
+    const void*                      coding_params;
+    enum nonlinear_type              nonlinear_type;
+    const double*                    nonlinear_modulator;
+    enum polarity_split_type         polarity_split_type;
+    enum reduce_type                 reduce_type;
+    size_t                           reduce_spread;
+    size_t                           hashed_geometry;
+    size_t                           dict_count;
+    size_t                           dict_geometry;
+    size_t                           sample_count;
+    const char*                      sample;
+    enum dataset_dtype               sample_dtype;
+    size_t                           observation_length;
+    char*                            sample_path;
+    struct dataset_file              sample_file;
+    bool                             ok;
+    size_t                           classifiers_count;
+    const double*                    weights;
+    size_t                           feature_count;
+    const double*                    feature_ids;
+    size_t                           num_workers;
+    size_t*                          feature_ids_zero_based;
+    size_t*                          feature_map;
+    double*                          weights_by_feature;
+    double*                          o_classifiers_decisions;
+    struct global_info               global_info;
+    struct task_info*                task_info;
+    size_t                           ii;
+
+    /* Extract relevant information from all inputs. A string "sample" is the path of a mapped dataset, which is
+       coded in place, without ever being loaded into memory as a whole. A non-empty "feature_ids" holds the one-based
+       features the classifiers were trained on, and coded observations are compacted to them before classification. */
+
+    row_count = (size_t)mxGetScalar(input[I_ROW_COUNT]);
+    col_count = (size_t)mxGetScalar(input[I_COL_COUNT]);
+    patch_row_count = (size_t)mxGetScalar(input[I_PATCH_ROW_COUNT]);
+    patch_col_count = (size_t)mxGetScalar(input[I_PATCH_COL_COUNT]);
+    channel_mode = (enum channel_mode)mxGetScalar(input[I_CHANNEL_MODE]);
+    coding_type = (enum coding_type)mxGetScalar(input[I_CODING_TYPE]);
+    extract_dictionaries(&dict_count,&dict_geometry,&word_count,&dicts,input[I_DICT],input[I_DICT_TRANSP],input[I_DICT_X_DICT_TRANSP]);
+    coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
+    coding_params = mxGetPr(input[I_CODING_PARAMS]);
+    nonlinear_type = (enum nonlinear_type)mxGetScalar(input[I_NONLINEAR_TYPE]);
+    nonlinear_modulator = mxGetPr(input[I_NONLINEAR_MODULATOR]);
+    polarity_split_type = (enum polarity_split_type)mxGetScalar(input[I_POLARITY_SPLIT_TYPE]);
+    reduce_type = (enum reduce_type)mxGetScalar(input[I_REDUCE_TYPE]);
+    reduce_spread = (size_t)mxGetScalar(input[I_REDUCE_SPREAD]);
+    hashed_geometry = (size_t)mxGetScalar(input[I_HASHED_GEOMETRY]);
+    classifiers_count = mxGetN(input[I_MODEL_WEIGHTS]);
+    weights = mxGetPr(input[I_MODEL_WEIGHTS]);
+    feature_count = mxGetNumberOfElements(input[I_FEATURE_IDS]);
+    feature_ids = mxGetPr(input[I_FEATURE_IDS]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    if (mxIsChar(input[I_SAMPLE])) {
+	sample_path = mxArrayToString(input[I_SAMPLE]);
+	ok = dataset_file_open(&sample_file,sample_path);
+	check_condition(ok,"master:NoLoad","Could not open dataset file.");
+
+	geometry = sample_file.geometry;
+	sample_count = (size_t)sample_file.header.count;
+	sample = sample_file.data;
+	sample_dtype = (enum dataset_dtype)sample_file.header.dtype;
+	observation_length = sample_file.observation_length;
+    } else {
+	sample_path = NULL;
+
+	geometry = mxGetM(input[I_SAMPLE]);
+	sample_count = mxGetN(input[I_SAMPLE]);
+	sample = (const char*)mxGetPr(input[I_SAMPLE]);
+	sample_dtype = DTYPE_FLOAT64;
+	observation_length = geometry * sizeof(double);
+    }
+
+    layer_count = geometry / (row_count * col_count);
+
+    check_condition(layer_count * row_count * col_count == geometry,"master:InvalidGeometry","Sample geometry is not a whole number of image layers.");
+    check_condition(dict_count == (channel_mode == PER_CHANNEL ? layer_count : 1),"master:InvalidHandle","There must be one dictionary per channel.");
+    check_condition(dict_geometry * dict_count == patch_row_count * patch_col_count * layer_count,"master:InvalidGeometry","Dictionary geometry does not match the patch size.");
+    check_condition(code_image_idx_fits(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry),
+		    "master:InvalidGeometry","Coded geometry has more features than coefficient indices can hold.");
+
+    /* Build output structures. */
+
+    output[O_CLASSIFIERS_DECISIONS] = mxCreateDoubleMatrix(classifiers_count,sample_count,mxREAL);
+    o_classifiers_decisions = mxGetPr(output[O_CLASSIFIERS_DECISIONS]);
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.new_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry);
+    global_info.row_count = row_count;
+    global_info.col_count = col_count;
+    global_info.layer_count = layer_count;
+    global_info.patch_row_count = patch_row_count;
+    global_info.patch_col_count = patch_col_count;
+    global_info.channel_mode = channel_mode;
+    global_info.coding_type = coding_type;
+    global_info.word_count = word_count;
+    global_info.dicts = dicts;
+    global_info.coeff_count = coeff_count;
+    global_info.coding_params = coding_params;
+    global_info.nonlinear_type = nonlinear_type;
+    global_info.nonlinear_modulator = nonlinear_modulator;
+    global_info.polarity_split_type = polarity_split_type;
+    global_info.reduce_type = reduce_type;
+    global_info.reduce_spread = reduce_spread;
+    global_info.hashed_geometry = hashed_geometry;
+    global_info.sample_dtype = sample_dtype;
+    global_info.classifiers_count = classifiers_count;
+
+    if (feature_count > 0) {
+	feature_ids_zero_based = (size_t*)mxMalloc(feature_count * sizeof(size_t));
+
+	for (ii = 0; ii < feature_count; ii++) {
+	    feature_ids_zero_based[ii] = (size_t)feature_ids[ii] - 1;
+	}
+
+	feature_map = (size_t*)mxMalloc(global_info.new_geometry * sizeof(size_t));
+	linear_classifier_feature_map(feature_map,global_info.new_geometry,feature_count,feature_ids_zero_based);
+	mxFree(feature_ids_zero_based);
+
+	global_info.feature_map = feature_map;
+	global_info.classifiers_geometry = feature_count;
+    } else {
+	feature_map = NULL;
+	global_info.feature_map = NULL;
+	global_info.classifiers_geometry = global_info.new_geometry;
+    }
+
+    weights_by_feature = (double*)mxMalloc((global_info.classifiers_geometry + 1) * classifiers_count * sizeof(double));
+    linear_classifier_weights_by_feature(weights_by_feature,global_info.classifiers_geometry,classifiers_count,weights);
+    global_info.weights_by_feature = weights_by_feature;
+
+    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].o_decisions = o_classifiers_decisions + ii * classifiers_count;
+	task_info[ii].observation = sample + ii * observation_length;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+    /* Free memory. */
+
+    mxFree(dicts);
+
+    mxFree(task_info);
+    mxFree(weights_by_feature);
+
+    if (feature_map != NULL) {
+	mxFree(feature_map);
+    }
+
+    if (sample_path != NULL) {
+	dataset_file_close(&sample_file);
+	mxFree(sample_path);
+    }
+}
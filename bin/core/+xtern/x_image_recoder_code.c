@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include <pthread.h>
@@ -10,7 +11,9 @@
 #include "x_mex_interface.h"
 #include "base_defines.h"
 #include "task_control.h"
+#include "latools.h"
 #include "image_coder.h"
+#include "dataset_file.h"
 
 enum output_decoder {
     O_SAMPLE_CODED       = 0,
@@ -23,41 +26,48 @@ enum input_decoder {
     I_COL_COUNT            = 1,
     I_PATCH_ROW_COUNT      = 2,
     I_PATCH_COL_COUNT      = 3,
-    I_CODING_TYPE          = 4,
-    I_DICT                 = 5,
-    I_DICT_TRANSP          = 6,
-    I_DICT_X_DICT_TRANSP   = 7,
-    I_COEFF_COUNT          = 8,
-    I_CODING_PARAMS        = 9,
-    I_NONLINEAR_TYPE       = 10,
-    I_NONLINEAR_MODULATOR  = 11,
-    I_POLARITY_SPLIT_TYPE  = 12,
-    I_REDUCE_TYPE          = 13,
-    I_REDUCE_SPREAD        = 14,
-    I_SAMPLE               = 15,
-    I_NUM_WORKERS          = 16,
+    I_CHANNEL_MODE         = 4,
+    I_CODING_TYPE          = 5,
+    I_DICT                 = 6,
+    I_DICT_TRANSP          = 7,
+    I_DICT_X_DICT_TRANSP   = 8,
+    I_COEFF_COUNT          = 9,
+    I_CODING_PARAMS        = 10,
+    I_NONLINEAR_TYPE       = 11,
+    I_NONLINEAR_MODULATOR  = 12,
+    I_POLARITY_SPLIT_TYPE  = 13,
+    I_REDUCE_TYPE          = 14,
+    I_REDUCE_SPREAD        = 15,
+    I_HASHED_GEOMETRY      = 16,
+    I_SAMPLE               = 17,
+    I_MAX_BAND_COUNT       = 18,
+    I_NUM_WORKERS          = 19,
     INPUTS_COUNT
 };
 
 struct global_info {
-    size_t                    geometry;
-    size_t                    new_geometry;
-    size_t                    row_count;
-    size_t                    col_count;
-    size_t                    patch_row_count;
-    size_t                    patch_col_count;
-    enum coding_type          coding_type;
-    size_t                    word_count;
-    const double*             dict;
-    const double*             dict_transp;
-    const double*             dict_x_dict_transp;
-    size_t                    coeff_count;
-    const void*               coding_params;
-    enum nonlinear_type       nonlinear_type;
-    const double*             nonlinear_modulator;
-    enum polarity_split_type  polarity_split_type;
-    enum reduce_type          reduce_type;
-    size_t                    reduce_spread;
+    size_t                                 geometry;
+    size_t                                 new_geometry;
+    size_t                                 row_count;
+    size_t                                 col_count;
+    size_t                                 layer_count;
+    size_t                                 patch_row_count;
+    size_t                                 patch_col_count;
+    enum channel_mode                      channel_mode;
+    enum coding_type                       coding_type;
+    size_t                                 word_count;
+    const struct dictionary_state* const*  dicts;
+    size_t                                 coeff_count;
+    const void*                            coding_params;
+    enum nonlinear_type                    nonlinear_type;
+    const double*                          nonlinear_modulator;
+    enum polarity_split_type               polarity_split_type;
+    enum reduce_type                       reduce_type;
+    size_t                                 reduce_spread;
+    size_t                                 hashed_geometry;
+    enum dataset_dtype                     sample_dtype;
+    size_t                                 band_row_count;
+    size_t                                 band_capacity;
 };
 
 struct global_vars {
@@ -68,11 +78,19 @@ struct global_vars {
     size_t           current_sample_coded_count;
     size_t           current_sample_coded_length;
     pthread_mutex_t  coeffs_queue_control;
+    const double*    band_observation;
+    size_t*          bands_coeff_count;
+    double*          bands_coeffs;
+    coeff_idx_t*     bands_coeffs_idx;
 };
 
 struct task_info {
-    size_t         observation_id;
-    const double*  observation;
+    size_t       observation_id;
+    const void*  observation;
+};
+
+struct band_task_info {
+    size_t  band_idx;
 };
 
 static void
@@ -82,41 +100,41 @@ do_task(
     struct global_vars*        global_vars,
     size_t                     task_info_count,
     struct task_info*          task_info) {
-    size_t   o_coeffs_count;
-    double*  o_coeffs;
-    size_t*  o_coeffs_idx;
-    char*    coding_tmps;
-    size_t   initial_sample_coded_count;
-    size_t   initial_sample_coded_length;
-    void*    param_table[2] = {NULL,NULL};
-    size_t   ii;
+    size_t         o_coeffs_count;
+    double*        o_coeffs;
+    coeff_idx_t*   o_coeffs_idx;
+    char*          coding_tmps;
+    double*        observation_buffer;
+    const double*  observation;
+    size_t         initial_sample_coded_count;
+    size_t         initial_sample_coded_length;
+    void*          param_table[2] = {NULL,NULL};
+    size_t         ii;
 
     o_coeffs = (double*)malloc(global_info->new_geometry * sizeof(double));
-    o_coeffs_idx = (size_t*)malloc(global_info->new_geometry * sizeof(double));
-    coding_tmps = (char*)malloc(code_image_coding_tmps_length(global_info->row_count,global_info->col_count,global_info->patch_row_count,global_info->patch_col_count,
-							      global_info->coding_type,global_info->word_count,global_info->coeff_count,global_info->reduce_spread));
-
-    if (global_info->coding_type == SPARSE_NET) {
-	double*   local_lambda_sigma_ratio;
-	gsl_rng*  rnd_generator;
+    o_coeffs_idx = (coeff_idx_t*)malloc(global_info->new_geometry * sizeof(coeff_idx_t));
+    coding_tmps = (char*)malloc(code_image_coding_tmps_length(global_info->row_count,global_info->col_count,global_info->layer_count,global_info->patch_row_count,global_info->patch_col_count,
+							      global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->coeff_count,global_info->reduce_spread,global_info->hashed_geometry));
+    observation_buffer = (double*)malloc(global_info->geometry * sizeof(double));
 
-	local_lambda_sigma_ratio = (double*)malloc(sizeof(double));
-	*local_lambda_sigma_ratio = ((double*)global_info->coding_params)[0];
+    make_param_table(param_table,global_info->coding_type,(const double*)global_info->coding_params,id);
 
-	rnd_generator = gsl_rng_alloc(gsl_rng_mt19937);
-	gsl_rng_set(rnd_generator,id);
-
-	param_table[0] = local_lambda_sigma_ratio;
-	param_table[1] = rnd_generator;
-    }
+    /* Observations of a mapped dataset stored with a narrower type are widened one at a time, right before coding. */
 
     for (ii = 0; ii < task_info_count; ii++) {
+	if (global_info->sample_dtype == DTYPE_FLOAT64) {
+	    observation = (const double*)task_info[ii].observation;
+	} else {
+	    dataset_convert(observation_buffer,global_info->sample_dtype,global_info->geometry,task_info[ii].observation);
+	    observation = observation_buffer;
+	}
+
 	code_image(&o_coeffs_count,o_coeffs,o_coeffs_idx,
-		   global_info->geometry,global_info->row_count,global_info->col_count,
+		   global_info->geometry,global_info->row_count,global_info->col_count,global_info->layer_count,
 		   global_info->patch_row_count,global_info->patch_col_count,
-		   global_info->coding_type,global_info->word_count,global_info->dict,global_info->dict_transp,global_info->dict_x_dict_transp,global_info->coeff_count,&param_table,
-		   global_info->nonlinear_type,global_info->nonlinear_modulator,global_info->polarity_split_type,global_info->reduce_type,global_info->reduce_spread,
-		   task_info[ii].observation,coding_tmps);
+		   global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->dicts,global_info->coeff_count,&param_table,
+		   global_info->nonlinear_type,global_info->nonlinear_modulator,global_info->polarity_split_type,global_info->reduce_type,global_info->reduce_spread,global_info->hashed_geometry,
+		   observation,coding_tmps);
 
 	pthread_mutex_lock(&global_vars->coeffs_queue_control);
 	initial_sample_coded_count = global_vars->current_sample_coded_count;
@@ -126,66 +144,120 @@ do_task(
 	pthread_mutex_unlock(&global_vars->coeffs_queue_control);
 
 	memcpy(global_vars->o_sample_coded_pr + initial_sample_coded_length,o_coeffs,o_coeffs_count * sizeof(double));
-	memcpy(global_vars->o_sample_coded_ir + initial_sample_coded_length,o_coeffs_idx,o_coeffs_count * sizeof(size_t));
+	widen_idx(global_vars->o_sample_coded_ir + initial_sample_coded_length,o_coeffs_idx,o_coeffs_count);
 	global_vars->o_sample_coded_jc[initial_sample_coded_count] = initial_sample_coded_length;
 	global_vars->o_observations_perm[initial_sample_coded_count] = task_info[ii].observation_id;
     }
 
-    if (global_info->coding_type == SPARSE_NET) {
-	gsl_rng_free((gsl_rng*)param_table[1]);
-	free((double*)param_table[1]);
-    }
+    free_param_table(param_table,global_info->coding_type);
 
+    free(observation_buffer);
     free(coding_tmps);
     free(o_coeffs_idx);
     free(o_coeffs);
 }
 
+static void
+do_band_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    struct global_vars*        global_vars,
+    size_t                     task_info_count,
+    struct band_task_info*     task_info) {
+    char*   coding_tmps;
+    void*   param_table[2] = {NULL,NULL};
+    size_t  band_idx;
+    size_t  ii;
+
+    if (task_info_count == 0) {
+	return;
+    }
+
+    coding_tmps = (char*)malloc(code_image_band_tmps_length(global_info->col_count,global_info->layer_count,global_info->patch_row_count,global_info->patch_col_count,
+							    global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->coeff_count,global_info->reduce_spread,global_info->band_row_count));
+
+    make_param_table(param_table,global_info->coding_type,(const double*)global_info->coding_params,id);
+
+    /* Every band writes to its own slot of the band buffers, so no locking is needed. With "SPARSE_NET", the
+       generator is reseeded by band, so the coded image does not depend on which worker took which band, though it
+       still depends on the band count. */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	band_idx = task_info[ii].band_idx;
+
+	if (global_info->coding_type == SPARSE_NET) {
+	    gsl_rng_set((gsl_rng*)param_table[1],band_idx);
+	}
+
+	code_image_band(&global_vars->bands_coeff_count[band_idx],
+			global_vars->bands_coeffs + band_idx * global_info->band_capacity,
+			global_vars->bands_coeffs_idx + band_idx * global_info->band_capacity,
+			global_info->geometry,global_info->row_count,global_info->col_count,global_info->layer_count,
+			global_info->patch_row_count,global_info->patch_col_count,
+			global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->dicts,global_info->coeff_count,&param_table,
+			global_info->nonlinear_type,global_info->nonlinear_modulator,global_info->polarity_split_type,global_info->reduce_type,global_info->reduce_spread,
+			global_info->band_row_count,band_idx,global_vars->band_observation,coding_tmps);
+    }
+
+    free_param_table(param_table,global_info->coding_type);
+
+    free(coding_tmps);
+}
+
 void
 mexFunction(
     int             output_count,
     mxArray*        output[],
     int             input_count,
     const mxArray*  input[]) {
-    size_t                    geometry;
-    size_t                    row_count;
-    size_t                    col_count;
-    size_t                    patch_row_count;
-    size_t                    patch_col_count;
-    enum coding_type          coding_type;
-    size_t                    word_count;
-    const double*             dict;
-    const double*             dict_transp;
-    const double*             dict_x_dict_transp;
-    size_t                    coeff_count;
-    const void*               coding_params;
-    enum nonlinear_type       nonlinear_type;
-    const double*             nonlinear_modulator;
-    enum polarity_split_type  polarity_split_type;
-    enum reduce_type          reduce_type;
-    size_t                    reduce_spread;
-    size_t                    sample_count;
-    const double*             sample;
-    size_t                    num_workers;
-    struct global_info        global_info;
-    struct global_vars        global_vars;
-    struct task_info*         task_info;
-    int                       pthread_res;
-    double*                   o_observations_perm;
-    size_t                    ii;
-
-    /* Extract relevant information from all inputs. */
-
-    geometry = mxGetM(input[I_SAMPLE]);
+    size_t                           geometry;
+    size_t                           row_count;
+    size_t                           col_count;
+    size_t                           layer_count;
+    size_t                           patch_row_count;
+    size_t                           patch_col_count;
+    enum channel_mode                channel_mode;
+    enum coding_type                 coding_type;
+    size_t                           word_count;
+    const struct dictionary_state**  dicts;
+    size_t                           coeff_count;
+    const void*                      coding_params;
+    enum nonlinear_type              nonlinear_type;
+    const double*                    nonlinear_modulator;
+    enum polarity_split_type         polarity_split_type;
+    enum reduce_type                 reduce_type;
+    size_t                           reduce_spread;
+    size_t                           hashed_geometry;
+    size_t                           dict_count;
+    size_t                           dict_geometry;
+    size_t                           sample_count;
+    const char*                      sample;
+    enum dataset_dtype               sample_dtype;
+    size_t                           observation_length;
+    char*                            sample_path;
+    struct dataset_file              sample_file;
+    bool                             ok;
+    size_t                           max_band_count;
+    size_t                           band_count;
+    size_t                           num_workers;
+    struct global_info               global_info;
+    struct global_vars               global_vars;
+    struct task_info*                task_info;
+    struct band_task_info*           band_task_info;
+    int                              pthread_res;
+    double*                          o_observations_perm;
+    size_t                           ii;
+
+    /* Extract relevant information from all inputs. A string "sample" is the path of a mapped dataset, which is
+       coded in place, without ever being loaded into memory as a whole. */
+
     row_count = (size_t)mxGetScalar(input[I_ROW_COUNT]);
     col_count = (size_t)mxGetScalar(input[I_COL_COUNT]);
     patch_row_count = (size_t)mxGetScalar(input[I_PATCH_ROW_COUNT]);
     patch_col_count = (size_t)mxGetScalar(input[I_PATCH_COL_COUNT]);
+    channel_mode = (enum channel_mode)mxGetScalar(input[I_CHANNEL_MODE]);
     coding_type = (enum coding_type)mxGetScalar(input[I_CODING_TYPE]);
-    word_count = mxGetM(input[I_DICT]);
-    dict = mxGetPr(input[I_DICT]);
-    dict_transp = mxGetPr(input[I_DICT_TRANSP]);
-    dict_x_dict_transp = mxGetPr(input[I_DICT_X_DICT_TRANSP]);
+    extract_dictionaries(&dict_count,&dict_geometry,&word_count,&dicts,input[I_DICT],input[I_DICT_TRANSP],input[I_DICT_X_DICT_TRANSP]);
     coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
     coding_params = mxGetPr(input[I_CODING_PARAMS]);
     nonlinear_type = (enum nonlinear_type)mxGetScalar(input[I_NONLINEAR_TYPE]);
@@ -193,23 +265,55 @@ mexFunction(
     polarity_split_type = (enum polarity_split_type)mxGetScalar(input[I_POLARITY_SPLIT_TYPE]);
     reduce_type = (enum reduce_type)mxGetScalar(input[I_REDUCE_TYPE]);
     reduce_spread = (size_t)mxGetScalar(input[I_REDUCE_SPREAD]);
-    sample_count = mxGetN(input[I_SAMPLE]);
-    sample = mxGetPr(input[I_SAMPLE]);
+    hashed_geometry = (size_t)mxGetScalar(input[I_HASHED_GEOMETRY]);
+    max_band_count = (size_t)mxGetScalar(input[I_MAX_BAND_COUNT]);
     num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
 
+    if (mxIsChar(input[I_SAMPLE])) {
+	sample_path = mxArrayToString(input[I_SAMPLE]);
+	ok = dataset_file_open(&sample_file,sample_path);
+	check_condition(ok,"master:NoLoad","Could not open dataset file.");
+
+	geometry = sample_file.geometry;
+	sample_count = (size_t)sample_file.header.count;
+	sample = sample_file.data;
+	sample_dtype = (enum dataset_dtype)sample_file.header.dtype;
+	observation_length = sample_file.observation_length;
+    } else {
+	sample_path = NULL;
+
+	geometry = mxGetM(input[I_SAMPLE]);
+	sample_count = mxGetN(input[I_SAMPLE]);
+	sample = (const char*)mxGetPr(input[I_SAMPLE]);
+	sample_dtype = DTYPE_FLOAT64;
+	observation_length = geometry * sizeof(double);
+    }
+
+    /* Images have "geometry / (row_count * col_count)" layers, and with "PER_CHANNEL" channels, one dictionary
+       for each of them. */
+
+    layer_count = geometry / (row_count * col_count);
+
+    check_condition(layer_count * row_count * col_count == geometry,"master:InvalidGeometry","Sample geometry is not a whole number of image layers.");
+    check_condition(dict_count == (channel_mode == PER_CHANNEL ? layer_count : 1),"master:InvalidHandle","There must be one dictionary per channel.");
+    check_condition(dict_geometry * dict_count == patch_row_count * patch_col_count * layer_count,"master:InvalidGeometry","Dictionary geometry does not match the patch size.");
+    check_condition(code_image_idx_fits(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry),
+		    "master:InvalidGeometry","Coded geometry has more features than coefficient indices can hold.");
+    check_condition(max_band_count >= 1,"master:InvalidGeometry","There must be at least one band per image.");
+
     /* Build task distribution information. */
 
     global_info.geometry = geometry;
-    global_info.new_geometry = code_image_new_geometry(row_count,col_count,word_count,polarity_split_type,reduce_spread);
+    global_info.new_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry);
     global_info.row_count = row_count;
     global_info.col_count = col_count;
+    global_info.layer_count = layer_count;
     global_info.patch_row_count = patch_row_count;
     global_info.patch_col_count = patch_col_count;
+    global_info.channel_mode = channel_mode;
     global_info.coding_type = coding_type;
     global_info.word_count = word_count;
-    global_info.dict = dict;
-    global_info.dict_transp = dict_transp;
-    global_info.dict_x_dict_transp = dict_x_dict_transp;
+    global_info.dicts = dicts;
     global_info.coeff_count = coeff_count;
     global_info.coding_params = coding_params;
     global_info.nonlinear_type = nonlinear_type;
@@ -217,6 +321,12 @@ mexFunction(
     global_info.polarity_split_type = polarity_split_type;
     global_info.reduce_type = reduce_type;
     global_info.reduce_spread = reduce_spread;
+    global_info.hashed_geometry = hashed_geometry;
+    global_info.sample_dtype = sample_dtype;
+    global_info.band_row_count = code_image_band_row_count(row_count,reduce_spread,max_band_count);
+    global_info.band_capacity = code_image_band_max_coeff_count(col_count,layer_count,channel_mode,coeff_count,reduce_spread,global_info.band_row_count);
+
+    band_count = code_image_band_count(row_count,reduce_spread,global_info.band_row_count);
 
     global_vars.o_sample_coded_pr = (double*)mxMalloc(global_info.new_geometry * sample_count * sizeof(double));
     global_vars.o_sample_coded_ir = (size_t*)mxMalloc(global_info.new_geometry * sample_count * sizeof(size_t));
@@ -227,17 +337,74 @@ mexFunction(
     pthread_res = pthread_mutex_init(&global_vars.coeffs_queue_control,NULL);
     check_condition(pthread_res == 0,"master:SystemError","Could not create queue mutex.");
 
-    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
-
-    for (ii = 0; ii < sample_count; ii++) {
-	task_info[ii].observation_id = ii;
-	task_info[ii].observation = sample + ii * geometry;
+    /* Run workers and compute output. With more than one band, images are coded one at a time, and the workers
+       share the rows of each image instead. This lowers the latency of coding a few large images, which would
+       otherwise keep only a few workers busy. */
+
+    if (band_count <= 1) {
+	task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+	for (ii = 0; ii < sample_count; ii++) {
+	    task_info[ii].observation_id = ii;
+	    task_info[ii].observation = sample + ii * observation_length;
+	}
+
+	run_workers_x(&global_info,&global_vars,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+	mxFree(task_info);
+    } else {
+	double*       observation_buffer;
+	size_t        o_coeffs_count;
+	double*       o_coeffs;
+	coeff_idx_t*  o_coeffs_idx;
+	char*         merge_tmps;
+
+	band_task_info = (struct band_task_info*)mxMalloc(band_count * sizeof(struct band_task_info));
+
+	for (ii = 0; ii < band_count; ii++) {
+	    band_task_info[ii].band_idx = ii;
+	}
+
+	global_vars.bands_coeff_count = (size_t*)mxMalloc(band_count * sizeof(size_t));
+	global_vars.bands_coeffs = (double*)mxMalloc(band_count * global_info.band_capacity * sizeof(double));
+	global_vars.bands_coeffs_idx = (coeff_idx_t*)mxMalloc(band_count * global_info.band_capacity * sizeof(coeff_idx_t));
+
+	observation_buffer = (double*)mxMalloc(geometry * sizeof(double));
+	o_coeffs = (double*)mxMalloc(global_info.new_geometry * sizeof(double));
+	o_coeffs_idx = (coeff_idx_t*)mxMalloc(global_info.new_geometry * sizeof(coeff_idx_t));
+	merge_tmps = (char*)mxMalloc(code_image_merge_bands_tmps_length(band_count,global_info.band_capacity,hashed_geometry));
+
+	for (ii = 0; ii < sample_count; ii++) {
+	    if (sample_dtype == DTYPE_FLOAT64) {
+		global_vars.band_observation = (const double*)(sample + ii * observation_length);
+	    } else {
+		dataset_convert(observation_buffer,sample_dtype,geometry,sample + ii * observation_length);
+		global_vars.band_observation = observation_buffer;
+	    }
+
+	    run_workers_x(&global_info,&global_vars,band_count,sizeof(struct band_task_info),band_task_info,(task_fn_x_t)do_band_task,num_workers);
+
+	    code_image_merge_bands(&o_coeffs_count,o_coeffs,o_coeffs_idx,band_count,global_info.band_capacity,
+				   global_vars.bands_coeff_count,global_vars.bands_coeffs,global_vars.bands_coeffs_idx,hashed_geometry,merge_tmps);
+
+	    memcpy(global_vars.o_sample_coded_pr + global_vars.current_sample_coded_length,o_coeffs,o_coeffs_count * sizeof(double));
+	    widen_idx(global_vars.o_sample_coded_ir + global_vars.current_sample_coded_length,o_coeffs_idx,o_coeffs_count);
+	    global_vars.o_sample_coded_jc[ii] = global_vars.current_sample_coded_length;
+	    global_vars.o_observations_perm[ii] = ii;
+	    global_vars.current_sample_coded_count += 1;
+	    global_vars.current_sample_coded_length += o_coeffs_count;
+	}
+
+	mxFree(merge_tmps);
+	mxFree(o_coeffs_idx);
+	mxFree(o_coeffs);
+	mxFree(observation_buffer);
+	mxFree(global_vars.bands_coeffs_idx);
+	mxFree(global_vars.bands_coeffs);
+	mxFree(global_vars.bands_coeff_count);
+	mxFree(band_task_info);
     }
 
-    /* Run workers and compute output. */
-
-    run_workers_x(&global_info,&global_vars,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
-
     /* Build output. */
 
     global_vars.o_sample_coded_pr = (double*)mxRealloc(global_vars.o_sample_coded_pr,global_vars.current_sample_coded_length * sizeof(double));
@@ -257,7 +424,12 @@ mexFunction(
 
     /* Free memory and destroy objects. */
 
-    mxFree(task_info);
+    mxFree(dicts);
+
+    if (sample_path != NULL) {
+	dataset_file_close(&sample_file);
+	mxFree(sample_path);
+    }
 
     pthread_res = pthread_mutex_destroy(&global_vars.coeffs_queue_control);
     check_condition(pthread_res == 0,"master:SystemError","Could not destroy queue mutex.");
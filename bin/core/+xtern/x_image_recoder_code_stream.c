@@ -0,0 +1,313 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "latools.h"
+#include "image_coder.h"
+#include "dataset_file.h"
+#include "csc_file.h"
+
+enum output_decoder {
+    O_INFO  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_ROW_COUNT            = 0,
+    I_COL_COUNT            = 1,
+    I_PATCH_ROW_COUNT      = 2,
+    I_PATCH_COL_COUNT      = 3,
+    I_CHANNEL_MODE         = 4,
+    I_CODING_TYPE          = 5,
+    I_DICT                 = 6,
+    I_DICT_TRANSP          = 7,
+    I_DICT_X_DICT_TRANSP   = 8,
+    I_COEFF_COUNT          = 9,
+    I_CODING_PARAMS        = 10,
+    I_NONLINEAR_TYPE       = 11,
+    I_NONLINEAR_MODULATOR  = 12,
+    I_POLARITY_SPLIT_TYPE  = 13,
+    I_REDUCE_TYPE          = 14,
+    I_REDUCE_SPREAD        = 15,
+    I_HASHED_GEOMETRY      = 16,
+    I_SAMPLE               = 17,
+    I_OUTPUT_PATH          = 18,
+    I_CHUNK_COUNT          = 19,
+    I_INDEX_ENCODING       = 20,
+    I_VALUE_ENCODING       = 21,
+    I_NUM_WORKERS          = 22,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t                                 geometry;
+    size_t                                 new_geometry;
+    size_t                                 row_count;
+    size_t                                 col_count;
+    size_t                                 layer_count;
+    size_t                                 patch_row_count;
+    size_t                                 patch_col_count;
+    enum channel_mode                      channel_mode;
+    enum coding_type                       coding_type;
+    size_t                                 word_count;
+    const struct dictionary_state* const*  dicts;
+    size_t                                 coeff_count;
+    const void*                            coding_params;
+    enum nonlinear_type                    nonlinear_type;
+    const double*                          nonlinear_modulator;
+    enum polarity_split_type               polarity_split_type;
+    enum reduce_type                       reduce_type;
+    size_t                                 reduce_spread;
+    size_t                                 hashed_geometry;
+    enum dataset_dtype                     sample_dtype;
+};
+
+struct task_info {
+    size_t*       o_coeffs_count;
+    double*       o_coeffs;
+    coeff_idx_t*  o_coeffs_idx;
+    const void*   observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*          coding_tmps;
+    double*        observation_buffer;
+    const double*  observation;
+    void*          param_table[2] = {NULL,NULL};
+    size_t         ii;
+
+    coding_tmps = (char*)malloc(code_image_coding_tmps_length(global_info->row_count,global_info->col_count,global_info->layer_count,global_info->patch_row_count,global_info->patch_col_count,
+							      global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->coeff_count,global_info->reduce_spread,global_info->hashed_geometry));
+    observation_buffer = (double*)malloc(global_info->geometry * sizeof(double));
+
+    make_param_table(param_table,global_info->coding_type,(const double*)global_info->coding_params,id);
+
+    /* Each observation has its own output slot in the chunk, so columns can be written in order, without locking. */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	if (global_info->sample_dtype == DTYPE_FLOAT64) {
+	    observation = (const double*)task_info[ii].observation;
+	} else {
+	    dataset_convert(observation_buffer,global_info->sample_dtype,global_info->geometry,task_info[ii].observation);
+	    observation = observation_buffer;
+	}
+
+	code_image(task_info[ii].o_coeffs_count,task_info[ii].o_coeffs,task_info[ii].o_coeffs_idx,
+		   global_info->geometry,global_info->row_count,global_info->col_count,global_info->layer_count,
+		   global_info->patch_row_count,global_info->patch_col_count,
+		   global_info->channel_mode,global_info->coding_type,global_info->word_count,global_info->dicts,global_info->coeff_count,&param_table,
+		   global_info->nonlinear_type,global_info->nonlinear_modulator,global_info->polarity_split_type,global_info->reduce_type,global_info->reduce_spread,global_info->hashed_geometry,
+		   observation,coding_tmps);
+    }
+
+    free_param_table(param_table,global_info->coding_type);
+
+    free(observation_buffer);
+    free(coding_tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t                           geometry;
+    size_t                           row_count;
+    size_t                           col_count;
+    size_t                           layer_count;
+    size_t                           patch_row_count;
+    size_t                           patch_col_count;
+    enum channel_mode                channel_mode;
+    enum coding_type                 coding_type;
+    size_t                           word_count;
+    const struct dictionary_state**  dicts;
+    size_t                           coeff_count;
+    const void*                      coding_params;
+    enum nonlinear_type              nonlinear_type;
+    const double*                    nonlinear_modulator;
+    enum polarity_split_type         polarity_split_type;
+    enum reduce_type                 reduce_type;
+    size_t                           reduce_spread;
+    size_t                           hashed_geometry;
+    size_t                           dict_count;
+    size_t                           dict_geometry;
+    size_t                           sample_count;
+    const char*                      sample;
+    enum dataset_dtype               sample_dtype;
+    size_t                           observation_length;
+    char*                            sample_path;
+    struct dataset_file              sample_file;
+    char*                            output_path;
+    size_t                           chunk_count;
+    enum csc_index_encoding          index_encoding;
+    enum csc_value_encoding          value_encoding;
+    size_t                           num_workers;
+    struct global_info               global_info;
+    struct task_info*                task_info;
+    size_t*                          chunk_coeffs_count;
+    double*                          chunk_coeffs;
+    coeff_idx_t*                     chunk_coeffs_idx;
+    size_t*                          column_ir;
+    struct csc_file_writer           writer;
+    size_t                           column_jc[2];
+    size_t                           current_count;
+    size_t                           first;
+    double*                          o_info;
+    bool                             codebook_overflow;
+    bool                             ok;
+    size_t                           ii;
+
+    /* Extract relevant information from all inputs. A string "sample" is the path of a mapped dataset. */
+
+    row_count = (size_t)mxGetScalar(input[I_ROW_COUNT]);
+    col_count = (size_t)mxGetScalar(input[I_COL_COUNT]);
+    patch_row_count = (size_t)mxGetScalar(input[I_PATCH_ROW_COUNT]);
+    patch_col_count = (size_t)mxGetScalar(input[I_PATCH_COL_COUNT]);
+    channel_mode = (enum channel_mode)mxGetScalar(input[I_CHANNEL_MODE]);
+    coding_type = (enum coding_type)mxGetScalar(input[I_CODING_TYPE]);
+    extract_dictionaries(&dict_count,&dict_geometry,&word_count,&dicts,input[I_DICT],input[I_DICT_TRANSP],input[I_DICT_X_DICT_TRANSP]);
+    coeff_count = (size_t)mxGetScalar(input[I_COEFF_COUNT]);
+    coding_params = mxGetPr(input[I_CODING_PARAMS]);
+    nonlinear_type = (enum nonlinear_type)mxGetScalar(input[I_NONLINEAR_TYPE]);
+    nonlinear_modulator = mxGetPr(input[I_NONLINEAR_MODULATOR]);
+    polarity_split_type = (enum polarity_split_type)mxGetScalar(input[I_POLARITY_SPLIT_TYPE]);
+    reduce_type = (enum reduce_type)mxGetScalar(input[I_REDUCE_TYPE]);
+    reduce_spread = (size_t)mxGetScalar(input[I_REDUCE_SPREAD]);
+    hashed_geometry = (size_t)mxGetScalar(input[I_HASHED_GEOMETRY]);
+    output_path = mxArrayToString(input[I_OUTPUT_PATH]);
+    chunk_count = (size_t)mxGetScalar(input[I_CHUNK_COUNT]);
+    index_encoding = (enum csc_index_encoding)mxGetScalar(input[I_INDEX_ENCODING]);
+    value_encoding = (enum csc_value_encoding)mxGetScalar(input[I_VALUE_ENCODING]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    if (mxIsChar(input[I_SAMPLE])) {
+	sample_path = mxArrayToString(input[I_SAMPLE]);
+	ok = dataset_file_open(&sample_file,sample_path);
+	check_condition(ok,"master:NoLoad","Could not open dataset file.");
+
+	geometry = sample_file.geometry;
+	sample_count = (size_t)sample_file.header.count;
+	sample = sample_file.data;
+	sample_dtype = (enum dataset_dtype)sample_file.header.dtype;
+	observation_length = sample_file.observation_length;
+    } else {
+	sample_path = NULL;
+
+	geometry = mxGetM(input[I_SAMPLE]);
+	sample_count = mxGetN(input[I_SAMPLE]);
+	sample = (const char*)mxGetPr(input[I_SAMPLE]);
+	sample_dtype = DTYPE_FLOAT64;
+	observation_length = geometry * sizeof(double);
+    }
+
+    layer_count = geometry / (row_count * col_count);
+
+    check_condition(layer_count * row_count * col_count == geometry,"master:InvalidGeometry","Sample geometry is not a whole number of image layers.");
+    check_condition(dict_count == (channel_mode == PER_CHANNEL ? layer_count : 1),"master:InvalidHandle","There must be one dictionary per channel.");
+    check_condition(dict_geometry * dict_count == patch_row_count * patch_col_count * layer_count,"master:InvalidGeometry","Dictionary geometry does not match the patch size.");
+    check_condition(code_image_idx_fits(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry),
+		    "master:InvalidGeometry","Coded geometry has more features than coefficient indices can hold.");
+
+    /* Build task distribution information. Only one chunk of coded observations is ever held in memory. */
+
+    global_info.geometry = geometry;
+    global_info.new_geometry = code_image_new_geometry(row_count,col_count,layer_count,word_count,channel_mode,polarity_split_type,reduce_spread,hashed_geometry);
+    global_info.row_count = row_count;
+    global_info.col_count = col_count;
+    global_info.layer_count = layer_count;
+    global_info.patch_row_count = patch_row_count;
+    global_info.patch_col_count = patch_col_count;
+    global_info.channel_mode = channel_mode;
+    global_info.coding_type = coding_type;
+    global_info.word_count = word_count;
+    global_info.dicts = dicts;
+    global_info.coeff_count = coeff_count;
+    global_info.coding_params = coding_params;
+    global_info.nonlinear_type = nonlinear_type;
+    global_info.nonlinear_modulator = nonlinear_modulator;
+    global_info.polarity_split_type = polarity_split_type;
+    global_info.reduce_type = reduce_type;
+    global_info.reduce_spread = reduce_spread;
+    global_info.hashed_geometry = hashed_geometry;
+    global_info.sample_dtype = sample_dtype;
+
+    chunk_coeffs_count = (size_t*)mxMalloc(chunk_count * sizeof(size_t));
+    chunk_coeffs = (double*)mxMalloc(chunk_count * global_info.new_geometry * sizeof(double));
+    chunk_coeffs_idx = (coeff_idx_t*)mxMalloc(chunk_count * global_info.new_geometry * sizeof(coeff_idx_t));
+    column_ir = (size_t*)mxMalloc(global_info.new_geometry * sizeof(size_t));
+    task_info = (struct task_info*)mxMalloc(chunk_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < chunk_count; ii++) {
+	task_info[ii].o_coeffs_count = chunk_coeffs_count + ii;
+	task_info[ii].o_coeffs = chunk_coeffs + ii * global_info.new_geometry;
+	task_info[ii].o_coeffs_idx = chunk_coeffs_idx + ii * global_info.new_geometry;
+    }
+
+    ok = csc_file_writer_open(&writer,output_path,global_info.new_geometry,index_encoding,value_encoding);
+    check_condition(ok,"master:NoSave","Could not open coded file.");
+
+    /* Run workers and compute output. */
+
+    for (first = 0; first < sample_count; first += current_count) {
+	current_count = sample_count - first < chunk_count ? sample_count - first : chunk_count;
+
+	for (ii = 0; ii < current_count; ii++) {
+	    task_info[ii].observation = sample + (first + ii) * observation_length;
+	}
+
+	run_workers_x(&global_info,NULL,current_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+	for (ii = 0; ok && (ii < current_count); ii++) {
+	    column_jc[0] = 0;
+	    column_jc[1] = chunk_coeffs_count[ii];
+	    widen_idx(column_ir,task_info[ii].o_coeffs_idx,chunk_coeffs_count[ii]);
+	    ok = csc_file_writer_append(&writer,1,task_info[ii].o_coeffs,column_ir,column_jc);
+	}
+
+	if (!ok) {
+	    break;
+	}
+    }
+
+    /* Build "info". */
+
+    output[O_INFO] = mxCreateDoubleMatrix(1,3,mxREAL);
+    o_info = mxGetPr(output[O_INFO]);
+    o_info[0] = (double)writer.header.row_count;
+    o_info[1] = (double)writer.header.col_count;
+    o_info[2] = (double)writer.header.nnz;
+
+    codebook_overflow = writer.codebook_overflow;
+    ok = csc_file_writer_close(&writer) && ok;
+
+    /* Free memory and destroy objects. */
+
+    mxFree(dicts);
+
+    mxFree(task_info);
+    mxFree(column_ir);
+    mxFree(chunk_coeffs_idx);
+    mxFree(chunk_coeffs);
+    mxFree(chunk_coeffs_count);
+
+    if (sample_path != NULL) {
+	dataset_file_close(&sample_file);
+	mxFree(sample_path);
+    }
+
+    mxFree(output_path);
+
+    check_condition(!codebook_overflow,"master:NoSave","Coded values do not fit a codebook of 256 distinct values.");
+    check_condition(ok,"master:NoSave","Could not write coded file.");
+}
@@ -1,7 +1,11 @@
+#include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 
+#include "gsl/gsl_rng.h"
+
 #include "x_mex_interface.h"
+#include "dictionary_handle.h"
 
 void
 check_condition(
@@ -72,3 +76,115 @@ logger_message(
     mxDestroyArray(message_array);
     free(extra_message);
 }
+
+void
+extract_dictionary(
+    size_t*          o_word_count,
+    const double**   o_dict,
+    const double**   o_dict_transp,
+    const double**   o_dict_x_dict_transp,
+    const mxArray*   dict,
+    const mxArray*   dict_transp,
+    const mxArray*   dict_x_dict_transp) {
+    struct dictionary_handle*  handle;
+
+    /* A "uint64" scalar in place of "dict" is a dictionary handle, and the other two inputs are then ignored. */
+
+    if (mxIsUint64(dict)) {
+        check_condition(mxGetNumberOfElements(dict) == 1,"master:InvalidHandle","Dictionary handle must be a \"uint64\" scalar.");
+        handle = dictionary_handle_from_id(*(const uint64_t*)mxGetData(dict));
+        check_condition(handle != NULL,"master:InvalidHandle","Invalid dictionary handle.");
+
+        *o_word_count = handle->state.word_count;
+        *o_dict = handle->state.dict;
+        *o_dict_transp = handle->state.dict_transp;
+        *o_dict_x_dict_transp = handle->state.dict_x_dict_transp;
+    } else {
+        *o_word_count = mxGetM(dict);
+        *o_dict = mxGetPr(dict);
+        *o_dict_transp = mxGetPr(dict_transp);
+        *o_dict_x_dict_transp = mxGetPr(dict_x_dict_transp);
+    }
+}
+
+void
+extract_dictionaries(
+    size_t*                            o_dict_count,
+    size_t*                            o_dict_geometry,
+    size_t*                            o_word_count,
+    const struct dictionary_state***   o_dicts,
+    const mxArray*                     dict,
+    const mxArray*                     dict_transp,
+    const mxArray*                     dict_x_dict_transp) {
+    const struct dictionary_handle*  handle;
+    const struct dictionary_state**  dicts;
+    struct dictionary_state*         matrix_dict;
+    size_t                           dict_count;
+    size_t                           ii;
+
+    /* A "uint64" vector in place of "dict" holds one dictionary handle per channel, and "o_dicts" points to the state
+       of each, which the coders read in place. A plain dictionary is described by a state stored right after the
+       single pointer. Either way, the caller frees "o_dicts" with "mxFree". */
+
+    if (mxIsUint64(dict)) {
+        dict_count = mxGetNumberOfElements(dict);
+        check_condition(dict_count >= 1,"master:InvalidHandle","Dictionary handles must be a non-empty \"uint64\" vector.");
+
+        dicts = (const struct dictionary_state**)mxMalloc(dict_count * sizeof(const struct dictionary_state*));
+
+        for (ii = 0; ii < dict_count; ii++) {
+            handle = dictionary_handle_from_id(((const uint64_t*)mxGetData(dict))[ii]);
+            check_condition(handle != NULL,"master:InvalidHandle","Invalid dictionary handle.");
+            dicts[ii] = &handle->state;
+            check_condition((dicts[ii]->geometry == dicts[0]->geometry) && (dicts[ii]->word_count == dicts[0]->word_count),
+                            "master:InvalidHandle","Dictionaries of different channels must have the same geometry and word count.");
+        }
+    } else {
+        dict_count = 1;
+        dicts = (const struct dictionary_state**)mxMalloc(sizeof(const struct dictionary_state*) + sizeof(struct dictionary_state));
+        matrix_dict = (struct dictionary_state*)(dicts + 1);
+        dictionary_state_wrap(matrix_dict,mxGetN(dict),mxGetM(dict),mxGetPr(dict),mxGetPr(dict_transp),mxGetPr(dict_x_dict_transp));
+        dicts[0] = matrix_dict;
+    }
+
+    *o_dict_count = dict_count;
+    *o_dict_geometry = dicts[0]->geometry;
+    *o_word_count = dicts[0]->word_count;
+    *o_dicts = dicts;
+}
+
+void
+make_param_table(
+    void**             o_param_table,
+    enum coding_type   coding_type,
+    const double*      coding_params,
+    size_t             id) {
+    double*   local_lambda_sigma_ratio;
+    gsl_rng*  rnd_generator;
+
+    /* Only "SPARSE_NET" keeps per worker state: a copy of the lambda/sigma ratio and a generator seeded with "id". */
+
+    if (coding_type == SPARSE_NET) {
+        local_lambda_sigma_ratio = (double*)malloc(sizeof(double));
+        *local_lambda_sigma_ratio = coding_params[0];
+
+        rnd_generator = gsl_rng_alloc(gsl_rng_mt19937);
+        gsl_rng_set(rnd_generator,id);
+
+        o_param_table[0] = local_lambda_sigma_ratio;
+        o_param_table[1] = rnd_generator;
+    } else {
+        o_param_table[0] = NULL;
+        o_param_table[1] = NULL;
+    }
+}
+
+void
+free_param_table(
+    void**             io_param_table,
+    enum coding_type   coding_type) {
+    if (coding_type == SPARSE_NET) {
+        gsl_rng_free((gsl_rng*)io_param_table[1]);
+        free((double*)io_param_table[0]);
+    }
+}
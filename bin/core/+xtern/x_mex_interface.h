@@ -3,6 +3,10 @@
 
 #include "mex.h"
 
+#include "base_defines.h"
+#include "dictionary_state.h"
+#include "coding_methods.h"
+
 extern void  check_condition(bool condition,const char* error_id,const char* message);
 
 extern void  printf_wrapper(const char* message);
@@ -11,4 +15,10 @@ extern void  logger_beg_node(mxArray* logger,const char* fmt_message,...);
 extern void  logger_end_node(mxArray* logger);
 extern void  logger_message(mxArray* logger,const char* fmt_message,...);
 
+extern void  extract_dictionary(size_t* o_word_count,const double** o_dict,const double** o_dict_transp,const double** o_dict_x_dict_transp,const mxArray* dict,const mxArray* dict_transp,const mxArray* dict_x_dict_transp);
+extern void  extract_dictionaries(size_t* o_dict_count,size_t* o_dict_geometry,size_t* o_word_count,const struct dictionary_state*** o_dicts,const mxArray* dict,const mxArray* dict_transp,const mxArray* dict_x_dict_transp);
+
+extern void  make_param_table(void** o_param_table,enum coding_type coding_type,const double* coding_params,size_t id);
+extern void  free_param_table(void** io_param_table,enum coding_type coding_type);
+
 #endif
@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "covariance.h"
+
+#define CHUNK_COUNT 256
+
+enum output_decoder {
+    O_MEAN        = 0,
+    O_COVARIANCE  = 1,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_SAMPLE       = 0,
+    I_NUM_WORKERS  = 1,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t  geometry;
+    size_t  chunk_count;
+};
+
+struct global_vars {
+    double*  worker_means;
+    double*  worker_scatters;
+    size_t*  worker_counts;
+};
+
+struct task_info {
+    const double*  observation;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    struct global_vars*        global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*  tmps;
+
+    if (task_info_count == 0) {
+	return;
+    }
+
+    tmps = (char*)malloc(covariance_tmps_length(global_info->geometry,global_info->chunk_count));
+
+    /* Observations are contiguous for the tasks of one worker. Each worker owns a slot in "global_vars", so no locking
+       is needed, and the merge order below does not depend on scheduling. */
+
+    covariance_accumulate(global_vars->worker_means + id * global_info->geometry,
+			  global_vars->worker_scatters + id * global_info->geometry * global_info->geometry,
+			  global_vars->worker_counts + id,
+			  global_info->geometry,task_info_count,task_info[0].observation,global_info->chunk_count,tmps);
+
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t              geometry;
+    size_t              sample_count;
+    const double*       sample;
+    size_t              num_workers;
+    double*             o_mean;
+    double*             o_covariance;
+    size_t              count;
+    struct global_info  global_info;
+    struct global_vars  global_vars;
+    struct task_info*   task_info;
+    size_t              ii;
+
+    /* Extract relevant information from all inputs. */
+
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    /* Build output structures. */
+
+    output[O_MEAN] = mxCreateDoubleMatrix(geometry,1,mxREAL);
+    o_mean = mxGetPr(output[O_MEAN]);
+    output[O_COVARIANCE] = mxCreateDoubleMatrix(geometry,geometry,mxREAL);
+    o_covariance = mxGetPr(output[O_COVARIANCE]);
+
+    /* Build task distribution information. */
+
+    global_info.geometry = geometry;
+    global_info.chunk_count = CHUNK_COUNT;
+
+    global_vars.worker_means = (double*)mxCalloc(num_workers * geometry,sizeof(double));
+    global_vars.worker_scatters = (double*)mxCalloc(num_workers * geometry * geometry,sizeof(double));
+    global_vars.worker_counts = (size_t*)mxCalloc(num_workers,sizeof(size_t));
+
+    task_info = (struct task_info*)mxMalloc(sample_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < sample_count; ii++) {
+	task_info[ii].observation = sample + ii * geometry;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,&global_vars,sample_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,num_workers);
+
+    /* Build "mean" and "covariance". */
+
+    count = 0;
+
+    for (ii = 0; ii < num_workers; ii++) {
+	covariance_merge(o_mean,o_covariance,&count,geometry,
+			 global_vars.worker_means + ii * geometry,global_vars.worker_scatters + ii * geometry * geometry,global_vars.worker_counts[ii]);
+    }
+
+    covariance_finish(o_covariance,geometry,count);
+
+    /* Free memory. */
+
+    mxFree(task_info);
+    mxFree(global_vars.worker_counts);
+    mxFree(global_vars.worker_scatters);
+    mxFree(global_vars.worker_means);
+}
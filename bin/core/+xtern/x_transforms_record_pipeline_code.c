@@ -0,0 +1,138 @@
+#include <stdlib.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "task_control.h"
+#include "pipeline.h"
+
+#define BLOCK_BYTES 262144
+
+enum output_decoder {
+    O_SAMPLE_CODED  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_OPS_TYPE     = 0,
+    I_OPS_PARAMS   = 1,
+    I_SAMPLE       = 2,
+    I_NUM_WORKERS  = 3,
+    INPUTS_COUNT
+};
+
+struct global_info {
+    size_t                     op_count;
+    const struct pipeline_op*  ops;
+    size_t                     block_count;
+};
+
+struct task_info {
+    double*        o_sample_coded;
+    size_t         count;
+    const double*  sample;
+};
+
+static void
+do_task(
+    size_t                     id,
+    const struct global_info*  global_info,
+    void*                      global_vars,
+    size_t                     task_info_count,
+    struct task_info*          task_info) {
+    char*   tmps;
+    size_t  ii;
+
+    tmps = (char*)malloc(pipeline_tmps_length(global_info->op_count,global_info->ops,global_info->block_count));
+
+    /* Each task is a block of observations small enough for both of its buffers to stay in cache. */
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	pipeline_code_block(task_info[ii].o_sample_coded,global_info->op_count,global_info->ops,task_info[ii].count,task_info[ii].sample,tmps);
+    }
+
+    free(tmps);
+}
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t               op_count;
+    const double*        ops_type;
+    size_t               geometry;
+    size_t               sample_count;
+    const double*        sample;
+    size_t               num_workers;
+    struct pipeline_op*  ops;
+    const mxArray*       op_params;
+    size_t               output_geometry;
+    size_t               max_geometry;
+    size_t               block_count;
+    double*              o_sample_coded;
+    struct global_info   global_info;
+    struct task_info*    task_info;
+    size_t               task_info_count;
+    size_t               ii;
+
+    /* Extract relevant information from all inputs. Only linear ops change the geometry, and their output geometry
+       is the number of rows of their parameters. */
+
+    op_count = mxGetNumberOfElements(input[I_OPS_TYPE]);
+    ops_type = mxGetPr(input[I_OPS_TYPE]);
+    geometry = mxGetM(input[I_SAMPLE]);
+    sample_count = mxGetN(input[I_SAMPLE]);
+    sample = mxGetPr(input[I_SAMPLE]);
+    num_workers = (size_t)mxGetScalar(input[I_NUM_WORKERS]);
+
+    ops = (struct pipeline_op*)mxMalloc(op_count * sizeof(struct pipeline_op));
+    output_geometry = geometry;
+
+    for (ii = 0; ii < op_count; ii++) {
+	op_params = mxGetCell(input[I_OPS_PARAMS],ii);
+
+	ops[ii].type = (enum pipeline_op_type)(int)ops_type[ii];
+	ops[ii].input_geometry = output_geometry;
+	ops[ii].output_geometry = ops[ii].type == OP_LINEAR ? mxGetM(op_params) : output_geometry;
+	ops[ii].params = mxIsEmpty(op_params) ? NULL : mxGetPr(op_params);
+
+	output_geometry = ops[ii].output_geometry;
+    }
+
+    max_geometry = op_count > 0 ? pipeline_max_geometry(op_count,ops) : geometry;
+    block_count = BLOCK_BYTES / (2 * max_geometry * sizeof(double));
+    block_count = block_count > 0 ? block_count : 1;
+
+    /* Build output structures. */
+
+    output[O_SAMPLE_CODED] = mxCreateDoubleMatrix(output_geometry,sample_count,mxREAL);
+    o_sample_coded = mxGetPr(output[O_SAMPLE_CODED]);
+
+    /* Build task distribution information. */
+
+    global_info.op_count = op_count;
+    global_info.ops = ops;
+    global_info.block_count = block_count;
+
+    task_info_count = (sample_count + block_count - 1) / block_count;
+    task_info = (struct task_info*)mxMalloc(task_info_count * sizeof(struct task_info));
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	task_info[ii].o_sample_coded = o_sample_coded + ii * block_count * output_geometry;
+	task_info[ii].count = (ii + 1) * block_count <= sample_count ? block_count : sample_count - ii * block_count;
+	task_info[ii].sample = sample + ii * block_count * geometry;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,task_info_count,sizeof(struct task_info),task_info,(task_fn_x_t)do_task,
+		  num_workers < task_info_count ? num_workers : task_info_count);
+
+    /* Free memory. */
+
+    mxFree(task_info);
+    mxFree(ops);
+}
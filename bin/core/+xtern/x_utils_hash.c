@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mex.h"
+
+#include "x_mex_interface.h"
+#include "base_defines.h"
+#include "hash.h"
+
+enum output_decoder {
+    O_HASH  = 0,
+    OUTPUTS_COUNT
+};
+
+enum input_decoder {
+    I_PARTS  = 0,
+    INPUTS_COUNT
+};
+
+void
+mexFunction(
+    int             output_count,
+    mxArray*        output[],
+    int             input_count,
+    const mxArray*  input[]) {
+    size_t          parts_count;
+    const mxArray*  part;
+    const char*     class_name;
+    size_t          dims_count;
+    const mwSize*   dims;
+    size_t          element_size;
+    size_t          values_count;
+    uint64_t        hash;
+    char            o_hash[17];
+    size_t          ii;
+
+    /* Extract relevant information from all inputs. Each part is a numeric, logical or char array, and both its
+       class and its dimensions go into the hash, so equal bytes with different shapes or types hash apart. */
+
+    parts_count = mxGetNumberOfElements(input[I_PARTS]);
+
+    /* Build "hash". */
+
+    hash = 0;
+
+    for (ii = 0; ii < parts_count; ii++) {
+	part = mxGetCell(input[I_PARTS],ii);
+	class_name = mxGetClassName(part);
+	dims_count = mxGetNumberOfDimensions(part);
+	dims = mxGetDimensions(part);
+	element_size = mxGetElementSize(part);
+
+	hash = hash_bytes(hash,strlen(class_name),class_name);
+	hash = hash_bytes(hash,dims_count * sizeof(mwSize),dims);
+
+	if (mxIsSparse(part)) {
+	    values_count = mxGetJc(part)[mxGetN(part)];
+	    hash = hash_bytes(hash,(mxGetN(part) + 1) * sizeof(mwIndex),mxGetJc(part));
+	    hash = hash_bytes(hash,values_count * sizeof(mwIndex),mxGetIr(part));
+	} else {
+	    values_count = mxGetNumberOfElements(part);
+	}
+
+	hash = hash_bytes(hash,values_count * element_size,mxGetData(part));
+
+	if (mxGetPi(part) != NULL) {
+	    hash = hash_bytes(hash,values_count * element_size,mxGetPi(part));
+	}
+    }
+
+    hash_to_string(o_hash,hash);
+    output[O_HASH] = mxCreateString(o_hash);
+}
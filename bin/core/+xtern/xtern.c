@@ -0,0 +1,879 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "gsl/gsl_rng.h"
+
+#include "xtern.h"
+#include "latools.h"
+#include "task_control.h"
+
+/* The batch entry points of "libxtern". Each splits a sample between workers the way the MEX files do, but reads it
+   from plain memory or a mapped dataset file and returns results in buffers allocated with "malloc", which the caller
+   owns. Coded samples are always in observation order, with ascending row indices in every column. */
+
+struct coding_params {
+    double    lambda_sigma_ratio;
+    gsl_rng*  rnd_generator;
+    void*     param_table[2];
+};
+
+struct dictionary_global_info {
+    const struct dictionary_state*  dict;
+    coding_method_t                 coding_method;
+    enum coding_type                coding_type;
+    size_t                          coeff_count;
+    double                          coding_param;
+    const struct xtern_sample*      sample;
+};
+
+struct dictionary_task_info {
+    double*      o_coeffs_pr;
+    size_t*      o_coeffs_ir;
+    const void*  observation;
+};
+
+struct image_global_info {
+    const struct dictionary_state* const*  dicts;
+    const struct xtern_image_coding*       coding;
+    size_t                                 new_geometry;
+    const struct xtern_sample*             sample;
+};
+
+struct image_global_vars {
+    double*          o_coeffs_pr;
+    size_t*          o_coeffs_ir;
+    size_t*          o_observations_offset;
+    size_t*          o_observations_length;
+    size_t           current_length;
+    bool             failed;
+    pthread_mutex_t  coeffs_queue_control;
+};
+
+struct image_task_info {
+    size_t       observation_id;
+    const void*  observation;
+};
+
+struct image_classify_global_info {
+    const struct dictionary_state* const*  dicts;
+    const struct xtern_image_coding*       coding;
+    size_t                                 new_geometry;
+    const struct xtern_sample*             sample;
+    const size_t*                          feature_map;
+    size_t                                 classifiers_geometry;
+    size_t                                 classifiers_count;
+    const double*                          weights_by_feature;
+};
+
+struct image_classify_global_vars {
+    bool             failed;
+    pthread_mutex_t  failed_control;
+};
+
+struct image_classify_task_info {
+    double*      o_decisions;
+    const void*  observation;
+};
+
+static void
+_coding_params_init(
+    struct coding_params* restrict  o_params,
+    enum coding_type                coding_type,
+    double                          coding_param,
+    size_t                          worker_id) {
+    o_params->lambda_sigma_ratio = coding_param;
+    o_params->rnd_generator = NULL;
+
+    if (coding_type == SPARSE_NET) {
+	o_params->rnd_generator = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(o_params->rnd_generator,worker_id);
+    }
+
+    o_params->param_table[0] = &o_params->lambda_sigma_ratio;
+    o_params->param_table[1] = o_params->rnd_generator;
+}
+
+static void
+_coding_params_free(
+    struct coding_params* restrict  io_params) {
+    if (io_params->rnd_generator != NULL) {
+	gsl_rng_free(io_params->rnd_generator);
+    }
+}
+
+static const double*
+_observation(
+    double* restrict                     o_buffer,
+    const struct xtern_sample* restrict  sample,
+    const void* restrict                 observation) {
+    if (sample->dtype == DTYPE_FLOAT64) {
+	return (const double*)observation;
+    } else {
+	dataset_convert(o_buffer,sample->dtype,sample->geometry,observation);
+	return o_buffer;
+    }
+}
+
+static bool
+_feature_ids_valid(
+    size_t                  geometry,
+    size_t                  feature_count,
+    const size_t* restrict  feature_ids) {
+    size_t  ii;
+
+    for (ii = 0; ii < feature_count; ii++) {
+	if ((feature_ids[ii] >= geometry) || ((ii > 0) && (feature_ids[ii] <= feature_ids[ii - 1]))) {
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+static const struct dictionary_state**
+_image_dictionaries(
+    const struct dictionary_handle* const* restrict  dicts,
+    const struct xtern_image_coding* restrict        coding) {
+    const struct dictionary_state**  image_dicts;
+    size_t                           dict_count;
+    size_t                           layer_geometry;
+    size_t                           ii;
+
+    /* A "JOINT" coding uses one dictionary over patches from all the layers, while a "PER_CHANNEL" one uses a
+       dictionary for each layer. "code_image" reads the state of every handle in place, through the returned array,
+       which the caller frees. */
+
+    dict_count = coding->channel_mode == PER_CHANNEL ? coding->layer_count : 1;
+    layer_geometry = coding->channel_mode == PER_CHANNEL ? 1 : coding->layer_count;
+
+    if ((coding->layer_count == 0) || (coding->coeff_count > dicts[0]->state.word_count) ||
+	!code_image_idx_fits(coding->row_count,coding->col_count,coding->layer_count,dicts[0]->state.word_count,coding->channel_mode,
+			     coding->polarity_split_type,coding->reduce_spread,coding->hashed_geometry)) {
+	return NULL;
+    }
+
+    for (ii = 0; ii < dict_count; ii++) {
+	if ((dicts[ii]->state.geometry != coding->patch_row_count * coding->patch_col_count * layer_geometry) ||
+	    (dicts[ii]->state.word_count != dicts[0]->state.word_count)) {
+	    return NULL;
+	}
+    }
+
+    image_dicts = (const struct dictionary_state**)malloc(dict_count * sizeof(const struct dictionary_state*));
+
+    if (image_dicts == NULL) {
+	return NULL;
+    }
+
+    for (ii = 0; ii < dict_count; ii++) {
+	image_dicts[ii] = &dicts[ii]->state;
+    }
+
+    return image_dicts;
+}
+
+static void
+_coded_compact(
+    struct xtern_coded* restrict  io_coded,
+    size_t                        feature_count,
+    const size_t* restrict        feature_map) {
+    size_t  current_length;
+    size_t  observation_length;
+    size_t  ii;
+
+    /* Columns only ever shrink, so they are compacted in place, front to back. */
+
+    current_length = 0;
+
+    for (ii = 0; ii < io_coded->col_count; ii++) {
+	observation_length = io_coded->jc[ii + 1] - io_coded->jc[ii];
+	memmove(io_coded->pr + current_length,io_coded->pr + io_coded->jc[ii],observation_length * sizeof(double));
+	memmove(io_coded->ir + current_length,io_coded->ir + io_coded->jc[ii],observation_length * sizeof(size_t));
+	io_coded->jc[ii] = current_length;
+	current_length += linear_classifier_compact(io_coded->pr + current_length,io_coded->ir + current_length,observation_length,feature_map);
+    }
+
+    io_coded->jc[io_coded->col_count] = current_length;
+    io_coded->row_count = feature_count;
+}
+
+static void
+_do_dictionary_task(
+    size_t                                id,
+    const struct dictionary_global_info*  global_info,
+    void*                                 global_vars,
+    size_t                                task_info_count,
+    struct dictionary_task_info*          task_info) {
+    char*                 coding_tmps;
+    coeff_idx_t*          coeffs_idx;
+    double*               observation_buffer;
+    struct coding_params  coding_params;
+    size_t                ii;
+
+    coding_tmps = (char*)malloc(coding_type_tmps_length(global_info->coding_type,global_info->dict->geometry,global_info->dict->word_count,global_info->coeff_count));
+    coeffs_idx = (coeff_idx_t*)malloc(global_info->coeff_count * sizeof(coeff_idx_t));
+    observation_buffer = (double*)malloc(global_info->sample->geometry * sizeof(double));
+    _coding_params_init(&coding_params,global_info->coding_type,global_info->coding_param,id);
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	global_info->coding_method(task_info[ii].o_coeffs_pr,coeffs_idx,
+				   global_info->dict->geometry,global_info->dict->word_count,
+				   global_info->dict->dict,global_info->dict->dict_transp,global_info->dict->dict_x_dict_transp,
+				   global_info->coeff_count,coding_params.param_table,
+				   _observation(observation_buffer,global_info->sample,task_info[ii].observation),coding_tmps);
+	sort_by_idxs(task_info[ii].o_coeffs_pr,coeffs_idx,global_info->coeff_count);
+	widen_idx(task_info[ii].o_coeffs_ir,coeffs_idx,global_info->coeff_count);
+    }
+
+    _coding_params_free(&coding_params);
+    free(observation_buffer);
+    free(coeffs_idx);
+    free(coding_tmps);
+}
+
+static void
+_do_image_task(
+    size_t                           id,
+    const struct image_global_info*  global_info,
+    struct image_global_vars*        global_vars,
+    size_t                           task_info_count,
+    struct image_task_info*          task_info) {
+    const struct xtern_image_coding*  coding;
+    size_t                            o_coeffs_count;
+    double*                           o_coeffs;
+    coeff_idx_t*                      o_coeffs_idx;
+    char*                             coding_tmps;
+    double*                           observation_buffer;
+    struct coding_params              coding_params;
+    size_t                            initial_length;
+    size_t                            ii;
+
+    coding = global_info->coding;
+
+    o_coeffs = (double*)malloc(global_info->new_geometry * sizeof(double));
+    o_coeffs_idx = (coeff_idx_t*)malloc(global_info->new_geometry * sizeof(coeff_idx_t));
+    coding_tmps = (char*)malloc(code_image_coding_tmps_length(coding->row_count,coding->col_count,coding->layer_count,coding->patch_row_count,coding->patch_col_count,
+							      coding->channel_mode,coding->coding_type,global_info->dicts[0]->word_count,coding->coeff_count,coding->reduce_spread,coding->hashed_geometry));
+    observation_buffer = (double*)malloc(global_info->sample->geometry * sizeof(double));
+
+    if ((o_coeffs == NULL) || (o_coeffs_idx == NULL) || (coding_tmps == NULL) || (observation_buffer == NULL)) {
+	pthread_mutex_lock(&global_vars->coeffs_queue_control);
+	global_vars->failed = true;
+	pthread_mutex_unlock(&global_vars->coeffs_queue_control);
+	free(observation_buffer);
+	free(coding_tmps);
+	free(o_coeffs_idx);
+	free(o_coeffs);
+	return;
+    }
+
+    _coding_params_init(&coding_params,coding->coding_type,coding->coding_param,id);
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	code_image(&o_coeffs_count,o_coeffs,o_coeffs_idx,
+		   global_info->sample->geometry,coding->row_count,coding->col_count,coding->layer_count,
+		   coding->patch_row_count,coding->patch_col_count,
+		   coding->channel_mode,coding->coding_type,global_info->dicts[0]->word_count,global_info->dicts,
+		   coding->coeff_count,coding_params.param_table,
+		   coding->nonlinear_type,coding->nonlinear_modulator,coding->polarity_split_type,coding->reduce_type,coding->reduce_spread,coding->hashed_geometry,
+		   _observation(observation_buffer,global_info->sample,task_info[ii].observation),coding_tmps);
+
+	pthread_mutex_lock(&global_vars->coeffs_queue_control);
+	initial_length = global_vars->current_length;
+	global_vars->current_length += o_coeffs_count;
+	pthread_mutex_unlock(&global_vars->coeffs_queue_control);
+
+	memcpy(global_vars->o_coeffs_pr + initial_length,o_coeffs,o_coeffs_count * sizeof(double));
+	widen_idx(global_vars->o_coeffs_ir + initial_length,o_coeffs_idx,o_coeffs_count);
+	global_vars->o_observations_offset[task_info[ii].observation_id] = initial_length;
+	global_vars->o_observations_length[task_info[ii].observation_id] = o_coeffs_count;
+    }
+
+    _coding_params_free(&coding_params);
+    free(observation_buffer);
+    free(coding_tmps);
+    free(o_coeffs_idx);
+    free(o_coeffs);
+}
+
+static void
+_do_image_classify_task(
+    size_t                                    id,
+    const struct image_classify_global_info*  global_info,
+    struct image_classify_global_vars*        global_vars,
+    size_t                                    task_info_count,
+    struct image_classify_task_info*          task_info) {
+    const struct xtern_image_coding*  coding;
+    size_t                            o_coeffs_count;
+    double*                           o_coeffs;
+    coeff_idx_t*                      o_coeffs_idx;
+    size_t*                           o_features_idx;
+    char*                             coding_tmps;
+    double*                           observation_buffer;
+    struct coding_params              coding_params;
+    size_t                            ii;
+
+    coding = global_info->coding;
+
+    o_coeffs = (double*)malloc(global_info->new_geometry * sizeof(double));
+    o_coeffs_idx = (coeff_idx_t*)malloc(global_info->new_geometry * sizeof(coeff_idx_t));
+    o_features_idx = (size_t*)malloc(global_info->new_geometry * sizeof(size_t));
+    coding_tmps = (char*)malloc(code_image_coding_tmps_length(coding->row_count,coding->col_count,coding->layer_count,coding->patch_row_count,coding->patch_col_count,
+							      coding->channel_mode,coding->coding_type,global_info->dicts[0]->word_count,coding->coeff_count,coding->reduce_spread,coding->hashed_geometry));
+    observation_buffer = (double*)malloc(global_info->sample->geometry * sizeof(double));
+
+    if ((o_coeffs == NULL) || (o_coeffs_idx == NULL) || (o_features_idx == NULL) || (coding_tmps == NULL) || (observation_buffer == NULL)) {
+	pthread_mutex_lock(&global_vars->failed_control);
+	global_vars->failed = true;
+	pthread_mutex_unlock(&global_vars->failed_control);
+	free(observation_buffer);
+	free(coding_tmps);
+	free(o_features_idx);
+	free(o_coeffs_idx);
+	free(o_coeffs);
+	return;
+    }
+
+    _coding_params_init(&coding_params,coding->coding_type,coding->coding_param,id);
+
+    for (ii = 0; ii < task_info_count; ii++) {
+	code_image(&o_coeffs_count,o_coeffs,o_coeffs_idx,
+		   global_info->sample->geometry,coding->row_count,coding->col_count,coding->layer_count,
+		   coding->patch_row_count,coding->patch_col_count,
+		   coding->channel_mode,coding->coding_type,global_info->dicts[0]->word_count,global_info->dicts,
+		   coding->coeff_count,coding_params.param_table,
+		   coding->nonlinear_type,coding->nonlinear_modulator,coding->polarity_split_type,coding->reduce_type,coding->reduce_spread,coding->hashed_geometry,
+		   _observation(observation_buffer,global_info->sample,task_info[ii].observation),coding_tmps);
+
+	widen_idx(o_features_idx,o_coeffs_idx,o_coeffs_count);
+
+	if (global_info->feature_map != NULL) {
+	    o_coeffs_count = linear_classifier_compact(o_coeffs,o_features_idx,o_coeffs_count,global_info->feature_map);
+	}
+
+	linear_classifier_decide(task_info[ii].o_decisions,global_info->classifiers_geometry,global_info->classifiers_count,global_info->weights_by_feature,
+				 o_coeffs_count,o_coeffs,o_features_idx);
+    }
+
+    _coding_params_free(&coding_params);
+    free(observation_buffer);
+    free(coding_tmps);
+    free(o_features_idx);
+    free(o_coeffs_idx);
+    free(o_coeffs);
+}
+
+int
+xtern_api_version(void) {
+    return XTERN_API_VERSION;
+}
+
+void
+xtern_sample_from_dense(
+    struct xtern_sample* restrict  o_sample,
+    size_t                         geometry,
+    size_t                         count,
+    const double* restrict         data) {
+    o_sample->geometry = geometry;
+    o_sample->count = count;
+    o_sample->dtype = DTYPE_FLOAT64;
+    o_sample->observation_length = geometry * sizeof(double);
+    o_sample->data = data;
+}
+
+void
+xtern_sample_from_file(
+    struct xtern_sample* restrict        o_sample,
+    const struct dataset_file* restrict  file) {
+    o_sample->geometry = file->geometry;
+    o_sample->count = (size_t)file->header.count;
+    o_sample->dtype = (enum dataset_dtype)file->header.dtype;
+    o_sample->observation_length = file->observation_length;
+    o_sample->data = file->data;
+}
+
+bool
+xtern_coded_from_file(
+    struct xtern_coded* restrict     o_coded,
+    const struct csc_file* restrict  file) {
+    size_t  nnz;
+
+    nnz = csc_file_chunk_nnz(file,0,(size_t)file->header.col_count);
+
+    o_coded->row_count = (size_t)file->header.row_count;
+    o_coded->col_count = (size_t)file->header.col_count;
+    o_coded->pr = (double*)malloc(nnz * sizeof(double));
+    o_coded->ir = (size_t*)malloc(nnz * sizeof(size_t));
+    o_coded->jc = (size_t*)malloc((o_coded->col_count + 1) * sizeof(size_t));
+
+    if ((o_coded->pr == NULL) || (o_coded->ir == NULL) || (o_coded->jc == NULL)) {
+	xtern_coded_free(o_coded);
+	return false;
+    }
+
+    csc_file_read_chunk(o_coded->pr,o_coded->ir,o_coded->jc,file,0,o_coded->col_count);
+
+    return true;
+}
+
+bool
+xtern_coded_to_file(
+    const char* restrict                path,
+    const struct xtern_coded* restrict  coded,
+    enum csc_index_encoding             index_encoding,
+    enum csc_value_encoding             value_encoding) {
+    struct csc_file_writer  writer;
+    bool                    ok;
+
+    if (!csc_file_writer_open(&writer,path,coded->row_count,index_encoding,value_encoding)) {
+	return false;
+    }
+
+    ok = csc_file_writer_append(&writer,coded->col_count,coded->pr,coded->ir,coded->jc);
+    ok = csc_file_writer_close(&writer) && ok;
+
+    return ok;
+}
+
+void
+xtern_coded_free(
+    struct xtern_coded* restrict  io_coded) {
+    free(io_coded->pr);
+    free(io_coded->ir);
+    free(io_coded->jc);
+
+    io_coded->pr = NULL;
+    io_coded->ir = NULL;
+    io_coded->jc = NULL;
+}
+
+bool
+xtern_coded_compact(
+    struct xtern_coded* restrict  io_coded,
+    size_t                        feature_count,
+    const size_t* restrict        feature_ids) {
+    size_t*  feature_map;
+
+    if (!_feature_ids_valid(io_coded->row_count,feature_count,feature_ids)) {
+	return false;
+    }
+
+    feature_map = (size_t*)malloc(io_coded->row_count * sizeof(size_t));
+    linear_classifier_feature_map(feature_map,io_coded->row_count,feature_count,feature_ids);
+
+    _coded_compact(io_coded,feature_count,feature_map);
+
+    free(feature_map);
+
+    return true;
+}
+
+bool
+xtern_code_dictionary(
+    struct xtern_coded* restrict               o_coded,
+    const struct dictionary_handle* restrict   dict,
+    enum coding_type                           coding_type,
+    size_t                                     coeff_count,
+    double                                     coding_param,
+    const struct xtern_sample* restrict        sample,
+    size_t                                     num_workers) {
+    struct dictionary_global_info  global_info;
+    struct dictionary_task_info*   task_info;
+    size_t                         ii;
+
+    if ((sample->geometry != dict->state.geometry) || (coeff_count > dict->state.word_count)) {
+	return false;
+    }
+
+    /* Build output structures. Every observation has exactly "coeff_count" coefficients, so each worker writes its
+       observations' columns in place. */
+
+    o_coded->row_count = dict->state.word_count;
+    o_coded->col_count = sample->count;
+    o_coded->pr = (double*)malloc(coeff_count * sample->count * sizeof(double));
+    o_coded->ir = (size_t*)malloc(coeff_count * sample->count * sizeof(size_t));
+    o_coded->jc = (size_t*)malloc((sample->count + 1) * sizeof(size_t));
+
+    if ((o_coded->pr == NULL) || (o_coded->ir == NULL) || (o_coded->jc == NULL)) {
+	xtern_coded_free(o_coded);
+	return false;
+    }
+
+    for (ii = 0; ii <= sample->count; ii++) {
+	o_coded->jc[ii] = ii * coeff_count;
+    }
+
+    /* Build task distribution information. */
+
+    global_info.dict = &dict->state;
+    global_info.coding_method = coding_type_method(coding_type);
+    global_info.coding_type = coding_type;
+    global_info.coeff_count = coeff_count;
+    global_info.coding_param = coding_param;
+    global_info.sample = sample;
+
+    task_info = (struct dictionary_task_info*)malloc(sample->count * sizeof(struct dictionary_task_info));
+
+    for (ii = 0; ii < sample->count; ii++) {
+	task_info[ii].o_coeffs_pr = o_coded->pr + ii * coeff_count;
+	task_info[ii].o_coeffs_ir = o_coded->ir + ii * coeff_count;
+	task_info[ii].observation = (const char*)sample->data + ii * sample->observation_length;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,NULL,sample->count,sizeof(struct dictionary_task_info),task_info,(task_fn_x_t)_do_dictionary_task,num_workers);
+
+    /* Free memory. */
+
+    free(task_info);
+
+    return true;
+}
+
+bool
+xtern_code_image(
+    struct xtern_coded* restrict                     o_coded,
+    const struct dictionary_handle* const* restrict  dicts,
+    const struct xtern_image_coding* restrict        coding,
+    const struct xtern_sample* restrict              sample,
+    size_t                                           num_workers) {
+    const struct dictionary_state**  image_dicts;
+    struct image_global_info         global_info;
+    struct image_global_vars         global_vars;
+    struct image_task_info*          task_info;
+    bool                             ok;
+    size_t                           ii;
+
+    if (sample->geometry != coding->row_count * coding->col_count * coding->layer_count) {
+	return false;
+    }
+
+    image_dicts = _image_dictionaries(dicts,coding);
+
+    if (image_dicts == NULL) {
+	return false;
+    }
+
+    /* Build task distribution information. Workers append coded observations in whatever order they finish them,
+       and remember where each one went. */
+
+    global_info.dicts = image_dicts;
+    global_info.coding = coding;
+    global_info.new_geometry = code_image_new_geometry(coding->row_count,coding->col_count,coding->layer_count,image_dicts[0]->word_count,coding->channel_mode,coding->polarity_split_type,coding->reduce_spread,coding->hashed_geometry);
+    global_info.sample = sample;
+
+    global_vars.o_coeffs_pr = (double*)malloc(global_info.new_geometry * sample->count * sizeof(double));
+    global_vars.o_coeffs_ir = (size_t*)malloc(global_info.new_geometry * sample->count * sizeof(size_t));
+    global_vars.o_observations_offset = (size_t*)malloc(sample->count * sizeof(size_t));
+    global_vars.o_observations_length = (size_t*)malloc(sample->count * sizeof(size_t));
+    global_vars.current_length = 0;
+    global_vars.failed = false;
+    task_info = (struct image_task_info*)malloc(sample->count * sizeof(struct image_task_info));
+
+    if ((global_vars.o_coeffs_pr == NULL) || (global_vars.o_coeffs_ir == NULL) ||
+	(global_vars.o_observations_offset == NULL) || (global_vars.o_observations_length == NULL) || (task_info == NULL) ||
+	(pthread_mutex_init(&global_vars.coeffs_queue_control,NULL) != 0)) {
+	free(task_info);
+	free(global_vars.o_observations_length);
+	free(global_vars.o_observations_offset);
+	free(global_vars.o_coeffs_ir);
+	free(global_vars.o_coeffs_pr);
+	free(image_dicts);
+	return false;
+    }
+
+    for (ii = 0; ii < sample->count; ii++) {
+	task_info[ii].observation_id = ii;
+	task_info[ii].observation = (const char*)sample->data + ii * sample->observation_length;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,&global_vars,sample->count,sizeof(struct image_task_info),task_info,(task_fn_x_t)_do_image_task,num_workers);
+
+    /* Build "o_coded", by putting the columns back in observation order. A worker which could not allocate its
+       buffers leaves some observations uncoded, and then there is no "o_coded". */
+
+    o_coded->row_count = global_info.new_geometry;
+    o_coded->col_count = sample->count;
+    o_coded->pr = (double*)malloc(global_vars.current_length * sizeof(double));
+    o_coded->ir = (size_t*)malloc(global_vars.current_length * sizeof(size_t));
+    o_coded->jc = (size_t*)malloc((sample->count + 1) * sizeof(size_t));
+
+    ok = !global_vars.failed && (o_coded->pr != NULL) && (o_coded->ir != NULL) && (o_coded->jc != NULL);
+
+    if (ok) {
+	o_coded->jc[0] = 0;
+
+	for (ii = 0; ii < sample->count; ii++) {
+	    memcpy(o_coded->pr + o_coded->jc[ii],global_vars.o_coeffs_pr + global_vars.o_observations_offset[ii],global_vars.o_observations_length[ii] * sizeof(double));
+	    memcpy(o_coded->ir + o_coded->jc[ii],global_vars.o_coeffs_ir + global_vars.o_observations_offset[ii],global_vars.o_observations_length[ii] * sizeof(size_t));
+	    o_coded->jc[ii + 1] = o_coded->jc[ii] + global_vars.o_observations_length[ii];
+	}
+    } else {
+	xtern_coded_free(o_coded);
+    }
+
+    /* Free memory and destroy objects. */
+
+    free(task_info);
+    pthread_mutex_destroy(&global_vars.coeffs_queue_control);
+    free(global_vars.o_observations_length);
+    free(global_vars.o_observations_offset);
+    free(global_vars.o_coeffs_ir);
+    free(global_vars.o_coeffs_pr);
+    free(image_dicts);
+
+    return ok;
+}
+
+bool
+xtern_model_init(
+    struct xtern_model* restrict  o_model,
+    size_t                        geometry,
+    size_t                        classifiers_count,
+    const double* restrict        weights,
+    int                           method_code,
+    double                        reg_param) {
+    size_t  weights_count;
+
+    o_model->geometry = geometry;
+    o_model->classifiers_count = classifiers_count;
+    o_model->weights = weights;
+    o_model->method_code = method_code;
+    o_model->reg_param = reg_param;
+    o_model->weights_pr = NULL;
+    o_model->weights_ir = NULL;
+    o_model->weights_jc = NULL;
+
+    if (!linear_classifier_method_valid(method_code)) {
+	return false;
+    }
+
+    if (!linear_classifier_has_sparse_weights(method_code)) {
+	return true;
+    }
+
+    /* L1 regularized classifiers have mostly zero weights, so only the non-zero ones are kept and visited. They
+       are gathered once here, and then shared by every call to "xtern_classify". */
+
+    weights_count = linear_classifier_sparse_weights_count(geometry,classifiers_count,weights);
+    o_model->weights_pr = (double*)malloc(weights_count * sizeof(double));
+    o_model->weights_ir = (size_t*)malloc(weights_count * sizeof(size_t));
+    o_model->weights_jc = (size_t*)malloc((geometry + 2) * sizeof(size_t));
+
+    if ((o_model->weights_jc == NULL) || ((weights_count > 0) && ((o_model->weights_pr == NULL) || (o_model->weights_ir == NULL)))) {
+	xtern_model_free(o_model);
+	return false;
+    }
+
+    linear_classifier_sparse_weights(o_model->weights_pr,o_model->weights_ir,o_model->weights_jc,geometry,classifiers_count,weights);
+
+    return true;
+}
+
+void
+xtern_model_free(
+    struct xtern_model* restrict  io_model) {
+    free(io_model->weights_pr);
+    free(io_model->weights_ir);
+    free(io_model->weights_jc);
+
+    io_model->weights_pr = NULL;
+    io_model->weights_ir = NULL;
+    io_model->weights_jc = NULL;
+}
+
+bool
+xtern_classify(
+    double* restrict                    o_decisions,
+    const struct xtern_model* restrict  model,
+    const struct xtern_coded* restrict  sample,
+    size_t                              num_workers) {
+    if (sample->row_count != model->geometry) {
+	return false;
+    }
+
+    if (model->weights_jc == NULL) {
+	linear_classifier_classify(o_decisions,sample->row_count,sample->col_count,sample->pr,sample->ir,sample->jc,
+				   model->classifiers_count,model->weights,model->method_code,model->reg_param,num_workers);
+    } else {
+	linear_classifier_classify_sparse(o_decisions,sample->row_count,sample->col_count,sample->pr,sample->ir,sample->jc,
+					  model->classifiers_count,model->weights_pr,model->weights_ir,model->weights_jc,num_workers);
+    }
+
+    return true;
+}
+
+bool
+xtern_classify_file(
+    double* restrict                 o_decisions,
+    size_t                           classifiers_count,
+    const double* restrict           weights,
+    int                              method_code,
+    double                           reg_param,
+    size_t                           feature_count,
+    const size_t* restrict           feature_ids,
+    const struct csc_file* restrict  file,
+    size_t                           chunk_count,
+    size_t                           num_workers) {
+    struct xtern_coded  chunk;
+    struct xtern_model  model;
+    size_t*             feature_map;
+    size_t              row_count;
+    size_t              col_count;
+    size_t              chunk_nnz;
+    size_t              max_chunk_nnz;
+    size_t              first;
+
+    row_count = (size_t)file->header.row_count;
+    col_count = (size_t)file->header.col_count;
+
+    if ((chunk_count == 0) || ((feature_ids != NULL) && !_feature_ids_valid(row_count,feature_count,feature_ids))) {
+	return false;
+    }
+
+    /* Only one chunk of columns is decoded at a time, so memory use follows the size of the file, whose values may
+       be as small as one byte each, rather than that of the decoded sample. */
+
+    max_chunk_nnz = 1;
+
+    for (first = 0; first < col_count; first += chunk_count) {
+	chunk_nnz = csc_file_chunk_nnz(file,first,chunk_count);
+	max_chunk_nnz = chunk_nnz > max_chunk_nnz ? chunk_nnz : max_chunk_nnz;
+    }
+
+    if (!xtern_model_init(&model,feature_ids != NULL ? feature_count : row_count,classifiers_count,weights,method_code,reg_param)) {
+	return false;
+    }
+
+    chunk.pr = (double*)malloc(max_chunk_nnz * sizeof(double));
+    chunk.ir = (size_t*)malloc(max_chunk_nnz * sizeof(size_t));
+    chunk.jc = (size_t*)malloc((chunk_count + 1) * sizeof(size_t));
+
+    if ((chunk.pr == NULL) || (chunk.ir == NULL) || (chunk.jc == NULL)) {
+	xtern_coded_free(&chunk);
+	xtern_model_free(&model);
+	return false;
+    }
+
+    if (feature_ids != NULL) {
+	feature_map = (size_t*)malloc(row_count * sizeof(size_t));
+	linear_classifier_feature_map(feature_map,row_count,feature_count,feature_ids);
+    } else {
+	feature_map = NULL;
+    }
+
+    for (first = 0; first < col_count; first += chunk.col_count) {
+	chunk.row_count = row_count;
+	chunk.col_count = csc_file_read_chunk(chunk.pr,chunk.ir,chunk.jc,file,first,chunk_count);
+
+	if (feature_map != NULL) {
+	    _coded_compact(&chunk,feature_count,feature_map);
+	}
+
+	xtern_classify(o_decisions + first * classifiers_count,&model,&chunk,num_workers);
+    }
+
+    free(feature_map);
+    xtern_coded_free(&chunk);
+    xtern_model_free(&model);
+
+    return true;
+}
+
+bool
+xtern_code_image_classify(
+    double* restrict                                 o_decisions,
+    const struct dictionary_handle* const* restrict  dicts,
+    const struct xtern_image_coding* restrict        coding,
+    size_t                                           classifiers_count,
+    const double* restrict                           weights,
+    size_t                                           feature_count,
+    const size_t* restrict                           feature_ids,
+    const struct xtern_sample* restrict              sample,
+    size_t                                           num_workers) {
+    const struct dictionary_state**    image_dicts;
+    struct image_classify_global_info  global_info;
+    struct image_classify_global_vars  global_vars;
+    struct image_classify_task_info*   task_info;
+    size_t*                            feature_map;
+    double*                            weights_by_feature;
+    size_t                             ii;
+
+    if (sample->geometry != coding->row_count * coding->col_count * coding->layer_count) {
+	return false;
+    }
+
+    image_dicts = _image_dictionaries(dicts,coding);
+
+    if (image_dicts == NULL) {
+	return false;
+    }
+
+    /* Build task distribution information. Every observation owns its column of "o_decisions", so workers need
+       no shared state. With "feature_ids", the sorted features the classifiers were trained on, coded observations
+       are compacted to them first. */
+
+    global_info.dicts = image_dicts;
+    global_info.coding = coding;
+    global_info.new_geometry = code_image_new_geometry(coding->row_count,coding->col_count,coding->layer_count,image_dicts[0]->word_count,coding->channel_mode,coding->polarity_split_type,coding->reduce_spread,coding->hashed_geometry);
+    global_info.sample = sample;
+    global_info.classifiers_count = classifiers_count;
+
+    if ((feature_ids != NULL) && !_feature_ids_valid(global_info.new_geometry,feature_count,feature_ids)) {
+	free(image_dicts);
+	return false;
+    }
+
+    if (feature_ids != NULL) {
+	feature_map = (size_t*)malloc(global_info.new_geometry * sizeof(size_t));
+	global_info.classifiers_geometry = feature_count;
+    } else {
+	feature_map = NULL;
+	global_info.classifiers_geometry = global_info.new_geometry;
+    }
+
+    weights_by_feature = (double*)malloc((global_info.classifiers_geometry + 1) * classifiers_count * sizeof(double));
+    task_info = (struct image_classify_task_info*)malloc(sample->count * sizeof(struct image_classify_task_info));
+    global_vars.failed = false;
+
+    if (((feature_ids != NULL) && (feature_map == NULL)) || (weights_by_feature == NULL) || (task_info == NULL) ||
+	(pthread_mutex_init(&global_vars.failed_control,NULL) != 0)) {
+	free(task_info);
+	free(weights_by_feature);
+	free(feature_map);
+	free(image_dicts);
+	return false;
+    }
+
+    if (feature_ids != NULL) {
+	linear_classifier_feature_map(feature_map,global_info.new_geometry,feature_count,feature_ids);
+    }
+
+    linear_classifier_weights_by_feature(weights_by_feature,global_info.classifiers_geometry,classifiers_count,weights);
+    global_info.feature_map = feature_map;
+    global_info.weights_by_feature = weights_by_feature;
+
+    for (ii = 0; ii < sample->count; ii++) {
+	task_info[ii].o_decisions = o_decisions + ii * classifiers_count;
+	task_info[ii].observation = (const char*)sample->data + ii * sample->observation_length;
+    }
+
+    /* Run workers and compute output. */
+
+    run_workers_x(&global_info,&global_vars,sample->count,sizeof(struct image_classify_task_info),task_info,(task_fn_x_t)_do_image_classify_task,num_workers);
+
+    /* Free memory and destroy objects. */
+
+    free(task_info);
+    pthread_mutex_destroy(&global_vars.failed_control);
+    free(weights_by_feature);
+    free(feature_map);
+    free(image_dicts);
+
+    return !global_vars.failed;
+}
@@ -0,0 +1,84 @@
+#ifndef _XTERN_H
+#define _XTERN_H
+
+#include <stdbool.h>
+
+#include "base_defines.h"
+#include "coding_methods.h"
+#include "image_coder.h"
+#include "dataset_file.h"
+#include "csc_file.h"
+#include "dictionary_handle.h"
+#include "linear_classifier.h"
+
+BEGIN_C_DECLS
+
+/* Public interface of "libxtern", for programs which code and classify data without MATLAB. The structures and
+   functions declared in this header keep their layout and signatures across releases, and "XTERN_API_VERSION" is
+   bumped whenever one of them changes. The modules it includes are exported too, but may change at any time. */
+
+#define XTERN_API_VERSION 6
+
+struct xtern_sample {
+    size_t              geometry;
+    size_t              count;
+    enum dataset_dtype  dtype;
+    size_t              observation_length;
+    const void*         data;
+};
+
+struct xtern_coded {
+    size_t   row_count;
+    size_t   col_count;
+    double*  pr;
+    size_t*  ir;
+    size_t*  jc;
+};
+
+struct xtern_model {
+    size_t         geometry;
+    size_t         classifiers_count;
+    const double*  weights;
+    int            method_code;
+    double         reg_param;
+    double*        weights_pr;
+    size_t*        weights_ir;
+    size_t*        weights_jc;
+};
+
+struct xtern_image_coding {
+    size_t                    row_count;
+    size_t                    col_count;
+    size_t                    layer_count;
+    size_t                    patch_row_count;
+    size_t                    patch_col_count;
+    enum channel_mode         channel_mode;
+    enum coding_type          coding_type;
+    size_t                    coeff_count;
+    double                    coding_param;
+    enum nonlinear_type       nonlinear_type;
+    const double*             nonlinear_modulator;
+    enum polarity_split_type  polarity_split_type;
+    enum reduce_type          reduce_type;
+    size_t                    reduce_spread;
+    size_t                    hashed_geometry;
+};
+
+extern int   xtern_api_version(void);
+extern void  xtern_sample_from_dense(struct xtern_sample* restrict o_sample,size_t geometry,size_t count,const double* restrict data);
+extern void  xtern_sample_from_file(struct xtern_sample* restrict o_sample,const struct dataset_file* restrict file);
+extern bool  xtern_coded_from_file(struct xtern_coded* restrict o_coded,const struct csc_file* restrict file);
+extern bool  xtern_coded_to_file(const char* restrict path,const struct xtern_coded* restrict coded,enum csc_index_encoding index_encoding,enum csc_value_encoding value_encoding);
+extern void  xtern_coded_free(struct xtern_coded* restrict io_coded);
+extern bool  xtern_coded_compact(struct xtern_coded* restrict io_coded,size_t feature_count,const size_t* restrict feature_ids);
+extern bool  xtern_code_dictionary(struct xtern_coded* restrict o_coded,const struct dictionary_handle* restrict dict,enum coding_type coding_type,size_t coeff_count,double coding_param,const struct xtern_sample* restrict sample,size_t num_workers);
+extern bool  xtern_code_image(struct xtern_coded* restrict o_coded,const struct dictionary_handle* const* restrict dicts,const struct xtern_image_coding* restrict coding,const struct xtern_sample* restrict sample,size_t num_workers);
+extern bool  xtern_code_image_classify(double* restrict o_decisions,const struct dictionary_handle* const* restrict dicts,const struct xtern_image_coding* restrict coding,size_t classifiers_count,const double* restrict weights,size_t feature_count,const size_t* restrict feature_ids,const struct xtern_sample* restrict sample,size_t num_workers);
+extern bool  xtern_model_init(struct xtern_model* restrict o_model,size_t geometry,size_t classifiers_count,const double* restrict weights,int method_code,double reg_param);
+extern void  xtern_model_free(struct xtern_model* restrict io_model);
+extern bool  xtern_classify(double* restrict o_decisions,const struct xtern_model* restrict model,const struct xtern_coded* restrict sample,size_t num_workers);
+extern bool  xtern_classify_file(double* restrict o_decisions,size_t classifiers_count,const double* restrict weights,int method_code,double reg_param,size_t feature_count,const size_t* restrict feature_ids,const struct csc_file* restrict file,size_t chunk_count,size_t num_workers);
+
+END_C_DECLS
+
+#endif
@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "xtern.h"
+
+/* Command line driver for "libxtern". Samples are read from dataset files, as written by "dataset.save_mapped", and
+   coded samples are written to and read from CSC files, as written by "dataset.save_coded". A dictionary is a dataset
+   file with one atom per observation, and a set of linear classifiers is one with the "geometry + 1" weights of one
+   classifier per observation, as found in the "model_weights" of the MATLAB classifiers. */
+
+#define CLASSIFY_CHUNK_COUNT 4096
+
+struct name_code {
+    const char*  name;
+    int          code;
+};
+
+static const struct name_code
+CODING_TYPE_NAMES[] = {
+    {"Corr",CORRELATION},
+    {"MP",MATCHING_PURSUIT},
+    {"OMP",ORTHOGONAL_MATCHING_PURSUIT},
+    {"OOMP",OPTIMIZED_ORTHOGONAL_MATCHING_PURSUIT},
+    {"SparseNet",SPARSE_NET},
+    {NULL,0}
+};
+
+static const struct name_code
+NONLINEAR_TYPE_NAMES[] = {
+    {"Linear",LINEAR},
+    {"Logistic",LOGISTIC},
+    {NULL,0}
+};
+
+static const struct name_code
+POLARITY_SPLIT_TYPE_NAMES[] = {
+    {"None",NONE},
+    {"NoSign",NO_SIGN},
+    {"KeepSign",KEEP_SIGN},
+    {NULL,0}
+};
+
+static const struct name_code
+CHANNEL_MODE_NAMES[] = {
+    {"Joint",JOINT},
+    {"PerChannel",PER_CHANNEL},
+    {NULL,0}
+};
+
+static const struct name_code
+VALUE_ENCODING_NAMES[] = {
+    {"Float64",VALUE_FLOAT64},
+    {"Float16",VALUE_FLOAT16},
+    {"Int8",VALUE_INT8},
+    {"Codebook",VALUE_CODEBOOK},
+    {NULL,0}
+};
+
+static const struct name_code
+REDUCE_TYPE_NAMES[] = {
+    {"Subsample",SUBSAMPLE},
+    {"MaxNoSign",MAX_NO_SIGN},
+    {"MaxKeepSign",MAX_KEEP_SIGN},
+    {"SumAbs",SUM_ABS},
+    {"SumSqr",SUM_SQR},
+    {NULL,0}
+};
+
+static void
+usage(void) {
+    fprintf(stderr,
+	    "Usage: xtern_cli code -d DICT -m METHOD -k COEFF_COUNT [-p PARAM] [-q VALUES] [-j WORKERS] SAMPLE CODED\n"
+	    "       xtern_cli recode -d DICT -m METHOD -k COEFF_COUNT [-p PARAM] -s PATCH_ROWSxPATCH_COLS [-c CHANNELS]\n"
+	    "                        [-n NONLINEAR] [-l POLARITY_SPLIT] -r REDUCE -R REDUCE_SPREAD [-H HASHED_GEOMETRY]\n"
+	    "                        [-q VALUES | -w WEIGHTS [-f FEATURE_IDS]] [-j WORKERS] SAMPLE CODED\n"
+	    "       xtern_cli classify -w WEIGHTS [-f FEATURE_IDS] -m METHOD_CODE -c REG_PARAM [-j WORKERS] CODED DECISIONS\n"
+	    "\n"
+	    "METHOD is one of Corr, MP, OMP, OOMP or SparseNet, and PARAM is the lambda to sigma ratio of SparseNet.\n"
+	    "NONLINEAR is Linear or Logistic, POLARITY_SPLIT is None, NoSign or KeepSign and REDUCE is one of\n"
+	    "Subsample, MaxNoSign, MaxKeepSign, SumAbs or SumSqr. METHOD_CODE is the liblinear solver the\n"
+	    "classifiers were trained with. With WEIGHTS, recode writes the decisions of the classifiers instead of the\n"
+	    "coded sample, without ever building the latter. FEATURE_IDS holds the one-based \"feature_ids\" of the\n"
+	    "classifiers, when they were trained on a compacted sample. HASHED_GEOMETRY hashes coded features into that\n"
+	    "many signed buckets. VALUES is how coded values are stored, and is one of Float64, the default, Float16,\n"
+	    "Int8 or Codebook. The last holds at most 256 distinct values, across the whole coded sample. CHANNELS is\n"
+	    "Joint, the default, which codes patches across all the layers of an image with one dictionary, or\n"
+	    "PerChannel, which codes each layer with its own dictionary. DICT then holds the atoms of the first\n"
+	    "layer's dictionary, followed by those of the second one, and so on.\n");
+    exit(EXIT_FAILURE);
+}
+
+static void
+fail(
+    const char*  message,
+    const char*  argument) {
+    fprintf(stderr,"xtern_cli: %s \"%s\".\n",message,argument);
+    exit(EXIT_FAILURE);
+}
+
+static int
+parse_name(
+    const struct name_code*  names,
+    const char*              name) {
+    size_t  ii;
+
+    for (ii = 0; names[ii].name != NULL; ii++) {
+	if (strcmp(names[ii].name,name) == 0) {
+	    return names[ii].code;
+	}
+    }
+
+    fail("Unknown name",name);
+    return 0;
+}
+
+static size_t
+parse_count(
+    const char*  text) {
+    char*  end;
+    long   value;
+
+    value = strtol(text,&end,10);
+
+    if ((*end != '\0') || (value < 1)) {
+	fail("Expected a positive integer instead of",text);
+    }
+
+    return (size_t)value;
+}
+
+static double
+parse_number(
+    const char*  text) {
+    char*   end;
+    double  value;
+
+    value = strtod(text,&end);
+
+    if (*end != '\0') {
+	fail("Expected a number instead of",text);
+    }
+
+    return value;
+}
+
+static double*
+read_columns(
+    size_t*      o_row_count,
+    size_t*      o_col_count,
+    const char*  path) {
+    struct dataset_file  file;
+    double*              columns;
+
+    if (!dataset_file_open(&file,path)) {
+	fail("Could not open dataset file",path);
+    }
+
+    *o_row_count = file.geometry;
+    *o_col_count = (size_t)file.header.count;
+    columns = (double*)malloc(*o_row_count * *o_col_count * sizeof(double));
+    dataset_file_read_chunk(columns,&file,0,*o_col_count);
+
+    dataset_file_close(&file);
+
+    return columns;
+}
+
+static size_t*
+read_feature_ids(
+    size_t*      o_feature_count,
+    const char*  path) {
+    double*  feature_ids_one_based;
+    size_t*  feature_ids;
+    size_t   row_count;
+    size_t   col_count;
+    size_t   ii;
+
+    feature_ids_one_based = read_columns(&row_count,&col_count,path);
+    *o_feature_count = row_count * col_count;
+    feature_ids = (size_t*)malloc(*o_feature_count * sizeof(size_t));
+
+    for (ii = 0; ii < *o_feature_count; ii++) {
+	feature_ids[ii] = (size_t)feature_ids_one_based[ii] - 1;
+    }
+
+    free(feature_ids_one_based);
+
+    return feature_ids;
+}
+
+static struct dictionary_handle**
+read_dictionaries(
+    size_t       dict_count,
+    const char*  path) {
+    struct dictionary_handle**  handles;
+    double*                     atoms;
+    double*                     dict;
+    size_t                      geometry;
+    size_t                      atom_count;
+    size_t                      word_count;
+    size_t                      dd;
+    size_t                      ii;
+    size_t                      jj;
+
+    /* Atoms are stored one per observation, with the "dict_count" dictionaries one after the other, while coders
+       expect them as the rows of "dict". */
+
+    atoms = read_columns(&geometry,&atom_count,path);
+
+    if (atom_count % dict_count != 0) {
+	fail("Could not split into one dictionary per layer",path);
+    }
+
+    word_count = atom_count / dict_count;
+    handles = (struct dictionary_handle**)malloc(dict_count * sizeof(struct dictionary_handle*));
+    dict = (double*)malloc(word_count * geometry * sizeof(double));
+
+    for (dd = 0; dd < dict_count; dd++) {
+	for (ii = 0; ii < word_count; ii++) {
+	    for (jj = 0; jj < geometry; jj++) {
+		dict[jj * word_count + ii] = atoms[(dd * word_count + ii) * geometry + jj];
+	    }
+	}
+
+	if (!dictionary_handle_create(&handles[dd],geometry,word_count,dict)) {
+	    fail("Could not build dictionary from",path);
+	}
+    }
+
+    free(dict);
+    free(atoms);
+
+    return handles;
+}
+
+static void
+free_dictionaries(
+    size_t                      dict_count,
+    struct dictionary_handle**  handles) {
+    size_t  dd;
+
+    for (dd = 0; dd < dict_count; dd++) {
+	dictionary_handle_destroy(handles[dd]);
+    }
+
+    free(handles);
+}
+
+static void
+write_coded(
+    const char*                 path,
+    const struct xtern_coded*   coded,
+    enum csc_value_encoding     value_encoding) {
+    if (!xtern_coded_to_file(path,coded,INDEX_VARINT_DELTA,value_encoding)) {
+	fail("Could not write CSC file",path);
+    }
+}
+
+static void
+write_decisions(
+    const char*    path,
+    size_t         classifiers_count,
+    size_t         count,
+    const double*  decisions) {
+    struct dataset_file_header  decisions_header;
+
+    dataset_file_header_init(&decisions_header,KIND_RECORD,DTYPE_FLOAT64,classifiers_count,1,1,count,false,0);
+
+    if (!dataset_file_write(path,&decisions_header,decisions,NULL,NULL)) {
+	fail("Could not write dataset file",path);
+    }
+}
+
+static int
+run_code(
+    int    argc,
+    char*  argv[],
+    bool   is_image) {
+    const char*                 dict_path;
+    struct dictionary_handle**  dicts;
+    size_t                      dict_count;
+    struct xtern_image_coding   coding;
+    struct dataset_file         sample_file;
+    struct xtern_sample         sample;
+    struct xtern_coded          coded;
+    double*                     weights;
+    size_t                      weights_geometry;
+    size_t                      classifiers_count;
+    size_t*                     feature_ids;
+    size_t                      feature_count;
+    size_t                      classifiers_geometry;
+    double*                     decisions;
+    enum csc_value_encoding     value_encoding;
+    size_t                      num_workers;
+    char*                       patch_separator;
+    int                         option;
+    bool                        ok;
+
+    dict_path = NULL;
+    memset(&coding,0,sizeof(struct xtern_image_coding));
+    coding.channel_mode = JOINT;
+    coding.coding_type = CORRELATION;
+    coding.nonlinear_type = LINEAR;
+    coding.polarity_split_type = NONE;
+    coding.reduce_type = SUBSAMPLE;
+    weights = NULL;
+    weights_geometry = 0;
+    classifiers_count = 0;
+    feature_ids = NULL;
+    feature_count = 0;
+    value_encoding = VALUE_FLOAT64;
+    num_workers = 1;
+
+    while ((option = getopt(argc,argv,is_image ? "d:m:k:p:s:c:n:l:r:R:H:q:w:f:j:" : "d:m:k:p:q:j:")) != -1) {
+	switch (option) {
+	case 'd':
+	    dict_path = optarg;
+	    break;
+	case 'm':
+	    coding.coding_type = (enum coding_type)parse_name(CODING_TYPE_NAMES,optarg);
+	    break;
+	case 'k':
+	    coding.coeff_count = parse_count(optarg);
+	    break;
+	case 'p':
+	    coding.coding_param = parse_number(optarg);
+	    break;
+	case 's':
+	    patch_separator = strchr(optarg,'x');
+
+	    if (patch_separator == NULL) {
+		fail("Expected a patch size instead of",optarg);
+	    }
+
+	    *patch_separator = '\0';
+	    coding.patch_row_count = parse_count(optarg);
+	    coding.patch_col_count = parse_count(patch_separator + 1);
+	    break;
+	case 'c':
+	    coding.channel_mode = (enum channel_mode)parse_name(CHANNEL_MODE_NAMES,optarg);
+	    break;
+	case 'n':
+	    coding.nonlinear_type = (enum nonlinear_type)parse_name(NONLINEAR_TYPE_NAMES,optarg);
+	    break;
+	case 'l':
+	    coding.polarity_split_type = (enum polarity_split_type)parse_name(POLARITY_SPLIT_TYPE_NAMES,optarg);
+	    break;
+	case 'r':
+	    coding.reduce_type = (enum reduce_type)parse_name(REDUCE_TYPE_NAMES,optarg);
+	    break;
+	case 'R':
+	    coding.reduce_spread = parse_count(optarg);
+	    break;
+	case 'H':
+	    coding.hashed_geometry = parse_count(optarg);
+	    break;
+	case 'q':
+	    value_encoding = (enum csc_value_encoding)parse_name(VALUE_ENCODING_NAMES,optarg);
+	    break;
+	case 'w':
+	    weights = read_columns(&weights_geometry,&classifiers_count,optarg);
+	    break;
+	case 'f':
+	    feature_ids = read_feature_ids(&feature_count,optarg);
+	    break;
+	case 'j':
+	    num_workers = parse_count(optarg);
+	    break;
+	default:
+	    usage();
+	}
+    }
+
+    if ((dict_path == NULL) || (coding.coeff_count == 0) || (optind + 2 != argc) ||
+	(is_image && ((coding.patch_row_count == 0) || (coding.reduce_spread == 0)))) {
+	usage();
+    }
+
+    if (!dataset_file_open(&sample_file,argv[optind])) {
+	fail("Could not open dataset file",argv[optind]);
+    }
+
+    xtern_sample_from_file(&sample,&sample_file);
+
+    coding.row_count = (size_t)sample_file.header.row_count;
+    coding.col_count = (size_t)sample_file.header.col_count;
+    coding.layer_count = (size_t)sample_file.header.layer_count;
+    dict_count = is_image && (coding.channel_mode == PER_CHANNEL) ? coding.layer_count : 1;
+    dicts = read_dictionaries(dict_count,dict_path);
+
+    if (is_image && !code_image_idx_fits(coding.row_count,coding.col_count,coding.layer_count,dicts[0]->state.word_count,coding.channel_mode,
+					 coding.polarity_split_type,coding.reduce_spread,coding.hashed_geometry)) {
+	fail("Coded geometry has more features than coefficient indices can hold for",argv[optind]);
+    }
+
+    if (is_image && (weights != NULL)) {
+	classifiers_geometry = feature_ids != NULL ? feature_count : code_image_new_geometry(coding.row_count,coding.col_count,coding.layer_count,dicts[0]->state.word_count,coding.channel_mode,coding.polarity_split_type,coding.reduce_spread,coding.hashed_geometry);
+
+	if (weights_geometry != classifiers_geometry + 1) {
+	    fail("Classifiers do not match the coded geometry of",argv[optind]);
+	}
+
+	decisions = (double*)malloc(classifiers_count * sample.count * sizeof(double));
+
+	if (!xtern_code_image_classify(decisions,(const struct dictionary_handle* const*)dicts,&coding,classifiers_count,weights,feature_count,feature_ids,&sample,num_workers)) {
+	    fail("Could not code the sample in",argv[optind]);
+	}
+
+	write_decisions(argv[optind + 1],classifiers_count,sample.count,decisions);
+
+	free(decisions);
+	free(feature_ids);
+	free(weights);
+	dataset_file_close(&sample_file);
+	free_dictionaries(dict_count,dicts);
+
+	return EXIT_SUCCESS;
+    } else if (is_image) {
+	ok = xtern_code_image(&coded,(const struct dictionary_handle* const*)dicts,&coding,&sample,num_workers);
+    } else {
+	ok = xtern_code_dictionary(&coded,dicts[0],coding.coding_type,coding.coeff_count,coding.coding_param,&sample,num_workers);
+    }
+
+    if (!ok) {
+	fail("Could not code the sample in",argv[optind]);
+    }
+
+    write_coded(argv[optind + 1],&coded,value_encoding);
+
+    xtern_coded_free(&coded);
+    dataset_file_close(&sample_file);
+    free_dictionaries(dict_count,dicts);
+
+    return EXIT_SUCCESS;
+}
+
+static int
+run_classify(
+    int    argc,
+    char*  argv[]) {
+    double*                     weights;
+    size_t                      weights_geometry;
+    size_t                      classifiers_count;
+    size_t*                     feature_ids;
+    size_t                      feature_count;
+    int                         method_code;
+    double                      reg_param;
+    size_t                      num_workers;
+    struct csc_file             sample_file;
+    size_t                      sample_geometry;
+    double*                     decisions;
+    int                         option;
+
+    weights = NULL;
+    weights_geometry = 0;
+    classifiers_count = 0;
+    feature_ids = NULL;
+    feature_count = 0;
+    method_code = -1;
+    reg_param = 1;
+    num_workers = 1;
+
+    while ((option = getopt(argc,argv,"w:f:m:c:j:")) != -1) {
+	switch (option) {
+	case 'w':
+	    weights = read_columns(&weights_geometry,&classifiers_count,optarg);
+	    break;
+	case 'f':
+	    feature_ids = read_feature_ids(&feature_count,optarg);
+	    break;
+	case 'm':
+	    method_code = (int)parse_number(optarg);
+	    break;
+	case 'c':
+	    reg_param = parse_number(optarg);
+	    break;
+	case 'j':
+	    num_workers = parse_count(optarg);
+	    break;
+	default:
+	    usage();
+	}
+    }
+
+    if ((weights == NULL) || !linear_classifier_method_valid(method_code) || (optind + 2 != argc)) {
+	usage();
+    }
+
+    if (!csc_file_open(&sample_file,argv[optind])) {
+	fail("Could not open CSC file",argv[optind]);
+    }
+
+    /* The coded sample is classified straight from the file, a chunk at a time, so it is never fully decoded. */
+
+    sample_geometry = feature_ids != NULL ? feature_count : (size_t)sample_file.header.row_count;
+
+    if (weights_geometry != sample_geometry + 1) {
+	fail("Classifiers do not match the geometry of",argv[optind]);
+    }
+
+    decisions = (double*)malloc(classifiers_count * (size_t)sample_file.header.col_count * sizeof(double));
+
+    if (!xtern_classify_file(decisions,classifiers_count,weights,method_code,reg_param,feature_count,feature_ids,&sample_file,CLASSIFY_CHUNK_COUNT,num_workers)) {
+	fail("Could not classify the sample in",argv[optind]);
+    }
+
+    write_decisions(argv[optind + 1],classifiers_count,(size_t)sample_file.header.col_count,decisions);
+
+    free(decisions);
+    csc_file_close(&sample_file);
+    free(feature_ids);
+    free(weights);
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(
+    int    argc,
+    char*  argv[]) {
+    if (argc < 2) {
+	usage();
+    }
+
+    /* Options are parsed after the command, as if it were the program name. */
+
+    if (strcmp(argv[1],"code") == 0) {
+	return run_code(argc - 1,argv + 1,false);
+    } else if (strcmp(argv[1],"recode") == 0) {
+	return run_code(argc - 1,argv + 1,true);
+    } else if (strcmp(argv[1],"classify") == 0) {
+	return run_classify(argc - 1,argv + 1);
+    } else {
+	usage();
+	return EXIT_FAILURE;
+    }
+}
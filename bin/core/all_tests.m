@@ -19,6 +19,8 @@ utils.params.test(test_figure);
 dataset.test(test_figure);
 classifier_info.test(test_figure);
 regressor_info.test(test_figure);
+utils.cache.test(test_figure);
+utils.dictionary_handle.test(test_figure);
 
 %% Tests for "transform" and derived classes.
 
@@ -28,6 +30,7 @@ transforms.record.normalize.test(test_figure);
 transforms.record.standardize.test(test_figure);
 transforms.record.pca.test(test_figure);
 transforms.record.zca.test(test_figure);
+transforms.record.pipeline.test(test_figure);
 transforms.record.dictionary.test(test_figure);
 transforms.record.dictionary.given.dct.test(test_figure);
 transforms.record.dictionary.random.filters.test(test_figure);
@@ -36,6 +39,8 @@ transforms.record.dictionary.learn.pca.test(test_figure);
 transforms.record.dictionary.learn.grad.test(test_figure);
 transforms.record.dictionary.learn.grad_st.test(test_figure);
 transforms.record.dictionary.learn.neural_gas.test(test_figure);
+transforms.record.dictionary.learn.online.test(test_figure);
+transforms.record.dictionary.learn.ksvd.test(test_figure);
 transforms.image.resize.test(test_figure);
 transforms.image.patch_extract.test(test_figure);
 transforms.image.digit.deform.test(test_figure);
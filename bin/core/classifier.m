@@ -32,7 +32,68 @@ classdef classifier
             assert(~check.classifier_info(class_info) || class_info.compatible(sample));
 
             [labels_idx_hat,labels_confidence] = obj.do_classify(sample);
+            [score,conf_matrix,misclassified] = classifier.evaluate(labels_idx_hat,class_info);
+        end
+        
+        function [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = classify_coded(obj,coded_path,class_info,chunk_count)
+            assert(check.scalar(obj));
+            assert(check.classifier(obj));
+            assert(check.scalar(coded_path));
+            assert(check.string(coded_path));
+            assert(check.scalar(class_info));
+            assert(check.classifier_info(class_info) || (class_info == -1));
+            assert(check.scalar(chunk_count));
+            assert(check.natural(chunk_count));
+            assert(chunk_count >= 1);
+            assert(~check.classifier_info(class_info) || (check.same(obj.saved_labels,class_info.labels)));
+            
+            [geometry,N] = dataset.coded_info(coded_path);
+            
+            assert(dataset.geom_compatible(obj.input_geometry,geometry));
+            assert(~check.classifier_info(class_info) || (length(class_info.labels_idx) == N));
+            
+            % Only one chunk of the coded sample is in memory at any time.
+            
+            labels_idx_hat = zeros(1,N);
+            labels_confidence = zeros(obj.saved_labels_count,N);
+            
+            for first = 1:chunk_count:N
+                chunk_idx = first:min(first + chunk_count - 1,N);
+                [labels_idx_hat(chunk_idx),labels_confidence(:,chunk_idx)] = obj.do_classify(dataset.load_coded(coded_path,first,chunk_count));
+            end
+            
+            [score,conf_matrix,misclassified] = classifier.evaluate(labels_idx_hat,class_info);
+        end
+        
+        function [labels_idx_hat,labels_confidence,score,conf_matrix,misclassified] = classify_recoded(obj,t_recoder,sample_plain,class_info)
+            assert(check.scalar(obj));
+            assert(check.classifier(obj));
+            assert(check.scalar(t_recoder));
+            assert(isa(t_recoder,'transforms.image.recoder'));
+            assert(check.dataset_image(sample_plain));
+            assert(check.scalar(class_info));
+            assert(check.classifier_info(class_info) || (class_info == -1));
+            assert(dataset.geom_compatible(t_recoder.input_geometry,dataset.geometry(sample_plain)));
+            assert(dataset.geom_compatible(obj.input_geometry,t_recoder.output_geometry));
+            assert(~check.classifier_info(class_info) || (check.same(obj.saved_labels,class_info.labels)));
+            assert(~check.classifier_info(class_info) || class_info.compatible(sample_plain));
+            
+            % Equivalent to classifying "t_recoder.code(sample_plain)", but classifiers which can work straight off the
+            % recoder's output never see the coded sample.
             
+            [labels_idx_hat,labels_confidence] = obj.do_classify_recoded(t_recoder,sample_plain);
+            [score,conf_matrix,misclassified] = classifier.evaluate(labels_idx_hat,class_info);
+        end
+    end
+    
+    methods (Access=protected)
+        function [labels_idx_hat,labels_confidence] = do_classify_recoded(obj,t_recoder,sample_plain)
+            [labels_idx_hat,labels_confidence] = obj.do_classify(t_recoder.code(sample_plain));
+        end
+    end
+    
+    methods (Static,Access=protected)
+        function [score,conf_matrix,misclassified] = evaluate(labels_idx_hat,class_info)
             if check.classifier_info(class_info)
                 score = 100 * sum(class_info.labels_idx == labels_idx_hat) / length(class_info.labels_idx);
                 conf_matrix = confusionmat(class_info.labels_idx,labels_idx_hat);
@@ -204,6 +204,191 @@ classdef dataset
                 assert(false);
             end
         end
+        
+        function [] = save_mapped(dataset_path,sample,class_info,dtype)
+            assert(check.scalar(dataset_path));
+            assert(check.string(dataset_path));
+            assert(check.dataset(sample));
+            assert(check.scalar(class_info));
+            assert(check.classifier_info(class_info) || (class_info == -1));
+            assert(~check.classifier_info(class_info) || class_info.compatible(sample));
+            assert(~exist('dtype','var') || check.scalar(dtype));
+            assert(~exist('dtype','var') || check.string(dtype));
+            assert(~exist('dtype','var') || check.one_of(dtype,'Float64','Float32','UInt8'));
+            assert(~exist('dtype','var') || ~check.same(dtype,'UInt8') || (check.natural(sample) && check.checkv(sample <= 255)));
+            
+            if ~exist('dtype','var')
+                dtype = 'Float64';
+            end
+            
+            % Observations are stored one after the other, so a mapped file can be coded or searched a chunk at a
+            % time, and narrower types trade precision for less disk traffic.
+            
+            if check.dataset_record(sample)
+                kind_code = 0;
+            else
+                kind_code = 1;
+            end
+            
+            if check.same(dtype,'Float64')
+                dtype_code = 0;
+            elseif check.same(dtype,'Float32')
+                dtype_code = 1;
+            elseif check.same(dtype,'UInt8')
+                dtype_code = 2;
+            else
+                assert(false);
+            end
+            
+            if check.classifier_info(class_info)
+                labels_idx = class_info.labels_idx;
+                label_names = sprintf('%s\n',class_info.labels{:});
+            else
+                labels_idx = zeros(1,0);
+                label_names = '';
+            end
+            
+            xtern.x_dataset_write(dataset_path,full(double(sample)),kind_code,dtype_code,labels_idx,label_names);
+        end
+        
+        function [sample,varargout] = load_mapped(dataset_path,first,count)
+            assert(check.scalar(dataset_path));
+            assert(check.string(dataset_path));
+            assert(~exist('first','var') || check.scalar(first));
+            assert(~exist('first','var') || check.natural(first));
+            assert(~exist('first','var') || (first >= 1));
+            assert(~exist('count','var') || check.scalar(count));
+            assert(~exist('count','var') || check.natural(count));
+            
+            if ~exist('first','var')
+                first = 1;
+            end
+            
+            if ~exist('count','var')
+                [~,count] = dataset.mapped_info(dataset_path);
+            end
+            
+            [sample,labels_idx,label_names] = xtern.x_dataset_read(dataset_path,first - 1,count);
+            
+            if nargout >= 2
+                if check.empty(label_names)
+                    throw(MException('master:NoLoad','No classifier info in mapped dataset!'));
+                end
+                
+                labels = regexp(label_names(1:end-1),'\n','split');
+                varargout{1} = classifier_info(labels,labels_idx);
+            end
+        end
+        
+        function [geometry,sample_count,dtype] = mapped_info(dataset_path)
+            assert(check.scalar(dataset_path));
+            assert(check.string(dataset_path));
+            
+            [~,~,~,info] = xtern.x_dataset_read(dataset_path,0,0);
+            
+            if info(1) == 0
+                geometry = info(3);
+            else
+                geometry = [prod(info(3:5)) info(3:5)];
+            end
+            
+            sample_count = info(6);
+            
+            if info(2) == 0
+                dtype = 'Float64';
+            elseif info(2) == 1
+                dtype = 'Float32';
+            elseif info(2) == 2
+                dtype = 'UInt8';
+            else
+                assert(false);
+            end
+        end
+        
+        function [] = save_coded(coded_path,sample,compress_idx,value_encoding)
+            assert(check.scalar(coded_path));
+            assert(check.string(coded_path));
+            assert(check.dataset_record(sample));
+            assert(~exist('compress_idx','var') || check.scalar(compress_idx));
+            assert(~exist('compress_idx','var') || check.logical(compress_idx));
+            assert(~exist('value_encoding','var') || check.scalar(value_encoding));
+            assert(~exist('value_encoding','var') || check.string(value_encoding));
+            assert(~exist('value_encoding','var') || check.one_of(value_encoding,'Float64','Float16','Int8','Codebook'));
+            assert(~exist('value_encoding','var') || ~check.same(value_encoding,'Codebook') || (length(unique(nonzeros(sample))) <= 256));
+            
+            if ~exist('compress_idx','var')
+                compress_idx = false;
+            end
+            
+            if ~exist('value_encoding','var')
+                value_encoding = 'Float64';
+            end
+            
+            xtern.x_csc_file_write(coded_path,sparse(double(sample)),double(compress_idx),dataset.coded_value_encoding_code(value_encoding));
+        end
+        
+        function [sample] = load_coded(coded_path,first,count)
+            assert(check.scalar(coded_path));
+            assert(check.string(coded_path));
+            assert(~exist('first','var') || check.scalar(first));
+            assert(~exist('first','var') || check.natural(first));
+            assert(~exist('first','var') || (first >= 1));
+            assert(~exist('count','var') || check.scalar(count));
+            assert(~exist('count','var') || check.natural(count));
+            
+            if ~exist('first','var')
+                first = 1;
+            end
+            
+            if ~exist('count','var')
+                [~,count] = dataset.coded_info(coded_path);
+            end
+            
+            sample = xtern.x_csc_file_read(coded_path,first - 1,count);
+        end
+        
+        function [geometry,sample_count,nnz_count,value_encoding] = coded_info(coded_path)
+            assert(check.scalar(coded_path));
+            assert(check.string(coded_path));
+            
+            [~,info] = xtern.x_csc_file_read(coded_path,0,0);
+            
+            geometry = info(1);
+            sample_count = info(2);
+            nnz_count = info(3);
+            
+            if info(5) == 0
+                value_encoding = 'Float64';
+            elseif info(5) == 1
+                value_encoding = 'Float16';
+            elseif info(5) == 2
+                value_encoding = 'Int8';
+            elseif info(5) == 3
+                value_encoding = 'Codebook';
+            else
+                assert(false);
+            end
+        end
+        
+        function [value_encoding_code] = coded_value_encoding_code(value_encoding)
+            assert(check.scalar(value_encoding));
+            assert(check.string(value_encoding));
+            assert(check.one_of(value_encoding,'Float64','Float16','Int8','Codebook'));
+            
+            % Values of coded samples are stored as doubles, half precision floats, 8 bit integers scaled per
+            % observation, or 8 bit positions into a codebook of at most 256 distinct values. All but the first lose
+            % precision, except for the codebook, which is exact for the few values of the "GlobalOrder" nonlinearity.
+            
+            if check.same(value_encoding,'Float64')
+                value_encoding_code = 0;
+            elseif check.same(value_encoding,'Float16')
+                value_encoding_code = 1;
+            elseif check.same(value_encoding,'Int8')
+                value_encoding_code = 2;
+            else
+                value_encoding_code = 3;
+            end
+        end
     end
 
     methods (Static,Access=public)
@@ -659,6 +844,168 @@ classdef dataset
             assert(check.same(s_1,s(:,:,:,idx)));
             
             clearvars -except test_figure;
+            
+            fprintf('  Functions "save_mapped", "load_mapped" and "mapped_info".\n');
+            
+            fprintf('    With records and classifier info.\n');
+            
+            s = rand(10,30);
+            ci = classifier_info({'a' 'bb' 'c'},randi(3,1,30));
+            dataset_path = tempname();
+            
+            dataset.save_mapped(dataset_path,s,ci);
+            [s_r,ci_r] = dataset.load_mapped(dataset_path);
+            [g,N,dtype] = dataset.mapped_info(dataset_path);
+            
+            assert(check.same(s_r,s));
+            assert(check.same(ci_r.labels,{'a' 'bb' 'c'}));
+            assert(check.same(ci_r.labels_idx,ci.labels_idx));
+            assert(g == 10);
+            assert(N == 30);
+            assert(check.same(dtype,'Float64'));
+            
+            delete(dataset_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With images and chunked reads.\n');
+            
+            s = rand(8,6,3,25);
+            dataset_path = tempname();
+            
+            dataset.save_mapped(dataset_path,s,-1,'Float32');
+            s_1 = dataset.load_mapped(dataset_path,1,10);
+            s_2 = dataset.load_mapped(dataset_path,11,10);
+            s_3 = dataset.load_mapped(dataset_path,21,10);
+            [g,N,dtype] = dataset.mapped_info(dataset_path);
+            
+            assert(check.dataset_image(s_1));
+            assert(check.same(cat(4,s_1,s_2,s_3),s,1e-6));
+            assert(dataset.count(s_3) == 5);
+            assert(check.same(g,[8*6*3 8 6 3]));
+            assert(N == 25);
+            assert(check.same(dtype,'Float32'));
+            
+            try
+                [~,~] = dataset.load_mapped(dataset_path);
+                assert(false);
+            catch e
+                assert(check.same(e.identifier,'master:NoLoad'));
+            end
+            
+            delete(dataset_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With bytes.\n');
+            
+            s = randi(256,20,40) - 1;
+            dataset_path = tempname();
+            
+            dataset.save_mapped(dataset_path,s,-1,'UInt8');
+            s_r = dataset.load_mapped(dataset_path,5);
+            [~,~,dtype] = dataset.mapped_info(dataset_path);
+            
+            assert(check.same(s_r,s(:,5:end)));
+            assert(check.same(dtype,'UInt8'));
+            
+            delete(dataset_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With improper external inputs.\n');
+            
+            try
+                dataset.load_mapped(tempname());
+                assert(false);
+            catch e
+                assert(check.same(e.identifier,'master:NoLoad'));
+            end
+            
+            clearvars -except test_figure;
+            
+            fprintf('  Functions "save_coded", "load_coded" and "coded_info".\n');
+            
+            fprintf('    With raw indices.\n');
+            
+            s = sprand(500,40,0.05);
+            coded_path = tempname();
+            
+            dataset.save_coded(coded_path,s);
+            s_r = dataset.load_coded(coded_path);
+            [g,N,nnz_count] = dataset.coded_info(coded_path);
+            
+            assert(issparse(s_r));
+            assert(check.same(s_r,s));
+            assert(g == 500);
+            assert(N == 40);
+            assert(nnz_count == nnz(s));
+            
+            delete(coded_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With compressed indices and chunked reads.\n');
+            
+            s = sprand(70000,30,0.001);
+            coded_path = tempname();
+            
+            dataset.save_coded(coded_path,s,true);
+            s_1 = dataset.load_coded(coded_path,1,12);
+            s_2 = dataset.load_coded(coded_path,13,12);
+            s_3 = dataset.load_coded(coded_path,25,12);
+            
+            assert(check.same([s_1 s_2 s_3],s));
+            assert(size(s_3,2) == 6);
+            
+            delete(coded_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With quantized values.\n');
+            
+            s = sprand(300,20,0.1);
+            s_c = sparse(ceil(4 * s) / 4);
+            coded_path = tempname();
+            
+            dataset.save_coded(coded_path,s,true);
+            s_d = dir(coded_path);
+            dataset.save_coded(coded_path,s,true,'Float16');
+            s_h = dataset.load_coded(coded_path);
+            [~,~,nnz_h,value_encoding_h] = dataset.coded_info(coded_path);
+            s_h_d = dir(coded_path);
+            dataset.save_coded(coded_path,s,true,'Int8');
+            s_i = dataset.load_coded(coded_path);
+            [~,~,~,value_encoding_i] = dataset.coded_info(coded_path);
+            s_i_d = dir(coded_path);
+            dataset.save_coded(coded_path,s_c,false,'Codebook');
+            s_c_r = dataset.load_coded(coded_path,1,20);
+            [~,~,~,value_encoding_c] = dataset.coded_info(coded_path);
+            
+            assert(check.same(value_encoding_h,'Float16'));
+            assert(nnz_h == nnz(s));
+            assert(check.checkv(abs(full(s_h - s)) <= 1e-3));
+            assert(s_h_d.bytes < s_d.bytes / 2);
+            assert(check.same(value_encoding_i,'Int8'));
+            assert(check.checkv(abs(full(s_i - s)) <= 1 / 254 + 1e-12));
+            assert(s_i_d.bytes < s_h_d.bytes);
+            assert(check.same(value_encoding_c,'Codebook'));
+            assert(check.same(s_c_r,s_c));
+            
+            delete(coded_path);
+            
+            clearvars -except test_figure;
+            
+            fprintf('    With improper external inputs.\n');
+            
+            try
+                dataset.load_coded(tempname());
+                assert(false);
+            catch e
+                assert(check.same(e.identifier,'master:NoLoad'));
+            end
+            
+            clearvars -except test_figure;
         end
     end
 end
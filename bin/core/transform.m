@@ -4,6 +4,12 @@ classdef transform
         output_geometry;
     end
     
+    properties (Constant,Hidden,GetAccess=public)
+        % Properties which only say how a transform runs, and not what it computes, are left out of cache keys.
+        
+        execution_properties = {'num_workers'};
+    end
+    
     methods (Access=public)
         function [obj] = transform(input_geometry,output_geometry)
             assert(check.vector(input_geometry));
@@ -25,7 +31,29 @@ classdef transform
             assert(check.dataset(sample_plain));
             assert(dataset.geom_compatible(obj.input_geometry,dataset.geometry(sample_plain)));
             
-            sample_coded = obj.do_code(sample_plain);
+            % With caching enabled, a transform which was already applied to an identical sample, by an identical
+            % transform, from this or an earlier session, is served from disk instead of being recomputed. Transforms
+            % which differ only in their "execution_properties" count as identical.
+            
+            if utils.cache.enabled() && obj.is_cacheable()
+                cache_key = utils.cache.key(obj,sample_plain);
+                [hit,sample_coded] = utils.cache.fetch(cache_key);
+                
+                if ~hit
+                    sample_coded = obj.do_code(sample_plain);
+                    utils.cache.store(cache_key,sample_coded);
+                end
+            else
+                sample_coded = obj.do_code(sample_plain);
+            end
+        end
+    end
+    
+    methods (Access=protected)
+        function [o] = is_cacheable(~)
+            % Transforms whose output is not fully determined by their properties and their input must override this.
+            
+            o = true;
         end
     end
     
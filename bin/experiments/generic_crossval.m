@@ -14,6 +14,15 @@ SAVED_SUBSAMPLE_COUNT = [[[natural >= 1]]];
 CODER_WORKER_COUNT = 2;
 TRAINING_WORKER_COUNT = 2;
 CLASSIFY_WORKER_COUNT = 2;
+CACHE_PATH = '../../explogs/cache';
+
+%% Enable the cache for coded features, shared by all experiments.
+
+if ~exist(CACHE_PATH,'dir')
+    mkdir(CACHE_PATH);
+end
+
+utils.cache.directory(CACHE_PATH);
 
 %% Build the list of coder configurations to test.
 
@@ -204,7 +213,7 @@ for coder_idx = 1:length(param_list_coder)
 
         s_classifier_useful_coded = dataset.subsample(s_coder_useful_coded,classifier_useful_idx);
 
-        coders_dicts{coder_rep_idx,coder_idx} = coders{coder_rep_idx,coder_idx}.t_dictionary.dict;
+        coders_dicts{coder_rep_idx,coder_idx} = coders{coder_rep_idx,coder_idx}.dict;
         sparse_rate(coder_rep_idx,coder_idx) = nnz(s_coder_useful_coded) / numel(s_coder_useful_coded);
         saved_coded_subsample{coder_rep_idx,coder_idx} = dataset.subsample(s_coder_useful_coded,1:SAVED_SUBSAMPLE_COUNT);
         saved_coded_subsample_ci{coder_rep_idx,coder_idx} = ci_coder_useful.subsample(1:SAVED_SUBSAMPLE_COUNT);